@@ -0,0 +1,24 @@
+# Writes OUTPUT, which defines parser::build_id as a hash of every file
+# under SOURCE_DIR/src and SOURCE_DIR/include. The file is only rewritten
+# when the hash changes, so that an unchanged build recompiles nothing.
+file(GLOB_RECURSE sources ${SOURCE_DIR}/src/* ${SOURCE_DIR}/include/*)
+list(SORT sources)
+set(hashes "")
+foreach(source ${sources})
+    file(SHA256 ${source} hash)
+    file(RELATIVE_PATH name ${SOURCE_DIR} ${source})
+    string(APPEND hashes "${name} ${hash}\n")
+endforeach()
+string(SHA256 build_id "${hashes}")
+
+string(CONCAT content
+    "#include \"chocopy_bytes.hpp\"\n\n"
+    "namespace parser {\n"
+    "const char build_id[] = \"${build_id}\";\n"
+    "}  // namespace parser\n")
+if(EXISTS ${OUTPUT})
+    file(READ ${OUTPUT} old_content)
+endif()
+if(NOT "${content}" STREQUAL "${old_content}")
+    file(WRITE ${OUTPUT} "${content}")
+endif()
@@ -67,7 +67,7 @@ class RiscVBackEnd {
 
     /** Emit the constant section containing the prototype FOR the class
      *  defined by CLASSINFO. */
-    string emit_prototype(Class classInfo) {
+    string emit_prototype(Class &classInfo) {
         string asm_code;
         if (classInfo.is_class_anon()) {
         } else {
@@ -85,7 +85,7 @@ class RiscVBackEnd {
         }
         for (auto attr : *classInfo.get_attribute()) {
             if (attr->init_obj != nullptr) {
-                if (auto glob = dynamic_cast<GlobalVariable *>(attr->init_obj);
+                if (auto glob = dyn_cast<GlobalVariable>(attr->init_obj);
                     glob) {
                     asm_code += fmt::format("  .word {}\n", glob->get_name());
                 } else {
@@ -108,6 +108,16 @@ class RiscVBackEnd {
         return asm_code;
     }
 
+    /** Emit the words of the type tag table TAGS, which give the last tag
+     *  below each class by its own. */
+    string emit_type_tag_table(const vector<int> &tags) {
+        if (tags.empty()) return "";
+        string asm_code = emit_global_label(type_tag_table_label);
+        asm_code += type_tag_table_label + ":\n";
+        for (auto tag : tags) asm_code += fmt::format("  .word {}\n", tag);
+        return asm_code;
+    }
+
     /**
      * Emit a local label marker for LABEL. Invoke only once per
      * unique label.
@@ -769,39 +779,91 @@ class RiscVBackEnd {
             fmt::format("snez {}, {}", rd.get_name(), rs.get_name()), comment);
     };
 
-    static string emit_vload(const InstGen::Reg &rd, const InstGen::Reg &rs,
+    /**
+     * Emit a vsetvli instruction: VL = min(RS, VLMAX) for elements of SEW
+     * bits in groups of LMUL registers, and RD = VL.
+     * COMMENT is an optional one-line comment (null if missing).
+     */
+    static string emit_vsetvli(const InstGen::Reg &rd, const InstGen::Reg &rs,
+                               int sew, int lmul, string comment = "") {
+        return fmt::format(
+            "  {:<40}#{:<42}\n",
+            fmt::format("vsetvli {}, {}, e{}, m{}, ta, ma", rd.get_name(),
+                        rs.get_name(), sew, lmul),
+            comment);
+    };
+
+    /**
+     * Emit a unit-stride vector load: VD[i] = the i-th word from RS.
+     * COMMENT is an optional one-line comment (null if missing).
+     */
+    static string emit_vload(int vd, const InstGen::Reg &rs,
                              string comment = "") {
         return fmt::format(
             "  {:<40}#{:<42}\n",
-            fmt::format("vload {}, {}", rd.get_name(), rs.get_name()), comment);
+            fmt::format("vle32.v v{}, ({})", vd, rs.get_name()), comment);
     };
-    static string emit_vstore(const InstGen::Reg &rd, const InstGen::Reg &rs,
+
+    /**
+     * Emit a unit-stride vector store: the i-th word from RS = VS[i].
+     * COMMENT is an optional one-line comment (null if missing).
+     */
+    static string emit_vstore(int vs, const InstGen::Reg &rs,
                               string comment = "") {
         return fmt::format(
             "  {:<40}#{:<42}\n",
-            fmt::format("vstore {}, {}", rd.get_name(), rs.get_name()),
-            comment);
+            fmt::format("vse32.v v{}, ({})", vs, rs.get_name()), comment);
     };
-    static string emit_vadd_vv(const InstGen::Reg &rd, const InstGen::Reg &rs,
-                               string comment = "") {
+
+    /**
+     * Emit a vector-vector instruction OP: VD = VS2 op VS1.
+     * COMMENT is an optional one-line comment (null if missing).
+     */
+    static string emit_vv(const string &op, int vd, int vs2, int vs1,
+                          string comment = "") {
         return fmt::format(
             "  {:<40}#{:<42}\n",
-            fmt::format("vadd.vv {}, {}", rd.get_name(), rs.get_name()),
-            comment);
+            fmt::format("{}.vv v{}, v{}, v{}", op, vd, vs2, vs1), comment);
+    };
+
+    /**
+     * Emit a vector-scalar instruction OP: VD = VS2 op RS1.
+     * COMMENT is an optional one-line comment (null if missing).
+     */
+    static string emit_vx(const string &op, int vd, int vs2,
+                          const InstGen::Reg &rs1, string comment = "") {
+        return fmt::format("  {:<40}#{:<42}\n",
+                           fmt::format("{}.vx v{}, v{}, {}", op, vd, vs2,
+                                       rs1.get_name()),
+                           comment);
     };
-    static string emit_vdiv_vv(const InstGen::Reg &rd, const InstGen::Reg &rs,
+
+    static string emit_vadd_vv(int vd, int vs2, int vs1,
                                string comment = "") {
-        return fmt::format(
-            "  {:<40}#{:<42}\n",
-            fmt::format("vdiv.vv {}, {}", rd.get_name(), rs.get_name()),
-            comment);
+        return emit_vv("vadd", vd, vs2, vs1, comment);
+    };
+    static string emit_vsub_vv(int vd, int vs2, int vs1,
+                               string comment = "") {
+        return emit_vv("vsub", vd, vs2, vs1, comment);
+    };
+    static string emit_vdiv_vv(int vd, int vs2, int vs1,
+                               string comment = "") {
+        return emit_vv("vdiv", vd, vs2, vs1, comment);
+    };
+    static string emit_vmul_vv(int vd, int vs2, int vs1,
+                               string comment = "") {
+        return emit_vv("vmul", vd, vs2, vs1, comment);
     };
-    static string emit_vmul_vv(const InstGen::Reg &rd, const InstGen::Reg &rs,
+
+    /**
+     * Emit a splat: VD[i] = RS for every element.
+     * COMMENT is an optional one-line comment (null if missing).
+     */
+    static string emit_vmv_v_x(int vd, const InstGen::Reg &rs,
                                string comment = "") {
         return fmt::format(
             "  {:<40}#{:<42}\n",
-            fmt::format("vmul.vv {}, {}", rd.get_name(), rs.get_name()),
-            comment);
+            fmt::format("vmv.v.x v{}, {}", vd, rs.get_name()), comment);
     };
 
     static string emit_epilogue(const std::vector<InstGen::Reg> &reg_list,
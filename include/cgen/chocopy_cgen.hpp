@@ -82,6 +82,7 @@ class CodeGen {
     [[nodiscard]] string generateFunctionCall(Instruction *inst,
                                               const string &call_inst,
                                               vector<Value *> ops);
+    [[nodiscard]] string generateVectorLoop(VExtInst *inst);
 
     [[nodiscard]] string getLabelName(BasicBlock *bb);
     [[nodiscard]] string getLabelName(Function *func, int type);
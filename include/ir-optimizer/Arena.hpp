@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "chocopy_arena.hpp"
+
+namespace lightir {
+class Value;
+
+/** Bump allocator for the IR of a module.
+ *
+ * Values are allocated with `new (m) X(...)` and are never freed one by
+ * one: when the module goes away, every value is destroyed and the blocks
+ * are returned all at once. */
+class Arena {
+   public:
+    Arena() = default;
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+    ~Arena();
+
+    void *allocate(size_t size);
+    /** Register v to be destroyed with the arena that allocated it. Called
+     * by the constructor of every value, which must have been allocated
+     * with `new (m)` on this thread. */
+    static void own(Value *v);
+    /** Destroy all values; the memory is kept until the arena is destroyed.
+     */
+    void clear();
+
+    size_t get_allocated_size() const {
+        return memory_.get_allocated_size();
+    }
+
+   private:
+    /** the blocks the values are carved from */
+    parser::BumpAllocator memory_;
+    /** the allocations whose value is not constructed yet, innermost last:
+     * the arguments of a constructor may allocate values of their own */
+    std::vector<std::pair<std::byte *, std::byte *>> pending_;
+    std::vector<Value *> values_;
+    /** the arena that allocated last on this thread */
+    static thread_local Arena *allocating_;
+};
+}  // namespace lightir
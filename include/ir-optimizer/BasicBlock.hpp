@@ -1,6 +1,7 @@
 #pragma once
 
 #include <list>
+#include <ostream>
 #include <set>
 #include <string>
 
@@ -18,7 +19,11 @@ class BasicBlock : public Value {
     /** Constructor that calls name completion. */
     static BasicBlock *create(Module *m, const string &name, Function *parent) {
         auto prefix = name.empty() ? "" : "label_";
-        return new BasicBlock(m, prefix + name, parent);
+        return new (m) BasicBlock(m, prefix + name, parent);
+    }
+
+    static bool classof(const Value *v) {
+        return v->get_value_kind() == ValueKind::BasicBlock;
     }
 
     Function *get_parent() { return parent_; }
@@ -44,7 +49,11 @@ class BasicBlock : public Value {
 
     void add_instruction(Instruction *instr);
     void add_instr_begin(Instruction *instr);
+    /** Unlink instr and drop the uses of its operands. */
     void delete_instr(Instruction *instr);
+    /** Unlink instr but keep its operands, to add it somewhere else. */
+    void remove_instr(Instruction *instr);
+    /** Insert before pos. */
     void insert_instr(Instruction *pos, Instruction *insert);
 
     bool empty() { return instr_list_.empty(); }
@@ -53,7 +62,12 @@ class BasicBlock : public Value {
 
     void erase_from_parent();
 
+    /** A cold block only runs on the way to a runtime error: it calls a
+     * noreturn function, so the backend can move it out of the hot path. */
+    bool is_cold();
+
     virtual string print() override;
+    void print(std::ostream &out);
 
    private:
     list<BasicBlock *> pre_bbs_;
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cassert>
+#include <type_traits>
+
+namespace lightir {
+/** LLVM-style checked casts over Value and Type, which replace dynamic_cast.
+ *
+ * A class To takes part by defining `static bool classof(const From *)`,
+ * usually a check of the kind stored in the base, see ValueKind and
+ * TypeKind. */
+template <typename To, typename From>
+bool isa(const From *v) {
+    assert(v && "isa on a null pointer");
+    return To::classof(v);
+}
+
+template <typename To, typename From>
+auto cast(From *v) {
+    assert(isa<To>(v) && "cast to an incompatible type");
+    using Result = std::conditional_t<std::is_const_v<From>, const To, To>;
+    return static_cast<Result *>(v);
+}
+
+/** Null if v is null or not a To. */
+template <typename To, typename From>
+auto dyn_cast(From *v) {
+    using Result = std::conditional_t<std::is_const_v<From>, const To, To>;
+    return v != nullptr && To::classof(v) ? static_cast<Result *>(v)
+                                          : nullptr;
+}
+}  // namespace lightir
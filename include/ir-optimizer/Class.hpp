@@ -25,10 +25,19 @@ class Constant;
 class AttrInfo : public Value {
    public:
     AttrInfo(Type *varType, string name_, int init_val_)
-        : Value(varType, std::move(name_)), init_val(init_val_){};
+        : Value(varType, std::move(name_)), init_val(init_val_) {
+        set_value_kind(ValueKind::AttrInfo);
+    };
     AttrInfo(Type *varType, string name_, Value *init_val_)
-        : Value(varType, std::move(name_)), init_obj(init_val_){};
-    AttrInfo(Type *varType, string name_) : Value(varType, std::move(name_)){};
+        : Value(varType, std::move(name_)), init_obj(init_val_) {
+        set_value_kind(ValueKind::AttrInfo);
+    };
+    AttrInfo(Type *varType, string name_) : Value(varType, std::move(name_)) {
+        set_value_kind(ValueKind::AttrInfo);
+    };
+    static bool classof(const Value *v) {
+        return v->get_value_kind() == ValueKind::AttrInfo;
+    }
     string print() override;
     int init_val = 0;
     Value *init_obj = nullptr;
@@ -41,6 +50,9 @@ class AttrInfo : public Value {
  *      2: bool
  *      3: str
  *     >3: User-defined types.
+ *  The tags are the numbers of the classes in the semantic class hierarchy,
+ *  so an object is an instance of a class exactly when its tag is from
+ *  type_tag_ to type_tag_last_ of the class.
  */
 class Class : public Type, public Value {
    private:
@@ -52,6 +64,8 @@ class Class : public Type, public Value {
     vector<Function *> *methods_ = new vector<Function *>();
 
     int type_tag_{};
+    /** The last tag of a class below this one, itself if there is none. */
+    int type_tag_last_{};
     string prototype_label_;
     string dispatch_table_label_;
     bool anon_ = false;
@@ -60,6 +74,21 @@ class Class : public Type, public Value {
           bool with_dispatch_table_ = true, bool print_dispatch_table_ = false,
           bool is_append = true);
     Class(Module *m, const string &name_, bool anon_);
+    /** The attribute and method lists are owned by the class. */
+    Class(const Class &) = delete;
+    Class &operator=(const Class &) = delete;
+    ~Class() override {
+        delete attributes_;
+        delete methods_;
+    }
+
+    static bool classof(const Value *v) {
+        return v->get_value_kind() == ValueKind::Class ||
+               v->get_value_kind() == ValueKind::List;
+    }
+    static bool classof(const Type *t) {
+        return t->get_type_kind() == TypeKind::Class;
+    }
 
     void add_attribute(AttrInfo *attrInfo) const {
         this->attributes_->emplace_back(attrInfo);
@@ -120,6 +149,9 @@ class List : public Class {
     List(Class *list_class, vector<Value *> contained, const string &name);
     static List *get(Class *list_class, vector<Value *> contained,
                      const string &name);
+    static bool classof(const Value *v) {
+        return v->get_value_kind() == ValueKind::List;
+    }
 
     Value *get_list_value(int idx) const { return contained_[idx]; }
     void set_list(vector<Value *> cont) { contained_ = cont; }
@@ -131,4 +163,11 @@ class List : public Class {
     string name_;                // list name
     Type::type inside_tag_;
 };
+
+/** The runtime table of the type tags: the word at index t is the last tag
+ * below the class tagged t, so that whether an object is an instance of a
+ * class only known at run time also takes two compares. */
+inline const string type_tag_table_label = "$type_tag_last";
+/** The table for classes, the anonymous ones and lists left out. */
+vector<int> type_tag_table(const list<Class *> &classes);
 }  // namespace lightir
@@ -17,6 +17,11 @@ class Constant : public User {
     explicit Constant(Type *ty, const string &name = "", unsigned num_ops = 0)
         : User(ty, name, num_ops) {}
     ~Constant() = default;
+
+    static bool classof(const Value *v) {
+        return v->get_value_kind() >= ValueKind::FirstConstant &&
+               v->get_value_kind() <= ValueKind::LastConstant;
+    }
 };
 
 class ConstantStr : public Constant {
@@ -35,20 +40,32 @@ class ConstantStr : public Constant {
     static ConstantStr *get(const string &val, int id, Module *m);
     string print() override;
     ConstantStr(Type *ty, string val, int id)
-        : Constant(ty, "", 0), value_(std::move(val)), id_(id) {}
+        : Constant(ty, "", 0), value_(std::move(val)), id_(id) {
+        set_value_kind(ValueKind::ConstantStr);
+    }
+    static bool classof(const Value *v) {
+        return v->get_value_kind() == ValueKind::ConstantStr;
+    }
 };
 
+/** Uniqued by the module: equal constants are the same Value. */
 class ConstantInt : public Constant {
    private:
-    int value_;
+    friend class Module;
+    ConstantInt(Type *ty, int val) : Constant(ty, "", 0), value_(val) {
+        set_value_kind(ValueKind::ConstantInt);
+    }
+
+    const int value_;
 
    public:
-    ConstantInt(Type *ty, int val) : Constant(ty, "", 0), value_(val) {}
     static int get_value(ConstantInt *const_val) { return const_val->value_; }
     int get_value() const { return value_; }
     static ConstantInt *get(int val, Module *m);
     static ConstantInt *get(bool val, Module *m);
-    void set_value(int value) { value_ = value; }
+    static bool classof(const Value *v) {
+        return v->get_value_kind() == ValueKind::ConstantInt;
+    }
     string print() override;
 };
 
@@ -68,7 +85,12 @@ class ConstantBoxInt : public Constant {
     static ConstantBoxInt *get(Class *int_class, int val, int id);
     string print() override;
     ConstantBoxInt(Type *ty, int val, int id)
-        : Constant(ty, "", 0), id_(id), value_(val) {}
+        : Constant(ty, "", 0), id_(id), value_(val) {
+        set_value_kind(ValueKind::ConstantBoxInt);
+    }
+    static bool classof(const Value *v) {
+        return v->get_value_kind() == ValueKind::ConstantBoxInt;
+    }
 };
 
 class ConstantBoxBool : public Constant {
@@ -87,13 +109,27 @@ class ConstantBoxBool : public Constant {
     static ConstantBoxBool *get(Class *bool_class, bool val, int id);
     string print() override;
     ConstantBoxBool(Type *ty, bool val, int id)
-        : Constant(ty, "", 0), id_(id), value_(val) {}
+        : Constant(ty, "", 0), id_(id), value_(val) {
+        set_value_kind(ValueKind::ConstantBoxBool);
+    }
+    static bool classof(const Value *v) {
+        return v->get_value_kind() == ValueKind::ConstantBoxBool;
+    }
 };
 
+/** Uniqued by the module, like ConstantInt. */
 class ConstantNull : public Constant {
+   private:
+    friend class Module;
+    explicit ConstantNull(Type *ty) : Constant(ty, "", 0) {
+        set_value_kind(ValueKind::ConstantNull);
+    }
+
    public:
-    ConstantNull(Type *ty) : Constant(ty, "", 0) {}
-    static ConstantNull *get(Type *ty) { return new ConstantNull(ty); };
+    static ConstantNull *get(Type *ty);
+    static bool classof(const Value *v) {
+        return v->get_value_kind() == ValueKind::ConstantNull;
+    }
 
     string print() override;
 };
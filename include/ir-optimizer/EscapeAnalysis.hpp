@@ -0,0 +1,46 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <vector>
+
+#include "Function.hpp"
+#include "Module.hpp"
+
+using std::map;
+using std::set;
+using std::vector;
+
+namespace lightir {
+/** Interprocedural escape analysis.
+ *
+ * A pointer escapes if what it points to may still be reachable once the
+ * function holding it returns: it is returned, stored anywhere but a local
+ * variable, or passed to a function which lets the parameter escape. Values
+ * stored to a local variable are followed through the loads of that
+ * variable, as long as the variable's own address is not taken.
+ *
+ * Parameter summaries are computed for the whole module up front, starting
+ * from "nothing escapes" and iterating until they are stable, so that
+ * (mutually) recursive functions are handled. */
+class EscapeAnalysis {
+   public:
+    explicit EscapeAnalysis(Module *m);
+
+    /** Follow everything val flows to. If stored is not null, it is set when
+     * val flows through a local variable or a phi, i.e. when it may be alive
+     * in a later iteration of a loop around its definition. */
+    bool escapes(Value *val, bool *stored = nullptr);
+    bool param_escapes(Function *func, unsigned arg_no);
+
+   private:
+    /** Runtime functions which neither keep nor return their arguments. */
+    static const set<string> non_capturing_builtins;
+
+    bool passes_to_escaping_param(CallInst *call, unsigned arg_no);
+
+    map<Function *, vector<bool>> param_escapes_;
+    /** Values standing for each parameter, see get_arg_no. */
+    map<Function *, vector<vector<Value *>>> params_;
+};
+}  // namespace lightir
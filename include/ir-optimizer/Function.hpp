@@ -28,6 +28,10 @@ class Function : public Value {
     Function(FunctionType *ty, const string &name, Module *parent);
     ~Function() = default;
 
+    static bool classof(const Value *v) {
+        return v->get_value_kind() == ValueKind::Function;
+    }
+
     static Function *create(FunctionType *ty, const string &name,
                             Module *parent);
     static Function *create(bool is_ctor, FunctionType *ty, const string &name,
@@ -57,9 +61,12 @@ class Function : public Value {
 
     void set_instr_name();
     string print() override;
+    void print(std::ostream &out);
     string print_method(Class *method_);
     string print_args();
     bool is_ctor = false;
+    /** Calls never return, e.g. the error.* runtime routines which exit. */
+    bool is_noreturn = false;
 
    private:
     void build_args();
@@ -68,7 +75,6 @@ class Function : public Value {
     list<BasicBlock *> basic_blocks_; /* basic blocks */
     list<Argument *> arguments_;      /* arguments */
     Module *parent_;
-    unsigned seq_cnt_;
 };
 
 /* Argument of Function, does not contain actual value. */
@@ -77,9 +83,15 @@ class Argument : public Value {
     /* Argument constructor.*/
     explicit Argument(Type *ty, const string &name = "", Function *f = nullptr,
                       unsigned arg_no = 0)
-        : Value(ty, name), parent_(f), arg_no_(arg_no) {}
+        : Value(ty, name), parent_(f), arg_no_(arg_no) {
+        set_value_kind(ValueKind::Argument);
+    }
     ~Argument() = default;
 
+    static bool classof(const Value *v) {
+        return v->get_value_kind() == ValueKind::Argument;
+    }
+
     inline const Function *get_parent() const { return parent_; }
     inline Function *get_parent() { return parent_; }
 
@@ -25,6 +25,9 @@ class GlobalVariable : public User {
                                   ConstantBoxBool *init);
     GlobalVariable(const string &name, Module *m, Type *ty, bool is_const,
                    Constant *init);
+    static bool classof(const Value *v) {
+        return v->get_value_kind() == ValueKind::GlobalVariable;
+    }
 
     Constant *get_init() const { return init_val_; }
     string print() override;
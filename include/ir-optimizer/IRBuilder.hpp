@@ -3,6 +3,7 @@
 #include <utility>
 
 #include "BasicBlock.hpp"
+#include "Class.hpp"
 #include "Constant.hpp"
 #include "Module.hpp"
 #include "Value.hpp"
@@ -47,8 +48,8 @@ class IRBuilder {
         return UnaryInst::create_neg(lhs, this->BB_, m_);
     }
     BinaryInst *create_not(Value *lhs) {
-        return new BinaryInst(Type::get_int32_type(m_), Instruction::Sub,
-                              ConstantInt::get(true, m_), lhs, this->BB_);
+        return new (m_) BinaryInst(Type::get_int32_type(m_), Instruction::Sub,
+                                   ConstantInt::get(true, m_), lhs, this->BB_);
     }
     PhiInst *create_phi(Type *lhs) {
         return PhiInst::create_phi(lhs, this->BB_);
@@ -74,11 +75,11 @@ class IRBuilder {
     }
 
     CallInst *create_call(Value *func, vector<Value *> args) {
-        return CallInst::create(dynamic_cast<Function *>(func), std::move(args),
+        return CallInst::create(dyn_cast<Function>(func), std::move(args),
                                 this->BB_);
     }
     CallInst *create_call(Value *real_func, Type *func, vector<Value *> args) {
-        return CallInst::create(real_func, dynamic_cast<FunctionType *>(func),
+        return CallInst::create(real_func, dyn_cast<FunctionType>(func),
                                 std::move(args), this->BB_);
     }
 
@@ -90,6 +91,10 @@ class IRBuilder {
         return BranchInst::create_cond_br(cond, if_true, if_false, this->BB_);
     }
 
+    UnreachableInst *create_unreachable() {
+        return UnreachableInst::create_unreachable(this->BB_);
+    }
+
     ReturnInst *create_ret(Value *val) {
         return ReturnInst::create_ret(val, this->BB_);
     }
@@ -108,7 +113,7 @@ class IRBuilder {
         return LoadInst::create_load(ty, ptr, this->BB_);
     }
     LoadInst *create_load(Value *ptr) {
-        if (dynamic_cast<GlobalVariable *>(ptr)) {
+        if (dyn_cast<GlobalVariable>(ptr)) {
             return LoadInst::create_load(ptr->get_type(), ptr, this->BB_);
         } else {
             return LoadInst::create_load(
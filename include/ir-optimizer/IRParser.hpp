@@ -0,0 +1,26 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "Module.hpp"
+
+using std::string;
+using std::string_view;
+
+namespace lightir {
+/** Reads back the text written by Module::print, with the ModuleID and
+ * source_filename lines the drivers put in front, so that the passes can be
+ * run on a .ll file without the front end.
+ *
+ * The text does not carry everything in the module: pointers all print as
+ * ptr, so the type a pointer points to is taken from the loads, stores and
+ * getelementptrs through it in the same function (i8 if there are none),
+ * and super classes, attribute names and comments come back empty.
+ *
+ * Null on malformed input, with "line:column: message" in error. */
+std::unique_ptr<Module> parse_ir(string_view text, string *error = nullptr);
+std::unique_ptr<Module> parse_ir_file(const string &path,
+                                      string *error = nullptr);
+}  // namespace lightir
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "Module.hpp"
+
+using std::string;
+using std::string_view;
+
+namespace lightir {
+/** Binary form of a Module, to cache the optimized IR between runs.
+ *
+ *   header          "LIRB", version, key (8 bytes)
+ *   strings         every name, label and string constant, once
+ *   class shells    name, tags and labels of each class
+ *   types           each type once, in terms of earlier types and classes
+ *   function shells name, type, flags and argument names
+ *   constants       str/int/bool boxes, then bare values (e.g. argN)
+ *   globals
+ *   class bodies    super class, attributes and methods
+ *   function bodies blocks, then one record per instruction
+ *
+ * Integers are LEB128 and everything is referred to by its index in the
+ * tables above, so the reader rebuilds the module in one pass. key is
+ * chosen by the caller, e.g. parser::hash_bytes() of the input; a file
+ * written with another key or version reads as null. */
+string write_binary_ir(Module *m, uint64_t key);
+bool write_binary_ir_file(Module *m, const string &path, uint64_t key);
+
+/** Null if data is not a module written with key. */
+std::unique_ptr<Module> read_binary_ir(string_view data, uint64_t key);
+/** Maps the file and reads straight from the mapping. */
+std::unique_ptr<Module> read_binary_ir_file(const string &path, uint64_t key);
+/** The key data was written with, 0 if it is not of this version. */
+uint64_t read_binary_ir_key(string_view data);
+}  // namespace lightir
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <map>
+#include <optional>
+#include <set>
+#include <vector>
+
+#include "BasicBlock.hpp"
+#include "Constant.hpp"
+#include "Function.hpp"
+#include "Module.hpp"
+
+using std::map;
+using std::set;
+using std::vector;
+
+namespace lightir {
+/** A natural loop with a single back edge latch -> header. */
+struct Loop {
+    BasicBlock *header;
+    /** The only predecessor of header outside the loop, or nullptr. */
+    BasicBlock *preheader;
+    BasicBlock *latch;
+    /** All blocks of the loop, header included. */
+    set<BasicBlock *> blocks;
+
+    bool contains(BasicBlock *bb) const { return blocks.contains(bb); }
+    /** True if val is computed outside the loop (or is not an instruction). */
+    bool is_invariant(Value *val) const;
+};
+
+/** An affine induction variable {init, +, step}, i.e.
+ *   i = phi [init, preheader], [next, latch];  next = add i, step
+ * together with the exit test `icmp lt i, bound` guarding the loop body. */
+struct InductionVar {
+    PhiInst *phi;
+    Value *init;
+    int step;
+    BinaryInst *next;
+    CmpInst *exit_cmp;
+    Value *bound;
+    /** Number of iterations if init and bound are known, -1 otherwise. */
+    int trip_count = -1;
+};
+
+/** Finds the natural loops of a function, innermost ones first. */
+class LoopSearch {
+   public:
+    explicit LoopSearch(Function *func);
+
+    vector<Loop> &get_loops() { return loops_; }
+    /** A loop is innermost if no other loop header is inside it. */
+    bool is_innermost(const Loop &loop) const;
+
+    /** SCEV-lite: recognise the induction variable driving the exit test of
+     * the loop, as produced for `for` statements. */
+    static std::optional<InductionVar> get_induction_var(const Loop &loop);
+
+    /** Successors read off the terminator, independent of the pred/succ
+     * lists kept on BasicBlock. */
+    static vector<BasicBlock *> get_succs(BasicBlock *bb);
+
+   private:
+    Function *func_;
+    vector<Loop> loops_;
+};
+}  // namespace lightir
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <map>
+#include <vector>
+
+#include "LoopSearch.hpp"
+#include "Module.hpp"
+#include "chocopy_optimization.hpp"
+
+using std::map;
+using std::vector;
+
+namespace lightir {
+/** Unrolls innermost counted loops (those driven by an InductionVar, as
+ * emitted for `for` statements).
+ *
+ * Loops with a known, small trip count are unrolled completely. The others
+ * get a main loop running Module::unroll_factor copies of the body per
+ * compare and branch:
+ *
+ *   unroll.header:  j = phi [init, preheader], [j + factor*step, ...]
+ *                   br (j + (factor-1)*step < bound), unroll.body, unroll.exit
+ *   unroll.body:    body(j); body(j+step); ...; br unroll.header
+ *   unroll.exit:    br header
+ *
+ * and the original loop is kept to run the remaining iterations. */
+class LoopUnroll : public Pass {
+   public:
+    static constexpr const char *name = "LoopUnroll";
+
+    explicit LoopUnroll(Module *m) : Pass(m) {}
+    void run() override;
+
+    /** Upper bound on the number of instructions a loop may grow into. */
+    static constexpr int max_unrolled_size = 512;
+    static constexpr int max_full_unroll_count = 16;
+
+   private:
+    bool can_unroll(Function *func, const Loop &loop, const InductionVar &iv);
+    void unroll_fully(Function *func, const Loop &loop,
+                      const InductionVar &iv);
+    void unroll_partially(Function *func, const Loop &loop,
+                          const InductionVar &iv, int factor);
+
+    /** Copy the body of the loop (all blocks but the header) in front of
+     * pos. Uses of the induction variable are replaced by iv_val, and the
+     * back edge to the header is redirected to cont. Returns the copy of the
+     * body entry; vmap maps the original values to their copies. */
+    BasicBlock *clone_body(Function *func, const Loop &loop,
+                           const InductionVar &iv, Value *iv_val,
+                           BasicBlock *cont, BasicBlock *pos,
+                           map<Value *, Value *> &vmap);
+    vector<BasicBlock *> get_body(Function *func, const Loop &loop);
+};
+}  // namespace lightir
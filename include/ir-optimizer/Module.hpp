@@ -4,9 +4,12 @@
 #include <list>
 #include <map>
 #include <memory>
+#include <ostream>
 #include <string>
+#include <unordered_map>
 #include <utility>
 
+#include "Arena.hpp"
 #include "Class.hpp"
 #include "Function.hpp"
 #include "GlobalVariable.hpp"
@@ -26,6 +29,7 @@ class Instruction : public User {
         // Terminator Instructions
         Ret,
         Br,
+        Unreachable,
         // Standard unary operators
         Neg,
         Not,
@@ -63,9 +67,17 @@ class Instruction : public User {
      * ty here is result type */
     Instruction(Type *ty, OpID id, unsigned num_ops, BasicBlock *parent);
     Instruction(Type *ty, OpID id, unsigned num_ops);
+
+    static bool classof(const Value *v) {
+        return v->get_value_kind() >= ValueKind::FirstInstruction &&
+               v->get_value_kind() <= ValueKind::LastInstruction;
+    }
     inline const BasicBlock *get_parent() const { return parent_; }
     inline BasicBlock *get_parent() { return parent_; }
     void set_parent(BasicBlock *parent) { this->parent_ = parent; }
+    /** The position in the instruction list of the parent, kept up to date
+     * by BasicBlock so that erase and insert take constant time. */
+    list<Instruction *>::iterator get_iterator() { return pos_; }
     /** Return the function this instruction belongs to. */
     const Function *get_function() const;
     Function *get_function() {
@@ -79,6 +91,7 @@ class Instruction : public User {
 
     bool is_void() {
         return ((op_id_ == Ret) || (op_id_ == Br) || (op_id_ == Store) ||
+                (op_id_ == Unreachable) || (op_id_ == VExt) ||
                 (op_id_ == Call && this->get_type()->is_void_type()));
     }
 
@@ -88,6 +101,7 @@ class Instruction : public User {
     bool is_ret() { return op_id_ == Ret; }
     bool is_load() { return op_id_ == Load; }
     bool is_br() { return op_id_ == Br; }
+    bool is_unreachable() { return op_id_ == Unreachable; }
 
     bool is_add() { return op_id_ == Add; }
     bool is_sub() { return op_id_ == Sub; }
@@ -120,14 +134,21 @@ class Instruction : public User {
                 (op_id_ == Call && this->get_type()->is_void_type()));
     }
 
-    bool isTerminator() { return is_br() || is_ret(); }
+    bool isTerminator() { return is_br() || is_ret() || is_unreachable(); }
+
+    /** Create a copy with the same opcode, type and operands at the end of
+     * bb.  Branches are copied without updating the CFG. */
+    virtual Instruction *copy_inst(BasicBlock *bb) = 0;
 
     string print_comment() { return comment_; };
 
     void set_comment(std::string_view comment) { comment_ = comment; };
 
    private:
+    friend class BasicBlock;
+
     BasicBlock *parent_;
+    list<Instruction *>::iterator pos_;
     OpID op_id_;
     unsigned num_ops_;
     string comment_;
@@ -135,6 +156,10 @@ class Instruction : public User {
 
 class BinaryInst : public Instruction {
    public:
+    static bool classof(const Value *v) {
+        return v->get_value_kind() == ValueKind::BinaryInst;
+    }
+
     BinaryInst(Type *ty, OpID id, Value *v1, Value *v2, BasicBlock *bb);
 
    public:
@@ -167,6 +192,7 @@ class BinaryInst : public Instruction {
                                  Module *m);
 
     string print() override;
+    Instruction *copy_inst(BasicBlock *bb) override;
 
    private:
     void assert_valid();
@@ -176,9 +202,15 @@ class UnaryInst : public Instruction {
    private:
     UnaryInst(Type *ty, OpID id, Value *v, BasicBlock *bb);
 
-    UnaryInst(Type *ty, OpID id, BasicBlock *bb) : Instruction(ty, id, 1, bb) {}
+    UnaryInst(Type *ty, OpID id, BasicBlock *bb) : Instruction(ty, id, 1, bb) {
+        set_value_kind(ValueKind::UnaryInst);
+    }
 
    public:
+    static bool classof(const Value *v) {
+        return v->get_value_kind() == ValueKind::UnaryInst;
+    }
+
     /** create neg instruction, auto insert to bb */
     static UnaryInst *create_neg(Value *v, BasicBlock *bb, Module *m);
 
@@ -186,10 +218,15 @@ class UnaryInst : public Instruction {
     static UnaryInst *create_not(Value *v, BasicBlock *bb, Module *m);
 
     string print() override;
+    Instruction *copy_inst(BasicBlock *bb) override;
 };
 
 class CmpInst : public Instruction {
    public:
+    static bool classof(const Value *v) {
+        return v->get_value_kind() == ValueKind::CmpInst;
+    }
+
     enum CmpOp {
         EQ, /* == */
         NE, /* != */
@@ -209,6 +246,7 @@ class CmpInst : public Instruction {
     CmpOp get_cmp_op() { return cmp_op_; }
 
     string print() override;
+    Instruction *copy_inst(BasicBlock *bb) override;
 
    private:
     CmpOp cmp_op_;
@@ -223,16 +261,31 @@ class CallInst : public Instruction {
              BasicBlock *bb);
 
    public:
+    static bool classof(const Value *v) {
+        return v->get_value_kind() == ValueKind::CallInst;
+    }
+
     static CallInst *create(Function *func, vector<Value *> args,
                             BasicBlock *bb);
     static CallInst *create(Value *real_func, FunctionType *func,
                             std::vector<Value *> args, BasicBlock *bb);
     FunctionType *get_function_type() const;
 
+    /** True if the callee is a known function marked noreturn, e.g. the
+     * error.* runtime routines. */
+    bool is_noreturn() const;
+
+    /** Set by TailCallElim on calls whose result is returned right away and
+     * which do not need the caller's frame, printed as `tail call`. */
+    bool is_tail_call() const { return is_tail_call_; }
+    void set_tail_call(bool is_tail_call) { is_tail_call_ = is_tail_call; }
+
     string print() override;
+    Instruction *copy_inst(BasicBlock *bb) override;
 
    private:
     FunctionType *func_type_;
+    bool is_tail_call_ = false;
 };
 
 class BranchInst : public Instruction {
@@ -242,6 +295,10 @@ class BranchInst : public Instruction {
     BranchInst(BasicBlock *if_true, BasicBlock *bb);
 
    public:
+    static bool classof(const Value *v) {
+        return v->get_value_kind() == ValueKind::BranchInst;
+    }
+
     static BranchInst *create_cond_br(Value *cond, BasicBlock *if_true,
                                       BasicBlock *if_false, BasicBlock *bb);
     static BranchInst *create_br(BasicBlock *if_true, BasicBlock *bb);
@@ -250,6 +307,7 @@ class BranchInst : public Instruction {
     bool is_cmp_br() const;
 
     string print() override;
+    Instruction *copy_inst(BasicBlock *bb) override;
 };
 
 class ReturnInst : public Instruction {
@@ -258,11 +316,33 @@ class ReturnInst : public Instruction {
     explicit ReturnInst(BasicBlock *bb);
 
    public:
+    static bool classof(const Value *v) {
+        return v->get_value_kind() == ValueKind::ReturnInst;
+    }
+
     static ReturnInst *create_ret(Value *val, BasicBlock *bb);
     static ReturnInst *create_void_ret(BasicBlock *bb);
     bool is_void_ret() const;
 
     string print() override;
+    Instruction *copy_inst(BasicBlock *bb) override;
+};
+
+/** Terminates a block whose end can never be reached, e.g. after a call to a
+ * noreturn function. */
+class UnreachableInst : public Instruction {
+   private:
+    explicit UnreachableInst(BasicBlock *bb);
+
+   public:
+    static bool classof(const Value *v) {
+        return v->get_value_kind() == ValueKind::UnreachableInst;
+    }
+
+    static UnreachableInst *create_unreachable(BasicBlock *bb);
+
+    string print() override;
+    Instruction *copy_inst(BasicBlock *bb) override;
 };
 
 class StoreInst : public Instruction {
@@ -270,12 +350,17 @@ class StoreInst : public Instruction {
     StoreInst(Value *val, Value *ptr, BasicBlock *bb);
 
    public:
+    static bool classof(const Value *v) {
+        return v->get_value_kind() == ValueKind::StoreInst;
+    }
+
     static StoreInst *create_store(Value *val, Value *ptr, BasicBlock *bb);
 
     Value *get_rval() { return this->get_operand(0); }
     Value *get_lval() { return this->get_operand(1); }
 
     string print() override;
+    Instruction *copy_inst(BasicBlock *bb) override;
 };
 
 class LoadInst : public Instruction {
@@ -283,12 +368,17 @@ class LoadInst : public Instruction {
     LoadInst(Type *ty, Value *ptr, BasicBlock *bb);
 
    public:
+    static bool classof(const Value *v) {
+        return v->get_value_kind() == ValueKind::LoadInst;
+    }
+
     static LoadInst *create_load(Type *ty, Value *ptr, BasicBlock *bb);
     Value *get_lval() { return this->get_operand(0); }
 
     Type *get_load_type() const;
 
     string print() override;
+    Instruction *copy_inst(BasicBlock *bb) override;
 };
 
 class AllocaInst : public Instruction {
@@ -296,11 +386,16 @@ class AllocaInst : public Instruction {
     AllocaInst(Type *ty, BasicBlock *bb);
 
    public:
+    static bool classof(const Value *v) {
+        return v->get_value_kind() == ValueKind::AllocaInst;
+    }
+
     static AllocaInst *create_alloca(Type *ty, BasicBlock *bb);
 
     Type *get_alloca_type() const;
 
     string print() override;
+    Instruction *copy_inst(BasicBlock *bb) override;
 
    private:
     Type *alloca_ty_;
@@ -311,11 +406,16 @@ class ZextInst : public Instruction {
     ZextInst(OpID op, Value *val, Type *ty, BasicBlock *bb);
 
    public:
+    static bool classof(const Value *v) {
+        return v->get_value_kind() == ValueKind::ZextInst;
+    }
+
     static ZextInst *create_zext(Value *val, Type *ty, BasicBlock *bb);
 
     Type *get_dest_type() const;
 
     string print() override;
+    Instruction *copy_inst(BasicBlock *bb) override;
 
    private:
     Type *dest_ty_;
@@ -326,12 +426,17 @@ class InsertElementInst : public Instruction {
     InsertElementInst(OpID op, Value *val, Type *ty, BasicBlock *bb);
 
    public:
+    static bool classof(const Value *v) {
+        return v->get_value_kind() == ValueKind::InsertElementInst;
+    }
+
     static InsertElementInst *create_insert_element(Value *val, Type *ty,
                                                     BasicBlock *bb);
 
     Type *get_dest_type() const;
 
     string print() override;
+    Instruction *copy_inst(BasicBlock *bb) override;
 
    private:
     Type *dest_ty_;
@@ -342,12 +447,17 @@ class ExtractElementInst : public Instruction {
     ExtractElementInst(OpID op, Value *val, Type *ty, BasicBlock *bb);
 
    public:
+    static bool classof(const Value *v) {
+        return v->get_value_kind() == ValueKind::ExtractElementInst;
+    }
+
     static ExtractElementInst *create_extract_element(Value *val, Type *ty,
                                                       BasicBlock *bb);
 
     Type *get_dest_type() const;
 
     string print() override;
+    Instruction *copy_inst(BasicBlock *bb) override;
 
    private:
     Type *dest_ty_;
@@ -358,11 +468,16 @@ class BitCastInst : public Instruction {
     BitCastInst(OpID op, Value *val, Type *ty, BasicBlock *bb);
 
    public:
+    static bool classof(const Value *v) {
+        return v->get_value_kind() == ValueKind::BitCastInst;
+    }
+
     static BitCastInst *create_bitcast(Value *val, Type *ty, BasicBlock *bb);
 
     Type *get_dest_type() const;
 
     string print() override;
+    Instruction *copy_inst(BasicBlock *bb) override;
 
    private:
     Type *dest_ty_;
@@ -373,11 +488,16 @@ class PtrToIntInst : public Instruction {
     PtrToIntInst(OpID op, Value *val, Type *ty, BasicBlock *bb);
 
    public:
+    static bool classof(const Value *v) {
+        return v->get_value_kind() == ValueKind::PtrToIntInst;
+    }
+
     static PtrToIntInst *create_ptrtoint(Value *val, Type *ty, BasicBlock *bb);
 
     Type *get_dest_type() const;
 
     string print() override;
+    Instruction *copy_inst(BasicBlock *bb) override;
 
    private:
     Type *dest_ty_;
@@ -388,11 +508,16 @@ class TruncInst : public Instruction {
     TruncInst(OpID op, Value *val, Type *ty, BasicBlock *bb);
 
    public:
+    static bool classof(const Value *v) {
+        return v->get_value_kind() == ValueKind::TruncInst;
+    }
+
     static TruncInst *create_trunc(Value *val, Type *ty, BasicBlock *bb);
 
     Type *get_dest_type() const;
 
     string print() override;
+    Instruction *copy_inst(BasicBlock *bb) override;
 
    private:
     Type *dest_ty_;
@@ -400,11 +525,17 @@ class TruncInst : public Instruction {
 
 class GetElementPtrInst : public Instruction {
    public:
+    static bool classof(const Value *v) {
+        return v->get_value_kind() == ValueKind::GetElementPtrInst;
+    }
+
     GetElementPtrInst(Value *ptr, Value *idx, BasicBlock *bb);
     GetElementPtrInst(Value *ptr, Value *idx);
     GetElementPtrInst(Type *ty, unsigned num_ops, BasicBlock *bb, Type *elem_ty)
         : Instruction(ty, Instruction::GEP, num_ops, bb),
-          element_ty_(elem_ty) {}
+          element_ty_(elem_ty) {
+        set_value_kind(ValueKind::GetElementPtrInst);
+    }
 
     static Type *get_element_type(Value *ptr, Value *idx);
     static GetElementPtrInst *create_gep(Value *ptr, Value *idx,
@@ -414,9 +545,9 @@ class GetElementPtrInst : public Instruction {
     Value *get_idx() const;
 
     string print() override;
+    Instruction *copy_inst(BasicBlock *bb) override;
 
    private:
-    Value *idx{};
     Type *element_ty_;
 };
 
@@ -425,10 +556,16 @@ class PhiInst : public Instruction {
     PhiInst(vector<Value *> vals, vector<BasicBlock *> val_bbs, Type *ty,
             BasicBlock *bb);
     PhiInst(Type *ty, OpID op, unsigned num_ops, BasicBlock *bb)
-        : Instruction(ty, op, num_ops, bb) {}
+        : Instruction(ty, op, num_ops, bb) {
+        set_value_kind(ValueKind::PhiInst);
+    }
     Value *l_val_{};
 
    public:
+    static bool classof(const Value *v) {
+        return v->get_value_kind() == ValueKind::PhiInst;
+    }
+
     static PhiInst *create_phi(Type *ty, BasicBlock *bb);
     Value *get_lval() { return l_val_; }
     void set_lval(Value *l_val) { l_val_ = l_val; }
@@ -437,6 +574,7 @@ class PhiInst : public Instruction {
         this->add_operand(pre_bb);
     }
     string print() override;
+    Instruction *copy_inst(BasicBlock *bb) override;
 };
 
 class AsmInst : public Instruction {
@@ -447,12 +585,64 @@ class AsmInst : public Instruction {
     string asm_str_;
 
    public:
+    static bool classof(const Value *v) {
+        return v->get_value_kind() == ValueKind::AsmInst;
+    }
+
     string print() override;
+    Instruction *copy_inst(BasicBlock *bb) override;
     string get_asm() { return asm_str_; };
     static AsmInst *create_asm(Module *m, const string &asm_str,
                                BasicBlock *bb);
 };
 
+/** An element-wise loop over arrays of i32, built by Vectorize and lowered
+ * by the backend to a strip-mined RVV loop:
+ *
+ *   for k in [0, count): dst[k] = expr(k)
+ *
+ * The operands are count, dst and then the leaves of expr: i32 pointers,
+ * read element by element (streams), and i32 values (scalars). expr is kept
+ * in postfix order, the last node being the value stored.
+ *
+ *   vext i32 %count, i32* %dst = add(vle(i32* %a), mul(vle(i32* %b), i32 3))
+ */
+class VExtInst : public Instruction {
+   public:
+    static bool classof(const Value *v) {
+        return v->get_value_kind() == ValueKind::VExtInst;
+    }
+
+    enum class NodeKind { Stream, Scalar, Add, Sub, Mul };
+    struct Node {
+        NodeKind kind;
+        /** the operand read by a stream or scalar, the left node otherwise */
+        unsigned lhs;
+        unsigned rhs = 0;
+    };
+
+    /** The backend keeps all pointers and scalars in temporary registers,
+     * and each node in a vector register of its own. */
+    static constexpr unsigned max_leaves = 4;
+    static constexpr unsigned max_nodes = 31;
+
+    static VExtInst *create_vext(Value *count, Value *dst,
+                                 const vector<Value *> &leaves,
+                                 vector<Node> program, BasicBlock *bb);
+
+    const vector<Node> &get_program() const { return program_; }
+
+    string print() override;
+    Instruction *copy_inst(BasicBlock *bb) override;
+
+   private:
+    VExtInst(Value *count, Value *dst, const vector<Value *> &leaves,
+             vector<Node> program, BasicBlock *bb);
+    string print_node(unsigned idx);
+
+    vector<Node> program_;
+};
+
 class Function;
 class GlobalVariable;
 class Class;
@@ -466,22 +656,34 @@ class Module {
     Type *get_label_type();
     IntegerType *get_int1_type();
     IntegerType *get_int32_type();
+    TypeContext &get_type_context() { return type_context_; }
+    Arena &get_arena() { return arena_; }
+    /** The constants of the module, each created once. */
+    ConstantInt *get_constant_int(IntegerType *ty, int val);
+    ConstantNull *get_constant_null(Type *ty);
 
     void add_function(Function *f);
-    list<Function *> get_functions();
+    const list<Function *> &get_functions() const { return function_list_; }
+    /** The function last added with this name, or null. */
+    Function *get_function(const string &name) const;
     void add_global_variable(GlobalVariable *g);
-    list<GlobalVariable *> get_global_variable();
+    const list<GlobalVariable *> &get_global_variable() const {
+        return global_list_;
+    }
     void add_class(Class *c);
-    list<Class *> get_class();
+    const list<Class *> &get_class() const { return class_list_; }
     string get_instr_op_name(Instruction::OpID instr) {
         return instr_id2string_[instr];
     }
     void set_print_name();
     virtual string print();
+    /** Writes the module one line at a time, without holding it all. */
+    void print(std::ostream &out);
     string module_name_;      /* Human-readable identifier for the module */
     string source_file_name_; /* Original source file name for module, for test
                                  and debug */
     int vectorize_num = 4;
+    int unroll_factor = 4;
     int thread_num = 4;
     bool is_declaration_ = false;
 
@@ -490,8 +692,23 @@ class Module {
         global_list_;                /* The Global Variables in the module */
     list<Function *> function_list_; /* The Functions in the module */
     list<Class *> class_list_;       /* The Functions in the module */
+    std::unordered_map<string, Function *>
+        function_index_; /* The Functions by name */
     map<Instruction::OpID, string>
         instr_id2string_; /* Instruction from opid to string */
+    /** Declared first, so that its memory outlives the rest of the module. */
+    Arena arena_;
+    TypeContext type_context_;
+    struct ConstantIntKeyHash {
+        size_t operator()(const std::pair<Type *, int> &key) const {
+            return std::hash<Type *>()(key.first) ^
+                   std::hash<int>()(key.second) * 31;
+        }
+    };
+    std::unordered_map<std::pair<Type *, int>, ConstantInt *,
+                       ConstantIntKeyHash>
+        int_constants_;
+    std::unordered_map<Type *, ConstantNull *> null_constants_;
     IntegerType *int1_ty_;
     IntegerType *int32_ty_;
     Type *label_ty_;
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Class.hpp"
+#include "EscapeAnalysis.hpp"
+#include "Function.hpp"
+#include "Module.hpp"
+#include "chocopy_optimization.hpp"
+
+namespace lightir {
+/** Moves objects which do not escape the function creating them from the
+ * heap to its frame.
+ *
+ * `alloc_object(C$prototype)` becomes an `alloca C` filled with a copy of
+ * the prototype. If the object is only used to read and write its
+ * attributes (besides the None checks and the call to the default
+ * constructor), each attribute gets an alloca of its own instead, and the
+ * object itself disappears.
+ *
+ * An object created inside a loop is only moved if it cannot be alive in
+ * the next iteration, i.e. it is never stored to a variable. */
+class StackAlloc : public Pass {
+   public:
+    static constexpr const char *name = "StackAlloc";
+
+    explicit StackAlloc(Module *m) : Pass(m) {}
+    void run() override;
+
+   private:
+    /** The class instantiated by call, if it is an alloc_object. */
+    static Class *get_allocated_class(CallInst *call);
+
+    bool replace_scalars(Function *func, CallInst *call, Class *cls);
+    void allocate_on_stack(Function *func, CallInst *call, Class *cls);
+
+    /** Copy word idx of the prototype proto points to into dst, in front of
+     * pos. */
+    void copy_prototype_word(Value *proto, int idx, Value *dst,
+                             Instruction *pos);
+};
+}  // namespace lightir
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+
+#include "Function.hpp"
+#include "Module.hpp"
+#include "chocopy_optimization.hpp"
+
+using std::vector;
+
+namespace lightir {
+/** Finds calls in tail position, i.e. `%r = call f(...)` directly followed
+ * by `ret %r`.
+ *
+ * A function calling itself in tail position is turned into a loop: the
+ * entry block keeps the allocas and the spills of the arguments, the rest of
+ * it moves to a new block, and each recursive call stores its arguments
+ * into the argument slots and branches back to that block.
+ *
+ * Other tail calls are marked with CallInst::set_tail_call, so that the
+ * backend can tear down the frame and jump to the callee. This is only done
+ * when the address of no alloca escapes, since the callee could otherwise
+ * still reach into the freed frame. */
+class TailCallElim : public Pass {
+   public:
+    static constexpr const char *name = "TailCallElim";
+
+    explicit TailCallElim(Module *m) : Pass(m) {}
+    void run() override;
+
+   private:
+    /** Returns the call if inst is a call followed by the return of its
+     * value, nullptr otherwise. */
+    static CallInst *get_tail_call(Instruction *inst, Instruction *next);
+    static bool frame_escapes(Function *func);
+    /** True if val is an alloca of the current frame, possibly offset or
+     * cast. */
+    static bool is_frame_address(Value *val);
+
+    void eliminate_self_recursion(Function *func,
+                                  const vector<CallInst *> &calls);
+};
+}  // namespace lightir
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <iostream>
+#include <memory>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -18,6 +20,12 @@ class FunctionType;
 class PtrType;
 class Class;
 class ConstantArray;
+class LabelType;
+class VoidType;
+
+/** The concrete class of a Type, for Casting.hpp. The type id can not tell
+ * them apart, as the ids of classes overlap with those of builtin types. */
+enum class TypeKind { Type, Integer, Function, Ptr, Label, Void, Class };
 
 class Type {
    public:
@@ -35,10 +43,12 @@ class Type {
         CLASS
     };
 
-    explicit Type(type tid, Module *m);
-    explicit Type(type tid) : Type(tid, nullptr){};
+    explicit Type(type tid, Module *m, TypeKind kind = TypeKind::Type);
     virtual ~Type() = default;
 
+    TypeKind get_type_kind() const { return kind_; }
+    static bool classof(const Type *) { return true; }
+
     constexpr int get_type_id() const { return get_underlying<type>(tid_); }
 
     constexpr bool is_class_anon() const { return tid_ == type::CLASS_ANON; }
@@ -86,84 +96,148 @@ class Type {
     std::strong_ordering operator<=>(Type rhs);
    private:
     const type tid_;
+    const TypeKind kind_;
     Module *m_;
 };
 
 class IntegerType : public Type {
    public:
-    explicit IntegerType(unsigned num_bits, Module *m);
-
     static IntegerType *get(unsigned num_bits, Module *m);
 
     unsigned get_num_bits() const;
+    static bool classof(const Type *t) {
+        return t->get_type_kind() == TypeKind::Integer;
+    }
 
     virtual string print() { return fmt::format("i{}", get_num_bits()); }
 
    private:
+    friend class TypeContext;
+    explicit IntegerType(unsigned num_bits, Module *m);
+
     unsigned num_bits_;
 };
 
 class FunctionType : public Type {
    public:
-    FunctionType(Type *result, const vector<Type *> &params);
-
     static FunctionType *get(Type *result, const vector<Type *> &params);
 
     static FunctionType *get(Type *result, const vector<Type *> &params,
                              bool is_variable_args);
 
     unsigned get_num_of_args() const;
+    static bool classof(const Type *t) {
+        return t->get_type_kind() == TypeKind::Function;
+    }
 
     Type *get_param_type(unsigned i) const;
-    vector<Type *>::iterator param_begin() { return args_.begin(); }
-    vector<Type *>::iterator param_end() { return args_.end(); }
+    const vector<Type *> &get_params() const { return args_; }
     Type *get_return_type() const;
     Type *get_arg_type(unsigned i) const;
 
     virtual string print();
-    bool is_variable_args = false;
+    /** Types are shared, so this never changes once created. */
+    const bool is_variable_args;
+
+   private:
+    friend class TypeContext;
+    FunctionType(Type *result, const vector<Type *> &params,
+                 bool is_variable_args);
 
-   public:
     Type *result_;
     vector<Type *> args_;
 };
 
 class PtrType : public Type {
    public:
-    explicit PtrType( Type *Contained);
     static PtrType *get(Type *contained);
 
     Type *get_element_type() const { return contained_; }
+    static bool classof(const Type *t) {
+        return t->get_type_kind() == TypeKind::Ptr;
+    }
 
     virtual string print();
 
    private:
+    friend class TypeContext;
+    explicit PtrType(Type *contained);
+
     Type *contained_;   // The element type of the array.
 };
 
 class LabelType : public Type {
    public:
-    explicit LabelType(string str_, Class *stored_, Module *m);
-
-    static LabelType *get(string str_, Class *stored_, Module *m);
+    static LabelType *get(const string &label, Class *stored, Module *m);
 
     string get_label() const;
+    static bool classof(const Type *t) {
+        return t->get_type_kind() == TypeKind::Label;
+    }
     Class *get_class() const { return stored_; };
 
     virtual string print() { return "%" + label_; }
 
    private:
+    friend class TypeContext;
+    explicit LabelType(string label, Class *stored, Module *m);
+
     string label_;
     Class *stored_;
 };
 
 class VoidType : public Type {
    public:
-    explicit VoidType(Module *m) : Type(Type::type::VOID, m){};
-
-    static VoidType *get(Module *m) { return new VoidType(m); };
+    static VoidType *get(Module *m);
+    static bool classof(const Type *t) {
+        return t->get_type_kind() == TypeKind::Void;
+    }
 
     virtual string print() { return "void"; }
+
+   private:
+    friend class TypeContext;
+    explicit VoidType(Module *m) : Type(Type::type::VOID, m, TypeKind::Void){};
+};
+
+/** Owns the types of a module and creates each of them only once, so that
+ * two types are equal iff they are the same object. Classes are types as
+ * well, but those are created by LightWalker and live on their own. */
+class TypeContext {
+   public:
+    explicit TypeContext(Module *m);
+    TypeContext(const TypeContext &) = delete;
+    TypeContext &operator=(const TypeContext &) = delete;
+
+    VoidType *get_void_type() { return void_ty_.get(); }
+    Type *get_label_type() { return label_ty_.get(); }
+    IntegerType *get_int_type(unsigned num_bits);
+    PtrType *get_ptr_type(Type *contained);
+    FunctionType *get_function_type(Type *result, const vector<Type *> &params,
+                                    bool is_variable_args);
+    LabelType *get_label_type(const string &label, Class *stored);
+
+   private:
+    struct FunctionKey {
+        Type *result;
+        vector<Type *> params;
+        bool is_variable_args;
+
+        bool operator==(const FunctionKey &) const = default;
+    };
+    struct FunctionKeyHash {
+        size_t operator()(const FunctionKey &key) const;
+    };
+
+    Module *m_;
+    std::unique_ptr<VoidType> void_ty_;
+    std::unique_ptr<Type> label_ty_;
+    std::unordered_map<unsigned, std::unique_ptr<IntegerType>> int_types_;
+    std::unordered_map<Type *, std::unique_ptr<PtrType>> ptr_types_;
+    std::unordered_map<FunctionKey, std::unique_ptr<FunctionType>,
+                       FunctionKeyHash>
+        function_types_;
+    std::unordered_map<string, std::unique_ptr<LabelType>> label_types_;
 };
 
 }  // namespace lightir
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <optional>
 #include <vector>
 
 #include "Value.hpp"
@@ -12,6 +13,11 @@ class User : public Value {
     explicit User(Type *ty, const string &name = "", unsigned num_ops_ = 0);
     ~User() = default;
 
+    static bool classof(const Value *v) {
+        return v->get_value_kind() >= ValueKind::FirstUser &&
+               v->get_value_kind() <= ValueKind::LastUser;
+    }
+
     vector<Value *> &get_operands();
 
     /* The operand starts from 0 */
@@ -20,12 +26,20 @@ class User : public Value {
     void add_operand(Value *v);
 
     unsigned get_num_operand() const;
+    /** True if operand i is set and its use list still holds this user, at
+     * the position kept for it. */
+    bool is_use_linked(unsigned i) const;
 
     void remove_use_of_ops();
     void remove_operands(int index1, int index2);
 
    private:
+    /** Unlink the use of operand i, if it is set. */
+    void remove_use_of_op(unsigned i);
+
     vector<Value *> operands_;
+    /** For each operand, its entry in the use list of the operand. */
+    vector<std::optional<list<Use>::iterator>> uses_;
     unsigned num_ops_;
 };
 }  // namespace lightir
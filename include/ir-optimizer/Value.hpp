@@ -5,10 +5,13 @@
 #include <string>
 #include <utility>
 
+#include "Casting.hpp"
+
 using std::list;
 using std::string;
 
 namespace lightir {
+class Module;
 class Type;
 class Value;
 
@@ -18,11 +21,66 @@ struct Use {
     Use(Value *val, unsigned no) : val_(val), arg_no_(no) {}
 };
 
+/** The concrete class of a Value, for isa, cast and dyn_cast in
+ * Casting.hpp. Each range of subclasses is kept contiguous. */
+enum class ValueKind {
+    Value,
+    Argument,
+    BasicBlock,
+    Function,
+    AttrInfo,
+    Class,
+    List,
+    // Users
+    GlobalVariable,
+    // Constants
+    ConstantStr,
+    ConstantInt,
+    ConstantBoxInt,
+    ConstantBoxBool,
+    ConstantNull,
+    // Instructions
+    BinaryInst,
+    UnaryInst,
+    CmpInst,
+    CallInst,
+    BranchInst,
+    ReturnInst,
+    UnreachableInst,
+    StoreInst,
+    LoadInst,
+    AllocaInst,
+    ZextInst,
+    InsertElementInst,
+    ExtractElementInst,
+    BitCastInst,
+    PtrToIntInst,
+    TruncInst,
+    GetElementPtrInst,
+    PhiInst,
+    AsmInst,
+    VExtInst,
+
+    FirstUser = GlobalVariable,
+    LastUser = VExtInst,
+    FirstConstant = ConstantStr,
+    LastConstant = ConstantNull,
+    FirstInstruction = BinaryInst,
+    LastInstruction = VExtInst,
+};
+
+/** Values live in the arena of their module, see Arena. */
 class Value {
    public:
     Value(Type *ty, string name);
     Value(Type *ty) : Value(ty, ""){};
-    ~Value() = default;
+    virtual ~Value() = default;
+
+    static void *operator new(size_t size, Module *m);
+    static void operator delete(void *, Module *) {}
+
+    ValueKind get_value_kind() const { return kind_; }
+    static bool classof(const Value *) { return true; }
 
     Type *get_type() const { return type_; }
 
@@ -30,7 +88,9 @@ class Value {
 
     list<Use> &get_use_list() { return use_list_; }
 
-    void add_use(Value *val, unsigned arg_no = 0);
+    /** Return the position of the new use, which User keeps to unlink it in
+     * constant time. */
+    list<Use>::iterator add_use(Value *val, unsigned arg_no = 0);
 
     bool set_name(string name) {
         name_ = std::move(name);
@@ -40,7 +100,8 @@ class Value {
     virtual string get_name();
 
     void replace_all_use_with(Value *new_val);
-    void remove_use(Value *val);
+    /** Called by User, which owns the position of each of its uses. */
+    void remove_use(list<Use>::iterator use) { use_list_.erase(use); }
 
     virtual string print() { return ""; };
 
@@ -48,7 +109,15 @@ class Value {
     string name_; /* The name field to put on */
     bool should_load = false;
 
+   protected:
+    /** Only the arena frees values, all at once. */
+    static void operator delete(void *) {}
+
+    /** Called by the constructor of each concrete subclass. */
+    void set_value_kind(ValueKind kind) { kind_ = kind; }
+
    private:
+    ValueKind kind_ = ValueKind::Value;
     list<Use> use_list_; /* The list contains people who call the value */
 };
 }  // namespace lightir
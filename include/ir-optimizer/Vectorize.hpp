@@ -0,0 +1,96 @@
+#pragma once
+
+#include <map>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "LoopSearch.hpp"
+#include "Module.hpp"
+#include "chocopy_optimization.hpp"
+
+using std::map;
+using std::vector;
+
+namespace lightir {
+/** Vectorizes element-wise loops over [int] lists, such as
+ *
+ *   while i < n:
+ *       c[i] = a[i] + k * b[i]
+ *       i = i + 1
+ *
+ * Every list is indexed by the counter alone, so the iterations are
+ * independent and each assignment becomes a VExtInst over [i, n), which the
+ * backend runs as a strip-mined RVV loop. The null and bounds checks of the
+ * body are replaced by a test in front of the loop:
+ *
+ *   vector.check:  0 <= i <= n, and for each list: not None and len >= n
+ *   vector.body:   vext ...; i = n; br exit
+ *
+ * and the original loop is kept to run when the test fails, so that it
+ * reports the error. */
+class Vectorize : public Pass {
+   public:
+    static constexpr const char *name = "Vectorize";
+
+    explicit Vectorize(Module *m) : Pass(m) {}
+    void run() override;
+
+   private:
+    /** What a value computed in the loop stands for. */
+    enum class Kind {
+        Invariant,  // the same on every iteration, and safe to compute early
+        Index,      // i
+        Next,       // i + 1
+        Elts,       // &list.__elts__
+        Array,      // list.__elts__
+        Elem,       // &list[i]
+        Int,        // list[i], or an int computed from list elements
+        Len,        // len(list)
+        Check,      // an error test on list
+    };
+    struct Info {
+        Kind kind;
+        Value *list = nullptr;
+    };
+    /** `list[i] = expr`, the store and the VExtInst it turns into. */
+    struct Assign {
+        StoreInst *store;
+        vector<VExtInst::Node> program;
+        /** the streams and scalars of program, as computed in the loop */
+        vector<Value *> leaves;
+    };
+    struct Plan {
+        Value *counter;
+        Value *bound;
+        BasicBlock *exit;
+        vector<Assign> assigns;
+        /** the lists accessed, with len(list) as computed in the loop */
+        vector<std::pair<Value *, Value *>> lists;
+    };
+
+    std::optional<Plan> analyze(const Loop &loop);
+    bool classify(Instruction *inst, Value *counter, const Loop &loop);
+    const Info *get_info(Value *val, const Loop &loop);
+    bool is_invariant(Value *val, const Loop &loop);
+    /** Add the nodes computing val to the program of assign. The list
+     * elements read must not be older than position min_pos, for the
+     * assignments in front of it have been done by then. Returns the index
+     * of the node, -1 if val cannot be vectorized. */
+    int add_node(Assign &assign, Value *val, unsigned min_pos,
+                 const Loop &loop, map<Value *, unsigned> &leaf_of,
+                 map<Value *, unsigned> &node_of);
+
+    void vectorize(Function *func, const Loop &loop, const Plan &plan);
+    /** Copy the computation of val in the loop to the end of bb. */
+    Value *materialize(Value *val, BasicBlock *bb, const Loop &loop,
+                       map<Value *, Value *> &vmap);
+
+    map<Value *, Info> info_;
+    /** position of each instruction in the iteration */
+    map<Value *, unsigned> pos_;
+    /** the lists accessed, in order, and len() of each */
+    vector<Value *> lists_;
+    map<Value *, Value *> len_of_;
+};
+}  // namespace lightir
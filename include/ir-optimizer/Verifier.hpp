@@ -0,0 +1,69 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "BasicBlock.hpp"
+#include "Function.hpp"
+#include "Module.hpp"
+
+using std::map;
+using std::set;
+using std::string;
+using std::string_view;
+
+namespace lightir {
+/** Checks the invariants the passes rely on and have to keep:
+ *
+ *  - each instruction sits in the block it names as parent, at the
+ *    position it keeps for constant time removal;
+ *  - a non-empty block ends in a terminator, except the last block of a
+ *    constructor, which the printer closes with unreachable. Code after a
+ *    ret or unreachable is allowed: the front end leaves the rest of the
+ *    statements there, and an empty block after an if whose branches all
+ *    return. A br ends its block;
+ *  - the pred/succ lists of the blocks match the branches;
+ *  - phis come first in their block and have one (value, block) pair for
+ *    each predecessor;
+ *  - every operand is set, its use list holds the user, and the use list
+ *    of each instruction, argument and block only holds users that are
+ *    instructions of the same function;
+ *  - an instruction of the function used in its own block is defined
+ *    before the use, unless the user is a phi.
+ *
+ * Dominance across blocks is not checked.
+ *
+ *   Verifier verifier;
+ *   if (!verifier.verify(m)) std::cerr << verifier.get_errors();
+ */
+class Verifier {
+   public:
+    /** Checks every function with a body. */
+    bool verify(Module *m);
+    bool verify(Function *func);
+
+    /** One line per problem found since the verifier was created. */
+    const string &get_errors() const { return errors_; }
+
+   private:
+    void check_block(BasicBlock *bb);
+    void check_cfg(BasicBlock *bb);
+    void check_phi(PhiInst *phi);
+    void check_operands(Instruction *inst);
+    void check_users(Value *val);
+
+    void fail(BasicBlock *bb, Value *val, string_view message);
+
+    Function *func_ = nullptr;
+    set<BasicBlock *> blocks_;
+    /** The blocks branching to each block, from the terminators. */
+    map<BasicBlock *, set<BasicBlock *>> preds_;
+    /** The position of each instruction of func_ in its block. */
+    std::unordered_map<Instruction *, int> index_;
+    bool ok_ = true;
+    string errors_;
+};
+}  // namespace lightir
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <regex>
 
@@ -12,11 +13,51 @@
 #include "SymbolType.hpp"
 #include "Type.hpp"
 #include "chocopy_ast.hpp"
+#include "chocopy_optimization.hpp"
 #include "chocopy_semant.hpp"
 
 const std::regex to_class_replace("\\$(.+?)+__init__\\.");
 
 void print_help(const string_view &exe_name);
+/** The path the outputs are named after without -o: input_path without
+ * its .py, or without its .ll or .lirb and with .opt, so that such an input
+ * is never written over with the new IR. */
+string target_of(const string &input_path);
+
+/** What the drivers are asked for on the command line, past the paths. */
+struct CompileOptions {
+    /** the names given to -pass, all known to PassManager */
+    vector<string> passes;
+    int unroll_factor = 0;
+    bool ir_cache = false;
+    bool ast_cache = false;
+    bool verify = false;
+};
+
+/** Key of the IR cached by tool for input_path: a change to the source, the
+ * passes or the sources of the compiler misses the cache. */
+uint64_t ir_cache_key(string_view tool, const string &input_path,
+                      const CompileOptions &options);
+/** Writes the IR of m to <target_path>.ll if to_file and to stdout if
+ * to_stdout, as it is printed rather than built up as one string first.
+ * Does nothing if neither is asked for. */
+void write_ir(lightir::Module *m, const string &target_path, bool to_file,
+              bool to_stdout);
+/** The module of a ChocoPy program, of the LightIR in a .ll file or of the
+ * module in a .lirb file. Null after printing the error if there is one.
+ * With ast_cache, the checked program comes from and goes to
+ * <input_path>.astb, see semantic::check. */
+std::shared_ptr<lightir::Module> load_module(const string &input_path,
+                                             bool ast_cache = false);
+/** The module of input_path after the passes add_first adds, then those of
+ * options. With options.ir_cache, it is read from <target_path>.lirb if
+ * tool wrote it there under the same ir_cache_key, which skips the front
+ * end and the passes, and written there otherwise. Null after printing the
+ * error if the program has one. */
+std::shared_ptr<lightir::Module> compile_module(
+    string_view tool, const string &input_path, const string &target_path,
+    const CompileOptions &options,
+    const std::function<void(lightir::PassManager &)> &add_first = nullptr);
 
 namespace semantic {
 class SymbolTable;
@@ -68,8 +109,8 @@ class ScopeAnalyzer {
         for (auto s = inner.rbegin(); s != inner.rend(); s++) {
             auto iter = s->find(name);
             if (iter != s->end()) {
-                if (!dynamic_cast<Function *>(iter->second) ||
-                    ((dynamic_cast<Function *>(iter->second))->get_args())
+                if (!dyn_cast<Function>(iter->second) ||
+                    ((dyn_cast<Function>(iter->second))->get_args())
                             .front()
                             ->get_type()
                             ->get_type_id() == ty->get_type_id()) {
@@ -105,13 +146,13 @@ class ScopeAnalyzer {
         Value *store = nullptr;
         for (auto &&s : inner[inner.size() - 2]) {
             if (s.first.starts_with("$class.anon")) {
-                to_find_class = dynamic_cast<Class *>(s.second);
+                to_find_class = dyn_cast<Class>(s.second);
             }
         }
         if (to_find_class == nullptr) {
             for (auto &&s : inner[inner.size() - 1]) {
                 if (s.first.starts_with("$class.anon")) {
-                    to_find_class = dynamic_cast<Class *>(s.second);
+                    to_find_class = dyn_cast<Class>(s.second);
                 }
             }
         }
@@ -191,11 +232,6 @@ class LightWalker : public ast::Visitor {
     unique_ptr<IRBuilder> builder;
 
     int next_const_id = 1;
-    int get_next_type_id();
-
-    // 1 for int, 2 for bool, 3 for str, >= 4 for user-defined classes
-    // check "ChocoPy RISC-V Implementation Guide" 4.1 Object layout
-    int next_type_id = 4;
     int get_const_type_id();
 
     // assign a unique name to each function
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "Function.hpp"
+#include "Module.hpp"
+#include "Verifier.hpp"
+
+using std::string;
+using std::vector;
+
+namespace lightir {
+/** A Pass takes the module, walks its functions and basic blocks and either
+ * collects information about them or transforms their instructions. */
+class Pass {
+   public:
+    explicit Pass(Module *m) : m_(m) {}
+    virtual ~Pass() = default;
+
+    virtual void run() = 0;
+
+    /** The functions changed by the last run. */
+    const std::unordered_set<Function *> &get_changed() const {
+        return changed_;
+    }
+
+   protected:
+    /** Recompute the pred/succ lists of every block from the terminators,
+     * after a pass has rewired branches. Also marks func as changed. */
+    void rebuild_cfg(Function *func);
+    /** Passes report each function they change, so that the verifier only
+     * checks those again. */
+    void set_changed(Function *func) { changed_.insert(func); }
+
+    Module *m_;
+
+   private:
+    friend class PassManager;
+
+    std::unordered_set<Function *> changed_;
+};
+
+/** The incoming arguments of a function are referred to by bare values
+ * named argN, see LightWalker::visit(parser::FuncDef &). Returns N, or -1
+ * if val is not one of them. */
+int get_arg_no(Value *val, unsigned num_args);
+
+/** Registers passes and runs them in the order they were added.
+ *
+ *   PassManager pm(module.get());
+ *   pm.add_Pass<LoopUnroll>(emit);  // print the IR after the pass if emit
+ *   pm.run();
+ *
+ * The module is checked by a Verifier before the first pass and after
+ * each pass, which aborts with the problems found if it is broken. */
+class PassManager {
+   public:
+    /** What is verified after a pass: nothing, the functions the pass
+     * changed, or every function. Debug builds default to Changed. */
+    enum class Verify { None, Changed, All };
+
+    explicit PassManager(Module *m) : m_(m) {}
+
+    template <typename PassType>
+    void add_Pass(bool emit = false) {
+        passes_.push_back({std::make_unique<PassType>(m_), PassType::name,
+                           emit});
+    }
+    /** Register a pass by the name given to `-pass`.
+     * return false if there is no pass with this name */
+    bool add_Pass(const string &name, bool emit = false);
+    /** Whether `-pass` can name a pass this way. */
+    static bool has_Pass(const string &name);
+
+    void set_verify(Verify verify) { verify_ = verify; }
+
+    void run();
+
+   private:
+    struct Entry {
+        std::unique_ptr<Pass> pass;
+        const char *name;
+        bool emit;
+    };
+    /** Aborts if the verifier found problems, after printing them. */
+    static void check(bool ok, const Verifier &verifier, string_view when);
+
+    vector<Entry> passes_;
+    Module *m_;
+#ifdef NDEBUG
+    Verify verify_ = Verify::None;
+#else
+    Verify verify_ = Verify::Changed;
+#endif
+};
+}  // namespace lightir
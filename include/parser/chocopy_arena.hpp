@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace parser {
+/** Memory for objects which are never freed one by one: it is carved out
+ * of large blocks, which all go away with the allocator. The AST of a
+ * program and the IR of a module each live in one. */
+class BumpAllocator {
+   public:
+    BumpAllocator() = default;
+    BumpAllocator(const BumpAllocator &) = delete;
+    BumpAllocator &operator=(const BumpAllocator &) = delete;
+
+    void *allocate(size_t size);
+
+    size_t get_allocated_size() const { return allocated_size_; }
+
+   private:
+    static constexpr size_t block_size = 64 * 1024;
+
+    std::vector<std::unique_ptr<std::byte[]>> blocks_;
+    std::byte *cur_ = nullptr;
+    std::byte *end_ = nullptr;
+    size_t allocated_size_ = 0;
+};
+
+/** Bump allocator for the AST of a program and the text of its literals.
+ *
+ * While an Arena::Scope is alive, the nodes created on its thread come from
+ * the arena. They are still owned and destroyed through their unique_ptrs,
+ * but their memory is only returned when the arena goes away, which the
+ * Program they belong to keeps alive. */
+class Arena : public BumpAllocator {
+   public:
+    /** A NUL terminated copy of len chars, of which the caller fills in
+     * what it needs. */
+    char *allocate_string(size_t len);
+
+    /** The arena of the innermost scope on this thread, or null. */
+    static Arena *current();
+
+    /** Makes arena the current one for its lifetime. */
+    class Scope {
+       public:
+        explicit Scope(Arena *arena);
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+        ~Scope();
+
+       private:
+        Arena *outer_;
+    };
+};
+}  // namespace parser
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <cstdint>
+#include <cstdio>
 #include <iostream>
 #include <memory>
+#include <string_view>
 #include <vector>
 
 #include "chocopy_parse.hpp"
@@ -47,7 +50,30 @@ class WhileStmt;
 
 }  // namespace parser
 
+/** Parses the file at input_path, or stdin if it is null. Each call has a
+ * scanner and parser state of its own, so files can be parsed from several
+ * threads at once. A regular file is mapped and scanned in place. */
 std::unique_ptr<parser::Program> parse(const char *input_path);
+/** Parses what is left in input, which stays open. */
+std::unique_ptr<parser::Program> parse(FILE *input);
+/** Parses source held in memory, e.g. sent to a compile service, without
+ * going through a file or copying it. base holds the source followed by
+ * two NULs, which size counts, and is scanned in place, so it has to be
+ * writable; it is as it was when this returns. name stands for the file in
+ * the messages. For lines of a larger source, the first of them is
+ * numbered first_line and the nodes go to arena, the one of the program
+ * they come from. */
+std::unique_ptr<parser::Program> parse_buffer(
+    char *base, size_t size, std::string_view name,
+    std::shared_ptr<parser::Arena> arena = nullptr, int first_line = 1);
+/** The same for source that has no room for the NULs, which is copied. */
+std::unique_ptr<parser::Program> parse_buffer(
+    std::string_view source, std::string_view name,
+    std::shared_ptr<parser::Arena> arena = nullptr, int first_line = 1);
+/** Runs the scanner alone over base, as parse_buffer would, to time it.
+ * Returns the number of tokens, with a hash of them and their locations in
+ * hash, so that the tokens of two scanners can be compared. */
+size_t scan_buffer(char *base, size_t size, uint64_t *hash);
 
 namespace ast {
 class Visitor {
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+using std::string;
+using std::string_view;
+
+namespace parser {
+/** A hash of the sources the compiler was built from, generated by CMake.
+ * It goes into the keys of the binary caches, so that a file written by
+ * another build misses. */
+extern const char build_id[];
+
+/** FNV-1a, stable across builds and runs unlike std::hash, for the keys of
+ * the binary caches. */
+inline uint64_t hash_bytes(string_view data,
+                           uint64_t seed = 0xcbf29ce484222325) {
+    for (auto ch : data) {
+        seed ^= static_cast<uint8_t>(ch);
+        seed *= 0x100000001b3;
+    }
+    return seed;
+}
+
+/** Writes data to a file next to path and renames it over path, so that a
+ * cache another run has mapped is replaced, never truncated under it, and a
+ * crash leaves the old file or none instead of a torn one. */
+bool write_file_atomically(const string &path, string_view data);
+
+/** A regular file of size bytes mapped copy-on-write, followed by the two
+ * NULs flex needs to scan it in place with parse_buffer. */
+class MappedSource {
+   public:
+    MappedSource(int fd, size_t size);
+    ~MappedSource();
+    MappedSource(const MappedSource &) = delete;
+    MappedSource &operator=(const MappedSource &) = delete;
+
+    bool mapped() const { return base_ != nullptr; }
+    /** The text and the NULs, which size counts. */
+    char *base() { return base_; }
+    size_t size() const { return size_; }
+    string_view text() const { return {base_, size_ - 2}; }
+
+   private:
+    char *base_ = nullptr;
+    size_t size_ = 0;
+};
+
+/** Appends LEB128 integers and raw bytes, for the binary caches. */
+class ByteWriter {
+   public:
+    void put_byte(uint8_t b) { buf_.push_back(static_cast<char>(b)); }
+    void put_uint(uint64_t v) {
+        while (v >= 0x80) {
+            put_byte(static_cast<uint8_t>(v) | 0x80);
+            v >>= 7;
+        }
+        put_byte(static_cast<uint8_t>(v));
+    }
+    void put_int(int64_t v) {
+        put_uint((static_cast<uint64_t>(v) << 1) ^
+                 static_cast<uint64_t>(v >> 63));
+    }
+    void put_fixed64(uint64_t v) {
+        for (int i = 0; i < 8; i++) {
+            put_byte(static_cast<uint8_t>(v >> (8 * i)));
+        }
+    }
+    void put_bytes(string_view bytes) { buf_ += bytes; }
+    void append(const ByteWriter &other) { buf_ += other.buf_; }
+    const string &bytes() const { return buf_; }
+
+   private:
+    string buf_;
+};
+
+/** Reads LEB128 with bounds checks; past the end or on a bad index it only
+ * records the failure and returns 0, checked once at the end. */
+class ByteReader {
+   public:
+    explicit ByteReader(string_view data) : data_(data) {}
+
+    bool ok() const { return ok_; }
+    void fail() { ok_ = false; }
+    uint8_t get_byte() {
+        if (pos_ >= data_.size()) {
+            fail();
+            return 0;
+        }
+        return static_cast<uint8_t>(data_[pos_++]);
+    }
+    uint64_t get_uint() {
+        uint64_t v = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            auto b = get_byte();
+            v |= static_cast<uint64_t>(b & 0x7f) << shift;
+            if ((b & 0x80) == 0) return v;
+        }
+        fail();
+        return 0;
+    }
+    int64_t get_int() {
+        auto v = get_uint();
+        return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+    }
+    uint64_t get_fixed64() {
+        uint64_t v = 0;
+        for (int i = 0; i < 8; i++) {
+            v |= static_cast<uint64_t>(get_byte()) << (8 * i);
+        }
+        return v;
+    }
+    /** An index into a table of size bound. */
+    unsigned get_index(size_t bound) {
+        auto v = get_uint();
+        if (v >= bound) {
+            fail();
+            return 0;
+        }
+        return v;
+    }
+    string_view get_bytes(size_t size) {
+        if (size > data_.size() - pos_) {
+            fail();
+            return {};
+        }
+        auto s = data_.substr(pos_, size);
+        pos_ += size;
+        return s;
+    }
+    /** A number of records, each at least one byte long. */
+    size_t get_count() { return get_index(data_.size() - pos_ + 1); }
+    bool at_end() const { return pos_ == data_.size(); }
+
+   private:
+    string_view data_;
+    size_t pos_ = 0;
+    bool ok_ = true;
+};
+}  // namespace parser
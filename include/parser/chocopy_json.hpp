@@ -0,0 +1,126 @@
+#pragma once
+
+#include <functional>
+#include <initializer_list>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "chocopy_ast.hpp"
+
+namespace semantic {
+class SymbolType;
+}  // namespace semantic
+
+namespace parser {
+/** Writes JSON text as it goes, formatted the way json::dump(indent) does,
+ * into a buffer that is passed on to the stream whenever it fills up.
+ * Keys are written in the order they are given. */
+class JsonWriter {
+   public:
+    explicit JsonWriter(std::ostream &out, int indent = 2)
+        : out_(out), indent_(indent) {}
+    JsonWriter(const JsonWriter &) = delete;
+    JsonWriter &operator=(const JsonWriter &) = delete;
+    ~JsonWriter() { flush(); }
+
+    void begin_object();
+    void end_object();
+    void begin_array();
+    void end_array();
+    /** The key of the next value in the current object. */
+    void key(std::string_view key);
+
+    void value(std::string_view s);
+    void value(const char *s) { value(std::string_view(s)); }
+    void value(int i);
+    void value(bool b);
+
+    /** Ends the text with a newline, like std::endl after dump. */
+    void end();
+    void flush();
+
+   private:
+    /** Starts a value, after its key or on a new line in an array. */
+    void element();
+    void close(char c);
+    void newline();
+    void write_string(std::string_view s);
+
+    static constexpr size_t buffer_size = 64 * 1024;
+
+    std::ostream &out_;
+    std::string buf_;
+    int indent_;
+    int depth_ = 0;
+    /** No element yet in the innermost container. */
+    bool empty_ = false;
+    bool after_key_ = false;
+};
+}  // namespace parser
+
+namespace ast {
+/** Writes the AST as the same text as json::dump(indent) would for it, with
+ * the keys of each node sorted, without building a json tree first.
+ *
+ *   JsonEmitter(std::cout).emit(*program);
+ */
+class JsonEmitter : public Visitor {
+   public:
+    explicit JsonEmitter(std::ostream &out, int indent = 2)
+        : out_(out, indent) {}
+
+    /** Writes node followed by a newline. */
+    void emit(parser::Node &node);
+
+    void visit(parser::AssignStmt &) override;
+    void visit(parser::Program &) override;
+    void visit(parser::PassStmt &) override;
+    void visit(parser::BinaryExpr &) override;
+    void visit(parser::BoolLiteral &) override;
+    void visit(parser::CallExpr &) override;
+    void visit(parser::ClassDef &) override;
+    void visit(parser::ClassType &) override;
+    void visit(parser::ExprStmt &) override;
+    void visit(parser::ForStmt &) override;
+    void visit(parser::FuncDef &) override;
+    void visit(parser::GlobalDecl &) override;
+    void visit(parser::Ident &) override;
+    void visit(parser::IfExpr &) override;
+    void visit(parser::IndexExpr &) override;
+    void visit(parser::IntegerLiteral &) override;
+    void visit(parser::ListExpr &) override;
+    void visit(parser::ListType &) override;
+    void visit(parser::MemberExpr &) override;
+    void visit(parser::IfStmt &) override;
+    void visit(parser::MethodCallExpr &) override;
+    void visit(parser::NoneLiteral &) override;
+    void visit(parser::NonlocalDecl &) override;
+    void visit(parser::ReturnStmt &) override;
+    void visit(parser::StringLiteral &) override;
+    void visit(parser::TypeAnnotation &) override;
+    void visit(parser::TypedVar &) override;
+    void visit(parser::UnaryExpr &) override;
+    void visit(parser::VarDef &) override;
+    void visit(parser::WhileStmt &) override;
+    void visit(parser::Errors &) override;
+    /** Compiler errors, and nodes without fields of their own. */
+    void visit(parser::Node &) override;
+
+   private:
+    using Field = std::pair<std::string_view, std::function<void()>>;
+
+    /** Writes an object with the fields of node and the ones given, sorted
+     * by key as json keeps them. */
+    void object(const parser::Node &node, std::initializer_list<Field> fields,
+                const semantic::SymbolType *inferred_type = nullptr);
+    /** The same, with the inferred type of an expression if it has one. */
+    void expr(const parser::Expr &node, std::initializer_list<Field> fields);
+    template <typename T>
+    void list(const T &nodes, bool skip_pass = false);
+    void type(const semantic::SymbolType &type);
+
+    parser::JsonWriter out_;
+};
+}  // namespace ast
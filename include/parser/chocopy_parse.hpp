@@ -3,14 +3,18 @@
 #include <iostream>
 #include <memory>
 #include <nlohmann/json.hpp>
+#include <string_view>
 #include <utility>
 #include <vector>
 
 #include "SymbolTable.hpp"
+#include "chocopy_arena.hpp"
 #include "chocopy_ast.hpp"
 #include "chocopy_logging.hpp"
+#include "chocopy_symbol.hpp"
 #include "hierarchy_tree.hpp"
 
+using std::string_view;
 using std::unique_ptr;
 using std::vector;
 using json = nlohmann::json;
@@ -90,16 +94,19 @@ class Node {
    public:
     Location location;
 
-    string kind;
+    string_view kind;
     string typeError;
 
     explicit Node(Location location) : location(location) {}
-    Node(Location location, string kind)
-        : location(location), kind(std::move(kind)) {}
+    Node(Location location, string_view kind)
+        : location(location), kind(kind) {}
     virtual ~Node() = default;
 
+    /** From the current Arena if there is one, else from the heap. */
+    static void *operator new(size_t size);
+    static void operator delete(void *ptr);
+
     virtual bool has_type_err() const { return !this->typeError.empty(); }
-    virtual json toJSON() const;
     virtual void accept(ast::Visitor &visitor);
 };
 
@@ -110,7 +117,7 @@ class Decl : public Node {
    public:
     /** A definition or declaration spanning source locations [LEFT..RIGHT]. */
     explicit Decl(Location location) : Node(location) {}
-    Decl(Location location, string kind) : Node(location, std::move(kind)) {}
+    Decl(Location location, string_view kind) : Node(location, kind) {}
 
     virtual Ident *get_id() { return nullptr; };
 };
@@ -131,7 +138,6 @@ class CompilerErr : public Node {
 
     CompilerErr(Location location, string message)
         : Node(location, "CompilerError"), message(std::move(message)) {}
-    json toJSON() const override;
 };
 
 /** Collects the error messages in a Program.  There is exactly one per
@@ -142,7 +148,6 @@ class Errors : public Node {
     vector<unique_ptr<CompilerErr>> compiler_errors;
     explicit Errors(Location location) : Node(location, "Errors") {}
 
-    json toJSON() const override;
     void accept(ast::Visitor &visitor) override;
 };
 
@@ -159,7 +164,6 @@ class TypedVar : public Node {
     TypedVar(Location location, Ident *identifier, TypeAnnotation *type)
         : Node(location, "TypedVar"), identifier(identifier), type(type) {}
 
-    json toJSON() const override;
     void accept(ast::Visitor &visitor) override;
 };
 
@@ -167,7 +171,7 @@ class Stmt : public Node {
    public:
     bool is_return = false;
     explicit Stmt(Location location) : Node(location) {}
-    Stmt(Location location, string kind) : Node(location, std::move(kind)) {}
+    Stmt(Location location, string_view kind) : Node(location, kind) {}
 };
 
 /**
@@ -183,9 +187,8 @@ class Expr : public Node {
    public:
     /** A Python expression spanning source locations [LEFT..RIGHT]. */
     explicit Expr(Location location) : Node(location){};
-    Expr(Location location, string kind) : Node(location, std::move(kind)){};
+    Expr(Location location, string_view kind) : Node(location, kind){};
 
-    json toJSON() const override;
     /**
      * The type of the value that this expression evaluates to.
      *
@@ -206,13 +209,11 @@ class Ident : public Expr {
    public:
     /** An AST for the variable, method, or parameter named NAME, spanning
      *  source locations [LEFT..RIGHT]. */
-    Ident(Location location, string name) : Expr(location, "Identifier") {
-        this->name = std::move(name);
-    }
+    Ident(Location location, Symbol name)
+        : Expr(location, "Identifier"), name(name) {}
 
-    string name;
+    Symbol name;
 
-    json toJSON() const override;
     void accept(ast::Visitor &visitor) override;
 };
 
@@ -226,11 +227,11 @@ class Literal : public Expr {
    public:
     /** A literal spanning source locations [LEFT..RIGHT]. */
     explicit Literal(Location location) : Expr(location){};
-    Literal(Location location, string kind) : Expr(location, std::move(kind)){};
-    Literal(Location location, string kind, int value)
-        : Expr(location, std::move(kind)), int_value(value), is_init(true){};
-    Literal(Location location, string kind, string value)
-        : Expr(location, std::move(kind)),
+    Literal(Location location, string_view kind) : Expr(location, kind){};
+    Literal(Location location, string_view kind, int value)
+        : Expr(location, kind), int_value(value), is_init(true){};
+    Literal(Location location, string_view kind, string value)
+        : Expr(location, kind),
           value(std::move(value)),
           is_init(true){};
 
@@ -247,8 +248,8 @@ class TypeAnnotation : public Node {
    public:
     /** An annotation spanning source locations [LEFT..RIGHT]. */
     explicit TypeAnnotation(Location location) : Node(location){};
-    TypeAnnotation(Location location, string kind)
-        : Node(location, std::move(kind)){};
+    TypeAnnotation(Location location, string_view kind)
+        : Node(location, kind){};
 
     string get_name();
 };
@@ -267,7 +268,6 @@ class AssignStmt : public Stmt {
         this->targets.emplace_back(target);
     }
 
-    json toJSON() const override;
     void accept(ast::Visitor &visitor) override;
 };
 
@@ -321,7 +321,6 @@ class BinaryExpr : public Expr {
         return operator_code::Unknown;
     }
 
-    json toJSON() const override;
     void accept(ast::Visitor &visitor) override;
 };
 
@@ -338,8 +337,6 @@ class BoolLiteral : public Literal {
         this->bin_value = value;
     }
 
-    json toJSON() const override;
-
     void accept(ast::Visitor &visitor) override;
 };
 
@@ -358,7 +355,6 @@ class CallExpr : public Expr {
     CallExpr(Location location, Ident *function)
         : Expr(location, "CallExpr"), function(function) {}
 
-    json toJSON() const override;
     void accept(ast::Visitor &visitor) override;
 };
 
@@ -378,21 +374,17 @@ class ClassDef : public Decl {
     }
 
     Ident *get_id() override { return this->name.get(); }
-    json toJSON() const override;
     void accept(ast::Visitor &visitor) override;
 };
 
 /** A simple class type name. */
 class ClassType : public TypeAnnotation {
    public:
-    string className;
+    Symbol className;
     /** An AST denoting a type named CLASSNAME0 at [LEFT..RIGHT]. */
-    ClassType(Location location, string className)
-        : TypeAnnotation(location, "ClassType") {
-        this->className = std::move(className);
-    }
+    ClassType(Location location, Symbol className)
+        : TypeAnnotation(location, "ClassType"), className(className) {}
 
-    json toJSON() const override;
     void accept(ast::Visitor &visitor) override;
 };
 
@@ -403,7 +395,6 @@ class ExprStmt : public Stmt {
     ExprStmt(Location location, Expr *expr)
         : Stmt(location, "ExprStmt"), expr(expr) {}
 
-    json toJSON() const override;
     void accept(ast::Visitor &visitor) override;
 };
 
@@ -428,7 +419,6 @@ class ForStmt : public Stmt {
         delete body;
     }
 
-    json toJSON() const override;
     void accept(ast::Visitor &visitor) override;
 };
 
@@ -461,7 +451,6 @@ class FuncDef : public Decl {
         delete statements;
     }
     Ident *get_id() override { return this->name.get(); }
-    json toJSON() const override;
     void accept(ast::Visitor &visitor) override;
 };
 
@@ -470,7 +459,6 @@ class GlobalDecl : public Decl {
     unique_ptr<Ident> variable;
     GlobalDecl(Location location, Ident *variable)
         : Decl(location, "GlobalDecl"), variable(variable) {}
-    json toJSON() const override;
 
     Ident *get_id() override { return this->variable.get(); }
     void accept(ast::Visitor &visitor) override;
@@ -524,7 +512,6 @@ class IfStmt : public Stmt {
         delete thenBody;
     }
 
-    json toJSON() const override;
     void accept(ast::Visitor &visitor) override;
 };
 
@@ -548,8 +535,6 @@ class IfExpr : public Expr {
           thenExpr(thenExpr),
           elseExpr(elseExpr) {}
 
-    json toJSON() const override;
-
     void accept(ast::Visitor &visitor) override;
 };
 
@@ -568,8 +553,6 @@ class IndexExpr : public Expr {
     IndexExpr(Location location, Expr *list, Expr *index)
         : Expr(location, "IndexExpr"), list(list), index(index) {}
 
-    json toJSON() const override;
-
     void accept(ast::Visitor &visitor) override;
 };
 
@@ -586,8 +569,6 @@ class IntegerLiteral : public Literal {
         this->value = value;
     }
 
-    json toJSON() const override;
-
     void accept(ast::Visitor &visitor) override;
 };
 
@@ -608,8 +589,6 @@ class ListExpr : public Expr {
     }
     explicit ListExpr(Location location) : Expr(location, "ListExpr") {}
 
-    json toJSON() const override;
-
     void accept(ast::Visitor &visitor) override;
 };
 
@@ -624,7 +603,6 @@ class ListType : public TypeAnnotation {
     ListType(Location location, TypeAnnotation *element)
         : TypeAnnotation(location, "ListType"), elementType(element) {}
 
-    json toJSON() const override;
     void accept(ast::Visitor &visitor) override;
 };
 
@@ -640,7 +618,6 @@ class MemberExpr : public Expr {
     MemberExpr(Location location, Expr *object, Ident *member)
         : Expr(location, "MemberExpr"), object(object), member(member) {}
 
-    json toJSON() const override;
     void accept(ast::Visitor &visitor) override;
 
     Ident *get_id() { return static_cast<Ident *>(object.get()); }
@@ -669,7 +646,6 @@ class MethodCallExpr : public Expr {
     MethodCallExpr(Location location, MemberExpr *method)
         : Expr(location, "MethodCallExpr"), method(method) {}
 
-    json toJSON() const override;
     void accept(ast::Visitor &visitor) override;
 };
 
@@ -680,7 +656,6 @@ class NoneLiteral : public Literal {
     explicit NoneLiteral(Location location)
         : Literal(location, "NoneLiteral") {}
 
-    json toJSON() const override;
     void accept(ast::Visitor &visitor) override;
 };
 
@@ -696,12 +671,15 @@ class NonlocalDecl : public Decl {
         : Decl(location, "NonLocalDecl"), variable(variable) {}
 
     Ident *get_id() override { return this->variable.get(); }
-    json toJSON() const override;
     void accept(ast::Visitor &visitor) override;
 };
 
 class Program : public Node {
    public:
+    /** Holds the nodes below when they come from the parser. First, so that
+     * it goes after them. */
+    std::shared_ptr<Arena> arena;
+
     vector<unique_ptr<parser::Stmt>> statements;
     unique_ptr<Errors> errors{new Errors({})};
     vector<unique_ptr<Decl>> declarations;
@@ -709,6 +687,8 @@ class Program : public Node {
     // For semantic analysis
     semantic::SymbolTable symbol_table;
     semantic::HierachyTree hierachy_tree;
+    /** Set once every body went through the type checker. */
+    bool type_checked = false;
 
     Program(Location location, vector<unique_ptr<Decl>> *declarations,
             vector<unique_ptr<parser::Stmt>> *statements)
@@ -727,6 +707,10 @@ class Program : public Node {
 
     explicit Program(Location location) : Node(location, "Program"){};
 
+    /** Always on the heap, as it outlives the arena. */
+    static void *operator new(size_t size) { return ::operator new(size); }
+    static void operator delete(void *ptr) { ::operator delete(ptr); }
+
     void add_error(vector<unique_ptr<CompilerErr>> *errs) {
         for (auto &err : *errs) {
             this->errors->compiler_errors.emplace_back(std::move(err));
@@ -734,7 +718,6 @@ class Program : public Node {
         errs->clear();
     }
 
-    json toJSON() const override;
     void accept(ast::Visitor &visitor) override;
 };
 
@@ -755,7 +738,6 @@ class ReturnStmt : public Stmt {
         is_return = true;
     }
 
-    json toJSON() const override;
     void accept(ast::Visitor &visitor) override;
 };
 
@@ -767,7 +749,6 @@ class StringLiteral : public Literal {
     /** The AST for a string literal containing VALUE, spanning source
      *  locations [LEFT..RIGHT]. */
     StringLiteral(Location location, const string &value);
-    json toJSON() const override;
 
     void accept(ast::Visitor &visitor) override;
 };
@@ -795,7 +776,6 @@ class UnaryExpr : public Expr {
         return operator_code::Unknown;
     }
 
-    json toJSON() const override;
     void accept(ast::Visitor &visitor) override;
 };
 
@@ -815,7 +795,6 @@ class VarDef : public Decl {
         : Decl(location, "VarDef"), var(var), value(value) {}
 
     Ident *get_id() override { return var->identifier.get(); }
-    json toJSON() const override;
     void accept(ast::Visitor &visitor) override;
 };
 
@@ -839,7 +818,6 @@ class WhileStmt : public Stmt {
         delete body;
     }
 
-    json toJSON() const override;
     void accept(ast::Visitor &visitor) override;
 };
 
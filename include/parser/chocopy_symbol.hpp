@@ -0,0 +1,137 @@
+#pragma once
+
+#include <fmt/format.h>
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using std::string;
+using std::string_view;
+
+namespace parser {
+/** An interned name. Every symbol with the same text refers to the one copy
+ * kept for the whole process, so comparing and hashing symbols only looks
+ * at that pointer. Interning is safe from several threads at once.
+ *
+ * A symbol converts to the const string & of its text, so it can be
+ * passed wherever a name is taken by reference. */
+class Symbol {
+   public:
+    /** The empty name. */
+    Symbol();
+    explicit Symbol(string_view name);
+
+    /** The symbol of a string that get() returned. */
+    static Symbol from(const string *interned) { return Symbol(interned); }
+    /** The symbol of name if it has been interned, without interning it:
+     * a name no symbol has is in no SymbolMap either. */
+    static std::optional<Symbol> find(string_view name);
+
+    const string &str() const { return *name_; }
+    const string *get() const { return name_; }
+    const char *c_str() const { return name_->c_str(); }
+    bool empty() const { return name_->empty(); }
+    operator const string &() const { return *name_; }
+
+    friend bool operator==(Symbol a, Symbol b) { return a.name_ == b.name_; }
+    friend bool operator==(Symbol a, string_view b) { return *a.name_ == b; }
+    friend bool operator==(Symbol a, const char *b) { return *a.name_ == b; }
+    friend bool operator==(Symbol a, const string &b) { return *a.name_ == b; }
+
+   private:
+    explicit Symbol(const string *interned) : name_(interned) {}
+
+    const string *name_;
+};
+
+inline string operator+(const string &a, Symbol b) { return a + b.str(); }
+inline string operator+(const char *a, Symbol b) { return a + b.str(); }
+inline string operator+(Symbol a, const string &b) { return a.str() + b; }
+inline string operator+(Symbol a, const char *b) { return a.str() + b; }
+
+/** A map from symbols by open addressing on the interned pointer, so a
+ * lookup hashes one pointer and probes until it finds it or an empty slot,
+ * without looking at the text. The entries themselves are kept in a vector
+ * in the order they were added, which is the order of iteration. Nothing
+ * is ever removed. */
+template <typename V>
+class SymbolMap {
+   public:
+    using value_type = std::pair<Symbol, V>;
+    using const_iterator = typename std::vector<value_type>::const_iterator;
+
+    const_iterator begin() const { return entries_.begin(); }
+    const_iterator end() const { return entries_.end(); }
+    size_t size() const { return entries_.size(); }
+    bool empty() const { return entries_.empty(); }
+
+    /** Null if name is not in the map. */
+    const V *find(Symbol name) const {
+        if (slots_.empty()) return nullptr;
+        for (auto i = slot(name);; i = (i + 1) & (slots_.size() - 1)) {
+            if (slots_[i] == 0) return nullptr;
+            auto &entry = entries_[slots_[i] - 1];
+            if (entry.first == name) return &entry.second;
+        }
+    }
+    V *find(Symbol name) {
+        return const_cast<V *>(std::as_const(*this).find(name));
+    }
+    bool contains(Symbol name) const { return find(name) != nullptr; }
+
+    /** The value of name, added default constructed if it is not there. */
+    V &operator[](Symbol name) {
+        if (auto value = find(name)) return *value;
+        entries_.emplace_back(name, V());
+        if (entries_.size() * 2 > slots_.size()) {
+            grow();
+        } else {
+            place(entries_.size() - 1);
+        }
+        return entries_.back().second;
+    }
+
+   private:
+    size_t slot(Symbol name) const {
+        auto h = reinterpret_cast<uintptr_t>(name.get()) * 0x9e3779b97f4a7c15;
+        return static_cast<size_t>(static_cast<uint64_t>(h) >> shift_);
+    }
+    /** Doubles the slots, keeping them at most half full. */
+    void grow() {
+        slots_.assign(slots_.empty() ? 8 : slots_.size() * 2, 0);
+        shift_ = 64;
+        for (auto n = slots_.size(); n > 1; n >>= 1) shift_--;
+        for (size_t i = 0; i < entries_.size(); i++) place(i);
+    }
+    void place(size_t index) {
+        auto i = slot(entries_[index].first);
+        while (slots_[i] != 0) i = (i + 1) & (slots_.size() - 1);
+        slots_[i] = static_cast<uint32_t>(index + 1);
+    }
+
+    std::vector<value_type> entries_;
+    /** index + 1 into entries_, 0 if empty */
+    std::vector<uint32_t> slots_;
+    unsigned shift_ = 64;
+};
+}  // namespace parser
+
+template <>
+struct std::hash<parser::Symbol> {
+    size_t operator()(parser::Symbol s) const noexcept {
+        return std::hash<const string *>()(s.get());
+    }
+};
+
+template <>
+struct fmt::formatter<parser::Symbol> : fmt::formatter<string_view> {
+    template <typename FormatContext>
+    auto format(parser::Symbol s, FormatContext &ctx) const {
+        return fmt::formatter<string_view>::format(s.str(), ctx);
+    }
+};
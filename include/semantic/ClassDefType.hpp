@@ -10,7 +10,13 @@ namespace semantic {
 class ClassDefType : public SymbolType {
    public:
     ClassDefType(string parent, string self)
-        : super_class(std::move(parent)), class_name(std::move(self)){};
+        : super_class(std::move(parent)), class_name(std::move(self)) {
+        set_kind(SymbolKind::Class);
+    }
+
+    static bool classof(const SymbolType *t) {
+        return t->get_kind() == SymbolKind::Class;
+    }
 
     const string get_name() const override { return class_name; }
     virtual json toJSON() const override { abort(); }
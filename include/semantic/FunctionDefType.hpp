@@ -20,6 +20,12 @@ class FunctionDefType : public SymbolType {
     SymbolTable current_scope;
     bool is_method;
 
+    FunctionDefType() { set_kind(SymbolKind::Function); }
+
+    static bool classof(const SymbolType *t) {
+        return t->get_kind() == SymbolKind::Function;
+    }
+
     bool operator==(const FunctionDefType &f2) const;
     bool is_func_type() const final { return true; }
     const string get_name() const final { return func_name; }
@@ -1,77 +1,132 @@
 #pragma once
 
-#include <map>
 #include <memory>
 #include <string>
-#include <vector>
+#include <type_traits>
+#include <utility>
 
 #include "SymbolType.hpp"
+#include "chocopy_symbol.hpp"
 
-using std::map;
 using std::shared_ptr;
 using std::string;
 
 namespace semantic {
 /** A block-structured symbol table a mapping identifiers to information
- *  about them of type T in a given declarative region. */
+ *  about them of type T in a given declarative region.
+ *
+ *  Names are symbols, so a lookup in a scope is a single probe of a hash
+ *  table on the interned pointer, and the entry is cast on its SymbolKind.
+ *  The overloads taking a string find the symbol first, and a string that
+ *  was never interned is not declared anywhere. */
 class SymbolTable {
    public:
+    using Symbol = parser::Symbol;
+
     /** A table representing a region nested in that represented by parent. */
     explicit SymbolTable(SymbolTable *parent) : parent(parent) {}
     SymbolTable() : parent(nullptr) {}
-    map<string, shared_ptr<SymbolType>> tab;
+    /** In the order the names were put. */
+    parser::SymbolMap<shared_ptr<SymbolType>> tab;
 
-    bool is_nonlocal(const string &name) const {
+    bool is_nonlocal(Symbol name) const {
         return this->parent != nullptr &&
                this->parent->is_nonlocal_helper(name);
     }
-    bool is_nonlocal_helper(const string &name) const {
-        return this->parent != nullptr &&
-               (tab.contains(name) || this->parent->is_nonlocal_helper(name));
+    bool is_nonlocal(const string &name) const {
+        auto symbol = Symbol::find(name);
+        return symbol && is_nonlocal(*symbol);
+    }
+    /** Declared in this scope or an enclosing one other than the global. */
+    bool is_nonlocal_helper(Symbol name) const {
+        for (auto table = this; table->parent != nullptr;
+             table = table->parent) {
+            if (table->tab.contains(name)) return true;
+        }
+        return false;
     }
 
-    /** Returns the mapping in this scope or in the parent scope using a
-     * recursive traversal */
+    /** Returns the mapping in this scope or in the parent scope, the
+     * innermost one that has the name */
+    template <typename T>
+    T *get(Symbol name) {
+        for (auto table = this; table != nullptr; table = table->parent) {
+            if (auto type = table->tab.find(name)) return cast<T>(*type);
+        }
+        return nullptr;
+    }
     template <typename T>
     T *get(const string &name) {
-        if (tab.count(name) > 0)
-            return dynamic_cast<T *>(tab.at(name).get());
-        else if (parent != nullptr)
-            return parent->get<T>(name);
-        else
-            return nullptr;
+        auto symbol = Symbol::find(name);
+        return symbol ? get<T>(*symbol) : nullptr;
     }
 
+    template <typename T>
+    shared_ptr<T> get_shared(Symbol name) {
+        for (auto table = this; table != nullptr; table = table->parent) {
+            if (auto type = table->tab.find(name)) {
+                return cast_shared<T>(*type);
+            }
+        }
+        return nullptr;
+    }
     template <typename T>
     shared_ptr<T> get_shared(const string &name) {
-        if (tab.count(name) > 0)
-            return std::dynamic_pointer_cast<T>(tab.at(name));
-        else if (parent != nullptr)
-            return parent->get_shared<T>(name);
-        else
-            return nullptr;
+        auto symbol = Symbol::find(name);
+        return symbol ? get_shared<T>(*symbol) : nullptr;
     }
 
     /** Return the mapping in this scope only. */
     template <typename T = SymbolType>
+    T *declares(Symbol name) const {
+        auto type = tab.find(name);
+        return type ? cast<T>(*type) : nullptr;
+    }
+    template <typename T = SymbolType>
     T *declares(const string &name) const {
-        if (tab.count(name) > 0) return dynamic_cast<T *>(tab.at(name).get());
-        return nullptr;
+        auto symbol = Symbol::find(name);
+        return symbol ? declares<T>(*symbol) : nullptr;
     }
 
+    template <typename T = SymbolType>
+    shared_ptr<T> declares_shared(Symbol name) const {
+        auto type = tab.find(name);
+        return type ? cast_shared<T>(*type) : nullptr;
+    }
     template <typename T = SymbolType>
     shared_ptr<T> declares_shared(const string &name) const {
-        if (tab.count(name) > 0)
-            return std::dynamic_pointer_cast<T>(tab.at(name));
-        return nullptr;
+        auto symbol = Symbol::find(name);
+        return symbol ? declares_shared<T>(*symbol) : nullptr;
     }
 
     /** Adds a new mapping in the current scope, possibly shadowing mappings in
      * the parent scope. */
+    void put(Symbol name, shared_ptr<SymbolType> value) {
+        tab[name] = std::move(value);
+    }
     void put(const string &name, shared_ptr<SymbolType> value) {
-        tab[name] = value;
+        put(Symbol(name), std::move(value));
     }
 
     SymbolTable *parent;
+
+   private:
+    /** The kind tag of the entry decides, see SymbolKind. */
+    template <typename T>
+    static T *cast(const shared_ptr<SymbolType> &type) {
+        if constexpr (std::is_same_v<T, SymbolType>) {
+            return type.get();
+        } else {
+            return type && T::classof(type.get())
+                       ? static_cast<T *>(type.get())
+                       : nullptr;
+        }
+    }
+    template <typename T>
+    static shared_ptr<T> cast_shared(const shared_ptr<SymbolType> &type) {
+        return type && T::classof(type.get())
+                   ? std::static_pointer_cast<T>(type)
+                   : nullptr;
+    }
 };
 }  // namespace semantic
@@ -9,10 +9,30 @@ using std::string;
 using std::string_view;
 
 namespace semantic {
+/** The concrete class of a SymbolType, so that a lookup in a SymbolTable
+ * casts without dynamic_cast. Each range of subclasses is kept contiguous. */
+enum class SymbolKind {
+    Ref,
+    NonlocalRef,
+    GlobalRef,
+    ListValue,
+    ClassValue,
+    Class,
+    Function,
+
+    FirstRef = Ref,
+    LastRef = GlobalRef,
+    FirstValue = ListValue,
+    LastValue = ClassValue,
+};
+
 class SymbolType {
    public:
     virtual ~SymbolType() = default;
 
+    SymbolKind get_kind() const { return kind_; }
+    static bool classof(const SymbolType *) { return true; }
+
     virtual constexpr bool is_value_type() const { return false; }
     virtual constexpr bool is_list_type() const { return false; }
     virtual constexpr bool is_func_type() const { return false; }
@@ -22,5 +42,12 @@ class SymbolType {
 
     bool eq(const SymbolType *_Value) const;
     bool neq(const SymbolType *_Value) const;
+
+   protected:
+    /** Called by the constructor of each concrete subclass. */
+    void set_kind(SymbolKind kind) { kind_ = kind; }
+
+   private:
+    SymbolKind kind_ = SymbolKind::Ref;
 };
 }  // namespace semantic
@@ -28,7 +28,12 @@ class ListValueType;
  */
 class RefType : public SymbolType {
    public:
-    RefType(const string &name) : name(name) {}
+    RefType(const string &name) : name(name) { set_kind(SymbolKind::Ref); }
+
+    static bool classof(const SymbolType *t) {
+        return t->get_kind() >= SymbolKind::FirstRef &&
+               t->get_kind() <= SymbolKind::LastRef;
+    }
 
     const string get_name() const override { return name; }
     virtual json toJSON() const final { abort(); }
@@ -37,11 +42,23 @@ class RefType : public SymbolType {
 };
 class NonlocalRefType : public RefType {
    public:
-    NonlocalRefType(const string &name) : RefType(name) {}
+    NonlocalRefType(const string &name) : RefType(name) {
+        set_kind(SymbolKind::NonlocalRef);
+    }
+
+    static bool classof(const SymbolType *t) {
+        return t->get_kind() == SymbolKind::NonlocalRef;
+    }
 };
 class GlobalRefType : public RefType {
    public:
-    GlobalRefType(const string &name) : RefType(name) {}
+    GlobalRefType(const string &name) : RefType(name) {
+        set_kind(SymbolKind::GlobalRef);
+    }
+
+    static bool classof(const SymbolType *t) {
+        return t->get_kind() == SymbolKind::GlobalRef;
+    }
 };
 
 /**
@@ -55,6 +72,11 @@ class ValueType : public SymbolType {
    public:
     ValueType() = default;
 
+    static bool classof(const SymbolType *t) {
+        return t->get_kind() >= SymbolKind::FirstValue &&
+               t->get_kind() <= SymbolKind::LastValue;
+    }
+
     bool is_value_type() const override { return true; }
 
     static shared_ptr<ValueType> annotate_to_val(
@@ -70,10 +92,16 @@ class ValueType : public SymbolType {
 class ListValueType : public ValueType {
    public:
     explicit ListValueType(shared_ptr<ValueType> element)
-        : element_type(element) {}
+        : element_type(element) {
+        set_kind(SymbolKind::ListValue);
+    }
 
     explicit ListValueType(parser::ListType *typeAnnotation);
 
+    static bool classof(const SymbolType *t) {
+        return t->get_kind() == SymbolKind::ListValue;
+    }
+
     bool constexpr is_list_type() const override { return true; }
 
     const string get_name() const override {
@@ -91,9 +119,15 @@ class ListValueType : public ValueType {
 class ClassValueType : public ValueType {
    public:
     explicit ClassValueType(string className)
-        : class_name(std::move(className)) {}
+        : class_name(std::move(className)) {
+        set_kind(SymbolKind::ClassValue);
+    }
     explicit ClassValueType(parser::ClassType *classTypeAnnotation);
-    ClassValueType() = default;
+    ClassValueType() { set_kind(SymbolKind::ClassValue); }
+
+    static bool classof(const SymbolType *t) {
+        return t->get_kind() == SymbolKind::ClassValue;
+    }
 
     bool is_special_class() const {
         return class_name != "str" && class_name != "int" &&
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "chocopy_parse.hpp"
+
+using std::string;
+using std::string_view;
+
+namespace semantic {
+/** Binary form of a checked Program, to skip the front end on a source
+ * that has not changed since the last run.
+ *
+ *   header  "ASTB", version, key (8 bytes)
+ *   source  the text the program was checked from
+ *   strings every name and string, once
+ *   types   the kind and names of each symbol type, then what each refers
+ *           to: element, return and parameter types, and its scope
+ *   program the global scope, the class hierarchy, then the tree with the
+ *           inferred types, errors and captured names
+ *
+ * The types are stored once and referred to by index, so the ones the
+ * tree and the scopes share are shared again when read, as are the scopes
+ * the parent pointers refer to. Integers are LEB128 as in the IR cache.
+ * A file written with another key or version reads as null. */
+string write_ast(parser::Program *program, uint64_t key,
+                 string_view source = {});
+bool write_ast_file(parser::Program *program, const string &path,
+                    uint64_t key, string_view source = {});
+
+/** Null if data is not a program written with key. */
+std::unique_ptr<parser::Program> read_ast(string_view data, uint64_t key);
+/** Maps the file and reads straight from the mapping. */
+std::unique_ptr<parser::Program> read_ast_file(const string &path,
+                                               uint64_t key);
+/** The source data was written with, whatever the key; empty if data is
+ * not of this version. */
+string_view read_ast_source(string_view data);
+
+/** Parses the program at input_path and runs SymbolTableGenerator,
+ * DeclarationAnalyzer and TypeChecker on it, each as long as there are no
+ * errors. With ast_cache, the result is read from <input_path>.astb if it
+ * was written for the same source by the same build of the compiler, and
+ * written there otherwise. incremental does the same, and when the file
+ * was written for an earlier version of the source, the program in it is
+ * rechecked where the source changed, as by recheck, if it can be, or
+ * checked from scratch, and written back either way, so that the next edit
+ * is diffed against this version. */
+std::unique_ptr<parser::Program> check(const string &input_path,
+                                       bool ast_cache = false,
+                                       bool incremental = false);
+}  // namespace semantic
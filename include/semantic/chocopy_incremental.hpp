@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string_view>
+
+#include "chocopy_parse.hpp"
+
+using std::string_view;
+
+namespace semantic {
+/** Lines line to line + removed - 1 of a source were replaced by added
+ * lines, numbered from line in the new source. */
+struct Edit {
+    int line = 1;
+    int removed = 0;
+    int added = 0;
+
+    int delta() const { return added - removed; }
+};
+
+/** The lines that differ between the two sources, after the lines they
+ * start with and before the lines they end with. */
+Edit diff_lines(string_view old_source, string_view new_source);
+
+/** Brings program, checked from old_source, up to date with new_source,
+ * which differs from it by edit, as an editor does after each change.
+ *
+ * The top-level declarations and the statements are the parts of the
+ * program, from the line each starts on to the next one. Only the part the
+ * edit falls in is parsed again, into the arena of the program, and
+ * declared and checked against the global scope it already has. The types
+ * of the other parts stay: a function and the methods of a class keep their
+ * entries and are given the new signatures and scopes in place, as the
+ * other parts and the subclasses refer to them. The parts that mention a function or a
+ * variable whose type changed are checked again after it, and the others
+ * are moved by the lines the edit added or removed, with their errors.
+ *
+ * Returns false when that is not enough: the edit spans two parts or
+ * changes the names, an error is found before the type checker, or a
+ * class changes its members. The program is then partly updated, and the
+ * caller checks new_source from scratch. */
+bool recheck(parser::Program &program, string_view old_source,
+             string_view new_source, const Edit &edit, string_view name);
+}  // namespace semantic
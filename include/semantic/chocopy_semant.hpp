@@ -1,11 +1,13 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <map>
 #include <memory>
 #include <set>
 #include <stack>
 #include <string>
+#include <thread>
 
 #include "ClassDefType.hpp"
 #include "FunctionDefType.hpp"
@@ -113,7 +115,12 @@ class SemanticError : public parser::CompilerErr {
 };
 
 /** Analyzer that performs ChocoPy type checks on all nodes.  Applied after
- *  collecting declarations. */
+ *  collecting declarations.
+ *
+ *  The declarations of the program and of its classes only read the global
+ *  and class scopes, which are complete by then, so they are checked on up
+ *  to JOBS threads, each with a copy of the checker. Their errors are kept
+ *  apart and merged in source order, as if checked one after the other. */
 class TypeChecker : public ast::ASTAnalyzer {
    public:
     void visit(parser::BinaryExpr &node) override;
@@ -158,9 +165,12 @@ class TypeChecker : public ast::ASTAnalyzer {
     SymbolTable *const global;
     HierachyTree *const hierachy_tree;
 
+    /** Threads checking the declarations; 1 checks them on this one. */
+    unsigned jobs = std::max(std::thread::hardware_concurrency(), 1u);
+
     /** For the nested function declaration */
     FunctionDefType *cur_func{};
-    std::vector<std::string> *cur_lambda_params;
+    std::vector<std::string> *cur_lambda_params{};
     stack<FunctionDefType *> saved_func{};
 
     bool is_lvalue{false};
@@ -188,7 +198,22 @@ class SymbolTableGenerator : public ast::ASTAnalyzer {
         : global_sym(&program.symbol_table),
           sym(&program.symbol_table),
           hierachy_tree(&program.hierachy_tree),
-          errors(&program.errors->compiler_errors) {
+          errors(&program.errors->compiler_errors) {}
+    void visit(parser::Program &) override;
+    void visit(parser::ClassDef &) override;
+    void visit(parser::VarDef &) override;
+    void visit(parser::FuncDef &) override;
+    void visit(parser::NonlocalDecl &) override;
+    void visit(parser::GlobalDecl &) override;
+
+    /** The type of one top-level declaration of a program that went through
+     * here before, without putting it in the global scope. The errors go to
+     * the program as usual. */
+    shared_ptr<SymbolType> declare(parser::Decl &decl);
+
+   private:
+    /** The classes and functions every program starts with. */
+    void add_predefined() {
         auto object_value_type = std::make_shared<ClassValueType>("object");
         auto none_value_type = std::make_shared<ClassValueType>("<None>");
 
@@ -198,7 +223,7 @@ class SymbolTableGenerator : public ast::ASTAnalyzer {
         object_init->return_type = none_value_type;
         object_init->params.emplace_back(object_value_type);
         object_class->current_scope.put("__init__", object_init);
-        sym->tab.insert({"object", object_class});
+        sym->put("object", object_class);
 
         auto str_class = std::make_shared<ClassDefType>("object", "str");
         auto str_init = std::make_shared<FunctionDefType>();
@@ -206,7 +231,7 @@ class SymbolTableGenerator : public ast::ASTAnalyzer {
         str_init->return_type = none_value_type;
         str_init->params.emplace_back(std::make_shared<ClassValueType>("str"));
         str_class->current_scope.put("__init__", str_init);
-        sym->tab.insert({"str", str_class});
+        sym->put("str", str_class);
 
         auto int_class = std::make_shared<ClassDefType>("object", "int");
         auto int_init = std::make_shared<FunctionDefType>();
@@ -214,7 +239,7 @@ class SymbolTableGenerator : public ast::ASTAnalyzer {
         int_init->return_type = none_value_type;
         int_init->params.emplace_back(std::make_shared<ClassValueType>("int"));
         int_class->current_scope.put("__init__", int_init);
-        sym->tab.insert({"int", int_class});
+        sym->put("int", int_class);
 
         auto bool_class = std::make_shared<ClassDefType>("object", "bool");
         auto bool_init = std::make_shared<FunctionDefType>();
@@ -223,33 +248,26 @@ class SymbolTableGenerator : public ast::ASTAnalyzer {
         bool_init->params.emplace_back(
             std::make_shared<ClassValueType>("bool"));
         bool_class->current_scope.put("__init__", bool_init);
-        sym->tab.insert({"bool", bool_class});
+        sym->put("bool", bool_class);
 
         auto len_func = std::make_shared<FunctionDefType>();
         len_func->func_name = "len";
         len_func->return_type = std::make_shared<ClassValueType>("int");
         len_func->params.emplace_back(object_value_type);
-        sym->tab.insert({"len", len_func});
+        sym->put("len", len_func);
 
         auto print_func = std::make_shared<FunctionDefType>();
         print_func->func_name = "print";
         print_func->return_type = none_value_type;
         print_func->params.emplace_back(object_value_type);
-        sym->tab.insert({"print", print_func});
+        sym->put("print", print_func);
 
         auto input_func = std::make_shared<FunctionDefType>();
         input_func->func_name = "input";
         input_func->return_type = std::make_shared<ClassValueType>("str");
-        sym->tab.insert({"input", input_func});
+        sym->put("input", input_func);
     }
-    void visit(parser::Program &) override;
-    void visit(parser::ClassDef &) override;
-    void visit(parser::VarDef &) override;
-    void visit(parser::FuncDef &) override;
-    void visit(parser::NonlocalDecl &) override;
-    void visit(parser::GlobalDecl &) override;
 
-   private:
     shared_ptr<SymbolType> return_value = nullptr;
     SymbolTable *const global_sym;  // Global symbol table
     SymbolTable *sym;               // Current symbol table
@@ -278,7 +296,7 @@ class DeclarationAnalyzer : public ast::ASTAnalyzer {
     vector<std::unique_ptr<parser::CompilerErr>> *errors;
 
    private:
-    ClassDefType *current_class;
+    ClassDefType *current_class{};
     SymbolTable *const globals;
     SymbolTable *sym;
     ClassDefType *getClass(const string &name) {
@@ -1,55 +1,111 @@
 #pragma once
 #include <cassert>
-#include <map>
 #include <string>
+#include <utility>
 #include <vector>
-using std::map;
+
+#include "chocopy_symbol.hpp"
 using std::string;
 using std::vector;
 namespace semantic {
+/** The classes by name, each with its super class. Every class is numbered
+ * in preorder of a walk from object, so that the classes below one are
+ * exactly those numbered from it to its last: two compares. The walk goes
+ * through int, bool and str first, so that the numbers of the predefined
+ * classes are their type tags in the runtime, and the numbers are used as
+ * the type tags of all the others. */
 class HierachyTree {
    public:
-    map<string, string> superclass_map;
-    map<string, int> depth_map;
-    map<string, vector<string>> subclasses_map;
+    using Symbol = parser::Symbol;
+    struct Class {
+        Symbol super_class;
+        vector<Symbol> subclasses;
+        unsigned pre = 0;
+        /** The largest number below this class. */
+        unsigned last = 0;
+
+        bool contains(const Class& other) const {
+            return pre <= other.pre && other.pre <= last;
+        }
+    };
+
     HierachyTree() {
-        superclass_map["object"] = "";
-        depth_map["object"] = 0;
-        add_class("str", "object");
+        classes_[Symbol("object")];
         add_class("int", "object");
         add_class("bool", "object");
+        add_class("str", "object");
     }
     void add_class(const string& class_, const string& super_class) {
-        assert(superclass_map.count(class_) == 0);
-        assert(superclass_map.contains(super_class));
-        superclass_map[class_] = super_class;
-        depth_map[class_] = depth_map.at(super_class) + 1;
-        subclasses_map[super_class].emplace_back(class_);
-    }
-    string common_ancestor(string class1, string class2) {
-        assert(superclass_map.contains(class1));
-        assert(superclass_map.contains(class2));
-        auto depth1 = depth_map.at(class1);
-        auto depth2 = depth_map.at(class2);
-        if (depth1 > depth2) {
-            std::swap(class1, class2);
-            std::swap(depth1, depth2);
-        }
-        while (depth1 < depth2) {
-            class2 = superclass_map[class2];
-            depth2--;
-        }
-        while (class1 != class2) {
-            class1 = superclass_map[class1];
-            class2 = superclass_map[class2];
+        add_class(Symbol(class_), Symbol(super_class));
+    }
+    void add_class(Symbol class_, Symbol super_class) {
+        assert(!classes_.contains(class_));
+        auto super_info = classes_.find(super_class);
+        assert(super_info != nullptr);
+        super_info->subclasses.push_back(class_);
+        classes_[class_].super_class = super_class;
+        numbered_ = false;
+    }
+    /** In the order they were added, object first. */
+    const parser::SymbolMap<Class>& classes() const { return classes_; }
+    const Class* find(const string& class_) const {
+        auto symbol = Symbol::find(class_);
+        return symbol ? classes_.find(*symbol) : nullptr;
+    }
+
+    string common_ancestor(const string& class1, const string& class2) {
+        auto name = Symbol::find(class1);
+        auto other = find(class2);
+        assert(name && other != nullptr);
+        number();
+        // up from class1 to the first class above class2 as well
+        auto info = classes_.find(*name);
+        while (!info->contains(*other)) {
+            name = info->super_class;
+            info = classes_.find(*name);
         }
-        return class1;
+        return name->str();
     }
     bool is_superclass(const string& subclass, const string& superclass) {
-        if (!superclass_map.contains(subclass) ||
-            !superclass_map.contains(superclass))
-            return false;
-        return common_ancestor(subclass, superclass) == superclass;
+        auto sub = find(subclass);
+        auto super = find(superclass);
+        if (sub == nullptr || super == nullptr) return false;
+        number();
+        return super->contains(*sub);
+    }
+    /** The numbers of class_ and of the last class below it. */
+    std::pair<unsigned, unsigned> interval(const string& class_) {
+        auto info = find(class_);
+        assert(info != nullptr);
+        number();
+        return {info->pre, info->last};
+    }
+
+    /** Numbers the classes if one was added since the last time. */
+    void number() {
+        if (numbered_) return;
+        unsigned pre = 0;
+        // (class, index of the next subclass to visit)
+        vector<std::pair<Class*, size_t>> stack;
+        auto root = classes_.find(Symbol("object"));
+        root->pre = pre++;
+        stack.emplace_back(root, 0);
+        while (!stack.empty()) {
+            auto& [info, next] = stack.back();
+            if (next == info->subclasses.size()) {
+                info->last = pre - 1;
+                stack.pop_back();
+                continue;
+            }
+            auto sub = classes_.find(info->subclasses[next++]);
+            sub->pre = pre++;
+            stack.emplace_back(sub, 0);
+        }
+        numbered_ = true;
     }
+
+   private:
+    parser::SymbolMap<Class> classes_;
+    bool numbered_ = false;
 };
 }  // namespace semantic
@@ -5,6 +5,7 @@
 #include <cassert>
 #include <ranges>
 #include <regex>
+#include <set>
 #include <string>
 #include <utility>
 
@@ -12,28 +13,34 @@
 #include "Constant.hpp"
 #include "Function.hpp"
 #include "GlobalVariable.hpp"
+#include "IRSerializer.hpp"
 #include "InstGen.hpp"
 #include "Module.hpp"
 #include "RiscVBackEnd.hpp"
+#include "TailCallElim.hpp"
 #include "Type.hpp"
 #include "Value.hpp"
 #include "chocopy_lightir.hpp"
+#include "chocopy_optimization.hpp"
 
 using namespace lightir;
 
 namespace cgen {
 int getTypeSizeInBytes(Type *type) {
-    if (dynamic_cast<PtrType *>(type)) {
+    if (dyn_cast<PtrType>(type)) {
         return 4;
     } else if (type->is_integer_type() || type->is_bool_type()) {
         return 4;  // bool and int are 4 bytes
-    } else if (auto class_ = dynamic_cast<Class *>(type);
+    } else if (auto class_ = dyn_cast<Class>(type);
                class_ && class_->anon_) {
         int ret = 0;
         for (auto attr : *class_->get_attribute()) {
             ret += getTypeSizeInBytes(attr->get_type());
         }
         return ret;
+    } else if (class_) {
+        // an object moved to the stack: the header and one word per attribute
+        return 4 * (3 + class_->get_attribute()->size());
     }
     assert(0);
 }
@@ -119,16 +126,16 @@ InstGen::Reg CodeGen::getReg(const string &vreg, int fallback) {
         return InstGen::Reg(fallback);
 }
 string CodeGen::vregToReg(Value *vreg, InstGen::Reg reg) {
-    if (dynamic_cast<ConstantNull *>(vreg)) {
+    if (dyn_cast<ConstantNull>(vreg)) {
         return backend->emit_li(reg, 0);
-    } else if (auto c = dynamic_cast<ConstantInt *>(vreg); c) {
+    } else if (auto c = dyn_cast<ConstantInt>(vreg); c) {
         return backend->emit_li(reg, c->get_value());
-    } else if (auto a = dynamic_cast<AllocaInst *>(vreg)) {
+    } else if (auto a = dyn_cast<AllocaInst>(vreg)) {
         assert(stack_size != 0);
         return backend->emit_addi(
             reg, InstGen::Reg("fp"),
             alloca_to_stack_slot.at(a->get_name()).getOffset());
-    } else if (auto cls = dynamic_cast<Class *>(vreg); cls) {
+    } else if (auto cls = dyn_cast<Class>(vreg); cls) {
         return backend->emit_la(reg, InstGen::Addr(cls->prototype_label_));
     } else if (auto name = vreg->get_name(); GOT.contains(name)) {
         return backend->emit_la(reg, InstGen::Addr(name));
@@ -177,11 +184,13 @@ string CodeGen::generateModuleCode() {
     for (auto &classInfo : this->module->get_class()) {
         asm_code += backend->emit_prototype(*classInfo);
     }
+    asm_code += backend->emit_type_tag_table(
+        type_tag_table(this->module->get_class()));
     asm_code += generateGlobalVarsCode();
 
     asm_code += ".text\n";
     for (auto func : this->module->get_functions()) {
-        assert(dynamic_cast<Function *>(func));
+        assert(dyn_cast<Function>(func));
         if (func->get_basic_blocks().size()) {
             asm_code += CodeGen::generateFunctionCode(func);
         }
@@ -205,7 +214,7 @@ void CodeGen::lifetimeAnalysis() {
         basic_block_from[bb] = inst_count++;
         for (auto &inst : bb->get_instructions()) {
             inst_id[inst] = inst_count++;
-            if (auto phi = dynamic_cast<PhiInst *>(inst); phi) {
+            if (auto phi = dyn_cast<PhiInst>(inst); phi) {
                 assert(phi->get_num_operand() == 4);
                 phi_instructions[bb].push_back(phi);
             }
@@ -258,18 +267,18 @@ void CodeGen::lifetimeAnalysis() {
                 int id = inst_id[inst];
 
                 live.erase(inst->get_name());
-                if (dynamic_cast<PhiInst *>(inst)) continue;
+                if (dyn_cast<PhiInst>(inst)) continue;
                 // std::cerr << " " << inst->get_name() << " setCreatePosition "
                 // << id << std::endl;
                 intervals[inst->get_name()].setCreatePosition(id);
 
-                if (dynamic_cast<AsmInst *>(inst)) continue;
+                if (dyn_cast<AsmInst>(inst)) continue;
                 ;
                 for (const auto &op : inst->get_operands()) {
-                    if (dynamic_cast<GlobalVariable *>(op) ||
-                        dynamic_cast<Class *>(op) ||
-                        dynamic_cast<Function *>(op) ||
-                        dynamic_cast<BasicBlock *>(op))
+                    if (dyn_cast<GlobalVariable>(op) ||
+                        dyn_cast<Class>(op) ||
+                        dyn_cast<Function>(op) ||
+                        dyn_cast<BasicBlock>(op))
                         continue;
                     // std::cerr << " " << op->get_name() << " addRange " <<
                     // bb_from << ' ' << id << std::endl;
@@ -330,12 +339,15 @@ void CodeGen::linearScan() {
     reg_to_vreg.clear();
     alloca_to_stack_slot.clear();
 
-    int call_count = 0;
-    std::set<std::string> call_inst_names;
+    int call_count = 0, vext_count = 0;
+    std::set<std::string> call_inst_names, vext_inst_names;
     std::map<std::string, int> alloca_inst_to_bytes;
     for (auto bb : current_function->get_basic_blocks()) {
         for (auto inst : bb->get_instructions()) {
-            if (dynamic_cast<CallInst *>(inst)) {
+            // nothing is live after a noreturn call, so it needs neither
+            // caller-saved spills nor a saved ra
+            if (auto call = dyn_cast<CallInst>(inst);
+                call && !call->is_noreturn()) {
                 if (inst->get_name() == "") {
                     call_inst_names.insert(fmt::format("call{}", call_count));
                     intervals[fmt::format("call{}", call_count)].addRange(
@@ -349,7 +361,14 @@ void CodeGen::linearScan() {
                     }
                 }
             }
-            if (dynamic_cast<AllocaInst *>(inst)) {
+            // the vector loop runs in the temporaries, which include t3-t6
+            if (dyn_cast<VExtInst>(inst)) {
+                vext_inst_names.insert(fmt::format("vext{}", vext_count));
+                intervals[fmt::format("vext{}", vext_count)].addRange(
+                    inst_id[inst], inst_id[inst]);
+                vext_count++;
+            }
+            if (dyn_cast<AllocaInst>(inst)) {
                 alloca_inst_to_bytes.insert(
                     {inst->get_name(),
                      getTypeSizeInBytes(
@@ -536,6 +555,12 @@ void CodeGen::linearScan() {
                 pair_vreg_reg(op, Reg(10));
                 active.insert(op);
             }
+        } else if (vext_inst_names.contains(op)) {
+            auto i = Interval();
+            i.addRange(pos, pos);
+            for (const auto &reg : temp_regs) {
+                move_conflict_vreg_to_stack(reg, i);
+            }
         } else if (op.starts_with("arg")) {
         } else {
             if (alloca_inst_to_bytes.contains(op)) {
@@ -577,6 +602,14 @@ void CodeGen::linearScan() {
     // std::cerr << "Linear scan done" << std::endl << std::endl;
 }
 
+/** A call marked by TailCallElim which the backend turns into a jump: its
+ * arguments must all be passed in registers, as the caller's frame is gone by
+ * the time the callee runs. */
+static bool is_lowered_tail_call(Value *val) {
+    auto call = dyn_cast<CallInst>(val);
+    return call && call->is_tail_call() && call->get_num_operand() - 1 <= 8;
+}
+
 string CodeGen::generateFunctionCode(Function *func) {
     using Reg = InstGen::Reg;
     using Addr = InstGen::Addr;
@@ -595,12 +628,12 @@ string CodeGen::generateFunctionCode(Function *func) {
     phi_store.clear();
     for (auto b : func->get_basic_blocks()) {
         for (auto i : b->get_instructions()) {
-            if (auto phi = dynamic_cast<PhiInst *>(i); phi) {
+            if (auto phi = dyn_cast<PhiInst>(i); phi) {
                 if (!vreg_to_reg.contains(phi->get_name())) continue;
                 auto ops = phi->get_operands();
                 assert(phi->get_operands().size() == 4);
-                assert(dynamic_cast<BasicBlock *>(ops[1]) &&
-                       dynamic_cast<BasicBlock *>(ops[3]));
+                assert(dyn_cast<BasicBlock>(ops[1]) &&
+                       dyn_cast<BasicBlock>(ops[3]));
                 auto v1 = ops[0];
                 auto b1 = (BasicBlock *)ops[1];
                 auto v2 = ops[2];
@@ -646,12 +679,54 @@ string CodeGen::generateFunctionCode(Function *func) {
             asm_code += regToStack(Reg(10 + i), it->second);
         }
     }
+    // Cold blocks are laid out after the hot path, so error checks fall
+    // through to the common case.  Those which only call an error routine are
+    // identical and share one body per callee.
+    std::vector<BasicBlock *> cold_bbs;
     for (auto b : func->get_basic_blocks()) {
+        if (b != func->get_entry_block() && b->is_cold()) {
+            cold_bbs.push_back(b);
+            continue;
+        }
         asm_code += fmt::format("{}:\n", getLabelName(b), b->get_name());
         asm_code += generateBasicBlockCode(b);
     }
+    map<string, std::vector<BasicBlock *>> cold_trampolines;
+    for (auto b : cold_bbs) {
+        auto &instrs = b->get_instructions();
+        if (instrs.size() == 2 && instrs.front()->is_call() &&
+            instrs.front()->get_num_operand() == 1 &&
+            instrs.back()->is_unreachable() && !phi_store.contains(b)) {
+            cold_trampolines[instrs.front()->get_operand(0)->get_name()]
+                .push_back(b);
+            continue;
+        }
+        asm_code += fmt::format("{}:\n", getLabelName(b), b->get_name());
+        asm_code += generateBasicBlockCode(b);
+    }
+    for (auto &[callee, bbs] : cold_trampolines) {
+        for (auto b : bbs) {
+            asm_code += fmt::format("{}:\n", getLabelName(b));
+        }
+        asm_code += generateBasicBlockCode(bbs.front());
+    }
 
     asm_code += fmt::format("{}$return:\n", func->get_name());
+    asm_code += generateFunctionExitCode();
+    asm_code += fmt::format("  ret\n");
+    return asm_code;
+}
+
+CodeGen::CodeGen(shared_ptr<Module> module)
+    : module(std::move(module)), backend(new RiscVBackEnd()) {}
+
+[[nodiscard]] string CodeGen::generateFunctionExitCode() {
+    using Reg = InstGen::Reg;
+    const Reg fp = Reg("fp");
+    const Reg sp = Reg("sp");
+    const Reg t0 = Reg("t0");
+    const int callee_save_regs[] = {9, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27};
+    std::string asm_code;
     if (vreg_to_stack_slot.contains("ra")) {
         asm_code += stackToReg(vreg_to_stack_slot.at("ra"), Reg("ra"));
     }
@@ -670,15 +745,6 @@ string CodeGen::generateFunctionCode(Function *func) {
             asm_code += backend->emit_add(sp, sp, t0);
         }
     }
-    asm_code += fmt::format("  ret\n");
-    return asm_code;
-}
-
-CodeGen::CodeGen(shared_ptr<Module> module)
-    : module(std::move(module)), backend(new RiscVBackEnd()) {}
-
-[[nodiscard]] string CodeGen::generateFunctionExitCode() {
-    std::string asm_code;
     return asm_code;
 }
 string CodeGen::generateBasicBlockCode(BasicBlock *bb) {
@@ -714,6 +780,8 @@ string CodeGen::generateInstructionCode(Instruction *inst) {
     switch (inst->get_instr_type()) {
         case lightir::Instruction::Ret: {
             assert(ops.size() == 0 || ops.size() == 1);
+            // the callee returns to our caller
+            if (ops.size() == 1 && is_lowered_tail_call(ops[0])) break;
             if (ops.size() == 1) {
                 asm_code += vregToReg(ops[0], Reg(10));
             }
@@ -725,11 +793,11 @@ string CodeGen::generateInstructionCode(Instruction *inst) {
             asm_code += generateBasicBlockPostCode(current_basic_block);
             if (ops.size() == 1) {
                 // unconditional branch
-                assert(dynamic_cast<BasicBlock *>(ops[0]));
+                assert(dyn_cast<BasicBlock>(ops[0]));
                 asm_code +=
                     fmt::format("  j {}\n", getLabelName((BasicBlock *)ops[0]));
             } else if (ops.size() == 3) {
-                assert(dynamic_cast<BasicBlock *>(ops[1]));
+                assert(dyn_cast<BasicBlock>(ops[1]));
                 auto rs = getReg(ops[0]->get_name());
                 asm_code += vregToReg(ops[0], rs);
                 asm_code += backend->emit_beq(
@@ -740,6 +808,9 @@ string CodeGen::generateInstructionCode(Instruction *inst) {
             }
             break;
         }
+        case lightir::Instruction::Unreachable: {
+            break;
+        }
         case lightir::Instruction::Neg:
         case lightir::Instruction::Not: {
             if (!vreg_to_reg.contains(inst->get_name())) break;
@@ -812,7 +883,7 @@ string CodeGen::generateInstructionCode(Instruction *inst) {
             Reg rd = vreg_to_reg.at(inst->get_name());
             assert(ops.size() == 1);
             string op = ops[0]->get_name();
-            if (inst->get_type()->print() == "i8") {
+            if (inst->get_type() == IntegerType::get(8, module.get())) {
                 auto rs = getReg(op);
                 asm_code += vregToReg(ops[0], rs);
                 asm_code += backend->emit_lbu(rd, rs, 0);
@@ -842,16 +913,16 @@ string CodeGen::generateInstructionCode(Instruction *inst) {
             auto vreg = ops[0];
             auto rs1 = Reg(5);
 
-            if (dynamic_cast<ConstantNull *>(vreg)) {
+            if (dyn_cast<ConstantNull>(vreg)) {
                 asm_code += backend->emit_li(rs1, 0);
-            } else if (auto c = dynamic_cast<ConstantInt *>(vreg); c) {
+            } else if (auto c = dyn_cast<ConstantInt>(vreg); c) {
                 asm_code += backend->emit_li(rs1, c->get_value());
-            } else if (auto a = dynamic_cast<AllocaInst *>(vreg)) {
+            } else if (auto a = dyn_cast<AllocaInst>(vreg)) {
                 assert(stack_size != 0);
                 asm_code += backend->emit_addi(
                     rs1, InstGen::Reg("fp"),
                     alloca_to_stack_slot.at(a->get_name()).getOffset());
-            } else if (auto cls = dynamic_cast<Class *>(vreg); cls) {
+            } else if (auto cls = dyn_cast<Class>(vreg); cls) {
                 asm_code +=
                     backend->emit_la(rs1, InstGen::Addr(cls->prototype_label_));
             } else if (auto name = vreg->get_name(); GOT.contains(name)) {
@@ -861,7 +932,7 @@ string CodeGen::generateInstructionCode(Instruction *inst) {
                 asm_code += vregToReg(vreg, rs1);
             }
 
-            if (dynamic_cast<AllocaInst *>(ops[1])) {
+            if (dyn_cast<AllocaInst>(ops[1])) {
                 asm_code += regToStack(
                     rs1, alloca_to_stack_slot.at(ops[1]->get_name()));
             } else {
@@ -907,7 +978,23 @@ string CodeGen::generateInstructionCode(Instruction *inst) {
             break;
         }
         case lightir::Instruction::Call: {
-            if (dynamic_cast<Function *>(ops[0])) {
+            if (is_lowered_tail_call(inst)) {
+                // tear down the frame once the arguments are in a0-a7, and
+                // jump to the callee with our ra
+                if (dyn_cast<Function>(ops[0])) {
+                    asm_code += generateFunctionCall(
+                        inst,
+                        generateFunctionExitCode() +
+                            fmt::format("  tail {}\n", ops[0]->get_name()),
+                        ops);
+                } else {
+                    asm_code += vregToReg(ops[0], Reg(6));
+                    asm_code += generateFunctionCall(
+                        inst, generateFunctionExitCode() + "  jr t1\n", ops);
+                }
+                break;
+            }
+            if (dyn_cast<Function>(ops[0])) {
                 auto func_name = ops[0]->get_name();
                 asm_code += generateFunctionCall(
                     inst, fmt::format("  call {}\n", func_name), ops);
@@ -927,17 +1014,17 @@ string CodeGen::generateInstructionCode(Instruction *inst) {
             Reg rd = vreg_to_reg.at(inst->get_name());
             auto gep = (GetElementPtrInst *)inst;
             auto ptr = ops[0];
-            assert(dynamic_cast<PtrType *>(ptr->get_type()));
+            assert(dyn_cast<PtrType>(ptr->get_type()));
             auto inner_type = ((PtrType *)ptr->get_type())->get_element_type();
-            if (dynamic_cast<Class *>(inner_type) ||
+            if (dyn_cast<Class>(inner_type) ||
                 inner_type->print().ends_with("$dispatchTable_type")) {
                 // it seems that every attribute is 4 bytes
-                assert(dynamic_cast<ConstantInt *>(ops[1]));
+                assert(dyn_cast<ConstantInt>(ops[1]));
                 auto idx = ((ConstantInt *)ops[1])->get_value();
                 auto rs = getReg(ptr->get_name());
                 asm_code += vregToReg(ptr, rs);
                 asm_code += backend->emit_addi(rd, rs, idx * 4);
-            } else if (auto i = dynamic_cast<IntegerType *>(inner_type)) {
+            } else if (auto i = dyn_cast<IntegerType>(inner_type)) {
                 auto rs1 = getReg(ptr->get_name());
                 asm_code += vregToReg(ptr, rs1);
                 auto rs2 = getReg(ops[1]->get_name());
@@ -989,10 +1076,13 @@ string CodeGen::generateInstructionCode(Instruction *inst) {
             asm_code += "  " + asm_ + "\n";
             break;
         }
+        case lightir::Instruction::VExt: {
+            asm_code += generateVectorLoop((VExtInst *)inst);
+            break;
+        }
         case lightir::Instruction::InElem:
         case lightir::Instruction::ExElem:
         case lightir::Instruction::Trunc:
-        case lightir::Instruction::VExt:
         case lightir::Instruction::Shl:
         case lightir::Instruction::AShr:
         case lightir::Instruction::LShr: {
@@ -1004,6 +1094,96 @@ string CodeGen::generateInstructionCode(Instruction *inst) {
     // std::cerr << "---" << std::endl;
     return asm_code;
 }
+string CodeGen::generateVectorLoop(VExtInst *inst) {
+    using Reg = InstGen::Reg;
+    using Addr = InstGen::Addr;
+    using Kind = VExtInst::NodeKind;
+    const auto &program = inst->get_program();
+    auto &ops = inst->get_operands();
+    const auto label =
+        fmt::format(".{}_vext{}", current_function->get_name(), inst_id[inst]);
+
+    // t0 counts the elements left, t1 holds vl, and the pointers and scalars
+    // live in t2-t6, which linearScan keeps free here. The operands go
+    // through the stack, like the arguments of a call, so that none is
+    // overwritten before it is read.
+    const Reg t0 = Reg("t0");
+    const Reg t1 = Reg("t1");
+    auto op_reg = [](unsigned i) { return temp_regs.at(i + 1); };
+    auto slot = [](unsigned i) { return Addr(Reg("sp"), -4 * (int)(i + 1)); };
+    std::string asm_code;
+    for (unsigned i = 0; i < ops.size(); i++) {
+        auto rs = getReg(ops[i]->get_name());
+        asm_code += vregToReg(ops[i], rs);
+        asm_code += regToStack(rs, slot(i));
+    }
+    for (unsigned i = 1; i < ops.size(); i++) {
+        asm_code += stackToReg(slot(i), op_reg(i));
+    }
+    asm_code += stackToReg(slot(0), t0);
+    asm_code += fmt::format("  blez t0, {}_end\n", label);
+
+    // one register group per node, v0 is left alone
+    int lmul = 8;
+    while (lmul > 1 && (int)program.size() * lmul > 32 - lmul) lmul /= 2;
+    auto vreg = [&](unsigned node) { return (int)(node + 1) * lmul; };
+
+    asm_code += fmt::format("{}:\n", label);
+    asm_code += backend->emit_vsetvli(t1, t0, 32, lmul);
+    for (unsigned i = 0; i < program.size(); i++) {
+        const auto &node = program[i];
+        const auto lhs = program[node.lhs].kind == Kind::Scalar;
+        const auto rhs = program[node.rhs].kind == Kind::Scalar;
+        string op;
+        switch (node.kind) {
+            case Kind::Stream:
+                asm_code += backend->emit_vload(vreg(i), op_reg(node.lhs));
+                continue;
+            case Kind::Scalar:
+                // only splatted when it is stored as is
+                if (i + 1 == program.size())
+                    asm_code +=
+                        backend->emit_vmv_v_x(vreg(i), op_reg(node.lhs));
+                continue;
+            case Kind::Add:
+                op = "vadd";
+                break;
+            case Kind::Sub:
+                op = lhs ? "vrsub" : "vsub";
+                break;
+            case Kind::Mul:
+                op = "vmul";
+                break;
+        }
+        // ints computed from scalars only are scalars themselves
+        assert(!(lhs && rhs));
+        if (lhs) {
+            asm_code += backend->emit_vx(op, vreg(i), vreg(node.rhs),
+                                         op_reg(program[node.lhs].lhs));
+        } else if (rhs) {
+            asm_code += backend->emit_vx(op, vreg(i), vreg(node.lhs),
+                                         op_reg(program[node.rhs].lhs));
+        } else {
+            asm_code +=
+                backend->emit_vv(op, vreg(i), vreg(node.lhs), vreg(node.rhs));
+        }
+    }
+    asm_code += backend->emit_vstore(vreg(program.size() - 1), op_reg(1));
+
+    // advance the pointers by vl words
+    asm_code += backend->emit_sub(t0, t0, t1);
+    asm_code += backend->emit_slli(t1, t1, 2);
+    asm_code += backend->emit_add(op_reg(1), op_reg(1), t1);
+    std::set<unsigned> streams;
+    for (const auto &node : program) {
+        if (node.kind == Kind::Stream && streams.insert(node.lhs).second)
+            asm_code +=
+                backend->emit_add(op_reg(node.lhs), op_reg(node.lhs), t1);
+    }
+    asm_code += fmt::format("  bnez t0, {}\n", label);
+    asm_code += fmt::format("{}_end:\n", label);
+    return asm_code;
+}
 string CodeGen::getLabelName(BasicBlock *bb) {
     return "." + bb->get_parent()->get_name() + "_" + bb->get_name();
 }
@@ -1066,7 +1246,7 @@ string CodeGen::generateGlobalVarsCode() {
                         "\n";
         } else {
             asm_code += CodeGen::generateInitializerCode(
-                dynamic_cast<Constant *>(global_var->get_operands().at(0)));
+                dyn_cast<Constant>(global_var->get_operands().at(0)));
         }
     }
     LOG(INFO) << asm_code;
@@ -1074,7 +1254,7 @@ string CodeGen::generateGlobalVarsCode() {
 }
 string CodeGen::generateInitializerCode(Constant *init) {
     string asm_code;
-    if (auto str_init = dynamic_cast<ConstantStr *>(init); str_init) {
+    if (auto str_init = dyn_cast<ConstantStr>(init); str_init) {
         // guarantee the string is the last attribute of any class
         string str = str_init->get_value();
         string str_label = fmt::format(".Lstr.{}", init->get_name());
@@ -1131,12 +1311,12 @@ string CodeGen::generateInitializerCode(Constant *init) {
         }
         asm_code += "\"\n";
         asm_code += "\n";
-    } else if (auto box_int = dynamic_cast<ConstantBoxInt *>(init); box_int) {
+    } else if (auto box_int = dyn_cast<ConstantBoxInt>(init); box_int) {
         asm_code += "  .word 1\n";
         asm_code += "  .word 4\n";
         asm_code += "  .word $int$dispatchTable\n";
         asm_code += fmt::format("  .word {}\n", box_int->get_value());
-    } else if (auto box_bool = dynamic_cast<ConstantBoxBool *>(init);
+    } else if (auto box_bool = dyn_cast<ConstantBoxBool>(init);
                box_bool) {
         asm_code += "  .word 2\n";
         asm_code += "  .word 4\n";
@@ -1153,13 +1333,13 @@ string CodeGen::generateInitializerCode(Constant *init) {
     return asm_code;
 }
 pair<int, bool> CodeGen::getConstIntVal(Value *val) {
-    auto const_val = dynamic_cast<ConstantInt *>(val);
-    auto inst_val = dynamic_cast<Instruction *>(val);
+    auto const_val = dyn_cast<ConstantInt>(val);
+    auto inst_val = dyn_cast<Instruction>(val);
     if (const_val) {
         return std::make_pair(const_val->get_value(), true);
     } else if (inst_val) {
         auto op_list = inst_val->get_operands();
-        if (dynamic_cast<BinaryInst *>(val)) {
+        if (dyn_cast<BinaryInst>(val)) {
             auto val_0 = CodeGen::getConstIntVal(op_list.at(0));
             auto val_1 = CodeGen::getConstIntVal(op_list.at(1));
             if (val_0.second && val_1.second) {
@@ -1196,7 +1376,7 @@ pair<int, bool> CodeGen::getConstIntVal(Value *val) {
                 return std::make_pair(0, false);
             }
         }
-        if (dynamic_cast<UnaryInst *>(val)) {
+        if (dyn_cast<UnaryInst>(val)) {
             auto val_0 = CodeGen::getConstIntVal(op_list.at(0));
             if (val_0.second) {
                 int ret = 0;
@@ -1217,7 +1397,7 @@ pair<int, bool> CodeGen::getConstIntVal(Value *val) {
                 return std::make_pair(0, false);
             }
         }
-    } else if (dynamic_cast<ConstantNull *>(val)) {
+    } else if (dyn_cast<ConstantNull>(val)) {
         return std::make_pair(0, true);
     }
     LOG(ERROR) << "Function getConstIntVal exception!";
@@ -1249,6 +1429,8 @@ int main(int argc, char *argv[]) {
     bool emit = false;
     bool run = false;
     bool assem = false;
+    CompileOptions options;
+    bool emit_ir = false;
 
     for (int i = 1; i < argc; ++i) {
         if (argv[i] == "-h"s || argv[i] == "--help"s) {
@@ -1268,11 +1450,35 @@ int main(int argc, char *argv[]) {
             assem = true;
         } else if (argv[i] == "-run"s) {
             run = true;
+        } else if (argv[i] == "-pass"s) {
+            if (i + 1 < argc && lightir::PassManager::has_Pass(argv[i + 1])) {
+                options.passes.emplace_back(argv[i + 1]);
+                i += 1;
+            } else {
+                print_help(argv[0]);
+                return 0;
+            }
+        } else if (argv[i] == "-ir-cache"s) {
+            options.ir_cache = true;
+        } else if (argv[i] == "-ast-cache"s) {
+            options.ast_cache = true;
+        } else if (argv[i] == "-verify"s) {
+            options.verify = true;
+        } else if (argv[i] == "-emit-ir"s) {
+            emit_ir = true;
+        } else if (argv[i] == "-unroll-factor"s) {
+            if (i + 1 < argc) {
+                options.unroll_factor = std::stoi(argv[i + 1]);
+                i += 1;
+            } else {
+                print_help(argv[0]);
+                return 0;
+            }
         } else {
             if (input_path.empty()) {
                 input_path = argv[i];
                 if (target_path.empty())
-                    target_path = replace_all(input_path, ".py", "");
+                    target_path = target_of(input_path);
             } else {
                 print_help(argv[0]);
                 return 0;
@@ -1280,47 +1486,16 @@ int main(int argc, char *argv[]) {
         }
     }
 
-    std::unique_ptr<parser::Program> tree(parse(input_path.c_str()));
-    if (tree->errors->compiler_errors.size() != 0) {
-        cout << "Syntax Error" << endl;
-        return 0;
-    }
-
-    auto symboltableGenerator = semantic::SymbolTableGenerator(*tree);
-    tree->accept(symboltableGenerator);
-    if (tree->errors->compiler_errors.size() == 0) {
-        auto declarationAnalyzer = semantic::DeclarationAnalyzer(*tree);
-        tree->accept(declarationAnalyzer);
-    }
-    if (tree->errors->compiler_errors.size() == 0) {
-        auto typeChecker = semantic::TypeChecker(*tree);
-        tree->accept(typeChecker);
-    }
-
-    if (tree->errors->compiler_errors.size() != 0) {
-        cout << "Type Error" << endl;
-        return 0;
-    }
-
-    std::shared_ptr<lightir::Module> m;
-    auto LightWalker = lightir::LightWalker(*tree);
-    tree->accept(LightWalker);
-    m = LightWalker.get_module();
+    auto m = compile_module(
+        "cgen", input_path, target_path, options,
+        [](lightir::PassManager &pm) {
+            // deep recursion would otherwise overflow the stack
+            pm.add_Pass<lightir::TailCallElim>();
+        });
+    if (m == nullptr) return 0;
     m->source_file_name_ = input_path;
 
-    string IR = fmt::format(
-        "; ModuleID = \"{}\"\n"
-        "source_filename = \"{}\"\n"
-        "{}",
-        m->module_name_, m->source_file_name_, m->print());
-
-    std::ofstream output_stream(target_path + ".ll");
-    output_stream << IR;
-    output_stream.flush();
-
-    if (emit) {
-        cout << IR;
-    }
+    write_ir(m.get(), target_path, emit_ir, emit);
 
     cgen::CodeGen code_generator(m);
     string asm_code = code_generator.generateModuleCode();
@@ -1334,14 +1509,20 @@ int main(int argc, char *argv[]) {
     }
 
     if (run) {
+        // vectorized code needs the V extension
+        const bool vectorized =
+            std::ranges::find(options.passes, "Vectorize") !=
+            options.passes.end();
         auto generate_exec = fmt::format(
-            "riscv64-elf-gcc -mabi=ilp32 -march=rv32imac -g "
+            "riscv64-elf-gcc -mabi=ilp32 -march={} -g "
             "-o {} {}.s "
             "-L./ -L./build -L../build -lchocopy_stdlib",
-            target_path, target_path);
+            vectorized ? "rv32imacv" : "rv32imac", target_path, target_path);
         int re_code_0 = std::system(generate_exec.c_str());
 
-        auto qemu_run = fmt::format("qemu-riscv32 {}", target_path);
+        auto qemu_run = fmt::format("qemu-riscv32 {}{}",
+                                    vectorized ? "-cpu rv32,v=true " : "",
+                                    target_path);
         int re_code_1 = std::system(qemu_run.c_str());
     }
     return 0;
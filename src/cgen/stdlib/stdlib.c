@@ -187,19 +187,19 @@ struct list_object* concat_list(struct list_object* l1,
     return list_obj;
 }
 
-void error_Div() asm("error.Div");
+void error_Div() asm("error.Div") __attribute__((noreturn));
 void error_Div() {
     printf("Division by zero\n");
     exit(2);
 }
 
-void error_OOB() asm("error.OOB");
+void error_OOB() asm("error.OOB") __attribute__((noreturn));
 void error_OOB() {
     printf("Index out of bounds\n");
     exit(3);
 }
 
-void error_None() asm("error.None");
+void error_None() asm("error.None") __attribute__((noreturn));
 void error_None() {
     printf("Operation on None\n");
     exit(4);
@@ -0,0 +1,47 @@
+#include "Arena.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <ranges>
+
+#include "Value.hpp"
+
+namespace lightir {
+thread_local Arena *Arena::allocating_ = nullptr;
+
+Arena::~Arena() {
+    clear();
+    if (allocating_ == this) allocating_ = nullptr;
+}
+
+void *Arena::allocate(size_t size) {
+    auto p = static_cast<std::byte *>(memory_.allocate(size));
+    pending_.emplace_back(p, p + size);
+    allocating_ = this;
+    return p;
+}
+
+void Arena::own(Value *v) {
+    assert(allocating_ != nullptr && "value not allocated with new (m)");
+    auto &pending = allocating_->pending_;
+    /** v may be a base at an offset in the object, e.g. of a Class */
+    auto p = reinterpret_cast<std::byte *>(v);
+    auto it = std::find_if(pending.rbegin(), pending.rend(), [p](auto &r) {
+        return r.first <= p && p < r.second;
+    });
+    if (it == pending.rend()) {
+        assert(0 && "value not allocated with new (m)");
+        return;
+    }
+    pending.erase(std::next(it).base());
+    allocating_->values_.push_back(v);
+}
+
+void Arena::clear() {
+    /** in reverse, as a value may refer to those created before it */
+    for (auto v : values_ | std::views::reverse) {
+        v->~Value();
+    }
+    values_.clear();
+}
+}  // namespace lightir
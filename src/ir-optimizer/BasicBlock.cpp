@@ -1,6 +1,7 @@
 #include "BasicBlock.hpp"
 
 #include <cassert>
+#include <sstream>
 
 #include "Function.hpp"
 #include "IRprinter.hpp"
@@ -10,6 +11,7 @@ namespace lightir {
 BasicBlock::BasicBlock(Module *m, const string &name = "",
                        Function *parent = nullptr)
     : Value(Type::get_label_type(m), name), parent_(parent) {
+    set_value_kind(ValueKind::BasicBlock);
     assert(parent && "currently parent should not be nullptr");
     parent_->add_basic_block(this);
 }
@@ -17,29 +19,31 @@ BasicBlock::BasicBlock(Module *m, const string &name = "",
 Module *BasicBlock::get_module() { return get_parent()->get_parent(); }
 
 void BasicBlock::add_instruction(Instruction *instr) {
-    instr_list_.push_back(instr);
+    instr->set_parent(this);
+    instr->pos_ = instr_list_.insert(instr_list_.end(), instr);
 }
 
 void BasicBlock::add_instr_begin(Instruction *instr) {
-    instr_list_.push_front(instr);
+    instr->set_parent(this);
+    instr->pos_ = instr_list_.insert(instr_list_.begin(), instr);
 }
 
 void BasicBlock::insert_instr(Instruction *pos, Instruction *insert) {
-    insert->set_parent(pos->get_parent());
-    for (auto instr = instr_list_.begin(); instr != instr_list_.end();
-         instr++) {
-        if (*instr == pos) {
-            instr_list_.insert(instr, insert);
-            return;
-        }
-    }
+    assert(pos->get_parent() == this && "pos is not in this block");
+    insert->set_parent(this);
+    insert->pos_ = instr_list_.insert(pos->pos_, insert);
 }
 
 void BasicBlock::delete_instr(Instruction *instr) {
-    instr_list_.remove(instr);
+    remove_instr(instr);
     instr->remove_use_of_ops();
 }
 
+void BasicBlock::remove_instr(Instruction *instr) {
+    assert(instr->get_parent() == this && "instr is not in this block");
+    instr_list_.erase(instr->pos_);
+}
+
 const Instruction *BasicBlock::get_terminator() const {
     if (instr_list_.empty()) {
         return nullptr;
@@ -47,6 +51,7 @@ const Instruction *BasicBlock::get_terminator() const {
     switch (instr_list_.back()->get_instr_type()) {
         case Instruction::Ret:
         case Instruction::Br:
+        case Instruction::Unreachable:
             return instr_list_.back();
 
         default:
@@ -56,32 +61,39 @@ const Instruction *BasicBlock::get_terminator() const {
 
 void BasicBlock::erase_from_parent() { this->get_parent()->remove(this); }
 
+bool BasicBlock::is_cold() {
+    for (auto instr : instr_list_) {
+        if (instr->is_call() && static_cast<CallInst *>(instr)->is_noreturn())
+            return true;
+    }
+    return false;
+}
+
 string BasicBlock::print() {
-    string bb_ir;
-    bb_ir += "\n";
-    bb_ir += this->get_name();
-    bb_ir += ":";
+    std::ostringstream bb_ir;
+    print(bb_ir);
+    return bb_ir.str();
+}
+
+void BasicBlock::print(std::ostream &out) {
+    out << "\n" << this->get_name() << ":";
     /** print prebb */
     if (!this->get_pre_basic_blocks().empty()) {
-        bb_ir += fmt::format("{:<48}; preds = ", "");
+        out << fmt::format("{:<48}; preds = ", "");
     }
     for (auto bb : this->get_pre_basic_blocks()) {
-        if (bb != *this->get_pre_basic_blocks().begin()) bb_ir += ", ";
-        bb_ir += print_as_op(bb, false);
+        if (bb != *this->get_pre_basic_blocks().begin()) out << ", ";
+        out << print_as_op(bb, false);
     }
 
     /** print pre-basic block */
     if (!this->get_parent()) {
-        bb_ir += "\n";
-        bb_ir += "; Error: Block without parent!";
+        out << "\n";
+        out << "; Error: Block without parent!";
     }
-    bb_ir += "\n";
+    out << "\n";
     for (auto instr : this->get_instructions()) {
-        bb_ir += "  ";
-        bb_ir += instr->print();
-        bb_ir += "\n";
+        out << "  " << instr->print() << "\n";
     }
-
-    return bb_ir;
 }
 }  // namespace lightir
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "Class.hpp"
 
+#include <numeric>
 #include <utility>
 
 #include "GlobalVariable.hpp"
@@ -23,18 +24,18 @@ void Class::add_method(Function *func) {
 Class::Class(Module *m, const string &name_, int type_tag,
              Class *super_class_info, bool with_dispatch_table_,
              bool is_dispatch_table_, bool is_append)
-    : Type(static_cast<type>(type_tag), m),
+    : Type(static_cast<type>(type_tag), m, TypeKind::Class),
       Value(this, name_),
       class_name_(name_),
       type_tag_(type_tag),
+      type_tag_last_(type_tag),
       super_class_info_(super_class_info),
       print_dispatch_table_(is_dispatch_table_) {
+    set_value_kind(ValueKind::Class);
     prototype_label_ = fmt::format("${}${}", name_, "prototype");
     if (with_dispatch_table_) {
         dispatch_table_label_ = fmt::format("${}${}", name_, "dispatchTable");
     }
-    attributes_ = new vector<AttrInfo *>();
-    methods_ = new vector<Function *>();
     set_type(
         LabelType::get(prototype_label_ + "_type", this, this->get_module()));
     bool flag = false;
@@ -44,13 +45,12 @@ Class::Class(Module *m, const string &name_, int type_tag,
 }
 
 Class::Class(Module *m, const string &name_, bool anon_)
-    : Type(static_cast<type>(-7), m),
+    : Type(static_cast<type>(-7), m, TypeKind::Class),
       Value(this, name_),
       class_name_(name_),
       anon_(anon_),
       super_class_info_(nullptr) {
-    attributes_ = new vector<AttrInfo *>();
-    methods_ = new vector<Function *>();
+    set_value_kind(ValueKind::Class);
     m->add_class(this);
 }
 
@@ -102,7 +102,7 @@ string Class::print_class() {
                 fmt::format(",\n  {} {}", attr->print(), attr->init_val);
         } else if (attr->init_obj == nullptr) {
             const_ir += fmt::format(",\n  {} null", attr->print());
-        } else if (dynamic_cast<GlobalVariable *>(attr->init_obj)) {
+        } else if (dyn_cast<GlobalVariable>(attr->init_obj)) {
             const_ir += fmt::format(",\n  {} @{}", attr->print(),
                                     attr->init_obj->get_name());
         } else {
@@ -150,11 +150,14 @@ string AttrInfo::print() {
 List::List(Class *list_class, vector<Value *> contained, const string &name)
     : Class(list_class->get_module(), name, type::LIST,
             list_class->super_class_info_, true, false),
-      contained_(std::move(contained)) {}
+      contained_(std::move(contained)) {
+    set_value_kind(ValueKind::List);
+}
 
 List *List::get(Class *list_class, vector<Value *> contained,
                 const string &name) {
-    return new List(list_class, std::move(contained), name);
+    return new (list_class->get_module())
+        List(list_class, std::move(contained), name);
 }
 
 string List::print() {
@@ -167,4 +170,18 @@ string List::print() {
     }
     return list_ir;
 }
+
+vector<int> type_tag_table(const list<Class *> &classes) {
+    int size = 0;
+    for (auto c : classes) {
+        if (!c->anon_) size = std::max(size, c->type_tag_ + 1);
+    }
+    vector<int> table(size);
+    std::iota(table.begin(), table.end(), 0);
+    for (auto c : classes) {
+        if (!c->anon_ && c->type_tag_ >= 0)
+            table[c->type_tag_] = c->type_tag_last_;
+    }
+    return table;
+}
 }  // namespace lightir
@@ -12,11 +12,11 @@ using namespace std;
 namespace lightir {
 
 ConstantInt *ConstantInt::get(int val, Module *m) {
-    return new ConstantInt(Type::get_int32_type(m), val);
+    return m->get_constant_int(Type::get_int32_type(m), val);
 }
 
 ConstantInt *ConstantInt::get(bool val, Module *m) {
-    return new ConstantInt(Type::get_int1_type(m), val ? 1 : 0);
+    return m->get_constant_int(Type::get_int1_type(m), val ? 1 : 0);
 }
 
 string ConstantInt::print() {
@@ -24,7 +24,7 @@ string ConstantInt::print() {
     const_ir += fmt::format("{} ", this->get_type()->print());
     Type *ty = this->get_type();
     if (ty->is_integer_type() &&
-        dynamic_cast<IntegerType *>(ty)->get_num_bits() == 1) {
+        dyn_cast<IntegerType>(ty)->get_num_bits() == 1) {
         /** int 1 */
         const_ir += (this->get_value() == 0) ? "false" : "true";
     } else {
@@ -34,12 +34,16 @@ string ConstantInt::print() {
     return const_ir;
 }
 
+ConstantNull *ConstantNull::get(Type *ty) {
+    return ty->get_module()->get_constant_null(ty);
+}
+
 string ConstantNull::print() {
     return fmt::format("{} null", this->get_type()->print());
 }
 
 ConstantStr *ConstantStr::get(const string &val, int id, Module *m) {
-    return new ConstantStr(PtrType::get(IntegerType::get(8, m)), val, id);
+    return new (m) ConstantStr(PtrType::get(IntegerType::get(8, m)), val, id);
 }
 string ConstantStr::print() {
     string const_ir;
@@ -69,7 +73,7 @@ string ConstantStr::print() {
 }
 
 ConstantBoxInt *ConstantBoxInt::get(Class *int_class, int val, int id) {
-    return new ConstantBoxInt(int_class, val, id);
+    return new (int_class->get_module()) ConstantBoxInt(int_class, val, id);
 }
 string ConstantBoxInt::print() {
     string const_ir;
@@ -88,7 +92,7 @@ string ConstantBoxInt::print() {
 }
 
 ConstantBoxBool *ConstantBoxBool::get(Class *bool_class, bool val, int id) {
-    return new ConstantBoxBool(bool_class, val, id);
+    return new (bool_class->get_module()) ConstantBoxBool(bool_class, val, id);
 }
 string ConstantBoxBool::print() {
     string const_ir;
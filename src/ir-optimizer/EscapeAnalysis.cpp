@@ -0,0 +1,111 @@
+#include "EscapeAnalysis.hpp"
+
+#include "BasicBlock.hpp"
+#include "chocopy_optimization.hpp"
+
+namespace lightir {
+const set<string> EscapeAnalysis::non_capturing_builtins = {
+    "print", "$len", "str_object_eq", "str_object_neq", "$object.__init__"};
+
+/** A local variable is an alloca which is only loaded from and stored to. */
+static bool is_local_variable(AllocaInst *alloca) {
+    for (auto &use : alloca->get_use_list()) {
+        if (dyn_cast<LoadInst>(use.val_)) continue;
+        if (dyn_cast<StoreInst>(use.val_) && use.arg_no_ == 1) continue;
+        return false;
+    }
+    return true;
+}
+
+EscapeAnalysis::EscapeAnalysis(Module *m) {
+    for (auto func : m->get_functions()) {
+        if (func->is_declaration()) continue;
+        const auto num_args = func->get_num_of_args();
+        auto &params = params_[func];
+        params.resize(num_args);
+        set<Value *> seen;
+        for (auto bb : func->get_basic_blocks()) {
+            for (auto inst : bb->get_instructions()) {
+                for (auto op : inst->get_operands()) {
+                    auto k = get_arg_no(op, num_args);
+                    if (k >= 0 && seen.insert(op).second) {
+                        params[k].push_back(op);
+                    }
+                }
+            }
+        }
+        param_escapes_[func].assign(num_args, false);
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto &[func, params] : params_) {
+            for (unsigned k = 0; k < params.size(); k++) {
+                if (param_escapes_[func][k]) continue;
+                for (auto val : params[k]) {
+                    if (escapes(val)) {
+                        param_escapes_[func][k] = true;
+                        changed = true;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+}
+
+bool EscapeAnalysis::param_escapes(Function *func, unsigned arg_no) {
+    if (func->is_declaration())
+        return !non_capturing_builtins.contains(func->get_name());
+    auto &escapes = param_escapes_.at(func);
+    return arg_no >= escapes.size() || escapes[arg_no];
+}
+
+bool EscapeAnalysis::passes_to_escaping_param(CallInst *call,
+                                              unsigned arg_no) {
+    auto callee = dyn_cast<Function>(call->get_operand(0));
+    return callee == nullptr || param_escapes(callee, arg_no);
+}
+
+bool EscapeAnalysis::escapes(Value *val, bool *stored) {
+    set<Value *> visited{val};
+    vector<Value *> worklist{val};
+    auto follow = [&](Value *alias) {
+        if (visited.insert(alias).second) worklist.push_back(alias);
+    };
+    while (!worklist.empty()) {
+        auto v = worklist.back();
+        worklist.pop_back();
+        for (auto &use : v->get_use_list()) {
+            auto user = use.val_;
+            if (dyn_cast<LoadInst>(user) || dyn_cast<CmpInst>(user))
+                continue;
+            if (dyn_cast<GetElementPtrInst>(user) ||
+                dyn_cast<BitCastInst>(user)) {
+                if (use.arg_no_ != 0) return true;
+                follow(user);
+            } else if (auto phi = dyn_cast<PhiInst>(user); phi) {
+                if (stored) *stored = true;
+                follow(phi);
+            } else if (auto store = dyn_cast<StoreInst>(user); store) {
+                if (use.arg_no_ == 1) continue;
+                auto slot = dyn_cast<AllocaInst>(store->get_operand(1));
+                if (slot == nullptr || !is_local_variable(slot)) return true;
+                if (stored) *stored = true;
+                for (auto &slot_use : slot->get_use_list()) {
+                    if (dyn_cast<LoadInst>(slot_use.val_))
+                        follow(slot_use.val_);
+                }
+            } else if (auto call = dyn_cast<CallInst>(user); call) {
+                if (use.arg_no_ == 0 ||
+                    passes_to_escaping_param(call, use.arg_no_ - 1))
+                    return true;
+            } else {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+}  // namespace lightir
@@ -1,30 +1,33 @@
 #include "Function.hpp"
 
+#include <sstream>
+
 #include "IRprinter.hpp"
 #include "Module.hpp"
 
 namespace lightir {
 
 Function::Function(FunctionType *ty, const std::string &name, Module *parent)
-    : Value(ty, name), parent_(parent), seq_cnt_(0) {
+    : Value(ty, name), parent_(parent) {
+    set_value_kind(ValueKind::Function);
     parent->add_function(this);
     build_args();
 }
 
 Function *Function::create(FunctionType *ty, const std::string &name,
                            Module *parent) {
-    return new Function(ty, name, parent);
+    return new (parent) Function(ty, name, parent);
 }
 
 Function *Function::create(bool is_ctor, FunctionType *ty,
                            const std::string &name, Module *parent) {
-    auto func = new Function(ty, name, parent);
+    auto func = new (parent) Function(ty, name, parent);
     func->is_ctor = is_ctor;
     return func;
 }
 
 FunctionType *Function::get_function_type() const {
-    return dynamic_cast<FunctionType *>(get_type());
+    return dyn_cast<FunctionType>(get_type());
 }
 
 Type *Function::get_return_type() const {
@@ -54,7 +57,7 @@ void Function::build_args() {
     unsigned num_args = get_num_of_args();
     for (unsigned int i = 0; i < num_args; i++) {
         arguments_.push_back(
-            new Argument(func_ty->get_param_type(i), "", this, i));
+            new (parent_) Argument(func_ty->get_param_type(i), "", this, i));
     }
 }
 
@@ -64,7 +67,7 @@ void Function::set_instr_name() {
     std::map<Value *, int> seq;
     for (auto arg : this->get_args()) {
         if (seq.find(arg) == seq.end()) {
-            auto seq_num = seq.size() + seq_cnt_;
+            auto seq_num = seq.size();
             if (arg->set_name("arg" + std::to_string(seq_num))) {
                 seq.insert({arg, seq_num});
             }
@@ -72,24 +75,29 @@ void Function::set_instr_name() {
     }
     for (auto &&bb : basic_blocks_) {
         if (seq.find(bb) == seq.end()) {
-            auto seq_num = seq.size() + seq_cnt_;
+            auto seq_num = seq.size();
             if (bb->set_name("label" + std::to_string(seq_num))) {
                 seq.insert({bb, seq_num});
             }
         }
         for (auto instr : bb->get_instructions()) {
             if (!instr->is_void() && seq.find(instr) == seq.end()) {
-                auto seq_num = seq.size() + seq_cnt_;
+                auto seq_num = seq.size();
                 if (instr->set_name("op" + std::to_string(seq_num))) {
                     seq.insert({instr, seq_num});
                 }
             }
         }
     }
-    seq_cnt_ += seq.size();
 }
 
 std::string Function::print() {
+    std::ostringstream func_ir;
+    print(func_ir);
+    return func_ir.str();
+}
+
+void Function::print(std::ostream &out) {
     std::string func_ir;
     if (this->is_declaration()) {
         func_ir += "declare ";
@@ -106,11 +114,11 @@ std::string Function::print() {
     if (this->is_declaration()) {
         for (unsigned int i = 0; i < this->get_num_of_args(); i++) {
             if (i) func_ir += ", ";
-            func_ir += dynamic_cast<FunctionType *>(this->get_type())
+            func_ir += dyn_cast<FunctionType>(this->get_type())
                            ->get_param_type(i)
                            ->print();
         }
-        if (dynamic_cast<FunctionType *>(this->get_type())->is_variable_args) {
+        if (dyn_cast<FunctionType>(this->get_type())->is_variable_args) {
             func_ir += ", ...";
         }
     } else {
@@ -122,20 +130,23 @@ std::string Function::print() {
         }
     }
     func_ir += ")";
+    if (this->is_noreturn) {
+        func_ir += " noreturn";
+    }
+
+    out << func_ir;
 
     /** print basic block */
     if (!this->is_declaration()) {
-        func_ir += " {\n";
+        out << " {\n";
         for (auto bb : this->get_basic_blocks()) {
-            func_ir += bb->print();
+            bb->print(out);
         }
         if (this->is_ctor) {
-            func_ir += "\nunreachable\n";
+            out << "\nunreachable\n";
         }
-        func_ir += "}";
+        out << "}";
     }
-
-    return func_ir;
 }
 string Function::print_args() {
     string arg_ir;
@@ -161,7 +172,7 @@ string Function::print_method(Class *method_) {
     if (this->is_declaration()) {
         for (unsigned int i = 0; i < this->get_num_of_args(); i++) {
             if (i) func_ir += ", ";
-            func_ir += dynamic_cast<FunctionType *>(this->get_type())
+            func_ir += dyn_cast<FunctionType>(this->get_type())
                            ->get_param_type(i)
                            ->print();
         }
@@ -9,6 +9,7 @@ namespace lightir {
 GlobalVariable::GlobalVariable(const string &name, Module *m, Type *ty,
                                bool is_const, Constant *init)
     : User(ty, name, init != nullptr), is_const_(is_const), init_val_(init) {
+    set_value_kind(ValueKind::GlobalVariable);
     m->add_global_variable(this);
     if (init) {
         this->set_operand(0, init);
@@ -18,19 +19,19 @@ GlobalVariable::GlobalVariable(const string &name, Module *m, Type *ty,
 GlobalVariable *GlobalVariable::create(const string &name, Module *m, Type *ty,
                                        bool is_const,
                                        Constant *init = nullptr) {
-    return new GlobalVariable(name, m, ty, is_const, init);
+    return new (m) GlobalVariable(name, m, ty, is_const, init);
 }
 GlobalVariable *GlobalVariable::create(const string &name, Module *m,
                                        ConstantStr *init) {
-    return new GlobalVariable(name, m, init->get_type(), true, init);
+    return new (m) GlobalVariable(name, m, init->get_type(), true, init);
 }
 GlobalVariable *GlobalVariable::create(const string &name, Module *m,
                                        ConstantBoxInt *init) {
-    return new GlobalVariable(name, m, init->get_type(), true, init);
+    return new (m) GlobalVariable(name, m, init->get_type(), true, init);
 }
 GlobalVariable *GlobalVariable::create(const string &name, Module *m,
                                        ConstantBoxBool *init) {
-    return new GlobalVariable(name, m, init->get_type(), true, init);
+    return new (m) GlobalVariable(name, m, init->get_type(), true, init);
 }
 
 string GlobalVariable::print() {
@@ -40,9 +41,9 @@ string GlobalVariable::print() {
                                  this->type_->print());
         return global_ir;
     }
-    if (dynamic_cast<ConstantStr *>(this->init_val_) ||
-        dynamic_cast<ConstantBoxInt *>(this->init_val_) ||
-        dynamic_cast<ConstantBoxBool *>(this->init_val_)) {
+    if (dyn_cast<ConstantStr>(this->init_val_) ||
+        dyn_cast<ConstantBoxInt>(this->init_val_) ||
+        dyn_cast<ConstantBoxBool>(this->init_val_)) {
         global_ir += this->init_val_->print();
         return global_ir;
     }
@@ -0,0 +1,1230 @@
+#include "IRParser.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "BasicBlock.hpp"
+#include "Class.hpp"
+#include "Constant.hpp"
+#include "Function.hpp"
+#include "GlobalVariable.hpp"
+
+using std::unordered_map;
+using std::unordered_set;
+using std::vector;
+
+namespace lightir {
+namespace {
+bool is_name_char(char ch) {
+    return std::isalnum(static_cast<unsigned char>(ch)) || ch == '$' ||
+           ch == '.' || ch == '_';
+}
+
+/** The classes whose type prints as their dispatch table, see LightWalker. */
+bool prints_dispatch_table(string_view class_name) {
+    return class_name == "object" || class_name == "int" ||
+           class_name == "bool";
+}
+
+/** Recursive descent over the printed module, in two passes. The first
+ * creates the classes and functions, so that a value can be referred to
+ * before the line defining it; the second fills them in. */
+class IRParser {
+   public:
+    explicit IRParser(string_view text) : text_(text) {}
+    std::unique_ptr<Module> parse(string *error);
+
+   private:
+    /** What the first pass learns from the body of a definition. */
+    struct FunctionInfo {
+        Function *func = nullptr;
+        size_t body = 0;
+        vector<string> labels;
+        unordered_set<string> defined;
+        /** the type loaded, stored or indexed through each local pointer */
+        unordered_map<string, Type *> pointee;
+    };
+
+    enum class ItemKind { AnonClass, Prototype, DispatchTable, Global, Define };
+    struct Item {
+        ItemKind kind;
+        size_t pos;
+        Class *c = nullptr;
+        FunctionInfo *info = nullptr;
+        string name;
+    };
+
+    bool ok() const { return error_.empty(); }
+    void fail(string_view message);
+    char peek() const { return pos_ < text_.size() ? text_[pos_] : '\0'; }
+    size_t column() const;
+    void skip_blanks();
+    void skip_space();
+    bool at_line_end();
+    void skip_item();
+    void skip_operand();
+    bool accept(string_view token);
+    bool accept_word(string_view word);
+    void expect(string_view token);
+    void expect_word(string_view word);
+    string_view name();
+    string_view word();
+    int integer();
+    string_view quoted();
+
+    Type *parse_type();
+    Type *local_type(Type *ty, const string &name) const;
+    Type *element_type(Type *pointee, Value *idx);
+    Value *parse_value(Type *ty);
+    Value *parse_typed_value();
+    Value *global_ref(string_view name);
+    BasicBlock *block_ref();
+
+    void declare_items();
+    Class *declare_class(const string &label);
+    void parse_type_tag_table();
+    void declare_function(bool is_definition);
+    void scan_body(FunctionInfo &info);
+    void define_items();
+    void parse_anon_class(Class *c);
+    void parse_prototype(Class *c);
+    void parse_dispatch_table(Class *c);
+    void parse_global(const string &name);
+    void parse_boxed_constant(const string &name, Class *c);
+    void parse_body(FunctionInfo &info);
+    Instruction *parse_instruction(BasicBlock *bb, const string &result);
+    Instruction *parse_call(BasicBlock *bb);
+    VExtInst *parse_vext(BasicBlock *bb);
+    unsigned parse_vext_node(vector<VExtInst::Node> &program,
+                             vector<Value *> &leaves);
+    void define(const string &name, Instruction *inst);
+
+    string_view text_;
+    size_t pos_ = 0;
+    string error_;
+    Module *m_ = nullptr;
+    /** what a plain ptr reads as when nothing tells more */
+    Type *ptr_ty_ = nullptr;
+
+    vector<Item> items_;
+    vector<std::unique_ptr<FunctionInfo>> infos_;
+    unordered_map<string, Type *> type_names_;
+    unordered_map<string, Class *> classes_;
+    unordered_map<string, Class *> prototypes_;
+    unordered_map<string, Class *> dispatch_tables_;
+    unordered_map<string, GlobalVariable *> globals_;
+    /** the last tag below each class, by its tag */
+    vector<int> type_tag_last_;
+    /** attributes initialized with a global, resolved after the globals */
+    vector<std::pair<AttrInfo *, string>> attr_inits_;
+
+    /** of the function being parsed */
+    FunctionInfo *info_ = nullptr;
+    unordered_map<string, Value *> locals_;
+    unordered_map<string, BasicBlock *> blocks_;
+    /** placeholders for the values used (by a phi) before their definition */
+    unordered_map<string, Value *> forward_;
+    vector<PhiInst *> phis_;
+};
+
+void IRParser::fail(string_view message) {
+    if (!ok()) return;
+    auto upto = text_.substr(0, std::min(pos_, text_.size()));
+    auto line = std::count(upto.begin(), upto.end(), '\n') + 1;
+    error_ = fmt::format("{}:{}: {}", line, column() + 1, message);
+}
+
+size_t IRParser::column() const {
+    auto line_start = text_.rfind('\n', pos_ == 0 ? 0 : pos_ - 1);
+    if (line_start == string_view::npos || pos_ == 0) return pos_;
+    return pos_ - line_start - 1;
+}
+
+/** spaces and comments, up to the end of the line */
+void IRParser::skip_blanks() {
+    while (pos_ < text_.size()) {
+        auto ch = text_[pos_];
+        if (ch == ' ' || ch == '\t' || ch == '\r') {
+            pos_++;
+        } else if (ch == ';') {
+            while (pos_ < text_.size() && text_[pos_] != '\n') pos_++;
+        } else {
+            break;
+        }
+    }
+}
+
+void IRParser::skip_space() {
+    skip_blanks();
+    while (peek() == '\n') {
+        pos_++;
+        skip_blanks();
+    }
+}
+
+bool IRParser::at_line_end() {
+    skip_blanks();
+    return pos_ >= text_.size() || text_[pos_] == '\n';
+}
+
+/** to the end of the line, or of the braces opened on it */
+void IRParser::skip_item() {
+    int depth = 0;
+    while (pos_ < text_.size()) {
+        auto ch = text_[pos_++];
+        if (ch == '"') {
+            while (pos_ < text_.size() && text_[pos_] != '"') pos_++;
+            pos_++;
+        } else if (ch == '{') {
+            depth++;
+        } else if (ch == '}') {
+            depth--;
+        } else if (ch == '\n' && depth <= 0) {
+            return;
+        }
+    }
+}
+
+void IRParser::skip_operand() {
+    skip_space();
+    if (peek() == '%' || peek() == '@' || peek() == '-') pos_++;
+    while (is_name_char(peek())) pos_++;
+}
+
+/** Stays put if the next token is not token, so that a line can end in
+ * something optional. */
+bool IRParser::accept(string_view token) {
+    auto start = pos_;
+    skip_space();
+    if (!ok() || !text_.substr(pos_).starts_with(token)) {
+        pos_ = start;
+        return false;
+    }
+    pos_ += token.size();
+    return true;
+}
+
+bool IRParser::accept_word(string_view word) {
+    auto start = pos_;
+    if (!accept(word) || is_name_char(peek())) {
+        pos_ = start;
+        return false;
+    }
+    return true;
+}
+
+void IRParser::expect(string_view token) {
+    if (!accept(token)) fail(fmt::format("expected '{}'", token));
+}
+
+void IRParser::expect_word(string_view word) {
+    if (!accept_word(word)) fail(fmt::format("expected '{}'", word));
+}
+
+/** of a value, label or type, right after its sigil */
+string_view IRParser::name() {
+    auto start = pos_;
+    while (is_name_char(peek())) pos_++;
+    if (start == pos_) fail("expected a name");
+    return text_.substr(start, pos_ - start);
+}
+
+/** an opcode or keyword */
+string_view IRParser::word() {
+    skip_space();
+    auto start = pos_;
+    while (is_name_char(peek())) pos_++;
+    return text_.substr(start, pos_ - start);
+}
+
+int IRParser::integer() {
+    skip_space();
+    int val = 0;
+    auto first = text_.data() + pos_;
+    auto [end, ec] = std::from_chars(first, text_.data() + text_.size(), val);
+    if (ec != std::errc()) {
+        fail("expected an integer");
+        return 0;
+    }
+    pos_ += end - first;
+    return val;
+}
+
+/** the raw text between the quotes, escapes and all */
+string_view IRParser::quoted() {
+    expect("\"");
+    auto end = text_.find('"', pos_);
+    if (!ok() || end == string_view::npos) {
+        fail("unterminated string");
+        return {};
+    }
+    auto str = text_.substr(pos_, end - pos_);
+    pos_ = end + 1;
+    return str;
+}
+
+Type *IRParser::parse_type() {
+    skip_space();
+    Type *ty = nullptr;
+    if (accept_word("void")) {
+        ty = m_->get_void_type();
+    } else if (accept_word("ptr")) {
+        ty = ptr_ty_;
+    } else if (peek() == 'i' && pos_ + 1 < text_.size() &&
+               std::isdigit(static_cast<unsigned char>(text_[pos_ + 1]))) {
+        pos_++;
+        auto bits = integer();
+        if (bits < 1 || bits > 64) fail("bad integer type");
+        if (ok()) ty = IntegerType::get(bits, m_);
+    } else if (accept("%")) {
+        auto type_name = name();
+        auto it = type_names_.find(string(type_name));
+        if (it != type_names_.end()) {
+            ty = it->second;
+        } else {
+            fail(fmt::format("unknown type %{}", type_name));
+        }
+    } else {
+        fail("expected a type");
+    }
+    while (ok()) {
+        if (accept("*")) {
+            ty = PtrType::get(ty);
+        } else if (accept("(")) {
+            vector<Type *> params;
+            bool is_variable_args = false;
+            while (ok() && !accept(")")) {
+                if (!params.empty() || is_variable_args) expect(",");
+                if (accept("...")) {
+                    is_variable_args = true;
+                } else {
+                    params.push_back(parse_type());
+                }
+            }
+            if (ok()) ty = FunctionType::get(ty, params, is_variable_args);
+        } else {
+            break;
+        }
+    }
+    return ok() ? ty : nullptr;
+}
+
+/** ty of the local name, pointing to what it is used as if ty is ptr */
+Type *IRParser::local_type(Type *ty, const string &name) const {
+    if (ty != ptr_ty_ || info_ == nullptr) return ty;
+    auto it = info_->pointee.find(name);
+    return it == info_->pointee.end() ? ty : PtrType::get(it->second);
+}
+
+Type *IRParser::element_type(Type *pointee, Value *idx) {
+    if (auto c = dyn_cast<Class>(pointee)) {
+        auto offset = dyn_cast<ConstantInt>(idx);
+        int first_attr = c->anon_ ? 0 : 3;
+        if (offset == nullptr || offset->get_value() < 0 ||
+            (offset->get_value() >= first_attr &&
+             offset->get_value() - first_attr >=
+                 static_cast<int>(c->attributes_->size()))) {
+            fail("bad index into a class");
+            return nullptr;
+        }
+    }
+    Value probe(PtrType::get(pointee));
+    return GetElementPtrInst::get_element_type(&probe, idx);
+}
+
+Value *IRParser::parse_value(Type *ty) {
+    skip_space();
+    if (accept("%")) {
+        string value_name(name());
+        if (!ok()) return nullptr;
+        if (auto it = locals_.find(value_name); it != locals_.end()) {
+            return it->second;
+        }
+        if (auto it = blocks_.find(value_name); it != blocks_.end()) {
+            return it->second;
+        }
+        if (info_ != nullptr && info_->defined.contains(value_name)) {
+            auto &placeholder = forward_[value_name];
+            if (placeholder == nullptr) {
+                placeholder = new (m_) Value(
+                    ty != nullptr ? ty : m_->get_int32_type(), value_name);
+            }
+            return placeholder;
+        }
+        if (auto it = classes_.find(value_name); it != classes_.end()) {
+            return it->second;
+        }
+        fail(fmt::format("undefined value %{}", value_name));
+        return nullptr;
+    }
+    if (accept("@")) return global_ref(name());
+    if (accept_word("true")) {
+        return m_->get_constant_int(m_->get_int1_type(), 1);
+    }
+    if (accept_word("false")) {
+        return m_->get_constant_int(m_->get_int1_type(), 0);
+    }
+    if (accept_word("null")) {
+        return m_->get_constant_null(ty != nullptr ? ty : ptr_ty_);
+    }
+    if (peek() == '-' || std::isdigit(static_cast<unsigned char>(peek()))) {
+        auto val = integer();
+        auto int_ty = ty != nullptr ? dyn_cast<IntegerType>(ty)
+                                    : m_->get_int32_type();
+        if (int_ty == nullptr) fail("integer constant of a non-integer type");
+        return ok() ? m_->get_constant_int(int_ty, val) : nullptr;
+    }
+    fail("expected a value");
+    return nullptr;
+}
+
+/** A global storing a constant prints itself, e.g. "@const_3", without the
+ * type. */
+Value *IRParser::parse_typed_value() {
+    skip_space();
+    if (accept("@")) {
+        auto global = global_ref(name());
+        /** and an external one prints its declaration */
+        if (accept("=")) {
+            expect_word("external");
+            expect_word("global");
+            parse_type();
+        }
+        return global;
+    }
+    auto ty = parse_type();
+    return ok() ? parse_value(ty) : nullptr;
+}
+
+Value *IRParser::global_ref(string_view global_name) {
+    if (!ok()) return nullptr;
+    string key(global_name);
+    if (auto it = globals_.find(key); it != globals_.end()) return it->second;
+    if (auto func = m_->get_function(key)) return func;
+    if (auto it = prototypes_.find(key); it != prototypes_.end()) {
+        return it->second;
+    }
+    fail(fmt::format("undefined global @{}", global_name));
+    return nullptr;
+}
+
+BasicBlock *IRParser::block_ref() {
+    expect("%");
+    auto label = name();
+    if (!ok()) return nullptr;
+    auto it = blocks_.find(string(label));
+    if (it == blocks_.end()) {
+        fail(fmt::format("undefined label %{}", label));
+        return nullptr;
+    }
+    return it->second;
+}
+
+void IRParser::declare_items() {
+    while (ok()) {
+        skip_space();
+        if (pos_ >= text_.size()) return;
+        auto start = pos_;
+        if (accept_word("source_filename")) {
+            expect("=");
+            m_->source_file_name_ = string(quoted());
+        } else if (accept_word("declare")) {
+            declare_function(false);
+        } else if (accept_word("define")) {
+            declare_function(true);
+        } else if (accept("@")) {
+            string global_name(name());
+            if (!ok()) return;
+            if (global_name.starts_with("$") &&
+                global_name.ends_with("$prototype")) {
+                auto c = declare_class(global_name);
+                if (c == nullptr) return;
+                items_.push_back({ItemKind::Prototype, pos_, c, nullptr, ""});
+            } else if (dispatch_tables_.contains(global_name)) {
+                items_.push_back({ItemKind::DispatchTable, pos_,
+                                  dispatch_tables_.at(global_name), nullptr,
+                                  ""});
+            } else if (global_name == type_tag_table_label) {
+                /** rebuilt from the classes when the module is printed */
+                parse_type_tag_table();
+            } else if (accept("=") && accept_word("private")) {
+                /** the characters of a str constant, read along with it */
+            } else {
+                items_.push_back({ItemKind::Global,
+                                  start + 1 + global_name.size(), nullptr,
+                                  nullptr, global_name});
+            }
+            pos_ = start;
+            skip_item();
+        } else if (accept("%$class.anon_")) {
+            string class_name(name());
+            if (!ok()) return;
+            auto c = new (m_) Class(m_, class_name, true);
+            type_names_["$class.anon_" + class_name] = c;
+            items_.push_back({ItemKind::AnonClass, pos_, c, nullptr, ""});
+            skip_item();
+        } else if (accept("%")) {
+            /** the types of prototypes and dispatch tables */
+            skip_item();
+        } else {
+            fail("expected a global, type or function");
+        }
+    }
+}
+
+/** From "= global [N x i32] [i32 LAST0, i32 LAST1, ...]". */
+void IRParser::parse_type_tag_table() {
+    expect("=");
+    expect_word("global");
+    expect("[");
+    integer();
+    expect_word("x");
+    expect_word("i32");
+    expect("]");
+    expect("[");
+    do {
+        expect_word("i32");
+        type_tag_last_.push_back(integer());
+    } while (ok() && accept(","));
+    expect("]");
+}
+
+/** From "= global %$X$prototype_type { i32 TAG, i32 SIZE, ptr @D", which is
+ * all the first pass needs of a class. */
+Class *IRParser::declare_class(const string &label) {
+    auto class_name = label.substr(1, label.size() - 11);
+    expect("=");
+    expect_word("global");
+    expect("%" + label + "_type");
+    expect("{");
+    expect_word("i32");
+    auto tag = integer();
+    expect(",");
+    expect_word("i32");
+    integer();
+    expect(",");
+    expect_word("ptr");
+    expect("@");
+    string dispatch_table;
+    while (is_name_char(peek())) dispatch_table += text_[pos_++];
+    if (!ok()) return nullptr;
+    if (classes_.contains(class_name)) {
+        fail(fmt::format("class {} defined twice", class_name));
+        return nullptr;
+    }
+    bool print_dispatch_table = prints_dispatch_table(class_name);
+    auto c = new (m_) Class(m_, class_name, tag, nullptr,
+                            !dispatch_table.empty(), print_dispatch_table,
+                            false);
+    m_->add_class(c);
+    c->type_tag_last_ = tag;
+    c->dispatch_table_label_ = dispatch_table;
+    classes_[class_name] = c;
+    prototypes_[label] = c;
+    if (dispatch_table.empty()) {
+        type_names_[label + "_type"] = c;
+        return c;
+    }
+    dispatch_tables_[dispatch_table] = c;
+    auto table_ty = dispatch_table + "_type";
+    if (print_dispatch_table) {
+        type_names_[table_ty] = c;
+        type_names_[label + "_type"] = c->get_type();
+    } else {
+        type_names_[table_ty] = LabelType::get(table_ty, c, m_);
+        type_names_[label + "_type"] = c;
+    }
+    return c;
+}
+
+void IRParser::declare_function(bool is_definition) {
+    auto result = parse_type();
+    expect("@");
+    string func_name(name());
+    expect("(");
+    vector<Type *> params;
+    vector<string> arg_names;
+    bool is_variable_args = false;
+    while (ok() && !accept(")")) {
+        if (!params.empty() || is_variable_args) expect(",");
+        if (accept("...")) {
+            is_variable_args = true;
+            continue;
+        }
+        params.push_back(parse_type());
+        if (is_definition) {
+            expect("%");
+            arg_names.emplace_back(name());
+        }
+    }
+    bool is_noreturn = accept_word("noreturn");
+    if (!ok()) return;
+
+    FunctionInfo *info = nullptr;
+    bool is_ctor = false;
+    if (is_definition) {
+        expect("{");
+        infos_.push_back(std::make_unique<FunctionInfo>());
+        info = infos_.back().get();
+        info->body = pos_;
+        scan_body(*info);
+        is_ctor = info->defined.contains("");
+        info->defined.erase("");
+        if (!ok()) return;
+        for (size_t i = 0; i < params.size(); i++) {
+            auto it = info->pointee.find(arg_names[i]);
+            if (params[i] == ptr_ty_ && it != info->pointee.end()) {
+                params[i] = PtrType::get(it->second);
+            }
+        }
+    }
+    /** a definition replaces a declaration in the index, not the reverse */
+    if (!is_definition && m_->get_function(func_name) != nullptr) return;
+    auto func = Function::create(
+        is_ctor, FunctionType::get(result, params, is_variable_args),
+        func_name, m_);
+    func->is_noreturn = is_noreturn;
+    size_t i = 0;
+    for (auto arg : func->get_args()) {
+        if (is_definition) arg->set_name(arg_names[i++]);
+    }
+    if (is_definition) {
+        info->func = func;
+        items_.push_back({ItemKind::Define, info->body, nullptr, info, ""});
+    }
+}
+
+/** Goes over the body line by line, for the labels, the names defined and
+ * the types of the pointers. A constructor ends with "unreachable" at the
+ * start of a line, which is noted as the empty name being defined. */
+void IRParser::scan_body(FunctionInfo &info) {
+    if (!at_line_end()) fail("expected the body on the next line");
+    while (ok()) {
+        skip_space();
+        if (pos_ >= text_.size()) {
+            fail("expected '}'");
+            return;
+        }
+        auto line_end = std::min(text_.find('\n', pos_), text_.size());
+        bool at_line_start = column() == 0;
+        if (at_line_start && peek() == '}') {
+            pos_++;
+            return;
+        }
+        if (at_line_start && accept_word("unreachable")) {
+            info.defined.insert("");
+        } else if (at_line_start) {
+            info.labels.emplace_back(name());
+            expect(":");
+        } else if (accept("%")) {
+            string value_name(name());
+            expect("=");
+            if (!ok()) return;
+            info.defined.insert(value_name);
+            if (accept_word("load") || accept_word("getelementptr")) {
+                auto ty = parse_type();
+                expect(",");
+                skip_space();
+                if (peek() != '@' && parse_type() != nullptr && accept("%")) {
+                    info.pointee.emplace(name(), ty);
+                }
+            }
+        } else if (accept_word("store")) {
+            skip_space();
+            Type *ty = peek() == '@' ? nullptr : parse_type();
+            skip_operand();
+            expect(",");
+            skip_space();
+            if (peek() != '@' && parse_type() != nullptr && accept("%") &&
+                ty != nullptr) {
+                info.pointee.emplace(name(), ty);
+            }
+        }
+        pos_ = line_end;
+    }
+}
+
+void IRParser::define_items() {
+    for (auto &item : items_) {
+        if (!ok()) return;
+        pos_ = item.pos;
+        switch (item.kind) {
+            case ItemKind::AnonClass:
+                parse_anon_class(item.c);
+                break;
+            case ItemKind::Prototype:
+                parse_prototype(item.c);
+                break;
+            case ItemKind::DispatchTable:
+                parse_dispatch_table(item.c);
+                break;
+            case ItemKind::Global:
+                parse_global(item.name);
+                break;
+            case ItemKind::Define:
+                parse_body(*item.info);
+                break;
+        }
+    }
+}
+
+void IRParser::parse_anon_class(Class *c) {
+    expect("=");
+    expect_word("type");
+    expect("{");
+    while (ok() && !accept("}")) {
+        if (!c->attributes_->empty()) expect(",");
+        auto ty = parse_type();
+        if (ok()) c->add_attribute(new (m_) AttrInfo(ty, ""));
+    }
+}
+
+void IRParser::parse_prototype(Class *c) {
+    /** the class itself was read by declare_class */
+    while (ok() && !accept("}")) {
+        expect(",");
+        auto ty = parse_type();
+        if (!ok()) return;
+        /** followed by the initial value: an integer, null or a global */
+        AttrInfo *attr;
+        if (accept("@")) {
+            attr = new (m_) AttrInfo(ty, "");
+            attr_inits_.emplace_back(attr, name());
+        } else if (accept_word("null")) {
+            attr = new (m_) AttrInfo(ty, "");
+        } else {
+            attr = new (m_) AttrInfo(ty, "", integer());
+        }
+        c->add_attribute(attr);
+    }
+}
+
+void IRParser::parse_dispatch_table(Class *c) {
+    expect("=");
+    expect_word("global");
+    parse_type();
+    expect("{");
+    while (ok() && !accept("}")) {
+        if (!c->methods_->empty()) expect(",");
+        expect_word("ptr");
+        expect("@");
+        auto method = m_->get_function(string(name()));
+        if (!ok()) return;
+        if (method == nullptr) {
+            fail("undefined method");
+            return;
+        }
+        /** not add_method, which would merge methods of the same name */
+        c->methods_->push_back(method);
+    }
+}
+
+void IRParser::parse_global(const string &global_name) {
+    expect("=");
+    if (accept_word("external")) {
+        expect_word("global");
+        auto ty = parse_type();
+        if (ok()) {
+            globals_[global_name] =
+                GlobalVariable::create(global_name, m_, ty, false, nullptr);
+        }
+        return;
+    }
+    bool is_const = accept_word("constant");
+    if (!is_const) expect_word("global");
+    auto ty = parse_type();
+    if (!ok()) return;
+    if (accept("{")) {
+        auto c = dyn_cast<Class>(ty);
+        if (auto label_ty = dyn_cast<LabelType>(ty)) c = label_ty->get_class();
+        if (c == nullptr) {
+            fail("expected a str, int or bool constant");
+            return;
+        }
+        parse_boxed_constant(global_name, c);
+        return;
+    }
+    auto init = dyn_cast<Constant>(parse_value(ty));
+    if (ok() && init == nullptr) fail("expected a constant");
+    if (ok()) {
+        globals_[global_name] =
+            GlobalVariable::create(global_name, m_, ty, is_const, init);
+    }
+}
+
+/** The body of "@const_N = global %$X$prototype_type {", followed by the
+ * characters of a str. */
+void IRParser::parse_boxed_constant(const string &global_name, Class *c) {
+    int id = 0;
+    auto id_str = string_view(global_name).substr(6);
+    auto [end, ec] =
+        std::from_chars(id_str.data(), id_str.data() + id_str.size(), id);
+    if (!global_name.starts_with("const_") || ec != std::errc() ||
+        end != id_str.data() + id_str.size()) {
+        fail("expected a constant named const_N");
+        return;
+    }
+    expect_word("i32");
+    integer();
+    expect(",");
+    expect_word("i32");
+    integer();
+    expect(",");
+    parse_type();
+    expect("@");
+    name();
+    expect(",");
+    auto val_ty = parse_type();
+    auto val = integer();
+    bool is_str = accept(",");
+    if (is_str) {
+        parse_type();
+        expect("@str." + global_name);
+    }
+    expect("}");
+    if (!ok()) return;
+
+    GlobalVariable *global;
+    if (is_str) {
+        expect("@str." + global_name);
+        expect("=");
+        expect_word("private");
+        expect_word("unnamed_addr");
+        expect_word("global");
+        expect("[");
+        integer();
+        expect_word("x");
+        expect_word("i8");
+        expect("]");
+        expect("c");
+        auto chars = quoted();
+        string str;
+        for (size_t i = 0; ok() && i + 2 < chars.size(); i += 3) {
+            unsigned ch = 0;
+            auto [ptr, ec] = std::from_chars(chars.data() + i + 1,
+                                             chars.data() + i + 3, ch, 16);
+            if (chars[i] != '\\' || ec != std::errc()) fail("bad str constant");
+            str += static_cast<char>(ch);
+        }
+        if (!str.empty() && str.back() == '\0') str.pop_back();
+        if (!ok()) return;
+        global = GlobalVariable::create(global_name, m_,
+                                        ConstantStr::get(str, id, m_));
+    } else if (val_ty == m_->get_int1_type()) {
+        global = GlobalVariable::create(global_name, m_,
+                                        ConstantBoxBool::get(c, val, id));
+    } else {
+        global = GlobalVariable::create(global_name, m_,
+                                        ConstantBoxInt::get(c, val, id));
+    }
+    global->set_type(PtrType::get(c));
+    globals_[global_name] = global;
+}
+
+void IRParser::parse_body(FunctionInfo &info) {
+    info_ = &info;
+    locals_.clear();
+    blocks_.clear();
+    forward_.clear();
+    phis_.clear();
+    for (auto arg : info.func->get_args()) locals_[arg->get_name()] = arg;
+    for (auto &label : info.labels) {
+        if (blocks_.contains(label)) {
+            fail(fmt::format("label {} defined twice", label));
+            return;
+        }
+        auto bb = BasicBlock::create(m_, "", info.func);
+        bb->set_name(label);
+        blocks_[label] = bb;
+    }
+
+    /** Branches add the edges in their own order, which is put back to the
+     * one in the "; preds =" comments at the end. */
+    vector<std::pair<BasicBlock *, vector<string>>> pred_order;
+    BasicBlock *bb = nullptr;
+    while (ok()) {
+        skip_space();
+        if (pos_ >= text_.size()) {
+            fail("expected '}'");
+        } else if (column() != 0) {
+            if (bb == nullptr) fail("expected a label");
+            string result;
+            if (accept("%")) {
+                result = name();
+                expect("=");
+            }
+            if (!ok()) break;
+            if (auto inst = parse_instruction(bb, result)) {
+                if (!result.empty()) define(result, inst);
+            } else {
+                fail("expected an instruction");
+            }
+            if (!at_line_end()) fail("expected the end of the line");
+        } else if (accept("}")) {
+            break;
+        } else if (accept_word("unreachable")) {
+            /** the end of a constructor */
+        } else {
+            auto label = blocks_.find(string(name()));
+            if (!ok()) break;
+            bb = label->second;
+            expect(":");
+            while (peek() == ' ' || peek() == '\t') pos_++;
+            constexpr string_view preds = "; preds = ";
+            if (!text_.substr(pos_).starts_with(preds)) continue;
+            pos_ += preds.size();
+            pred_order.emplace_back(bb, vector<string>());
+            do {
+                expect("%");
+                pred_order.back().second.emplace_back(name());
+            } while (ok() && !at_line_end() && accept(","));
+        }
+    }
+    if (!ok()) return;
+    if (!forward_.empty()) {
+        fail(fmt::format("undefined value %{}", forward_.begin()->first));
+        return;
+    }
+    for (auto &[block, names] : pred_order) {
+        auto position = [&names](BasicBlock *pred) {
+            return std::find(names.begin(), names.end(), pred->get_name()) -
+                   names.begin();
+        };
+        block->get_pre_basic_blocks().sort(
+            [&](BasicBlock *a, BasicBlock *b) {
+                return position(a) < position(b);
+            });
+    }
+    info_ = nullptr;
+}
+
+void IRParser::define(const string &value_name, Instruction *inst) {
+    if (locals_.contains(value_name)) {
+        fail(fmt::format("%{} defined twice", value_name));
+        return;
+    }
+    inst->set_type(local_type(inst->get_type(), value_name));
+    inst->set_name(value_name);
+    locals_[value_name] = inst;
+    auto it = forward_.find(value_name);
+    if (it == forward_.end()) return;
+    auto placeholder = it->second;
+    placeholder->replace_all_use_with(inst);
+    for (auto phi : phis_) {
+        if (phi->get_lval() == placeholder) phi->set_lval(inst);
+    }
+    forward_.erase(it);
+}
+
+Instruction *IRParser::parse_instruction(BasicBlock *bb,
+                                         const string &result) {
+    static const unordered_map<string_view, Instruction::OpID> binary_ops = {
+        {"add", Instruction::Add},   {"sub", Instruction::Sub},
+        {"mul", Instruction::Mul},   {"sdiv", Instruction::Div},
+        {"srem", Instruction::Rem},  {"and", Instruction::And},
+        {"or", Instruction::Or},     {"shl", Instruction::Shl},
+        {"ashr", Instruction::AShr}, {"lshr", Instruction::LShr}};
+    static const unordered_map<string_view, CmpInst::CmpOp> cmp_ops = {
+        {"eq", CmpInst::EQ},  {"ne", CmpInst::NE},  {"sgt", CmpInst::GT},
+        {"sge", CmpInst::GE}, {"slt", CmpInst::LT}, {"sle", CmpInst::LE}};
+
+    auto op = word();
+
+    if (auto it = binary_ops.find(op); it != binary_ops.end()) {
+        auto ty = parse_type();
+        auto lhs = parse_value(ty);
+        expect(",");
+        auto rhs = parse_value(ty);
+        if (!ok()) return nullptr;
+        return new (m_) BinaryInst(ty, it->second, lhs, rhs, bb);
+    }
+    if (op == "not") {
+        auto val = parse_value(nullptr);
+        if (!ok()) return nullptr;
+        auto inst = UnaryInst::create_not(val, bb, m_);
+        inst->set_type(val->get_type());
+        return inst;
+    }
+    if (op == "icmp") {
+        auto cmp = cmp_ops.find(word());
+        if (cmp == cmp_ops.end()) fail("unknown comparison");
+        auto ty = parse_type();
+        auto lhs = parse_value(ty);
+        expect(",");
+        auto rhs = parse_value(ty);
+        if (!ok()) return nullptr;
+        auto lhs_ty = lhs->get_type(), rhs_ty = rhs->get_type();
+        if (!(lhs_ty->is_ptr_type() && rhs_ty->is_ptr_type()) &&
+            !(lhs_ty->is_integer_type() && lhs_ty == rhs_ty)) {
+            fail("icmp of different types");
+            return nullptr;
+        }
+        return CmpInst::create_cmp(cmp->second, lhs, rhs, bb, m_);
+    }
+    if (op == "tail") {
+        expect_word("call");
+        auto call = ok() ? parse_call(bb) : nullptr;
+        if (auto tail_call = dyn_cast<CallInst>(call)) {
+            tail_call->set_tail_call(true);
+        }
+        return call;
+    }
+    if (op == "call") return parse_call(bb);
+    if (op == "br") {
+        if (accept_word("label")) {
+            auto target = block_ref();
+            return ok() ? BranchInst::create_br(target, bb) : nullptr;
+        }
+        auto cond = parse_typed_value();
+        expect(",");
+        expect_word("label");
+        auto if_true = block_ref();
+        expect(",");
+        expect_word("label");
+        auto if_false = block_ref();
+        if (!ok()) return nullptr;
+        return BranchInst::create_cond_br(cond, if_true, if_false, bb);
+    }
+    if (op == "ret") {
+        auto ty = parse_type();
+        if (ok() && ty->is_void_type()) return ReturnInst::create_void_ret(bb);
+        auto val = ok() ? parse_value(ty) : nullptr;
+        return ok() ? ReturnInst::create_ret(val, bb) : nullptr;
+    }
+    if (op == "unreachable") return UnreachableInst::create_unreachable(bb);
+    if (op == "store") {
+        auto val = parse_typed_value();
+        expect(",");
+        auto ptr = parse_typed_value();
+        return ok() ? StoreInst::create_store(val, ptr, bb) : nullptr;
+    }
+    if (op == "load") {
+        auto ty = parse_type();
+        expect(",");
+        auto ptr = parse_typed_value();
+        if (!ok()) return nullptr;
+        return LoadInst::create_load(local_type(ty, result), ptr, bb);
+    }
+    if (op == "alloca") {
+        auto ty = parse_type();
+        if (accept(",")) {
+            expect_word("align");
+            integer();
+        }
+        return ok() ? AllocaInst::create_alloca(ty, bb) : nullptr;
+    }
+    if (op == "zext" || op == "trunc" || op == "bitcast" || op == "ptrtoint") {
+        auto val = parse_typed_value();
+        expect_word("to");
+        auto ty = parse_type();
+        if (!ok()) return nullptr;
+        ty = local_type(ty, result);
+        if (op == "bitcast") return BitCastInst::create_bitcast(val, ty, bb);
+        if (op == "ptrtoint") return PtrToIntInst::create_ptrtoint(val, ty, bb);
+        /** a trunc prints as zext too */
+        auto from = dyn_cast<IntegerType>(val->get_type());
+        auto to = dyn_cast<IntegerType>(ty);
+        if (op == "trunc" ||
+            (from && to && from->get_num_bits() > to->get_num_bits())) {
+            return TruncInst::create_trunc(val, ty, bb);
+        }
+        return ZextInst::create_zext(val, ty, bb);
+    }
+    if (op == "insertelement" || op == "extractelement") {
+        auto val = parse_typed_value();
+        expect(",");
+        auto ty = parse_type();
+        if (!ok()) return nullptr;
+        ty = local_type(ty, result);
+        if (op == "insertelement") {
+            return InsertElementInst::create_insert_element(val, ty, bb);
+        }
+        return ExtractElementInst::create_extract_element(val, ty, bb);
+    }
+    if (op == "getelementptr") {
+        /** "i32 0, " comes first when indexing a prototype or dispatch
+         * table */
+        auto pointee = parse_type();
+        expect(",");
+        auto ptr = parse_typed_value();
+        expect(",");
+        auto idx = parse_typed_value();
+        if (ok() && accept(",")) idx = parse_typed_value();
+        if (!ok()) return nullptr;
+        auto elem_ty = local_type(ptr_ty_, result);
+        if (elem_ty == ptr_ty_) {
+            elem_ty = element_type(pointee, idx);
+            if (!ok()) return nullptr;
+        } else {
+            elem_ty = elem_ty->get_ptr_element_type();
+        }
+        auto gep = new (m_)
+            GetElementPtrInst(PtrType::get(elem_ty), 2, bb, elem_ty);
+        gep->set_operand(0, ptr);
+        gep->set_operand(1, idx);
+        return gep;
+    }
+    if (op == "phi") {
+        auto ty = parse_type();
+        if (!ok()) return nullptr;
+        auto phi = PhiInst::create_phi(local_type(ty, result), bb);
+        /** the incoming undefs, and the commas around them, are not kept */
+        while (ok() && !at_line_end()) {
+            if (accept(",")) continue;
+            expect("[");
+            if (accept_word("undef")) {
+                expect(",");
+                block_ref();
+            } else {
+                auto val = parse_value(ty);
+                expect(",");
+                auto pred = block_ref();
+                if (ok()) phi->add_phi_pair_operand(val, pred);
+            }
+            expect("]");
+        }
+        if (!ok()) return nullptr;
+        phi->set_lval(phi->get_num_operand() > 0 ? phi->get_operand(0) : phi);
+        bb->add_instruction(phi);
+        phis_.push_back(phi);
+        return phi;
+    }
+    if (op == "vext") return parse_vext(bb);
+    fail(fmt::format("unknown instruction '{}'", op));
+    return nullptr;
+}
+
+/** "RET[ (PARAMS, ...)] CALLEE(ARGS)", or inline assembly. */
+Instruction *IRParser::parse_call(BasicBlock *bb) {
+    auto ty = parse_type();
+    if (ok() && ty->is_void_type() && accept_word("asm")) {
+        expect_word("sideeffect");
+        string asm_str(quoted());
+        expect(",");
+        quoted();
+        expect("(");
+        expect(")");
+        return ok() ? AsmInst::create_asm(m_, asm_str, bb) : nullptr;
+    }
+    auto callee = parse_value(nullptr);
+    expect("(");
+    vector<Value *> args;
+    while (ok() && !accept(")")) {
+        if (!args.empty()) expect(",");
+        args.push_back(parse_typed_value());
+    }
+    if (!ok()) return nullptr;
+    if (auto func = dyn_cast<Function>(callee)) {
+        return CallInst::create(func, args, bb);
+    }
+    auto func_ty = dyn_cast<FunctionType>(ty);
+    if (func_ty == nullptr) {
+        vector<Type *> params;
+        for (auto arg : args) params.push_back(arg->get_type());
+        func_ty = FunctionType::get(ty, params);
+    }
+    return CallInst::create(callee, func_ty, args, bb);
+}
+
+/** "i32 %count, ptr %dst = EXPR", EXPR printed by VExtInst::print_node. */
+VExtInst *IRParser::parse_vext(BasicBlock *bb) {
+    auto count = parse_typed_value();
+    expect(",");
+    auto dst = parse_typed_value();
+    expect("=");
+    vector<VExtInst::Node> program;
+    vector<Value *> leaves;
+    parse_vext_node(program, leaves);
+    if (ok() && (leaves.size() > VExtInst::max_leaves ||
+                 program.size() > VExtInst::max_nodes)) {
+        fail("vext too large");
+    }
+    if (!ok()) return nullptr;
+    return VExtInst::create_vext(count, dst, leaves, std::move(program), bb);
+}
+
+unsigned IRParser::parse_vext_node(vector<VExtInst::Node> &program,
+                                   vector<Value *> &leaves) {
+    auto leaf = [&leaves](Value *val) {
+        auto it = std::find(leaves.begin(), leaves.end(), val);
+        if (it == leaves.end()) it = leaves.insert(it, val);
+        return static_cast<unsigned>(2 + (it - leaves.begin()));
+    };
+    VExtInst::Node node{};
+    if (accept_word("vle")) {
+        expect("(");
+        auto stream = parse_typed_value();
+        expect(")");
+        node = {VExtInst::NodeKind::Stream, ok() ? leaf(stream) : 0};
+    } else if (accept_word("add") || accept_word("sub") ||
+               accept_word("mul")) {
+        auto kind = text_[pos_ - 3] == 'a'   ? VExtInst::NodeKind::Add
+                    : text_[pos_ - 3] == 's' ? VExtInst::NodeKind::Sub
+                                             : VExtInst::NodeKind::Mul;
+        expect("(");
+        auto lhs = parse_vext_node(program, leaves);
+        expect(",");
+        auto rhs = parse_vext_node(program, leaves);
+        expect(")");
+        node = {kind, lhs, rhs};
+    } else {
+        auto scalar = parse_typed_value();
+        node = {VExtInst::NodeKind::Scalar, ok() ? leaf(scalar) : 0};
+    }
+    if (program.size() > VExtInst::max_nodes) fail("vext too large");
+    program.push_back(node);
+    return program.size() - 1;
+}
+
+std::unique_ptr<Module> IRParser::parse(string *error) {
+    auto m = std::make_unique<Module>("");
+    m_ = m.get();
+    ptr_ty_ = PtrType::get(IntegerType::get(8, m_));
+    /** a comment to everything else */
+    constexpr string_view module_id = "; ModuleID = ";
+    if (text_.starts_with(module_id)) {
+        pos_ = module_id.size();
+        m->module_name_ = string(quoted());
+    }
+
+    declare_items();
+    for (auto c : m->get_class()) {
+        if (!c->anon_ && c->type_tag_ >= 0 &&
+            c->type_tag_ < (int)type_tag_last_.size())
+            c->type_tag_last_ = type_tag_last_[c->type_tag_];
+    }
+    define_items();
+    for (auto &[attr, global_name] : attr_inits_) {
+        attr->init_obj = global_ref(global_name);
+    }
+    if (!ok()) {
+        if (error != nullptr) *error = error_;
+        return nullptr;
+    }
+    return m;
+}
+}  // namespace
+
+std::unique_ptr<Module> parse_ir(string_view text, string *error) {
+    return IRParser(text).parse(error);
+}
+
+std::unique_ptr<Module> parse_ir_file(const string &path, string *error) {
+    std::ifstream input_stream(path);
+    if (!input_stream) {
+        if (error != nullptr) *error = fmt::format("cannot open {}", path);
+        return nullptr;
+    }
+    std::stringstream buffer;
+    buffer << input_stream.rdbuf();
+    return parse_ir(buffer.str(), error);
+}
+}  // namespace lightir
@@ -0,0 +1,875 @@
+#include "IRSerializer.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <unordered_map>
+#include <vector>
+
+#include "BasicBlock.hpp"
+#include "Class.hpp"
+#include "Constant.hpp"
+#include "Function.hpp"
+#include "GlobalVariable.hpp"
+#include "chocopy_bytes.hpp"
+
+using parser::ByteReader;
+using parser::ByteWriter;
+using std::unordered_map;
+using std::vector;
+
+namespace lightir {
+namespace {
+constexpr string_view magic = "LIRB";
+constexpr unsigned version = 2;
+
+enum class TypeTag : uint8_t {
+    Void,
+    Label,
+    Integer,
+    Ptr,
+    Function,
+    LabelType,
+    Class
+};
+
+/** How an operand is referred to. Classes, functions and globals are in
+ * the tables of the module, arguments, blocks and instructions in those of
+ * the current function. An instruction used before it is defined (by a phi)
+ * is a Forward reference and comes with its type. */
+enum class RefTag : uint8_t {
+    Null,
+    Class,
+    Function,
+    Global,
+    Constant,
+    ConstantInt,
+    ConstantNull,
+    Bare,
+    Argument,
+    Block,
+    Instruction,
+    Forward
+};
+
+enum class ConstantTag : uint8_t { Str, BoxInt, BoxBool };
+
+class Writer {
+   public:
+    explicit Writer(Module *m);
+    string write(uint64_t key);
+
+   private:
+    unsigned string_id(const string &s);
+    unsigned type_id(Type *ty);
+    unsigned class_id(Class *c, bool in_list = false);
+    void put_ref(ByteWriter &out, Value *v);
+    void write_class_body(Class *c);
+    void write_function_body(Function *func);
+    void write_instruction(Instruction *inst);
+
+    Module *m_;
+    ByteWriter strings_, classes_, types_, functions_, constants_, bares_,
+        globals_, class_bodies_, bodies_;
+    unsigned num_constants_ = 0;
+    unordered_map<string, unsigned> string_ids_;
+    unordered_map<Type *, unsigned> type_ids_;
+    unordered_map<Class *, unsigned> class_ids_;
+    vector<Class *> classes_list_;
+    unordered_map<Function *, unsigned> function_ids_;
+    unordered_map<GlobalVariable *, unsigned> global_ids_;
+    unordered_map<Value *, unsigned> constant_ids_;
+    unordered_map<Value *, unsigned> bare_ids_;
+    /** arguments, blocks and instructions of the function being written */
+    unordered_map<Value *, unsigned> local_ids_;
+    unsigned num_written_insts_ = 0;
+};
+
+Writer::Writer(Module *m) : m_(m) {
+    for (auto c : m->get_class()) class_id(c, true);
+    for (auto func : m->get_functions()) {
+        function_ids_.emplace(func, function_ids_.size());
+    }
+    for (auto global : m->get_global_variable()) {
+        global_ids_.emplace(global, global_ids_.size());
+    }
+}
+
+unsigned Writer::string_id(const string &s) {
+    auto [it, inserted] = string_ids_.emplace(s, string_ids_.size());
+    if (inserted) {
+        strings_.put_uint(s.size());
+        for (auto ch : s) strings_.put_byte(static_cast<uint8_t>(ch));
+    }
+    return it->second;
+}
+
+unsigned Writer::class_id(Class *c, bool in_list) {
+    if (auto it = class_ids_.find(c); it != class_ids_.end()) return it->second;
+    auto id = classes_list_.size();
+    class_ids_.emplace(c, id);
+    classes_list_.push_back(c);
+    classes_.put_byte(in_list);
+    classes_.put_byte(c->anon_);
+    classes_.put_uint(string_id(c->get_string()));
+    classes_.put_int(c->type_tag_);
+    classes_.put_int(c->type_tag_last_);
+    classes_.put_uint(string_id(c->prototype_label_));
+    classes_.put_uint(string_id(c->dispatch_table_label_));
+    classes_.put_byte(c->print_dispatch_table_);
+    return id;
+}
+
+unsigned Writer::type_id(Type *ty) {
+    if (auto it = type_ids_.find(ty); it != type_ids_.end()) return it->second;
+    /** the types it refers to come first */
+    ByteWriter record;
+    if (auto c = dyn_cast<Class>(ty)) {
+        record.put_byte(static_cast<uint8_t>(TypeTag::Class));
+        record.put_uint(class_id(c));
+    } else if (auto i = dyn_cast<IntegerType>(ty)) {
+        record.put_byte(static_cast<uint8_t>(TypeTag::Integer));
+        record.put_uint(i->get_num_bits());
+    } else if (auto p = dyn_cast<PtrType>(ty)) {
+        auto contained = type_id(p->get_element_type());
+        record.put_byte(static_cast<uint8_t>(TypeTag::Ptr));
+        record.put_uint(contained);
+    } else if (auto f = dyn_cast<FunctionType>(ty)) {
+        vector<unsigned> params;
+        for (auto param : f->get_params()) params.push_back(type_id(param));
+        auto result = type_id(f->get_return_type());
+        record.put_byte(static_cast<uint8_t>(TypeTag::Function));
+        record.put_uint(result);
+        record.put_uint(params.size());
+        for (auto param : params) record.put_uint(param);
+        record.put_byte(f->is_variable_args);
+    } else if (auto l = dyn_cast<LabelType>(ty)) {
+        record.put_byte(static_cast<uint8_t>(TypeTag::LabelType));
+        record.put_uint(string_id(l->get_label()));
+        record.put_byte(l->get_class() != nullptr);
+        if (l->get_class() != nullptr) {
+            record.put_uint(class_id(l->get_class()));
+        }
+    } else if (isa<VoidType>(ty)) {
+        record.put_byte(static_cast<uint8_t>(TypeTag::Void));
+    } else {
+        assert(ty == m_->get_label_type() && "unknown type");
+        record.put_byte(static_cast<uint8_t>(TypeTag::Label));
+    }
+    auto id = type_ids_.size();
+    type_ids_.emplace(ty, id);
+    types_.append(record);
+    return id;
+}
+
+void Writer::put_ref(ByteWriter &out, Value *v) {
+    auto put_tag = [&out](RefTag tag) {
+        out.put_byte(static_cast<uint8_t>(tag));
+    };
+    if (v == nullptr) {
+        put_tag(RefTag::Null);
+    } else if (auto c = dyn_cast<Class>(v)) {
+        put_tag(RefTag::Class);
+        out.put_uint(class_id(c));
+    } else if (auto func = dyn_cast<Function>(v)) {
+        put_tag(RefTag::Function);
+        out.put_uint(function_ids_.at(func));
+    } else if (auto global = dyn_cast<GlobalVariable>(v)) {
+        put_tag(RefTag::Global);
+        out.put_uint(global_ids_.at(global));
+    } else if (auto i = dyn_cast<ConstantInt>(v)) {
+        put_tag(RefTag::ConstantInt);
+        out.put_uint(type_id(i->get_type()));
+        out.put_int(i->get_value());
+    } else if (isa<ConstantNull>(v)) {
+        put_tag(RefTag::ConstantNull);
+        out.put_uint(type_id(v->get_type()));
+    } else if (isa<Constant>(v)) {
+        auto [it, inserted] = constant_ids_.emplace(v, num_constants_);
+        if (inserted) {
+            num_constants_++;
+            auto type = type_id(v->get_type());
+            if (auto s = dyn_cast<ConstantStr>(v)) {
+                constants_.put_byte(static_cast<uint8_t>(ConstantTag::Str));
+                constants_.put_uint(type);
+                constants_.put_uint(string_id(s->get_value()));
+                constants_.put_int(s->get_id());
+            } else if (auto b = dyn_cast<ConstantBoxInt>(v)) {
+                constants_.put_byte(static_cast<uint8_t>(ConstantTag::BoxInt));
+                constants_.put_uint(type);
+                constants_.put_int(b->get_value());
+                constants_.put_int(b->get_id());
+            } else {
+                auto bb = cast<ConstantBoxBool>(v);
+                constants_.put_byte(static_cast<uint8_t>(ConstantTag::BoxBool));
+                constants_.put_uint(type);
+                constants_.put_int(bb->get_value());
+                constants_.put_int(bb->get_id());
+            }
+        }
+        put_tag(RefTag::Constant);
+        out.put_uint(it->second);
+    } else if (v->get_value_kind() == ValueKind::Value) {
+        auto [it, inserted] = bare_ids_.emplace(v, bare_ids_.size());
+        if (inserted) {
+            bares_.put_uint(type_id(v->get_type()));
+            bares_.put_uint(string_id(v->name_));
+        }
+        put_tag(RefTag::Bare);
+        out.put_uint(it->second);
+    } else {
+        auto it = local_ids_.find(v);
+        assert(it != local_ids_.end() && "value of another function");
+        if (isa<Argument>(v)) {
+            put_tag(RefTag::Argument);
+            out.put_uint(it->second);
+        } else if (isa<BasicBlock>(v)) {
+            put_tag(RefTag::Block);
+            out.put_uint(it->second);
+        } else if (it->second < num_written_insts_) {
+            put_tag(RefTag::Instruction);
+            out.put_uint(it->second);
+        } else {
+            put_tag(RefTag::Forward);
+            out.put_uint(it->second);
+            out.put_uint(type_id(v->get_type()));
+        }
+    }
+}
+
+void Writer::write_class_body(Class *c) {
+    auto &out = class_bodies_;
+    out.put_uint(type_id(c->get_type()));
+    put_ref(out, c->super_class_info_);
+    put_ref(out, c->get_current_type());
+    out.put_uint(c->get_attribute()->size());
+    for (auto attr : *c->get_attribute()) {
+        out.put_uint(type_id(attr->get_type()));
+        out.put_uint(string_id(attr->name_));
+        out.put_int(attr->init_val);
+        put_ref(out, attr->init_obj);
+    }
+    out.put_uint(c->get_method()->size());
+    for (auto method : *c->get_method()) {
+        out.put_uint(function_ids_.at(method));
+    }
+}
+
+void Writer::write_function_body(Function *func) {
+    local_ids_.clear();
+    num_written_insts_ = 0;
+    unsigned num_insts = 0;
+    for (auto arg : func->get_args()) {
+        local_ids_.emplace(arg, local_ids_.size());
+    }
+    unsigned num_blocks = 0;
+    for (auto bb : func->get_basic_blocks()) {
+        local_ids_.emplace(bb, num_blocks++);
+        for (auto inst : bb->get_instructions()) {
+            local_ids_.emplace(inst, num_insts++);
+        }
+    }
+    bodies_.put_uint(num_blocks);
+    for (auto bb : func->get_basic_blocks()) {
+        bodies_.put_uint(string_id(bb->name_));
+    }
+    bodies_.put_uint(num_insts);
+    for (auto bb : func->get_basic_blocks()) {
+        bodies_.put_uint(bb->get_instructions().size());
+        for (auto inst : bb->get_instructions()) {
+            write_instruction(inst);
+            num_written_insts_++;
+        }
+    }
+}
+
+void Writer::write_instruction(Instruction *inst) {
+    auto &out = bodies_;
+    out.put_uint(static_cast<unsigned>(inst->get_value_kind()) -
+                 static_cast<unsigned>(ValueKind::FirstInstruction));
+    out.put_uint(inst->get_instr_type());
+    out.put_uint(type_id(inst->get_type()));
+    out.put_uint(string_id(inst->name_));
+    out.put_uint(string_id(inst->print_comment()));
+    out.put_uint(inst->get_num_operand());
+    for (auto op : inst->get_operands()) put_ref(out, op);
+
+    if (auto cmp = dyn_cast<CmpInst>(inst)) {
+        out.put_uint(cmp->get_cmp_op());
+    } else if (auto call = dyn_cast<CallInst>(inst)) {
+        out.put_uint(type_id(call->get_function_type()));
+        out.put_byte(call->is_tail_call());
+    } else if (auto alloca = dyn_cast<AllocaInst>(inst)) {
+        out.put_uint(type_id(alloca->get_alloca_type()));
+    } else if (auto gep = dyn_cast<GetElementPtrInst>(inst)) {
+        out.put_uint(type_id(gep->get_element_type()));
+    } else if (auto phi = dyn_cast<PhiInst>(inst)) {
+        put_ref(out, phi->get_lval());
+    } else if (auto asm_inst = dyn_cast<AsmInst>(inst)) {
+        out.put_uint(string_id(asm_inst->get_asm()));
+    } else if (auto vext = dyn_cast<VExtInst>(inst)) {
+        out.put_uint(vext->get_program().size());
+        for (auto &node : vext->get_program()) {
+            out.put_uint(static_cast<unsigned>(node.kind));
+            out.put_uint(node.lhs);
+            out.put_uint(node.rhs);
+        }
+    }
+}
+
+string Writer::write(uint64_t key) {
+    ByteWriter module;
+    module.put_uint(string_id(m_->module_name_));
+    module.put_uint(string_id(m_->source_file_name_));
+    module.put_int(m_->vectorize_num);
+    module.put_int(m_->unroll_factor);
+    module.put_int(m_->thread_num);
+    module.put_byte(m_->is_declaration_);
+
+    for (auto func : m_->get_functions()) {
+        functions_.put_uint(string_id(func->name_));
+        functions_.put_uint(type_id(func->get_type()));
+        functions_.put_byte(func->is_ctor);
+        functions_.put_byte(func->is_noreturn);
+        for (auto arg : func->get_args()) {
+            functions_.put_uint(string_id(arg->name_));
+        }
+    }
+    for (auto global : m_->get_global_variable()) {
+        globals_.put_uint(string_id(global->name_));
+        globals_.put_uint(type_id(global->get_type()));
+        globals_.put_byte(global->is_const_);
+        globals_.put_byte(global->is_print_head_);
+        globals_.put_byte(global->is_init);
+        put_ref(globals_, global->get_init());
+    }
+    for (auto func : m_->get_functions()) write_function_body(func);
+    /** bodies may refer to classes not seen so far, which need one too */
+    for (size_t i = 0; i < classes_list_.size(); i++) {
+        write_class_body(classes_list_[i]);
+    }
+
+    ByteWriter out;
+    for (auto ch : magic) out.put_byte(ch);
+    out.put_uint(version);
+    out.put_fixed64(key);
+    out.put_uint(string_ids_.size());
+    out.append(strings_);
+    out.append(module);
+    out.put_uint(classes_list_.size());
+    out.append(classes_);
+    out.put_uint(type_ids_.size());
+    out.append(types_);
+    out.put_uint(function_ids_.size());
+    out.append(functions_);
+    out.put_uint(num_constants_);
+    out.append(constants_);
+    out.put_uint(bare_ids_.size());
+    out.append(bares_);
+    out.put_uint(global_ids_.size());
+    out.append(globals_);
+    out.append(class_bodies_);
+    out.append(bodies_);
+    return out.bytes();
+}
+
+class Reader {
+   public:
+    explicit Reader(string_view data) : in_(data) {}
+    std::unique_ptr<Module> read(uint64_t key);
+
+   private:
+    template <typename T>
+    T get_entry(const vector<T> &table) {
+        auto idx = in_.get_index(table.size());
+        return in_.ok() ? table[idx] : T{};
+    }
+    string get_string() { return string(get_entry(strings_)); }
+    Type *get_type() { return get_entry(types_); }
+    Value *get_ref();
+    void read_classes();
+    void read_types();
+    void read_class_body(Class *c);
+    bool read_function_body(Function *func);
+    bool read_instruction(BasicBlock *bb);
+
+    ByteReader in_;
+    Module *m_ = nullptr;
+    /** views into the data: names are only copied into the values */
+    vector<string_view> strings_;
+    vector<Class *> classes_;
+    vector<Type *> types_;
+    vector<Function *> functions_;
+    vector<Value *> constants_;
+    vector<Value *> bares_;
+    vector<GlobalVariable *> globals_;
+    /** of the function being read */
+    vector<Argument *> args_;
+    vector<BasicBlock *> blocks_;
+    vector<Instruction *> insts_;
+    size_t num_insts_ = 0;
+    /** placeholders for the instructions used before their definition */
+    unordered_map<unsigned, Value *> forward_;
+};
+
+void Reader::read_classes() {
+    auto n = in_.get_count();
+    for (size_t i = 0; i < n && in_.ok(); i++) {
+        bool in_list = in_.get_byte();
+        bool anon = in_.get_byte();
+        auto name = get_string();
+        auto tag = in_.get_int();
+        auto tag_last = in_.get_int();
+        auto prototype_label = get_string();
+        auto dispatch_table_label = get_string();
+        bool print_dispatch_table = in_.get_byte();
+        if (anon && !in_list) in_.fail();
+        if (!in_.ok()) return;
+        Class *c;
+        if (anon) {
+            c = new (m_) Class(m_, name, true);
+        } else {
+            c = new (m_) Class(m_, name, tag, nullptr,
+                               !dispatch_table_label.empty(),
+                               print_dispatch_table, false);
+            if (in_list) m_->add_class(c);
+        }
+        if (!anon) c->type_tag_last_ = tag_last;
+        c->prototype_label_ = prototype_label;
+        c->dispatch_table_label_ = dispatch_table_label;
+        classes_.push_back(c);
+    }
+}
+
+void Reader::read_types() {
+    auto n = in_.get_count();
+    for (size_t i = 0; i < n && in_.ok(); i++) {
+        Type *ty = nullptr;
+        switch (static_cast<TypeTag>(in_.get_byte())) {
+            case TypeTag::Void:
+                ty = m_->get_void_type();
+                break;
+            case TypeTag::Label:
+                ty = m_->get_label_type();
+                break;
+            case TypeTag::Integer:
+                ty = IntegerType::get(in_.get_uint(), m_);
+                break;
+            case TypeTag::Ptr:
+                if (auto contained = get_type()) ty = PtrType::get(contained);
+                break;
+            case TypeTag::Function: {
+                auto result = get_type();
+                vector<Type *> params(in_.get_count());
+                for (auto &param : params) param = get_type();
+                bool is_variable_args = in_.get_byte();
+                if (in_.ok()) {
+                    ty = FunctionType::get(result, params, is_variable_args);
+                }
+                break;
+            }
+            case TypeTag::LabelType: {
+                auto label = get_string();
+                Class *stored = nullptr;
+                if (in_.get_byte()) stored = get_entry(classes_);
+                if (in_.ok()) ty = LabelType::get(label, stored, m_);
+                break;
+            }
+            case TypeTag::Class:
+                ty = get_entry(classes_);
+                break;
+            default:
+                in_.fail();
+        }
+        types_.push_back(ty);
+    }
+}
+
+Value *Reader::get_ref() {
+    switch (static_cast<RefTag>(in_.get_byte())) {
+        case RefTag::Null:
+            return nullptr;
+        case RefTag::Class:
+            return get_entry(classes_);
+        case RefTag::Function:
+            return get_entry(functions_);
+        case RefTag::Global:
+            return get_entry(globals_);
+        case RefTag::Constant:
+            return get_entry(constants_);
+        case RefTag::ConstantInt: {
+            auto ty = dyn_cast<IntegerType>(get_type());
+            auto val = in_.get_int();
+            if (ty == nullptr) break;
+            return m_->get_constant_int(ty, val);
+        }
+        case RefTag::ConstantNull: {
+            auto ty = get_type();
+            if (ty == nullptr) break;
+            return m_->get_constant_null(ty);
+        }
+        case RefTag::Bare:
+            return get_entry(bares_);
+        case RefTag::Argument:
+            return get_entry(args_);
+        case RefTag::Block:
+            return get_entry(blocks_);
+        case RefTag::Instruction:
+            return get_entry(insts_);
+        case RefTag::Forward: {
+            auto idx = in_.get_index(num_insts_);
+            auto ty = get_type();
+            if (ty == nullptr || idx < insts_.size()) break;
+            auto &placeholder = forward_[idx];
+            if (placeholder == nullptr) placeholder = new (m_) Value(ty);
+            return placeholder;
+        }
+        default:
+            break;
+    }
+    in_.fail();
+    return nullptr;
+}
+
+void Reader::read_class_body(Class *c) {
+    auto ty = get_type();
+    auto super = get_ref();
+    auto current = get_ref();
+    if (!in_.ok()) return;
+    c->set_type(ty);
+    c->super_class_info_ = dyn_cast<Class>(super);
+    c->set_current_type(dyn_cast<Class>(current));
+    auto num_attrs = in_.get_count();
+    for (size_t i = 0; i < num_attrs && in_.ok(); i++) {
+        auto attr_ty = get_type();
+        auto name = get_string();
+        auto init_val = in_.get_int();
+        auto init_obj = get_ref();
+        if (!in_.ok()) return;
+        auto attr =
+            new (m_) AttrInfo(attr_ty, name, static_cast<int>(init_val));
+        attr->init_obj = init_obj;
+        c->add_attribute(attr);
+    }
+    auto num_methods = in_.get_count();
+    for (size_t i = 0; i < num_methods && in_.ok(); i++) {
+        /** not add_method, which would merge methods of the same name */
+        if (auto method = get_entry(functions_)) c->methods_->push_back(method);
+    }
+}
+
+bool Reader::read_function_body(Function *func) {
+    args_.assign(func->get_args().begin(), func->get_args().end());
+    blocks_.clear();
+    insts_.clear();
+    forward_.clear();
+    auto num_blocks = in_.get_count();
+    for (size_t i = 0; i < num_blocks && in_.ok(); i++) {
+        auto bb = BasicBlock::create(m_, "", func);
+        bb->set_name(get_string());
+        blocks_.push_back(bb);
+    }
+    num_insts_ = in_.get_count();
+    for (auto bb : blocks_) {
+        auto n = in_.get_count();
+        for (size_t i = 0; i < n && in_.ok(); i++) {
+            if (!read_instruction(bb)) in_.fail();
+        }
+    }
+    if (!in_.ok() || insts_.size() != num_insts_) return false;
+    for (auto [idx, placeholder] : forward_) {
+        placeholder->replace_all_use_with(insts_[idx]);
+        for (auto inst : insts_) {
+            auto phi = dyn_cast<PhiInst>(inst);
+            if (phi && phi->get_lval() == placeholder) {
+                phi->set_lval(insts_[idx]);
+            }
+        }
+    }
+    return true;
+}
+
+bool Reader::read_instruction(BasicBlock *bb) {
+    auto kind = static_cast<ValueKind>(
+        in_.get_index(static_cast<unsigned>(ValueKind::LastInstruction) -
+                      static_cast<unsigned>(ValueKind::FirstInstruction) + 1) +
+        static_cast<unsigned>(ValueKind::FirstInstruction));
+    auto op =
+        static_cast<Instruction::OpID>(in_.get_index(Instruction::ASM + 1));
+    auto ty = get_type();
+    auto name = get_string();
+    auto comment = get_string();
+    vector<Value *> ops(in_.get_count());
+    for (auto &operand : ops) operand = get_ref();
+    if (!in_.ok()) return false;
+
+    auto operand = [&ops](size_t i) {
+        return i < ops.size() ? ops[i] : nullptr;
+    };
+    auto block = [&](size_t i) { return dyn_cast<BasicBlock>(operand(i)); };
+    Instruction *inst = nullptr;
+    switch (kind) {
+        case ValueKind::BinaryInst:
+            if (ops.size() != 2) return false;
+            inst = new (m_) BinaryInst(ty, op, ops[0], ops[1], bb);
+            break;
+        case ValueKind::UnaryInst:
+            if (ops.size() != 1) return false;
+            inst = op == Instruction::Neg
+                       ? UnaryInst::create_neg(ops[0], bb, m_)
+                       : UnaryInst::create_not(ops[0], bb, m_);
+            break;
+        case ValueKind::CmpInst: {
+            auto cmp_op = static_cast<CmpInst::CmpOp>(in_.get_uint());
+            if (ops.size() != 2) return false;
+            inst = CmpInst::create_cmp(cmp_op, ops[0], ops[1], bb, m_);
+            break;
+        }
+        case ValueKind::CallInst: {
+            auto func_ty = dyn_cast<FunctionType>(get_type());
+            bool is_tail_call = in_.get_byte();
+            if (ops.empty() || func_ty == nullptr) return false;
+            auto call = CallInst::create(
+                ops[0], func_ty, vector<Value *>(ops.begin() + 1, ops.end()),
+                bb);
+            call->set_tail_call(is_tail_call);
+            inst = call;
+            break;
+        }
+        case ValueKind::BranchInst:
+            if (ops.size() == 1 && block(0)) {
+                inst = BranchInst::create_br(block(0), bb);
+            } else if (ops.size() == 3 && block(1) && block(2)) {
+                inst = BranchInst::create_cond_br(ops[0], block(1), block(2),
+                                                  bb);
+            }
+            break;
+        case ValueKind::ReturnInst:
+            inst = ops.empty() ? ReturnInst::create_void_ret(bb)
+                               : ReturnInst::create_ret(ops[0], bb);
+            break;
+        case ValueKind::UnreachableInst:
+            inst = UnreachableInst::create_unreachable(bb);
+            break;
+        case ValueKind::StoreInst:
+            if (ops.size() != 2) return false;
+            inst = StoreInst::create_store(ops[0], ops[1], bb);
+            break;
+        case ValueKind::LoadInst:
+            if (ops.size() != 1) return false;
+            inst = LoadInst::create_load(ty, ops[0], bb);
+            break;
+        case ValueKind::AllocaInst: {
+            auto alloca_ty = get_type();
+            if (alloca_ty == nullptr) return false;
+            inst = AllocaInst::create_alloca(alloca_ty, bb);
+            break;
+        }
+        case ValueKind::ZextInst:
+            if (ops.size() != 1) return false;
+            inst = ZextInst::create_zext(ops[0], ty, bb);
+            break;
+        case ValueKind::InsertElementInst:
+            if (ops.size() != 1) return false;
+            inst = InsertElementInst::create_insert_element(ops[0], ty, bb);
+            break;
+        case ValueKind::ExtractElementInst:
+            if (ops.size() != 1) return false;
+            inst = ExtractElementInst::create_extract_element(ops[0], ty, bb);
+            break;
+        case ValueKind::BitCastInst:
+            if (ops.size() != 1) return false;
+            inst = BitCastInst::create_bitcast(ops[0], ty, bb);
+            break;
+        case ValueKind::PtrToIntInst:
+            if (ops.size() != 1) return false;
+            inst = PtrToIntInst::create_ptrtoint(ops[0], ty, bb);
+            break;
+        case ValueKind::TruncInst:
+            if (ops.size() != 1) return false;
+            inst = TruncInst::create_trunc(ops[0], ty, bb);
+            break;
+        case ValueKind::GetElementPtrInst: {
+            auto elem_ty = get_type();
+            if (elem_ty == nullptr) return false;
+            auto gep = new (m_) GetElementPtrInst(ty, ops.size(), bb, elem_ty);
+            for (size_t i = 0; i < ops.size(); i++) gep->set_operand(i, ops[i]);
+            inst = gep;
+            break;
+        }
+        case ValueKind::PhiInst: {
+            auto lval = get_ref();
+            if (!in_.ok()) return false;
+            auto phi = PhiInst::create_phi(ty, bb);
+            for (auto val : ops) phi->add_operand(val);
+            phi->set_lval(lval);
+            bb->add_instruction(phi);
+            inst = phi;
+            break;
+        }
+        case ValueKind::AsmInst:
+            inst = AsmInst::create_asm(m_, get_string(), bb);
+            break;
+        case ValueKind::VExtInst: {
+            vector<VExtInst::Node> program(in_.get_count());
+            for (auto &node : program) {
+                node.kind = static_cast<VExtInst::NodeKind>(in_.get_uint());
+                node.lhs = in_.get_index(ops.size());
+                node.rhs = in_.get_uint();
+            }
+            if (!in_.ok() || ops.size() < 2 || program.empty() ||
+                ops.size() - 2 > VExtInst::max_leaves) {
+                return false;
+            }
+            inst = VExtInst::create_vext(
+                ops[0], ops[1], vector<Value *>(ops.begin() + 2, ops.end()),
+                std::move(program), bb);
+            break;
+        }
+        default:
+            break;
+    }
+    if (inst == nullptr || !in_.ok()) return false;
+    inst->set_type(ty);
+    inst->set_name(name);
+    inst->set_comment(comment);
+    insts_.push_back(inst);
+    return true;
+}
+
+std::unique_ptr<Module> Reader::read(uint64_t key) {
+    if (in_.get_bytes(magic.size()) != magic || in_.get_uint() != version ||
+        in_.get_fixed64() != key || !in_.ok()) {
+        return nullptr;
+    }
+    auto num_strings = in_.get_count();
+    for (size_t i = 0; i < num_strings && in_.ok(); i++) {
+        strings_.push_back(in_.get_bytes(in_.get_uint()));
+    }
+    if (!in_.ok()) return nullptr;
+
+    auto m = std::make_unique<Module>(get_string());
+    m_ = m.get();
+    m->source_file_name_ = get_string();
+    m->vectorize_num = in_.get_int();
+    m->unroll_factor = in_.get_int();
+    m->thread_num = in_.get_int();
+    m->is_declaration_ = in_.get_byte();
+
+    read_classes();
+    read_types();
+
+    auto num_functions = in_.get_count();
+    for (size_t i = 0; i < num_functions && in_.ok(); i++) {
+        auto name = get_string();
+        auto ty = dyn_cast<FunctionType>(get_type());
+        bool is_ctor = in_.get_byte();
+        bool is_noreturn = in_.get_byte();
+        if (ty == nullptr) {
+            in_.fail();
+            break;
+        }
+        auto func = Function::create(is_ctor, ty, name, m_);
+        func->is_noreturn = is_noreturn;
+        for (auto arg : func->get_args()) arg->set_name(get_string());
+        functions_.push_back(func);
+    }
+
+    auto num_constants = in_.get_count();
+    for (size_t i = 0; i < num_constants && in_.ok(); i++) {
+        auto tag = static_cast<ConstantTag>(in_.get_byte());
+        auto ty = get_type();
+        if (!in_.ok()) break;
+        Value *constant = nullptr;
+        if (tag == ConstantTag::Str) {
+            auto val = get_string();
+            constant = new (m_) ConstantStr(ty, val, in_.get_int());
+        } else if (tag == ConstantTag::BoxInt) {
+            auto val = in_.get_int();
+            constant = new (m_) ConstantBoxInt(ty, val, in_.get_int());
+        } else if (tag == ConstantTag::BoxBool) {
+            auto val = in_.get_int();
+            constant = new (m_) ConstantBoxBool(ty, val, in_.get_int());
+        } else {
+            in_.fail();
+        }
+        constants_.push_back(constant);
+    }
+
+    auto num_bares = in_.get_count();
+    for (size_t i = 0; i < num_bares && in_.ok(); i++) {
+        auto ty = get_type();
+        auto name = get_string();
+        if (in_.ok()) bares_.push_back(new (m_) Value(ty, name));
+    }
+
+    auto num_globals = in_.get_count();
+    for (size_t i = 0; i < num_globals && in_.ok(); i++) {
+        auto name = get_string();
+        auto ty = get_type();
+        bool is_const = in_.get_byte();
+        bool is_print_head = in_.get_byte();
+        bool is_init = in_.get_byte();
+        auto init = get_ref();
+        if (!in_.ok() || (init != nullptr && !isa<Constant>(init))) {
+            in_.fail();
+            break;
+        }
+        auto global = GlobalVariable::create(name, m_, ty, is_const,
+                                             dyn_cast<Constant>(init));
+        global->is_print_head_ = is_print_head;
+        global->is_init = is_init;
+        globals_.push_back(global);
+    }
+
+    for (auto c : classes_) {
+        if (!in_.ok()) break;
+        read_class_body(c);
+    }
+    for (auto func : functions_) {
+        if (!in_.ok() || !read_function_body(func)) return nullptr;
+    }
+    if (!in_.ok() || !in_.at_end()) return nullptr;
+    return m;
+}
+}  // namespace
+
+string write_binary_ir(Module *m, uint64_t key) { return Writer(m).write(key); }
+
+bool write_binary_ir_file(Module *m, const string &path, uint64_t key) {
+    return parser::write_file_atomically(path, write_binary_ir(m, key));
+}
+
+std::unique_ptr<Module> read_binary_ir(string_view data, uint64_t key) {
+    return Reader(data).read(key);
+}
+
+std::unique_ptr<Module> read_binary_ir_file(const string &path, uint64_t key) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+    struct stat st {};
+    std::unique_ptr<Module> m;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        auto size = static_cast<size_t>(st.st_size);
+        void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            m = read_binary_ir(string_view(static_cast<char *>(data), size),
+                               key);
+            munmap(data, size);
+        }
+    }
+    close(fd);
+    return m;
+}
+
+uint64_t read_binary_ir_key(string_view data) {
+    ByteReader in(data);
+    if (in.get_bytes(magic.size()) != magic || in.get_uint() != version) {
+        return 0;
+    }
+    auto key = in.get_fixed64();
+    return in.ok() ? key : 0;
+}
+}  // namespace lightir
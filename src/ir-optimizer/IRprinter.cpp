@@ -7,25 +7,25 @@ namespace lightir {
 
 string print_as_op(Value *v, bool print_ty, const string &method_) {
     string op_ir;
-    if (print_ty && !dynamic_cast<BasicBlock *>(v)) {
+    if (print_ty && !dyn_cast<BasicBlock>(v)) {
         op_ir += v->get_type()->print();
         op_ir += " ";
     }
 
-    if (dynamic_cast<GlobalVariable *>(v)) {
+    if (dyn_cast<GlobalVariable>(v)) {
         op_ir += "@" + v->get_name();
-    } else if (dynamic_cast<Function *>(v)) {
+    } else if (dyn_cast<Function>(v)) {
         if (method_.empty()) {
             op_ir += "@" + v->get_name();
         } else {
             op_ir += "@" + method_ + "." + v->get_name();
         }
-    } else if (dynamic_cast<ConstantStr *>(v)) {
+    } else if (dyn_cast<ConstantStr>(v)) {
         op_ir += v->print();
-    } else if (dynamic_cast<Constant *>(v)) {
+    } else if (dyn_cast<Constant>(v)) {
         op_ir += std::regex_replace(v->print(), to_const_replace, "");
-    } else if (dynamic_cast<Class *>(v) &&
-               dynamic_cast<Class *>(v)->is_class_anon()) {
+    } else if (dyn_cast<Class>(v) &&
+               dyn_cast<Class>(v)->is_class_anon()) {
         op_ir += "%arg0";
     } else {
         op_ir += "%" + v->get_name();
@@ -28,6 +28,7 @@ Module *Instruction::get_module() { return parent_->get_module(); }
 
 BinaryInst::BinaryInst(Type *ty, OpID id, Value *v1, Value *v2, BasicBlock *bb)
     : Instruction(ty, id, 2, bb) {
+    set_value_kind(ValueKind::BinaryInst);
     set_operand(0, v1);
     set_operand(1, v2);
 }
@@ -35,63 +36,65 @@ BinaryInst::BinaryInst(Type *ty, OpID id, Value *v1, Value *v2, BasicBlock *bb)
 void BinaryInst::assert_valid() {
     assert(get_operand(0)->get_type()->is_integer_type());
     assert(get_operand(1)->get_type()->is_integer_type());
-    assert(dynamic_cast<IntegerType *>(get_operand(0)->get_type())
+    assert(dyn_cast<IntegerType>(get_operand(0)->get_type())
                ->get_num_bits() ==
-           dynamic_cast<IntegerType *>(get_operand(1)->get_type())
+           dyn_cast<IntegerType>(get_operand(1)->get_type())
                ->get_num_bits());
 }
 
 BinaryInst *BinaryInst::create_add(Value *v1, Value *v2, BasicBlock *bb,
                                    Module *m) {
-    return new BinaryInst(Type::get_int32_type(m), Instruction::Add, v1, v2,
-                          bb);
+    return new (m) BinaryInst(Type::get_int32_type(m), Instruction::Add, v1, v2,
+                              bb);
 }
 
 BinaryInst *BinaryInst::create_sub(Value *v1, Value *v2, BasicBlock *bb,
                                    Module *m) {
-    return new BinaryInst(Type::get_int32_type(m), Instruction::Sub, v1, v2,
-                          bb);
+    return new (m) BinaryInst(Type::get_int32_type(m), Instruction::Sub, v1, v2,
+                              bb);
 }
 
 BinaryInst *BinaryInst::create_mul(Value *v1, Value *v2, BasicBlock *bb,
                                    Module *m) {
-    return new BinaryInst(Type::get_int32_type(m), Instruction::Mul, v1, v2,
-                          bb);
+    return new (m) BinaryInst(Type::get_int32_type(m), Instruction::Mul, v1, v2,
+                              bb);
 }
 
 BinaryInst *BinaryInst::create_sdiv(Value *v1, Value *v2, BasicBlock *bb,
                                     Module *m) {
-    return new BinaryInst(Type::get_int32_type(m), Instruction::Div, v1, v2,
-                          bb);
+    return new (m) BinaryInst(Type::get_int32_type(m), Instruction::Div, v1, v2,
+                              bb);
 }
 
 BinaryInst *BinaryInst::create_rem(Value *v1, Value *v2, BasicBlock *bb,
                                    Module *m) {
-    return new BinaryInst(Type::get_int32_type(m), Instruction::Rem, v1, v2,
-                          bb);
+    return new (m) BinaryInst(Type::get_int32_type(m), Instruction::Rem, v1, v2,
+                              bb);
 }
 
 BinaryInst *BinaryInst::create_and(Value *v1, Value *v2, BasicBlock *bb,
                                    Module *m) {
-    return new BinaryInst(Type::get_int32_type(m), Instruction::And, v1, v2,
-                          bb);
+    return new (m) BinaryInst(Type::get_int32_type(m), Instruction::And, v1, v2,
+                              bb);
 }
 
 BinaryInst *BinaryInst::create_or(Value *v1, Value *v2, BasicBlock *bb,
                                   Module *m) {
-    return new BinaryInst(Type::get_int32_type(m), Instruction::Or, v1, v2, bb);
+    return new (m) BinaryInst(Type::get_int32_type(m), Instruction::Or, v1, v2,
+                              bb);
 }
 
 UnaryInst *UnaryInst::create_not(Value *v1, BasicBlock *bb, Module *m) {
-    return new UnaryInst(Type::get_int32_type(m), Instruction::Not, v1, bb);
+    return new (m) UnaryInst(Type::get_int32_type(m), Instruction::Not, v1, bb);
 }
 
 UnaryInst *UnaryInst::create_neg(Value *v1, BasicBlock *bb, Module *m) {
-    return new UnaryInst(Type::get_int32_type(m), Instruction::Neg, v1, bb);
+    return new (m) UnaryInst(Type::get_int32_type(m), Instruction::Neg, v1, bb);
 }
 
 UnaryInst::UnaryInst(Type *ty, OpID id, Value *v1, BasicBlock *bb)
     : Instruction(ty, id, 1, bb) {
+    set_value_kind(ValueKind::UnaryInst);
     set_operand(0, v1);
 }
 
@@ -123,6 +126,7 @@ string BinaryInst::print() {
 
 CmpInst::CmpInst(Type *ty, CmpOp op, Value *lhs, Value *rhs, BasicBlock *bb)
     : Instruction(ty, Instruction::ICmp, 2, bb), cmp_op_(op) {
+    set_value_kind(ValueKind::CmpInst);
     set_operand(0, lhs);
     set_operand(1, rhs);
     assert_valid();
@@ -134,15 +138,15 @@ void CmpInst::assert_valid() {
         return;
     assert(get_operand(0)->get_type()->is_integer_type());
     assert(get_operand(1)->get_type()->is_integer_type());
-    assert(dynamic_cast<IntegerType *>(get_operand(0)->get_type())
+    assert(dyn_cast<IntegerType>(get_operand(0)->get_type())
                ->get_num_bits() ==
-           dynamic_cast<IntegerType *>(get_operand(1)->get_type())
+           dyn_cast<IntegerType>(get_operand(1)->get_type())
                ->get_num_bits());
 }
 
 CmpInst *CmpInst::create_cmp(CmpOp op, Value *lhs, Value *rhs, BasicBlock *bb,
                              Module *m) {
-    return new CmpInst(m->get_int1_type(), op, lhs, rhs, bb);
+    return new (m) CmpInst(m->get_int1_type(), op, lhs, rhs, bb);
 }
 
 string CmpInst::print() {
@@ -169,6 +173,7 @@ CallInst::CallInst(Function *func, std::vector<Value *> args, BasicBlock *bb)
     : Instruction(func->get_return_type(), Instruction::Call, args.size() + 1,
                   bb),
       func_type_(func->get_function_type()) {
+    set_value_kind(ValueKind::CallInst);
     /** Runtime will support the check */
     int num_ops = args.size() + 1;
     set_operand(0, func);
@@ -181,6 +186,7 @@ CallInst::CallInst(Value *real_func, FunctionType *func,
     : Instruction(func->get_return_type(), Instruction::Call, args.size() + 1,
                   bb),
       func_type_(func) {
+    set_value_kind(ValueKind::CallInst);
     /** Runtime will support the check */
     int num_ops = args.size() + 1;
     set_operand(0, real_func);
@@ -191,15 +197,21 @@ CallInst::CallInst(Value *real_func, FunctionType *func,
 
 CallInst *CallInst::create(Function *func, std::vector<Value *> args,
                            BasicBlock *bb) {
-    return new CallInst(func, std::move(args), bb);
+    return new (bb->get_module()) CallInst(func, std::move(args), bb);
 }
 CallInst *CallInst::create(Value *real_func, FunctionType *func,
                            std::vector<Value *> args, BasicBlock *bb) {
-    return new CallInst(real_func, func, std::move(args), bb);
+    return new (bb->get_module()) CallInst(real_func, func, std::move(args),
+                                           bb);
 }
 
 FunctionType *CallInst::get_function_type() const { return func_type_; }
 
+bool CallInst::is_noreturn() const {
+    auto callee = dyn_cast<Function>(this->get_operand(0));
+    return callee != nullptr && callee->is_noreturn;
+}
+
 string CallInst::print() {
     string instr_ir;
     if (!this->is_void()) {
@@ -207,17 +219,18 @@ string CallInst::print() {
         instr_ir += this->get_name();
         instr_ir += " = ";
     }
+    if (is_tail_call_) instr_ir += "tail ";
     instr_ir += this->get_module()->get_instr_op_name(this->get_instr_type());
     instr_ir += " ";
     instr_ir += this->get_function_type()->get_return_type()->print();
     if (this->get_function_type()->is_variable_args) {
         instr_ir += " (";
         for (unsigned int i = 0;
-             i < dynamic_cast<FunctionType *>(this->get_function_type())
+             i < dyn_cast<FunctionType>(this->get_function_type())
                      ->get_num_of_args();
              i++) {
             if (i) instr_ir += ", ";
-            instr_ir += dynamic_cast<FunctionType *>(this->get_function_type())
+            instr_ir += dyn_cast<FunctionType>(this->get_function_type())
                             ->get_param_type(i)
                             ->print();
         }
@@ -238,6 +251,7 @@ BranchInst::BranchInst(Value *cond, BasicBlock *if_true, BasicBlock *if_false,
                        BasicBlock *bb)
     : Instruction(Type::get_void_type(if_true->get_module()), Instruction::Br,
                   3, bb) {
+    set_value_kind(ValueKind::BranchInst);
     set_operand(0, cond);
     set_operand(1, if_true);
     set_operand(2, if_false);
@@ -246,6 +260,7 @@ BranchInst::BranchInst(Value *cond, BasicBlock *if_true, BasicBlock *if_false,
 BranchInst::BranchInst(BasicBlock *if_true, BasicBlock *bb)
     : Instruction(Type::get_void_type(if_true->get_module()), Instruction::Br,
                   1, bb) {
+    set_value_kind(ValueKind::BranchInst);
     set_operand(0, if_true);
 }
 
@@ -256,14 +271,14 @@ BranchInst *BranchInst::create_cond_br(Value *cond, BasicBlock *if_true,
     bb->add_succ_basic_block(if_false);
     bb->add_succ_basic_block(if_true);
 
-    return new BranchInst(cond, if_true, if_false, bb);
+    return new (bb->get_module()) BranchInst(cond, if_true, if_false, bb);
 }
 
 BranchInst *BranchInst::create_br(BasicBlock *if_true, BasicBlock *bb) {
     if_true->add_pre_basic_block(bb);
     bb->add_succ_basic_block(if_true);
 
-    return new BranchInst(if_true, bb);
+    return new (bb->get_module()) BranchInst(if_true, bb);
 }
 
 bool BranchInst::is_cond_br() const { return get_num_operand() == 3; }
@@ -291,19 +306,36 @@ bool BranchInst::is_cmp_br() const { return get_num_operand() == 4; }
 ReturnInst::ReturnInst(Value *val, BasicBlock *bb)
     : Instruction(Type::get_void_type(bb->get_module()), Instruction::Ret, 1,
                   bb) {
+    set_value_kind(ValueKind::ReturnInst);
     set_operand(0, val);
 }
 
 ReturnInst::ReturnInst(BasicBlock *bb)
     : Instruction(Type::get_void_type(bb->get_module()), Instruction::Ret, 0,
-                  bb) {}
+                  bb) {
+    set_value_kind(ValueKind::ReturnInst);
+}
 
 ReturnInst *ReturnInst::create_ret(Value *val, BasicBlock *bb) {
-    return new ReturnInst(val, bb);
+    return new (bb->get_module()) ReturnInst(val, bb);
 }
 
 ReturnInst *ReturnInst::create_void_ret(BasicBlock *bb) {
-    return new ReturnInst(bb);
+    return new (bb->get_module()) ReturnInst(bb);
+}
+
+UnreachableInst::UnreachableInst(BasicBlock *bb)
+    : Instruction(Type::get_void_type(bb->get_module()),
+                  Instruction::Unreachable, 0, bb) {
+    set_value_kind(ValueKind::UnreachableInst);
+}
+
+UnreachableInst *UnreachableInst::create_unreachable(BasicBlock *bb) {
+    return new (bb->get_module()) UnreachableInst(bb);
+}
+
+string UnreachableInst::print() {
+    return this->get_module()->get_instr_op_name(this->get_instr_type());
 }
 
 bool ReturnInst::is_void_ret() const { return get_num_operand() == 0; }
@@ -325,12 +357,13 @@ string ReturnInst::print() {
 StoreInst::StoreInst(Value *val, Value *ptr, BasicBlock *bb)
     : Instruction(Type::get_void_type(bb->get_module()), Instruction::Store, 2,
                   bb) {
+    set_value_kind(ValueKind::StoreInst);
     set_operand(0, val);
     set_operand(1, ptr);
 }
 
 StoreInst *StoreInst::create_store(Value *val, Value *ptr, BasicBlock *bb) {
-    return new StoreInst(val, ptr, bb);
+    return new (bb->get_module()) StoreInst(val, ptr, bb);
 }
 
 string StoreInst::print() {
@@ -341,13 +374,13 @@ string StoreInst::print() {
             this->get_module()->get_instr_op_name(this->get_instr_type()),
             print_as_op(this->get_operand(0), true),
             print_as_op(this->get_operand(1), false));
-    } else if (dynamic_cast<GlobalVariable *>(this->get_operand(1))) {
+    } else if (dyn_cast<GlobalVariable>(this->get_operand(1))) {
         instr_ir += fmt::format(
             "{} {}, {}",
             this->get_module()->get_instr_op_name(this->get_instr_type()),
             print_as_op(this->get_operand(0), true),
             this->get_operand(1)->print());
-    } else if (dynamic_cast<GlobalVariable *>(this->get_operand(0))) {
+    } else if (dyn_cast<GlobalVariable>(this->get_operand(0))) {
         instr_ir += fmt::format(
             "{} {}, {}",
             this->get_module()->get_instr_op_name(this->get_instr_type()),
@@ -364,22 +397,23 @@ string StoreInst::print() {
 
 LoadInst::LoadInst(Type *ty, Value *ptr, BasicBlock *bb)
     : Instruction(ty, Instruction::Load, 1, bb) {
+    set_value_kind(ValueKind::LoadInst);
     set_operand(0, ptr);
 }
 LoadInst *LoadInst::create_load(Type *ty, Value *ptr, BasicBlock *bb) {
-    return new LoadInst(ty, ptr, bb);
+    return new (bb->get_module()) LoadInst(ty, ptr, bb);
 }
 Type *LoadInst::get_load_type() const { return get_operand(0)->get_type(); }
 
 string LoadInst::print() {
     string load_inst;
-    if (dynamic_cast<GlobalVariable *>(this->get_operand(0))) {
+    if (dyn_cast<GlobalVariable>(this->get_operand(0))) {
         load_inst += fmt::format(
             "%{} = {} {}, {}", this->get_name(),
             this->get_module()->get_instr_op_name(this->get_instr_type()),
             this->get_operand(0)->get_type()->print(),
             this->get_operand(0)->print());
-    } else if (dynamic_cast<AllocaInst *>(this->get_operand(0))) {
+    } else if (dyn_cast<AllocaInst>(this->get_operand(0))) {
         auto t =
             this->get_operand(0)->get_type()->get_ptr_element_type()->print();
         load_inst += fmt::format(
@@ -400,10 +434,12 @@ string LoadInst::print() {
 
 AllocaInst::AllocaInst(Type *ty, BasicBlock *bb)
     : Instruction(PtrType::get(ty), Instruction::Alloca, 0, bb),
-      alloca_ty_(ty) {}
+      alloca_ty_(ty) {
+    set_value_kind(ValueKind::AllocaInst);
+}
 
 AllocaInst *AllocaInst::create_alloca(Type *ty, BasicBlock *bb) {
-    return new AllocaInst(ty, bb);
+    return new (bb->get_module()) AllocaInst(ty, bb);
 }
 
 Type *AllocaInst::get_alloca_type() const { return alloca_ty_; }
@@ -427,11 +463,12 @@ string AllocaInst::print() {
 
 ZextInst::ZextInst(OpID op, Value *val, Type *ty, BasicBlock *bb)
     : Instruction(ty, op, 1, bb), dest_ty_(ty) {
+    set_value_kind(ValueKind::ZextInst);
     set_operand(0, val);
 }
 
 ZextInst *ZextInst::create_zext(Value *val, Type *ty, BasicBlock *bb) {
-    return new ZextInst(Instruction::ZExt, val, ty, bb);
+    return new (bb->get_module()) ZextInst(Instruction::ZExt, val, ty, bb);
 }
 
 Type *ZextInst::get_dest_type() const { return dest_ty_; }
@@ -448,13 +485,15 @@ string ZextInst::print() {
 InsertElementInst::InsertElementInst(OpID op, Value *val, Type *ty,
                                      BasicBlock *bb)
     : Instruction(ty, op, 1, bb), dest_ty_(ty) {
+    set_value_kind(ValueKind::InsertElementInst);
     set_operand(0, val);
 }
 
 InsertElementInst *InsertElementInst::create_insert_element(Value *val,
                                                             Type *ty,
                                                             BasicBlock *bb) {
-    return new InsertElementInst(Instruction::InElem, val, ty, bb);
+    return new (bb->get_module()) InsertElementInst(Instruction::InElem, val,
+                                                    ty, bb);
 }
 
 Type *InsertElementInst::get_dest_type() const { return dest_ty_; }
@@ -471,13 +510,15 @@ string InsertElementInst::print() {
 ExtractElementInst::ExtractElementInst(OpID op, Value *val, Type *ty,
                                        BasicBlock *bb)
     : Instruction(ty, op, 1, bb), dest_ty_(ty) {
+    set_value_kind(ValueKind::ExtractElementInst);
     set_operand(0, val);
 }
 
 ExtractElementInst *ExtractElementInst::create_extract_element(Value *val,
                                                                Type *ty,
                                                                BasicBlock *bb) {
-    return new ExtractElementInst(Instruction::ExElem, val, ty, bb);
+    return new (bb->get_module()) ExtractElementInst(Instruction::ExElem, val,
+                                                     ty, bb);
 }
 
 Type *ExtractElementInst::get_dest_type() const { return dest_ty_; }
@@ -493,29 +534,31 @@ string ExtractElementInst::print() {
 
 BitCastInst::BitCastInst(OpID op, Value *val, Type *ty, BasicBlock *bb)
     : Instruction(ty, op, 1, bb), dest_ty_(ty) {
+    set_value_kind(ValueKind::BitCastInst);
     set_operand(0, val);
 }
 
 BitCastInst *BitCastInst::create_bitcast(Value *val, Type *ty, BasicBlock *bb) {
-    return new BitCastInst(Instruction::BitCast, val, ty, bb);
+    return new (bb->get_module()) BitCastInst(Instruction::BitCast, val, ty,
+                                              bb);
 }
 
 Type *BitCastInst::get_dest_type() const { return dest_ty_; }
 
 string BitCastInst::print() {
-    if (dynamic_cast<Class *>(this->get_operand(0))) {
+    if (dyn_cast<Class>(this->get_operand(0))) {
         return fmt::format(
             "%{} = {} {}* {} to {}", this->get_name(),
             this->get_module()->get_instr_op_name(this->get_instr_type()),
             this->get_operand(0)->get_type()->print(),
             fmt::format(
                 "@{}",
-                dynamic_cast<Class *>(this->get_operand(0))->prototype_label_),
+                dyn_cast<Class>(this->get_operand(0))->prototype_label_),
             this->get_dest_type()->print());
-    } else if (dynamic_cast<ConstantStr *>(this->get_operand(0)) ||
-               (dynamic_cast<GlobalVariable *>(this->get_operand(0)) &&
-                dynamic_cast<ConstantStr *>(
-                    dynamic_cast<GlobalVariable *>(this->get_operand(0))
+    } else if (dyn_cast<ConstantStr>(this->get_operand(0)) ||
+               (dyn_cast<GlobalVariable>(this->get_operand(0)) &&
+                dyn_cast<ConstantStr>(
+                    dyn_cast<GlobalVariable>(this->get_operand(0))
                         ->get_init())))
         return fmt::format(
             "%{} = {} %$str$prototype_type* {} to {}", this->get_name(),
@@ -533,11 +576,13 @@ string BitCastInst::print() {
 
 PtrToIntInst::PtrToIntInst(OpID op, Value *val, Type *ty, BasicBlock *bb)
     : Instruction(ty, op, 1, bb), dest_ty_(ty) {
+    set_value_kind(ValueKind::PtrToIntInst);
     set_operand(0, val);
 }
 PtrToIntInst *PtrToIntInst::create_ptrtoint(Value *val, Type *ty,
                                             BasicBlock *bb) {
-    return new PtrToIntInst(Instruction::PtrToInt, val, ty, bb);
+    return new (bb->get_module()) PtrToIntInst(Instruction::PtrToInt, val, ty,
+                                               bb);
 }
 Type *PtrToIntInst::get_dest_type() const { return dest_ty_; }
 string PtrToIntInst::print() {
@@ -550,11 +595,12 @@ string PtrToIntInst::print() {
 
 TruncInst::TruncInst(OpID op, Value *val, Type *ty, BasicBlock *bb)
     : Instruction(ty, op, 1, bb), dest_ty_(ty) {
+    set_value_kind(ValueKind::TruncInst);
     set_operand(0, val);
 }
 
 TruncInst *TruncInst::create_trunc(Value *val, Type *ty, BasicBlock *bb) {
-    return new TruncInst(Instruction::ZExt, val, ty, bb);
+    return new (bb->get_module()) TruncInst(Instruction::ZExt, val, ty, bb);
 }
 
 Type *TruncInst::get_dest_type() const { return dest_ty_; }
@@ -570,8 +616,8 @@ string TruncInst::print() {
 
 GetElementPtrInst::GetElementPtrInst(Value *ptr, Value *idx, BasicBlock *bb)
     : Instruction(PtrType::get(get_element_type(ptr, idx)), Instruction::GEP, 2,
-                  bb),
-      idx(idx) {
+                  bb) {
+    set_value_kind(ValueKind::GetElementPtrInst);
     set_operand(0, ptr);
     set_operand(1, idx);
     element_ty_ = get_element_type(ptr, idx);
@@ -579,8 +625,8 @@ GetElementPtrInst::GetElementPtrInst(Value *ptr, Value *idx, BasicBlock *bb)
 
 GetElementPtrInst::GetElementPtrInst(Value *ptr, Value *idx)
     : Instruction(PtrType::get(get_element_type(ptr, idx)), Instruction::GEP,
-                  2),
-      idx(idx) {
+                  2) {
+    set_value_kind(ValueKind::GetElementPtrInst);
     set_operand(0, ptr);
     set_operand(1, idx);
     element_ty_ = get_element_type(ptr, idx);
@@ -591,10 +637,10 @@ Type *GetElementPtrInst::get_element_type(Value *ptr, Value *idx) {
     if (ptr_type->is_ptr_type()) {
         // it is a pointer
         auto inner_type = ((PtrType *)ptr_type)->get_element_type();
-        if (dynamic_cast<Class *>(inner_type)) {
+        if (dyn_cast<Class>(inner_type)) {
             auto class_type = (Class *)inner_type;
             // it is a class
-            if (dynamic_cast<ConstantInt *>(idx)) {
+            if (dyn_cast<ConstantInt>(idx)) {
                 int idx_value = ((ConstantInt *)idx)->get_value();
                 if (class_type->anon_) {
                     return class_type->get_offset_attr(idx_value);
@@ -606,7 +652,7 @@ Type *GetElementPtrInst::get_element_type(Value *ptr, Value *idx) {
                             class_type->dispatch_table_label_ + "_type",
                             class_type, class_type->get_module()));
                     } else {
-                        return new IntegerType(32, class_type->get_module());
+                        return IntegerType::get(32, class_type->get_module());
                     }
                 }
             } else {
@@ -621,6 +667,7 @@ Type *GetElementPtrInst::get_element_type(Value *ptr, Value *idx) {
 
 string GetElementPtrInst::print() {
     string instr_ir;
+    auto idx = this->get_idx();
     auto op0_type =
         this->get_operand(0)->get_type()->get_ptr_element_type()->print();
     if (op0_type.ends_with("$prototype_type") ||
@@ -629,19 +676,19 @@ string GetElementPtrInst::print() {
             "%{} = {} {}, ptr {}, i32 0, {}", this->get_name(),
             this->get_module()->get_instr_op_name(this->get_instr_type()),
             op0_type, print_as_op(this->get_operand(0), false),
-            dynamic_cast<ConstantInt *>(idx)
-                ? dynamic_cast<ConstantInt *>(idx)->print()
+            dyn_cast<ConstantInt>(idx)
+                ? dyn_cast<ConstantInt>(idx)->print()
                 : print_as_op(idx, true));
-    else if (dynamic_cast<AllocaInst *>(this->get_operand(0)) ||
-             dynamic_cast<BitCastInst *>(this->get_operand(0)) ||
-             dynamic_cast<GetElementPtrInst *>(this->get_operand(0)) ||
+    else if (dyn_cast<AllocaInst>(this->get_operand(0)) ||
+             dyn_cast<BitCastInst>(this->get_operand(0)) ||
+             dyn_cast<GetElementPtrInst>(this->get_operand(0)) ||
              this->get_operand(0)->get_type()->is_list_type())
         instr_ir += fmt::format(
             "%{} = {} {}, ptr {}, {}", this->get_name(),
             this->get_module()->get_instr_op_name(this->get_instr_type()),
             op0_type, print_as_op(this->get_operand(0), false),
-            dynamic_cast<ConstantInt *>(idx)
-                ? dynamic_cast<ConstantInt *>(idx)->print()
+            dyn_cast<ConstantInt>(idx)
+                ? dyn_cast<ConstantInt>(idx)->print()
                 : print_as_op(idx, true));
     else
         assert(0);
@@ -652,17 +699,18 @@ Type *GetElementPtrInst::get_element_type() const { return element_ty_; }
 
 GetElementPtrInst *GetElementPtrInst::create_gep(Value *ptr, Value *idx,
                                                  BasicBlock *bb) {
-    return new GetElementPtrInst(ptr, idx, bb);
+    return new (bb->get_module()) GetElementPtrInst(ptr, idx, bb);
 }
 
 GetElementPtrInst *GetElementPtrInst::create_gep(Value *ptr, Value *idx) {
-    return new GetElementPtrInst(ptr, idx);
+    return new (ptr->get_type()->get_module()) GetElementPtrInst(ptr, idx);
 }
-Value *GetElementPtrInst::get_idx() const { return idx; }
+Value *GetElementPtrInst::get_idx() const { return get_operand(1); }
 
 PhiInst::PhiInst(std::vector<Value *> vals, std::vector<BasicBlock *> val_bbs,
                  Type *ty, BasicBlock *bb)
     : Instruction(ty, OpID::PHI, 2 * vals.size()) {
+    set_value_kind(ValueKind::PhiInst);
     for (size_t i = 0; i < vals.size(); i++) {
         set_operand(2 * i, vals[i]);
         set_operand(2 * i + 1, val_bbs[i]);
@@ -673,7 +721,7 @@ PhiInst::PhiInst(std::vector<Value *> vals, std::vector<BasicBlock *> val_bbs,
 PhiInst *PhiInst::create_phi(Type *ty, BasicBlock *bb) {
     std::vector<Value *> vals;
     std::vector<BasicBlock *> val_bbs;
-    return new PhiInst(vals, val_bbs, ty, bb);
+    return new (bb->get_module()) PhiInst(vals, val_bbs, ty, bb);
 }
 
 string PhiInst::print() {
@@ -717,6 +765,7 @@ string PhiInst::print() {
 AsmInst::AsmInst(Module *m, string asm_str, BasicBlock *bb)
     : Instruction(Type::get_void_type(m), Instruction::ASM, 1, bb),
       asm_str_(std::move(asm_str)) {
+    set_value_kind(ValueKind::AsmInst);
     set_operand(0, bb);
 };
 
@@ -729,7 +778,171 @@ string AsmInst::print() {
 
 AsmInst *AsmInst::create_asm(Module *m_, const string &asm_str,
                              BasicBlock *bb) {
-    return new AsmInst(m_, asm_str, bb);
+    return new (bb->get_module()) AsmInst(m_, asm_str, bb);
+}
+
+VExtInst::VExtInst(Value *count, Value *dst, const vector<Value *> &leaves,
+                   vector<Node> program, BasicBlock *bb)
+    : Instruction(Type::get_void_type(bb->get_module()), Instruction::VExt,
+                  2 + leaves.size(), bb),
+      program_(std::move(program)) {
+    set_value_kind(ValueKind::VExtInst);
+    assert(leaves.size() <= max_leaves && !program_.empty());
+    set_operand(0, count);
+    set_operand(1, dst);
+    for (unsigned i = 0; i < leaves.size(); i++) {
+        set_operand(2 + i, leaves[i]);
+    }
+}
+
+VExtInst *VExtInst::create_vext(Value *count, Value *dst,
+                                const vector<Value *> &leaves,
+                                vector<Node> program, BasicBlock *bb) {
+    return new (bb->get_module()) VExtInst(count, dst, leaves,
+                                           std::move(program), bb);
+}
+
+string VExtInst::print_node(unsigned idx) {
+    const auto &node = program_.at(idx);
+    switch (node.kind) {
+        case NodeKind::Stream:
+            return fmt::format("vle({})",
+                               print_as_op(get_operand(node.lhs), true));
+        case NodeKind::Scalar:
+            return print_as_op(get_operand(node.lhs), true);
+        case NodeKind::Add:
+            return fmt::format("add({}, {})", print_node(node.lhs),
+                               print_node(node.rhs));
+        case NodeKind::Sub:
+            return fmt::format("sub({}, {})", print_node(node.lhs),
+                               print_node(node.rhs));
+        case NodeKind::Mul:
+            return fmt::format("mul({}, {})", print_node(node.lhs),
+                               print_node(node.rhs));
+    }
+    return "";
+}
+
+string VExtInst::print() {
+    return fmt::format(
+        "{} {}, {} = {}",
+        this->get_module()->get_instr_op_name(this->get_instr_type()),
+        print_as_op(this->get_operand(0), true),
+        print_as_op(this->get_operand(1), true),
+        print_node(program_.size() - 1));
+}
+
+Instruction *BinaryInst::copy_inst(BasicBlock *bb) {
+    return new (bb->get_module()) BinaryInst(get_type(), get_instr_type(),
+                                             get_operand(0), get_operand(1),
+                                             bb);
+}
+
+Instruction *UnaryInst::copy_inst(BasicBlock *bb) {
+    return new (bb->get_module()) UnaryInst(get_type(), get_instr_type(),
+                                            get_operand(0), bb);
+}
+
+Instruction *CmpInst::copy_inst(BasicBlock *bb) {
+    return new (bb->get_module()) CmpInst(get_type(), cmp_op_, get_operand(0),
+                                          get_operand(1), bb);
+}
+
+Instruction *CallInst::copy_inst(BasicBlock *bb) {
+    vector<Value *> args(get_operands().begin() + 1, get_operands().end());
+    auto new_inst = new (bb->get_module()) CallInst(get_operand(0), func_type_,
+                                                    args, bb);
+    new_inst->set_type(get_type());
+    return new_inst;
+}
+
+Instruction *BranchInst::copy_inst(BasicBlock *bb) {
+    if (is_cond_br())
+        return new (bb->get_module()) BranchInst(get_operand(0),
+                                                 (BasicBlock *)get_operand(1),
+                                                 (BasicBlock *)get_operand(2),
+                                                 bb);
+    return new (bb->get_module()) BranchInst((BasicBlock *)get_operand(0), bb);
+}
+
+Instruction *ReturnInst::copy_inst(BasicBlock *bb) {
+    if (is_void_ret()) return new (bb->get_module()) ReturnInst(bb);
+    return new (bb->get_module()) ReturnInst(get_operand(0), bb);
+}
+
+Instruction *UnreachableInst::copy_inst(BasicBlock *bb) {
+    return new (bb->get_module()) UnreachableInst(bb);
+}
+
+Instruction *StoreInst::copy_inst(BasicBlock *bb) {
+    return new (bb->get_module()) StoreInst(get_operand(0), get_operand(1), bb);
+}
+
+Instruction *LoadInst::copy_inst(BasicBlock *bb) {
+    return new (bb->get_module()) LoadInst(get_type(), get_operand(0), bb);
+}
+
+Instruction *AllocaInst::copy_inst(BasicBlock *bb) {
+    return new (bb->get_module()) AllocaInst(alloca_ty_, bb);
+}
+
+Instruction *ZextInst::copy_inst(BasicBlock *bb) {
+    return new (bb->get_module()) ZextInst(get_instr_type(), get_operand(0),
+                                           dest_ty_, bb);
+}
+
+Instruction *InsertElementInst::copy_inst(BasicBlock *bb) {
+    return new (bb->get_module()) InsertElementInst(get_instr_type(),
+                                                    get_operand(0), dest_ty_,
+                                                    bb);
+}
+
+Instruction *ExtractElementInst::copy_inst(BasicBlock *bb) {
+    return new (bb->get_module()) ExtractElementInst(get_instr_type(),
+                                                     get_operand(0), dest_ty_,
+                                                     bb);
+}
+
+Instruction *BitCastInst::copy_inst(BasicBlock *bb) {
+    return new (bb->get_module()) BitCastInst(get_instr_type(), get_operand(0),
+                                              dest_ty_, bb);
+}
+
+Instruction *PtrToIntInst::copy_inst(BasicBlock *bb) {
+    return new (bb->get_module()) PtrToIntInst(get_instr_type(), get_operand(0),
+                                               dest_ty_, bb);
+}
+
+Instruction *TruncInst::copy_inst(BasicBlock *bb) {
+    return new (bb->get_module()) TruncInst(get_instr_type(), get_operand(0),
+                                            dest_ty_, bb);
+}
+
+Instruction *GetElementPtrInst::copy_inst(BasicBlock *bb) {
+    auto new_inst = new (bb->get_module()) GetElementPtrInst(get_type(), 2, bb,
+                                                             element_ty_);
+    new_inst->set_operand(0, get_operand(0));
+    new_inst->set_operand(1, get_operand(1));
+    return new_inst;
+}
+
+Instruction *PhiInst::copy_inst(BasicBlock *bb) {
+    auto new_inst = new (bb->get_module()) PhiInst(get_type(), PHI, 0, bb);
+    for (auto op : get_operands()) {
+        new_inst->add_operand(op);
+    }
+    new_inst->set_lval(l_val_);
+    return new_inst;
+}
+
+Instruction *AsmInst::copy_inst(BasicBlock *bb) {
+    return new (bb->get_module()) AsmInst(bb->get_module(), asm_str_, bb);
+}
+
+Instruction *VExtInst::copy_inst(BasicBlock *bb) {
+    vector<Value *> leaves(get_operands().begin() + 2, get_operands().end());
+    return new (bb->get_module()) VExtInst(get_operand(0), get_operand(1),
+                                           leaves, program_, bb);
 }
 
 }  // namespace lightir
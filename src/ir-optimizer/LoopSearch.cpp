@@ -0,0 +1,156 @@
+#include "LoopSearch.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace lightir {
+bool Loop::is_invariant(Value *val) const {
+    auto inst = dyn_cast<Instruction>(val);
+    return inst == nullptr || !contains(inst->get_parent());
+}
+
+vector<BasicBlock *> LoopSearch::get_succs(BasicBlock *bb) {
+    vector<BasicBlock *> succs;
+    auto term = bb->get_terminator();
+    if (term == nullptr || !term->is_br()) return succs;
+    for (auto op : term->get_operands()) {
+        if (auto succ = dyn_cast<BasicBlock>(op); succ) {
+            succs.push_back(succ);
+        }
+    }
+    return succs;
+}
+
+LoopSearch::LoopSearch(Function *func) : func_(func) {
+    if (func->is_declaration()) return;
+
+    auto entry = func->get_entry_block();
+    set<BasicBlock *> reachable{entry};
+    vector<BasicBlock *> worklist{entry};
+    while (!worklist.empty()) {
+        auto bb = worklist.back();
+        worklist.pop_back();
+        for (auto succ : get_succs(bb)) {
+            if (reachable.insert(succ).second) worklist.push_back(succ);
+        }
+    }
+    map<BasicBlock *, vector<BasicBlock *>> preds;
+    for (auto bb : func->get_basic_blocks()) {
+        if (!reachable.contains(bb)) continue;
+        for (auto succ : get_succs(bb)) preds[succ].push_back(bb);
+    }
+
+    for (auto header : func->get_basic_blocks()) {
+        if (!reachable.contains(header)) continue;
+        vector<BasicBlock *> latches;
+        set<BasicBlock *> blocks{header};
+        for (auto pred : preds[header]) {
+            /** Walk backwards from pred without passing the header. If the
+             * entry is reached, the header does not dominate pred and
+             * pred -> header is not a back edge. */
+            set<BasicBlock *> body{header};
+            bool is_back_edge = true;
+            worklist = {pred};
+            while (!worklist.empty() && is_back_edge) {
+                auto bb = worklist.back();
+                worklist.pop_back();
+                if (!body.insert(bb).second) continue;
+                if (bb == entry) is_back_edge = false;
+                for (auto p : preds[bb]) worklist.push_back(p);
+            }
+            if (!is_back_edge) continue;
+            latches.push_back(pred);
+            blocks.insert(body.begin(), body.end());
+        }
+        if (latches.size() != 1) continue;
+
+        Loop loop{header, nullptr, latches.front(), std::move(blocks)};
+        vector<BasicBlock *> outside;
+        for (auto pred : preds[header]) {
+            if (!loop.contains(pred)) outside.push_back(pred);
+        }
+        if (outside.size() == 1) loop.preheader = outside.front();
+        loops_.push_back(std::move(loop));
+    }
+    std::stable_sort(loops_.begin(), loops_.end(),
+                     [](const Loop &a, const Loop &b) {
+                         return a.blocks.size() < b.blocks.size();
+                     });
+}
+
+bool LoopSearch::is_innermost(const Loop &loop) const {
+    return std::none_of(loops_.begin(), loops_.end(), [&](const Loop &other) {
+        return other.header != loop.header && loop.contains(other.header);
+    });
+}
+
+/** A constant, or the length of a fresh list literal:
+ *   %0 = call construct_list(i32 n, ...)
+ *   %1 = bitcast %0
+ *   %2 = call $len(%1) */
+static std::optional<int> get_constant_value(Value *val) {
+    if (auto c = dyn_cast<ConstantInt>(val); c) return c->get_value();
+
+    auto len = dyn_cast<CallInst>(val);
+    if (len == nullptr || len->get_num_operand() != 2 ||
+        len->get_operand(0)->get_name() != "$len")
+        return std::nullopt;
+    auto list = len->get_operand(1);
+    while (auto cast = dyn_cast<BitCastInst>(list)) {
+        list = cast->get_operand(0);
+    }
+    auto ctor = dyn_cast<CallInst>(list);
+    if (ctor == nullptr || ctor->get_operand(0)->get_name() != "construct_list")
+        return std::nullopt;
+    if (auto n = dyn_cast<ConstantInt>(ctor->get_operand(1)); n)
+        return n->get_value();
+    return std::nullopt;
+}
+
+std::optional<InductionVar> LoopSearch::get_induction_var(const Loop &loop) {
+    if (loop.preheader == nullptr) return std::nullopt;
+
+    auto term = loop.header->get_terminator();
+    if (term == nullptr || !term->is_br() || term->get_num_operand() != 3)
+        return std::nullopt;
+    auto cmp = dyn_cast<CmpInst>(term->get_operand(0));
+    if (cmp == nullptr || cmp->get_cmp_op() != CmpInst::LT ||
+        !loop.contains((BasicBlock *)term->get_operand(1)) ||
+        loop.contains((BasicBlock *)term->get_operand(2)))
+        return std::nullopt;
+
+    auto phi = dyn_cast<PhiInst>(cmp->get_operand(0));
+    auto bound = cmp->get_operand(1);
+    if (phi == nullptr || phi->get_parent() != loop.header ||
+        phi->get_num_operand() != 4 || !loop.is_invariant(bound))
+        return std::nullopt;
+
+    InductionVar iv{phi, nullptr, 0, nullptr, cmp, bound};
+    for (int i = 0; i < 4; i += 2) {
+        if (phi->get_operand(i + 1) == loop.preheader) {
+            iv.init = phi->get_operand(i);
+        } else if (phi->get_operand(i + 1) == loop.latch) {
+            iv.next = dyn_cast<BinaryInst>(phi->get_operand(i));
+        }
+    }
+    if (iv.init == nullptr || iv.next == nullptr || !iv.next->is_add())
+        return std::nullopt;
+
+    ConstantInt *step = nullptr;
+    if (iv.next->get_operand(0) == phi) {
+        step = dyn_cast<ConstantInt>(iv.next->get_operand(1));
+    } else if (iv.next->get_operand(1) == phi) {
+        step = dyn_cast<ConstantInt>(iv.next->get_operand(0));
+    }
+    if (step == nullptr || step->get_value() <= 0) return std::nullopt;
+    iv.step = step->get_value();
+
+    auto init = get_constant_value(iv.init);
+    auto end = get_constant_value(bound);
+    if (init.has_value() && end.has_value()) {
+        iv.trip_count =
+            std::max(0, (*end - *init + iv.step - 1) / iv.step);
+    }
+    return iv;
+}
+}  // namespace lightir
@@ -0,0 +1,211 @@
+#include "LoopUnroll.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#include "BasicBlock.hpp"
+#include "Constant.hpp"
+#include "Function.hpp"
+
+namespace lightir {
+static void replace_operand(User *user, Value *from, Value *to) {
+    for (unsigned i = 0; i < user->get_num_operand(); i++) {
+        if (user->get_operand(i) == from) user->set_operand(i, to);
+    }
+}
+
+static void erase_block(Function *func, BasicBlock *bb) {
+    for (auto inst : bb->get_instructions()) {
+        inst->remove_use_of_ops();
+    }
+    func->get_basic_blocks().remove(bb);
+}
+
+static void move_before(Function *func, BasicBlock *bb, BasicBlock *pos) {
+    auto &blocks = func->get_basic_blocks();
+    blocks.remove(bb);
+    blocks.insert(std::find(blocks.begin(), blocks.end(), pos), bb);
+}
+
+void LoopUnroll::run() {
+    const int factor = m_->unroll_factor;
+    for (auto func : m_->get_functions()) {
+        if (func->is_declaration()) continue;
+        LoopSearch loop_search(func);
+        bool changed = false;
+        for (auto &loop : loop_search.get_loops()) {
+            if (!loop_search.is_innermost(loop)) continue;
+            auto iv = LoopSearch::get_induction_var(loop);
+            if (!iv.has_value() || !can_unroll(func, loop, *iv)) continue;
+
+            int body_size = 0;
+            for (auto bb : get_body(func, loop)) {
+                body_size += bb->get_num_of_instr();
+            }
+            if (dyn_cast<ConstantInt>(iv->init) &&
+                0 <= iv->trip_count &&
+                iv->trip_count <= max_full_unroll_count &&
+                iv->trip_count * body_size <= max_unrolled_size) {
+                unroll_fully(func, loop, *iv);
+                changed = true;
+            } else if (factor > 1 && factor * body_size <= max_unrolled_size &&
+                       (iv->trip_count < 0 || iv->trip_count >= factor)) {
+                unroll_partially(func, loop, *iv, factor);
+                changed = true;
+            }
+        }
+        if (changed) rebuild_cfg(func);
+    }
+}
+
+bool LoopUnroll::can_unroll(Function *func, const Loop &loop,
+                            const InductionVar &iv) {
+    /** The header only holds the induction variable and the exit test, and
+     * is entered by unconditional branches. */
+    if (loop.header->get_num_of_instr() != 3) return false;
+    auto pre_term = loop.preheader->get_terminator();
+    auto latch_term = loop.latch->get_terminator();
+    if (pre_term == nullptr || !pre_term->is_br() ||
+        pre_term->get_num_operand() != 1 || latch_term == nullptr ||
+        !latch_term->is_br() || latch_term->get_num_operand() != 1)
+        return false;
+
+    auto exit = (BasicBlock *)loop.header->get_terminator()->get_operand(2);
+    for (auto inst : exit->get_instructions()) {
+        if (inst->is_phi()) return false;
+    }
+
+    /** Only the induction variable may flow out of the header, and nothing
+     * computed in the loop may be used after it. */
+    for (auto bb : func->get_basic_blocks()) {
+        if (bb == loop.header) continue;
+        for (auto inst : bb->get_instructions()) {
+            for (auto op : inst->get_operands()) {
+                if (loop.contains(bb)) {
+                    if (op == loop.header && inst->is_phi()) return false;
+                    auto op_inst = dyn_cast<Instruction>(op);
+                    if (op_inst && op_inst->get_parent() == loop.header &&
+                        op_inst != iv.phi)
+                        return false;
+                } else if (!loop.is_invariant(op)) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+vector<BasicBlock *> LoopUnroll::get_body(Function *func, const Loop &loop) {
+    vector<BasicBlock *> body;
+    for (auto bb : func->get_basic_blocks()) {
+        if (bb != loop.header && loop.contains(bb)) body.push_back(bb);
+    }
+    return body;
+}
+
+BasicBlock *LoopUnroll::clone_body(Function *func, const Loop &loop,
+                                   const InductionVar &iv, Value *iv_val,
+                                   BasicBlock *cont, BasicBlock *pos,
+                                   map<Value *, Value *> &vmap) {
+    vmap[iv.phi] = iv_val;
+    vmap[loop.header] = cont;
+
+    auto body = get_body(func, loop);
+    for (auto bb : body) {
+        auto new_bb = BasicBlock::create(m_, "", func);
+        move_before(func, new_bb, pos);
+        vmap[bb] = new_bb;
+    }
+    vector<Instruction *> new_insts;
+    for (auto bb : body) {
+        auto new_bb = (BasicBlock *)vmap.at(bb);
+        for (auto inst : bb->get_instructions()) {
+            /** already given a value, e.g. the increment of a fully unrolled
+             * loop */
+            if (vmap.contains(inst)) continue;
+            auto new_inst = inst->copy_inst(new_bb);
+            vmap[inst] = new_inst;
+            new_insts.push_back(new_inst);
+        }
+    }
+    for (auto inst : new_insts) {
+        for (unsigned i = 0; i < inst->get_num_operand(); i++) {
+            auto it = vmap.find(inst->get_operand(i));
+            if (it != vmap.end()) inst->set_operand(i, it->second);
+        }
+    }
+    return (BasicBlock *)vmap.at(loop.header->get_terminator()->get_operand(1));
+}
+
+void LoopUnroll::unroll_fully(Function *func, const Loop &loop,
+                              const InductionVar &iv) {
+    const int start = static_cast<ConstantInt *>(iv.init)->get_value();
+    auto exit = (BasicBlock *)loop.header->get_terminator()->get_operand(2);
+
+    /** Build the copies back to front, so that each one can branch to the
+     * next, with the induction variable folded to a constant. */
+    BasicBlock *cont = exit;
+    BasicBlock *pos = loop.header;
+    for (int k = iv.trip_count - 1; k >= 0; k--) {
+        map<Value *, Value *> vmap{
+            {iv.next, ConstantInt::get(start + (k + 1) * iv.step, m_)}};
+        cont = clone_body(func, loop, iv,
+                          ConstantInt::get(start + k * iv.step, m_), cont, pos,
+                          vmap);
+        pos = cont;
+    }
+    replace_operand(loop.preheader->get_terminator(), loop.header, cont);
+
+    for (auto bb : get_body(func, loop)) {
+        erase_block(func, bb);
+    }
+    erase_block(func, loop.header);
+}
+
+void LoopUnroll::unroll_partially(Function *func, const Loop &loop,
+                                  const InductionVar &iv, int factor) {
+    auto u_header = BasicBlock::create(m_, "", func);
+    auto u_exit = BasicBlock::create(m_, "", func);
+    move_before(func, u_header, loop.header);
+    move_before(func, u_exit, loop.header);
+
+    auto j = PhiInst::create_phi(iv.phi->get_type(), u_header);
+    j->set_lval(iv.phi->get_lval());
+    u_header->add_instr_begin(j);
+    auto last = BinaryInst::create_add(
+        j, ConstantInt::get((factor - 1) * iv.step, m_), u_header, m_);
+    auto cond = CmpInst::create_cmp(CmpInst::LT, last, iv.bound, u_header, m_);
+
+    /** Chain the copies: the latch of each one jumps to the next copy, the
+     * last one back to the unrolled header. */
+    Value *iv_val = j;
+    BasicBlock *first = nullptr;
+    BasicBlock *prev_latch = nullptr;
+    for (int k = 0; k < factor; k++) {
+        map<Value *, Value *> vmap;
+        auto entry =
+            clone_body(func, loop, iv, iv_val, u_header, u_exit, vmap);
+        if (prev_latch == nullptr) {
+            first = entry;
+        } else {
+            replace_operand(prev_latch->get_terminator(), u_header, entry);
+        }
+        prev_latch = (BasicBlock *)vmap.at(loop.latch);
+        iv_val = vmap.at(iv.next);
+    }
+    j->add_phi_pair_operand(iv.init, loop.preheader);
+    j->add_phi_pair_operand(iv_val, prev_latch);
+    BranchInst::create_cond_br(cond, first, u_exit, u_header);
+    BranchInst::create_br(loop.header, u_exit);
+    replace_operand(loop.preheader->get_terminator(), loop.header, u_header);
+
+    /** The original loop runs the remaining iterations. */
+    for (int i = 0; i < 4; i += 2) {
+        if (iv.phi->get_operand(i + 1) == loop.preheader) {
+            iv.phi->set_operand(i, j);
+            iv.phi->set_operand(i + 1, u_exit);
+        }
+    }
+}
+}  // namespace lightir
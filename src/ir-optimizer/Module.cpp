@@ -1,15 +1,19 @@
 #include "Module.hpp"
 
+#include <sstream>
+
 namespace lightir {
 
-Module::Module(string name) : module_name_(std::move(name)) {
-    void_ty_ = new VoidType(this);
-    int1_ty_ = new IntegerType(1, this);
-    int32_ty_ = new IntegerType(32, this);
-    label_ty_ = new Type(Type::type::LABEL);
+Module::Module(string name)
+    : module_name_(std::move(name)), type_context_(this) {
+    void_ty_ = type_context_.get_void_type();
+    int1_ty_ = type_context_.get_int_type(1);
+    int32_ty_ = type_context_.get_int_type(32);
+    label_ty_ = type_context_.get_label_type();
 
     instr_id2string_.insert({Instruction::Ret, "ret"});
     instr_id2string_.insert({Instruction::Br, "br"});
+    instr_id2string_.insert({Instruction::Unreachable, "unreachable"});
     /** Int Negate not supported in clang 14 */
     instr_id2string_.insert({Instruction::Neg, "sub i32 0,"});
     instr_id2string_.insert({Instruction::Add, "add"});
@@ -37,12 +41,12 @@ Module::Module(string name) : module_name_(std::move(name)) {
     instr_id2string_.insert({Instruction::ExElem, "extractelement"});
     instr_id2string_.insert({Instruction::BitCast, "bitcast"});
     instr_id2string_.insert({Instruction::PtrToInt, "ptrtoint"});
+    instr_id2string_.insert({Instruction::VExt, "vext"});
 }
 
 Module::~Module() {
-    delete void_ty_;
-    delete int1_ty_;
-    delete int32_ty_;
+    /** The values may still refer to the types. */
+    arena_.clear();
 }
 
 Type *Module::get_void_type() { return void_ty_; }
@@ -53,14 +57,30 @@ IntegerType *Module::get_int32_type() { return int32_ty_; }
 
 Type *Module::get_label_type() { return label_ty_; }
 
-void Module::add_function(Function *f) { function_list_.push_back(f); }
-list<Function *> Module::get_functions() { return function_list_; }
+ConstantInt *Module::get_constant_int(IntegerType *ty, int val) {
+    auto &c = int_constants_[{ty, val}];
+    if (c == nullptr) c = new (this) ConstantInt(ty, val);
+    return c;
+}
+
+ConstantNull *Module::get_constant_null(Type *ty) {
+    auto &c = null_constants_[ty];
+    if (c == nullptr) c = new (this) ConstantNull(ty);
+    return c;
+}
+
+void Module::add_function(Function *f) {
+    function_list_.push_back(f);
+    function_index_[f->get_name()] = f;
+}
+Function *Module::get_function(const string &name) const {
+    auto it = function_index_.find(name);
+    return it == function_index_.end() ? nullptr : it->second;
+}
 void Module::add_global_variable(GlobalVariable *g) {
     global_list_.push_back(g);
 }
-list<GlobalVariable *> Module::get_global_variable() { return global_list_; }
 void Module::add_class(Class *c) { class_list_.push_back(c); };
-list<Class *> Module::get_class() { return class_list_; }
 
 void Module::set_print_name() {
     for (auto func : this->get_functions()) {
@@ -69,39 +89,48 @@ void Module::set_print_name() {
 }
 
 string Module::print() {
-    string module_ir;
+    std::ostringstream module_ir;
+    print(module_ir);
+    return module_ir.str();
+}
+
+void Module::print(std::ostream &out) {
     this->is_declaration_ = true;
     this->is_declaration_ = false;
     for (auto &&class_ : this->get_class()) {
-        module_ir += fmt::format("{}\n", class_->print_class());
+        out << class_->print_class() << "\n";
+    }
+    if (auto tags = type_tag_table(this->get_class()); !tags.empty()) {
+        out << fmt::format("@{} = global [{} x i32] [i32 {}]\n",
+                           type_tag_table_label, tags.size(),
+                           fmt::join(tags, ", i32 "));
     }
     auto counter = 0;
     for (auto global_val : this->get_global_variable()) {
         if (global_val->init_val_ != nullptr &&
-            dynamic_cast<ConstantStr *>(global_val->init_val_)) {
+            dyn_cast<ConstantStr>(global_val->init_val_)) {
             if (counter ==
-                dynamic_cast<ConstantStr *>(global_val->init_val_)->get_id()) {
+                dyn_cast<ConstantStr>(global_val->init_val_)->get_id()) {
                 continue;
             }
             counter =
-                dynamic_cast<ConstantStr *>(global_val->init_val_)->get_id();
+                dyn_cast<ConstantStr>(global_val->init_val_)->get_id();
         }
-        module_ir += fmt::format("{}\n", global_val->print());
+        out << global_val->print() << "\n";
     }
+    /** A declaration is dropped if the function shows up again later. */
+    std::unordered_map<string, int> last_index;
     int count = 0;
     for (auto func : this->function_list_) {
-        count++;
-        auto this_ptr = this->function_list_.begin();
-        std::advance(this_ptr, count);
-        auto idx = std::find_if(
-            this_ptr, this->function_list_.end(), [&func](Function *func_) {
-                return func_->get_name() == func->get_name() &&
-                       func->is_declaration();
-            });
-        if (idx == this->function_list_.end()) {
-            module_ir += fmt::format("{}\n", func->print());
+        last_index[func->get_name()] = count++;
+    }
+    count = 0;
+    for (auto func : this->function_list_) {
+        if (!func->is_declaration() || last_index[func->get_name()] == count) {
+            func->print(out);
+            out << "\n";
         }
+        count++;
     }
-    return module_ir;
 }
 }  // namespace lightir
@@ -0,0 +1,205 @@
+#include "StackAlloc.hpp"
+
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "BasicBlock.hpp"
+#include "Constant.hpp"
+#include "LoopSearch.hpp"
+
+namespace lightir {
+/** Move inst, just created at the end of its block, in front of pos. */
+static void move_before(Instruction *inst, Instruction *pos) {
+    inst->get_parent()->remove_instr(inst);
+    pos->get_parent()->insert_instr(pos, inst);
+}
+
+static AllocaInst *create_entry_alloca(Type *ty, Function *func) {
+    auto entry = func->get_entry_block();
+    auto alloca = AllocaInst::create_alloca(ty, entry);
+    entry->remove_instr(alloca);
+    entry->add_instr_begin(alloca);
+    return alloca;
+}
+
+static void erase_if_unused(Instruction *inst) {
+    if (inst->get_use_list().empty()) inst->get_parent()->delete_instr(inst);
+}
+
+static bool is_in_cycle(BasicBlock *bb) {
+    std::set<BasicBlock *> visited;
+    auto worklist = LoopSearch::get_succs(bb);
+    while (!worklist.empty()) {
+        auto cur = worklist.back();
+        worklist.pop_back();
+        if (cur == bb) return true;
+        if (!visited.insert(cur).second) continue;
+        for (auto succ : LoopSearch::get_succs(cur)) worklist.push_back(succ);
+    }
+    return false;
+}
+
+void StackAlloc::run() {
+    EscapeAnalysis escape_analysis(m_);
+    for (auto func : m_->get_functions()) {
+        if (func->is_declaration()) continue;
+
+        vector<std::pair<CallInst *, Class *>> objects;
+        for (auto bb : func->get_basic_blocks()) {
+            for (auto inst : bb->get_instructions()) {
+                auto call = dyn_cast<CallInst>(inst);
+                if (call == nullptr) continue;
+                auto cls = get_allocated_class(call);
+                if (cls == nullptr) continue;
+                bool stored = false;
+                if (escape_analysis.escapes(call, &stored) ||
+                    (stored && is_in_cycle(bb)))
+                    continue;
+                objects.emplace_back(call, cls);
+            }
+        }
+
+        if (!objects.empty()) set_changed(func);
+        bool in_frame = false;
+        for (auto [call, cls] : objects) {
+            if (!replace_scalars(func, call, cls)) {
+                allocate_on_stack(func, call, cls);
+                in_frame = true;
+            }
+        }
+        /** The frame now has to outlive the calls the objects are passed
+         * to. */
+        if (in_frame) {
+            for (auto bb : func->get_basic_blocks()) {
+                for (auto inst : bb->get_instructions()) {
+                    if (auto call = dyn_cast<CallInst>(inst); call)
+                        call->set_tail_call(false);
+                }
+            }
+        }
+    }
+}
+
+Class *StackAlloc::get_allocated_class(CallInst *call) {
+    if (call->get_operand(0)->get_name() != "alloc_object") return nullptr;
+    auto cast = dyn_cast<BitCastInst>(call->get_operand(1));
+    if (cast == nullptr) return nullptr;
+    auto cls = dyn_cast<Class>(cast->get_operand(0));
+    if (cls == nullptr || cls->anon_) return nullptr;
+    return cls;
+}
+
+void StackAlloc::copy_prototype_word(Value *proto, int idx, Value *dst,
+                                     Instruction *pos) {
+    auto bb = pos->get_parent();
+    auto src =
+        GetElementPtrInst::create_gep(proto, ConstantInt::get(idx, m_), bb);
+    move_before(src, pos);
+    auto word = LoadInst::create_load(src->get_type()->get_ptr_element_type(),
+                                      src, bb);
+    move_before(word, pos);
+    move_before(StoreInst::create_store(word, dst, bb), pos);
+}
+
+void StackAlloc::allocate_on_stack(Function *func, CallInst *call,
+                                   Class *cls) {
+    auto bb = call->get_parent();
+    auto slot = create_entry_alloca(cls, func);
+    auto proto = BitCastInst::create_bitcast(cls, PtrType::get(cls), bb);
+    move_before(proto, call);
+    const int size = 3 + cls->get_attribute()->size();
+    for (int i = 0; i < size; i++) {
+        auto dst =
+            GetElementPtrInst::create_gep(slot, ConstantInt::get(i, m_), bb);
+        move_before(dst, call);
+        copy_prototype_word(proto, i, dst, call);
+    }
+    auto obj = BitCastInst::create_bitcast(slot, call->get_type(), bb);
+    move_before(obj, call);
+
+    auto arg = dyn_cast<Instruction>(call->get_operand(1));
+    call->replace_all_use_with(obj);
+    bb->delete_instr(call);
+    erase_if_unused(arg);
+}
+
+bool StackAlloc::replace_scalars(Function *func, CallInst *call, Class *cls) {
+    vector<Instruction *> casts;
+    vector<GetElementPtrInst *> fields;
+    vector<CmpInst *> none_checks;
+    vector<Instruction *> inits;
+    vector<Value *> worklist{call};
+    while (!worklist.empty()) {
+        auto v = worklist.back();
+        worklist.pop_back();
+        for (auto &use : v->get_use_list()) {
+            auto user = use.val_;
+            if (auto cast = dyn_cast<BitCastInst>(user); cast) {
+                casts.push_back(cast);
+                worklist.push_back(cast);
+            } else if (auto gep = dyn_cast<GetElementPtrInst>(user);
+                       gep) {
+                auto idx = dyn_cast<ConstantInt>(gep->get_operand(1));
+                if (use.arg_no_ != 0 || idx == nullptr || idx->get_value() < 3)
+                    return false;
+                for (auto &field_use : gep->get_use_list()) {
+                    if (dyn_cast<LoadInst>(field_use.val_)) continue;
+                    if (dyn_cast<StoreInst>(field_use.val_) &&
+                        field_use.arg_no_ == 1)
+                        continue;
+                    return false;
+                }
+                fields.push_back(gep);
+            } else if (auto cmp = dyn_cast<CmpInst>(user); cmp) {
+                auto other = cmp->get_operand(1 - use.arg_no_);
+                if (!dyn_cast<ConstantNull>(other) ||
+                    (cmp->get_cmp_op() != CmpInst::EQ &&
+                     cmp->get_cmp_op() != CmpInst::NE))
+                    return false;
+                none_checks.push_back(cmp);
+            } else if (auto init = dyn_cast<CallInst>(user); init) {
+                if (init->get_operand(0)->get_name() != "$object.__init__" ||
+                    !init->get_use_list().empty())
+                    return false;
+                inits.push_back(init);
+            } else {
+                return false;
+            }
+        }
+    }
+
+    auto bb = call->get_parent();
+    auto proto = BitCastInst::create_bitcast(cls, PtrType::get(cls), bb);
+    move_before(proto, call);
+    std::map<int, AllocaInst *> scalars;
+    for (auto gep : fields) {
+        const int idx = ((ConstantInt *)gep->get_operand(1))->get_value();
+        if (!scalars.contains(idx)) {
+            scalars[idx] = create_entry_alloca(gep->get_element_type(), func);
+            copy_prototype_word(proto, idx, scalars[idx], call);
+        }
+        gep->replace_all_use_with(scalars[idx]);
+        gep->get_parent()->delete_instr(gep);
+    }
+    /** the object exists, so it is never None */
+    for (auto cmp : none_checks) {
+        cmp->replace_all_use_with(
+            ConstantInt::get(cmp->get_cmp_op() == CmpInst::NE, m_));
+        cmp->get_parent()->delete_instr(cmp);
+    }
+    for (auto init : inits) {
+        init->get_parent()->delete_instr(init);
+    }
+    for (auto it = casts.rbegin(); it != casts.rend(); ++it) {
+        erase_if_unused(*it);
+    }
+
+    auto arg = dyn_cast<Instruction>(call->get_operand(1));
+    bb->delete_instr(call);
+    erase_if_unused(arg);
+    erase_if_unused(proto);
+    return true;
+}
+}  // namespace lightir
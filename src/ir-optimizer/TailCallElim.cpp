@@ -0,0 +1,190 @@
+#include "TailCallElim.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <map>
+#include <set>
+
+#include "BasicBlock.hpp"
+#include "LoopSearch.hpp"
+
+namespace lightir {
+static void replace_incoming_block(BasicBlock *succ, BasicBlock *from,
+                                   BasicBlock *to) {
+    for (auto inst : succ->get_instructions()) {
+        if (!inst->is_phi()) continue;
+        for (unsigned i = 1; i < inst->get_num_operand(); i += 2) {
+            if (inst->get_operand(i) == from) inst->set_operand(i, to);
+        }
+    }
+}
+
+static void move_after(Function *func, BasicBlock *bb, BasicBlock *pos) {
+    auto &blocks = func->get_basic_blocks();
+    blocks.remove(bb);
+    blocks.insert(std::next(std::find(blocks.begin(), blocks.end(), pos)), bb);
+}
+
+void TailCallElim::run() {
+    for (auto func : m_->get_functions()) {
+        if (func->is_declaration()) continue;
+
+        vector<CallInst *> self_calls;
+        vector<CallInst *> tail_calls;
+        for (auto bb : func->get_basic_blocks()) {
+            auto &insts = bb->get_instructions();
+            for (auto it = insts.begin(); it != insts.end(); ++it) {
+                if ((*it)->isTerminator()) break;
+                if (std::next(it) == insts.end()) break;
+                auto call = get_tail_call(*it, *std::next(it));
+                if (call == nullptr) continue;
+                auto &ops = call->get_operands();
+                if (ops[0] == func &&
+                    std::none_of(ops.begin() + 1, ops.end(), is_frame_address)) {
+                    self_calls.push_back(call);
+                } else {
+                    tail_calls.push_back(call);
+                }
+            }
+        }
+        if (!self_calls.empty()) {
+            eliminate_self_recursion(func, self_calls);
+            rebuild_cfg(func);
+        }
+        if (!tail_calls.empty() && !frame_escapes(func)) {
+            for (auto call : tail_calls) call->set_tail_call(true);
+            set_changed(func);
+        }
+    }
+}
+
+CallInst *TailCallElim::get_tail_call(Instruction *inst, Instruction *next) {
+    auto call = dyn_cast<CallInst>(inst);
+    if (call == nullptr || call->is_void() || call->is_noreturn() ||
+        !next->is_ret() || next->get_num_operand() != 1 ||
+        next->get_operand(0) != call || call->get_use_list().size() != 1)
+        return nullptr;
+    return call;
+}
+
+bool TailCallElim::frame_escapes(Function *func) {
+    for (auto bb : func->get_basic_blocks()) {
+        for (auto inst : bb->get_instructions()) {
+            if (!inst->is_alloca()) continue;
+            for (auto &use : inst->get_use_list()) {
+                if (dyn_cast<LoadInst>(use.val_)) continue;
+                if (dyn_cast<StoreInst>(use.val_) && use.arg_no_ == 1)
+                    continue;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool TailCallElim::is_frame_address(Value *val) {
+    while (true) {
+        if (dyn_cast<AllocaInst>(val)) return true;
+        if (auto gep = dyn_cast<GetElementPtrInst>(val); gep) {
+            val = gep->get_operand(0);
+        } else if (auto cast = dyn_cast<BitCastInst>(val); cast) {
+            val = cast->get_operand(0);
+        } else {
+            return false;
+        }
+    }
+}
+
+void TailCallElim::eliminate_self_recursion(Function *func,
+                                            const vector<CallInst *> &calls) {
+    auto entry = func->get_entry_block();
+    const auto num_args = func->get_num_of_args();
+
+    vector<std::set<Value *>> args(num_args);
+    for (auto bb : func->get_basic_blocks()) {
+        for (auto inst : bb->get_instructions()) {
+            for (auto op : inst->get_operands()) {
+                if (auto k = get_arg_no(op, num_args); k >= 0) {
+                    args[k].insert(op);
+                }
+            }
+        }
+    }
+
+    /** Find the slot each argument lives in. An argument only spilled to an
+     * alloca, as is done for the parameters, already has one; the others
+     * (e.g. the closure of a nested function) get a new one. */
+    vector<Value *> slots(num_args, nullptr);
+    std::set<Instruction *> spills;
+    for (unsigned k = 0; k < num_args; k++) {
+        if (args[k].size() != 1) continue;
+        auto &uses = (*args[k].begin())->get_use_list();
+        if (uses.size() != 1) continue;
+        auto store = dyn_cast<StoreInst>(uses.front().val_);
+        if (store == nullptr || uses.front().arg_no_ != 0 ||
+            store->get_parent() != entry ||
+            !dyn_cast<AllocaInst>(store->get_operand(1)))
+            continue;
+        slots[k] = store->get_operand(1);
+        spills.insert(store);
+    }
+
+    auto loop = BasicBlock::create(m_, "", func);
+    move_after(func, loop, entry);
+    for (unsigned k = 0; k < num_args; k++) {
+        if (slots[k] != nullptr || args[k].empty()) continue;
+        auto arg = *args[k].begin();
+        auto slot = AllocaInst::create_alloca(arg->get_type(), entry);
+        auto val = LoadInst::create_load(arg->get_type(), slot, loop);
+        for (auto other : args[k]) {
+            other->replace_all_use_with(val);
+        }
+        spills.insert(StoreInst::create_store(arg, slot, entry));
+        slots[k] = slot;
+    }
+
+    /** Everything but the allocas and spills runs on each iteration. */
+    auto &entry_insts = entry->get_instructions();
+    for (auto it = entry_insts.begin(); it != entry_insts.end();) {
+        auto inst = *it++;
+        if (inst->is_alloca() || spills.contains(inst)) continue;
+        entry->remove_instr(inst);
+        loop->add_instruction(inst);
+    }
+    BranchInst::create_br(loop, entry);
+    for (auto succ : LoopSearch::get_succs(loop)) {
+        replace_incoming_block(succ, entry, loop);
+    }
+
+    for (auto call : calls) {
+        auto bb = call->get_parent();
+        auto &insts = bb->get_instructions();
+        auto it = call->get_iterator();
+        auto ret = *std::next(it);
+
+        /** Code after the return is dead, but may still feed phis; keep it in
+         * a block of its own. */
+        if (std::next(it, 2) != insts.end()) {
+            auto dead = BasicBlock::create(m_, "", func);
+            move_after(func, dead, bb);
+            auto &dead_insts = dead->get_instructions();
+            dead_insts.splice(dead_insts.end(), insts, std::next(it, 2),
+                              insts.end());
+            for (auto inst : dead_insts) inst->set_parent(dead);
+            for (auto succ : LoopSearch::get_succs(dead)) {
+                replace_incoming_block(succ, bb, dead);
+            }
+        }
+
+        vector<Value *> new_args(call->get_operands().begin() + 1,
+                                 call->get_operands().end());
+        bb->delete_instr(ret);
+        bb->delete_instr(call);
+        for (unsigned k = 0; k < num_args; k++) {
+            if (slots[k] != nullptr)
+                StoreInst::create_store(new_args[k], slots[k], bb);
+        }
+        BranchInst::create_br(loop, bb);
+    }
+}
+}  // namespace lightir
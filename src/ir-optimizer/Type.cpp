@@ -1,5 +1,6 @@
 #include "Type.hpp"
 
+#include <cassert>
 #include <utility>
 
 #include "Module.hpp"
@@ -7,7 +8,9 @@
 
 namespace lightir {
 
-Type::Type(type tid, Module *m) : tid_(tid) { m_ = m; }
+Type::Type(type tid, Module *m, TypeKind kind) : tid_(tid), kind_(kind) {
+    m_ = m;
+}
 
 Module *Type::get_module() { return m_; }
 
@@ -20,17 +23,17 @@ IntegerType *Type::get_int1_type(Module *m) { return m->get_int1_type(); }
 IntegerType *Type::get_int32_type(Module *m) { return m->get_int32_type(); }
 
 Type *Type::get_ptr_element_type() {
-    if (!dynamic_cast<PtrType *>(this))
+    if (!dyn_cast<PtrType>(this))
         return this;
     else if (this->is_ptr_type())
-        return dynamic_cast<PtrType *>(this)->get_element_type();
+        return dyn_cast<PtrType>(this)->get_element_type();
     else
         return this;
 }
 
 int Type::get_size() {
     if (this->is_integer_type()) {
-        auto bits = dynamic_cast<IntegerType *>(this)->get_num_bits();
+        auto bits = dyn_cast<IntegerType>(this)->get_num_bits();
         return bits > 0 ? bits : 1;
     }
     if (this->is_ptr_type()) return 32;
@@ -47,33 +50,32 @@ std::strong_ordering Type::operator<=>(Type rhs) {
 string Type::print() { return {}; }
 
 IntegerType::IntegerType(unsigned num_bits, Module *m)
-    : Type(num_bits == 1 ? Type::type::BOOL : Type::type::INT, m),
+    : Type(num_bits == 1 ? Type::type::BOOL : Type::type::INT, m,
+           TypeKind::Integer),
       num_bits_(num_bits) {}
 
 IntegerType *IntegerType::get(unsigned num_bits, Module *m) {
-    return new IntegerType(num_bits, m);
+    return m->get_type_context().get_int_type(num_bits);
 }
 
 unsigned IntegerType::get_num_bits() const { return num_bits_; }
 
-FunctionType::FunctionType(Type *result, const std::vector<Type *> &params)
-    : Type(Type::type::FUNC, result->get_module()) {
-    result_ = result;
-    for (auto p : params) {
-        args_.push_back(p);
-    }
-}
+FunctionType::FunctionType(Type *result, const std::vector<Type *> &params,
+                           bool is_variable_args)
+    : Type(Type::type::FUNC, result->get_module(), TypeKind::Function),
+      is_variable_args(is_variable_args),
+      result_(result),
+      args_(params) {}
 
 FunctionType *FunctionType::get(Type *result,
                                 const std::vector<Type *> &params) {
-    return new FunctionType(result, params);
+    return get(result, params, false);
 }
 
 FunctionType *FunctionType::get(Type *result, const std::vector<Type *> &params,
                                 bool is_variable_args) {
-    auto tmp_func = new FunctionType(result, params);
-    tmp_func->is_variable_args = is_variable_args;
-    return tmp_func;
+    return result->get_module()->get_type_context().get_function_type(
+        result, params, is_variable_args);
 }
 
 unsigned FunctionType::get_num_of_args() const { return args_.size(); }
@@ -86,13 +88,13 @@ Type *FunctionType::get_arg_type(unsigned int i) const { return args_[i]; }
 
 string FunctionType::print() {
     string type_ir;
-    type_ir += dynamic_cast<FunctionType *>(this)->get_return_type()->print();
+    type_ir += dyn_cast<FunctionType>(this)->get_return_type()->print();
     type_ir += " (";
-    for (unsigned int i = 0; i < dynamic_cast<FunctionType *>(this)->get_num_of_args();
+    for (unsigned int i = 0; i < dyn_cast<FunctionType>(this)->get_num_of_args();
          i++) {
         if (i) type_ir += ", ";
         type_ir +=
-            dynamic_cast<FunctionType *>(this)->get_param_type(i)->print();
+            dyn_cast<FunctionType>(this)->get_param_type(i)->print();
     }
     if (is_variable_args) {
         type_ir += ", ...";
@@ -102,12 +104,13 @@ string FunctionType::print() {
 }
 
 PtrType::PtrType(Type *contained)
-    : Type(Type::type::LIST, contained->get_module()) {
+    : Type(Type::type::LIST, contained->get_module(), TypeKind::Ptr) {
     contained_ = contained;
 }
 
 PtrType *PtrType::get(Type *contained) {
-    return new PtrType(contained);
+    return contained->get_module()->get_type_context().get_ptr_type(
+        contained);
 }
 
 string PtrType::print() {
@@ -116,11 +119,58 @@ string PtrType::print() {
     return type_ir;
 }
 
-LabelType *LabelType::get(string str_, Class *stored_, Module *m) {
-    return new LabelType(std::move(str_), stored_, m);
+LabelType *LabelType::get(const string &label, Class *stored, Module *m) {
+    return m->get_type_context().get_label_type(label, stored);
 }
-LabelType::LabelType(string label_, Class *stored_, Module *m)
-    : Type(Type::type::LABEL, m), label_(std::move(label_)), stored_(stored_) {}
+LabelType::LabelType(string label, Class *stored, Module *m)
+    : Type(Type::type::LABEL, m, TypeKind::Label),
+      label_(std::move(label)),
+      stored_(stored) {}
 string LabelType::get_label() const { return label_; }
 
+VoidType *VoidType::get(Module *m) {
+    return m->get_type_context().get_void_type();
+}
+
+TypeContext::TypeContext(Module *m)
+    : m_(m),
+      void_ty_(new VoidType(m)),
+      label_ty_(new Type(Type::type::LABEL, m)) {}
+
+IntegerType *TypeContext::get_int_type(unsigned num_bits) {
+    auto &ty = int_types_[num_bits];
+    if (!ty) ty.reset(new IntegerType(num_bits, m_));
+    return ty.get();
+}
+
+PtrType *TypeContext::get_ptr_type(Type *contained) {
+    auto &ty = ptr_types_[contained];
+    if (!ty) ty.reset(new PtrType(contained));
+    return ty.get();
+}
+
+FunctionType *TypeContext::get_function_type(Type *result,
+                                             const vector<Type *> &params,
+                                             bool is_variable_args) {
+    auto &ty = function_types_[{result, params, is_variable_args}];
+    if (!ty) ty.reset(new FunctionType(result, params, is_variable_args));
+    return ty.get();
+}
+
+LabelType *TypeContext::get_label_type(const string &label, Class *stored) {
+    auto &ty = label_types_[label];
+    if (!ty) ty.reset(new LabelType(label, stored, m_));
+    assert(ty->get_class() == stored);
+    return ty.get();
+}
+
+size_t TypeContext::FunctionKeyHash::operator()(const FunctionKey &key) const {
+    auto seed = std::hash<Type *>()(key.result) ^ key.is_variable_args;
+    for (auto param : key.params) {
+        seed ^= std::hash<Type *>()(param) + 0x9e3779b9 + (seed << 6) +
+                (seed >> 2);
+    }
+    return seed;
+}
+
 }  // namespace lightir
@@ -9,6 +9,7 @@ namespace lightir {
 User::User(Type *ty, const std::string &name, unsigned num_ops)
     : Value(ty, name), num_ops_(num_ops) {
     operands_.resize(num_ops_, nullptr);
+    uses_.resize(num_ops_);
 }
 
 std::vector<Value *> &User::get_operands() { return operands_; }
@@ -17,30 +18,48 @@ Value *User::get_operand(unsigned i) const { return operands_[i]; }
 
 void User::set_operand(unsigned i, Value *v) {
     assert(i < num_ops_ && "set_operand out of index");
+    remove_use_of_op(i);
     operands_[i] = v;
-    v->add_use(this, i);
+    uses_[i] = v->add_use(this, i);
 }
 
 void User::add_operand(Value *v) {
     operands_.push_back(v);
-    v->add_use(this, num_ops_);
+    uses_.emplace_back(v->add_use(this, num_ops_));
     num_ops_++;
 }
 
 unsigned User::get_num_operand() const { return num_ops_; }
 
+bool User::is_use_linked(unsigned i) const {
+    return i < operands_.size() && operands_[i] != nullptr && uses_[i] &&
+           (*uses_[i])->val_ == this && (*uses_[i])->arg_no_ == i;
+}
+
+void User::remove_use_of_op(unsigned i) {
+    if (uses_[i]) {
+        operands_[i]->remove_use(*uses_[i]);
+        uses_[i].reset();
+    }
+}
+
 void User::remove_use_of_ops() {
-    for (auto op : operands_) {
-        op->remove_use(this);
+    for (unsigned i = 0; i < operands_.size(); i++) {
+        remove_use_of_op(i);
     }
 }
 
 void User::remove_operands(int index1, int index2) {
     for (int i = index1; i <= index2; i++) {
-        operands_[i]->remove_use(this);
+        remove_use_of_op(i);
     }
     operands_.erase(operands_.begin() + index1, operands_.begin() + index2 + 1);
+    uses_.erase(uses_.begin() + index1, uses_.begin() + index2 + 1);
     LOG(DEBUG) << operands_.size();
     num_ops_ = operands_.size();
+    /** the operands after the removed ones moved down */
+    for (unsigned i = index1; i < num_ops_; i++) {
+        if (uses_[i]) (*uses_[i])->arg_no_ = i;
+    }
 }
 }  // namespace lightir
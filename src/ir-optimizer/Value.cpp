@@ -3,28 +3,32 @@
 #include <cassert>
 #include <utility>
 
+#include "Module.hpp"
 #include "Type.hpp"
 #include "User.hpp"
 namespace lightir {
 
-Value::Value(Type *ty, std::string name) : type_(ty), name_(std::move(name)) {}
+Value::Value(Type *ty, std::string name) : type_(ty), name_(std::move(name)) {
+    Arena::own(this);
+}
+
+void *Value::operator new(size_t size, Module *m) {
+    return m->get_arena().allocate(size);
+}
 
-void Value::add_use(Value *val, unsigned arg_no) {
-    use_list_.emplace_back(val, arg_no);
+list<Use>::iterator Value::add_use(Value *val, unsigned arg_no) {
+    return use_list_.emplace(use_list_.end(), val, arg_no);
 }
 
 std::string Value::get_name() { return name_; }
 
 void Value::replace_all_use_with(Value *new_val) {
-    for (auto use : use_list_) {
-        auto val = dynamic_cast<User *>(use.val_);
+    /** set_operand unlinks the use from use_list_, so walk a copy */
+    auto uses = use_list_;
+    for (auto use : uses) {
+        auto val = dyn_cast<User>(use.val_);
         assert(val && "new_val is not a user");
         val->set_operand(use.arg_no_, new_val);
     }
 }
-
-void Value::remove_use(Value *val) {
-    auto is_val = [val](const Use &use) { return use.val_ == val; };
-    use_list_.remove_if(is_val);
-}
-}  // namespace lightir
\ No newline at end of file
+}  // namespace lightir
@@ -0,0 +1,387 @@
+#include "Vectorize.hpp"
+
+#include <algorithm>
+#include <set>
+
+#include "BasicBlock.hpp"
+#include "Constant.hpp"
+#include "Function.hpp"
+
+namespace lightir {
+static bool is_int32(Type *ty) {
+    return ty == Type::get_int32_type(ty->get_module());
+}
+
+static bool is_int32_ptr(Type *ty) {
+    return ty == PtrType::get(Type::get_int32_type(ty->get_module()));
+}
+
+static bool is_const(Value *val, int c) {
+    auto const_int = dyn_cast<ConstantInt>(val);
+    return const_int != nullptr && const_int->get_value() == c;
+}
+
+/** A variable, local or global, which is only read and written as a whole. */
+static bool is_variable(Value *ptr) {
+    return dyn_cast<AllocaInst>(ptr) ||
+           dyn_cast<GlobalVariable>(ptr);
+}
+
+/** A block reporting a runtime error, as created for the checks of an
+ * access: a call to a noreturn routine followed by unreachable. */
+static bool is_error_block(BasicBlock *bb) {
+    auto &insts = bb->get_instructions();
+    if (insts.empty()) return false;
+    auto call = dyn_cast<CallInst>(insts.front());
+    return call != nullptr && call->is_noreturn();
+}
+
+static void move_before(Function *func, BasicBlock *bb, BasicBlock *pos) {
+    auto &blocks = func->get_basic_blocks();
+    blocks.remove(bb);
+    blocks.insert(std::find(blocks.begin(), blocks.end(), pos), bb);
+}
+
+void Vectorize::run() {
+    for (auto func : m_->get_functions()) {
+        if (func->is_declaration()) continue;
+        LoopSearch loop_search(func);
+        bool changed = false;
+        for (auto &loop : loop_search.get_loops()) {
+            if (!loop_search.is_innermost(loop) || loop.preheader == nullptr)
+                continue;
+            auto plan = analyze(loop);
+            if (!plan.has_value()) continue;
+            vectorize(func, loop, *plan);
+            changed = true;
+        }
+        if (changed) rebuild_cfg(func);
+    }
+}
+
+const Vectorize::Info *Vectorize::get_info(Value *val, const Loop &loop) {
+    static const Info invariant{Kind::Invariant};
+    if (loop.is_invariant(val)) return &invariant;
+    auto it = info_.find(val);
+    return it == info_.end() ? nullptr : &it->second;
+}
+
+bool Vectorize::is_invariant(Value *val, const Loop &loop) {
+    auto info = get_info(val, loop);
+    return info != nullptr && info->kind == Kind::Invariant;
+}
+
+bool Vectorize::classify(Instruction *inst, Value *counter,
+                         const Loop &loop) {
+    auto kind_of = [&](Value *val) {
+        auto info = get_info(val, loop);
+        return info == nullptr ? std::optional<Kind>() : info->kind;
+    };
+    auto list_of = [&](Value *val) { return info_.at(val).list; };
+    /** Each access loads the list from its variable again. */
+    auto add_list = [&](Value *list) {
+        for (auto other : lists_) {
+            auto load = dyn_cast<LoadInst>(list);
+            auto other_load = dyn_cast<LoadInst>(other);
+            if (other == list ||
+                (load != nullptr && other_load != nullptr &&
+                 is_variable(load->get_operand(0)) &&
+                 load->get_operand(0) == other_load->get_operand(0)))
+                return other;
+        }
+        lists_.push_back(list);
+        return list;
+    };
+    auto &ops = inst->get_operands();
+
+    Info info{Kind::Invariant};
+    if (inst->is_load()) {
+        auto ptr = ops[0];
+        if (ptr == counter) {
+            info = {Kind::Index};
+        } else if (is_variable(ptr)) {
+            /** nothing but list elements and i are written in the loop */
+            info = {Kind::Invariant};
+        } else if (kind_of(ptr) == Kind::Elts) {
+            info = {Kind::Array, list_of(ptr)};
+        } else if (kind_of(ptr) == Kind::Elem && is_int32(inst->get_type())) {
+            info = {Kind::Int, list_of(ptr)};
+        } else {
+            return false;
+        }
+    } else if (inst->is_gep()) {
+        if (is_invariant(ops[0], loop) && is_const(ops[1], 4)) {
+            info = {Kind::Elts, add_list(ops[0])};
+        } else if (kind_of(ops[0]) == Kind::Array &&
+                   kind_of(ops[1]) == Kind::Index) {
+            info = {Kind::Elem, list_of(ops[0])};
+        } else {
+            return false;
+        }
+    } else if (inst->get_instr_type() == Instruction::BitCast) {
+        if (kind_of(ops[0]) == Kind::Elem && is_int32_ptr(inst->get_type())) {
+            info = {Kind::Elem, list_of(ops[0])};
+        } else if (!is_invariant(ops[0], loop)) {
+            return false;
+        }
+    } else if (inst->is_call()) {
+        if (ops[0]->get_name() != "$len" || ops.size() != 2 ||
+            !is_invariant(ops[1], loop))
+            return false;
+        info = {Kind::Len, add_list(ops[1])};
+        len_of_.emplace(info.list, inst);
+    } else if (inst->is_cmp()) {
+        auto op = ((CmpInst *)inst)->get_cmp_op();
+        if (op == CmpInst::EQ && is_invariant(ops[0], loop) &&
+            dyn_cast<ConstantNull>(ops[1])) {
+            info = {Kind::Check, add_list(ops[0])};
+        } else if (op == CmpInst::GE && kind_of(ops[0]) == Kind::Index &&
+                   kind_of(ops[1]) == Kind::Len) {
+            info = {Kind::Check, list_of(ops[1])};
+        } else if (op == CmpInst::LT && kind_of(ops[0]) == Kind::Index &&
+                   is_const(ops[1], 0)) {
+            info = {Kind::Check};
+        } else if (!is_invariant(ops[0], loop) ||
+                   !is_invariant(ops[1], loop)) {
+            return false;
+        }
+    } else if (inst->is_binary()) {
+        auto lhs = kind_of(ops[0]);
+        auto rhs = kind_of(ops[1]);
+        const bool arith = inst->is_add() || inst->is_sub() || inst->is_mul();
+        if (inst->is_add() && lhs == Kind::Index && is_const(ops[1], 1)) {
+            info = {Kind::Next};
+        } else if (inst->is_or() && lhs == Kind::Check && rhs == Kind::Check) {
+            info = {Kind::Check};
+        } else if (arith && lhs == Kind::Invariant && rhs == Kind::Invariant) {
+            info = {Kind::Invariant};
+        } else if (arith && (lhs == Kind::Int || lhs == Kind::Invariant) &&
+                   (rhs == Kind::Int || rhs == Kind::Invariant)) {
+            info = {Kind::Int};
+        } else {
+            return false;
+        }
+    } else {
+        return false;
+    }
+    info_[inst] = info;
+    return true;
+}
+
+std::optional<Vectorize::Plan> Vectorize::analyze(const Loop &loop) {
+    info_.clear();
+    pos_.clear();
+    lists_.clear();
+    len_of_.clear();
+
+    /** header: br (i < n), body, exit */
+    auto header = loop.header;
+    auto term = header->get_terminator();
+    if (term == nullptr || !term->is_br() || term->get_num_operand() != 3)
+        return std::nullopt;
+    auto exit_cmp = dyn_cast<CmpInst>(term->get_operand(0));
+    auto body = (BasicBlock *)term->get_operand(1);
+    auto exit = (BasicBlock *)term->get_operand(2);
+    if (exit_cmp == nullptr || exit_cmp->get_cmp_op() != CmpInst::LT ||
+        !loop.contains(body) || loop.contains(exit))
+        return std::nullopt;
+    auto i = dyn_cast<LoadInst>(exit_cmp->get_operand(0));
+    if (i == nullptr || !is_variable(i->get_operand(0))) return std::nullopt;
+    for (auto inst : exit->get_instructions()) {
+        if (inst->is_phi()) return std::nullopt;
+    }
+
+    Plan plan{i->get_operand(0), exit_cmp->get_operand(1), exit, {}, {}};
+    vector<unsigned> assign_pos;
+    bool incremented = false;
+    unsigned pos = 0;
+    std::set<BasicBlock *> visited;
+    /** The loop must be a single path through its blocks, which only leaves
+     * it to report errors. */
+    for (auto bb = header;;) {
+        visited.insert(bb);
+        for (auto inst : bb->get_instructions()) {
+            if (inst->isTerminator()) break;
+            pos_[inst] = pos++;
+            /** nothing but the back edge after i = i + 1 */
+            if (incremented || inst->is_phi()) return std::nullopt;
+            if (inst == exit_cmp) {
+                info_[inst] = {Kind::Check};
+            } else if (inst->is_store()) {
+                auto val = inst->get_operand(0);
+                auto ptr = inst->get_operand(1);
+                auto val_info = get_info(val, loop);
+                auto ptr_info = get_info(ptr, loop);
+                if (val_info == nullptr) return std::nullopt;
+                if (ptr == plan.counter && val_info->kind == Kind::Next) {
+                    incremented = true;
+                } else if (ptr_info != nullptr &&
+                           ptr_info->kind == Kind::Elem &&
+                           is_int32(val->get_type()) &&
+                           (val_info->kind == Kind::Invariant ||
+                            val_info->kind == Kind::Int)) {
+                    plan.assigns.push_back({(StoreInst *)inst, {}, {}});
+                    assign_pos.push_back(pos_[inst]);
+                } else {
+                    return std::nullopt;
+                }
+            } else if (!classify(inst, plan.counter, loop)) {
+                return std::nullopt;
+            }
+        }
+
+        auto br = bb->get_terminator();
+        if (br == nullptr || !br->is_br()) return std::nullopt;
+        BasicBlock *next;
+        if (bb == header) {
+            next = body;
+        } else if (br->get_num_operand() == 1) {
+            next = (BasicBlock *)br->get_operand(0);
+            if (next == header) break;
+        } else {
+            /** a check of the access, true if it fails */
+            auto cond = get_info(br->get_operand(0), loop);
+            if (cond == nullptr || cond->kind != Kind::Check ||
+                !is_error_block((BasicBlock *)br->get_operand(1)))
+                return std::nullopt;
+            next = (BasicBlock *)br->get_operand(2);
+        }
+        if (!loop.contains(next) || visited.contains(next))
+            return std::nullopt;
+        bb = next;
+    }
+    if (visited.size() != loop.blocks.size() || !incremented ||
+        plan.assigns.empty() || !is_invariant(plan.bound, loop))
+        return std::nullopt;
+
+    /** Only the variables carry values out of the loop. */
+    for (auto bb : loop.blocks) {
+        for (auto inst : bb->get_instructions()) {
+            for (auto &use : inst->get_use_list()) {
+                auto user = dyn_cast<Instruction>(use.val_);
+                if (user != nullptr && !loop.contains(user->get_parent()))
+                    return std::nullopt;
+            }
+        }
+    }
+
+    for (auto list : lists_) {
+        if (!len_of_.contains(list)) return std::nullopt;
+        plan.lists.emplace_back(list, len_of_.at(list));
+    }
+
+    /** The iterations are independent, every list being accessed at i only,
+     * so each assignment can run over all of them before the next one. The
+     * elements it reads must then come after the previous assignment. */
+    for (unsigned k = 0; k < plan.assigns.size(); k++) {
+        auto &assign = plan.assigns[k];
+        map<Value *, unsigned> leaf_of;
+        map<Value *, unsigned> node_of;
+        const unsigned min_pos = k == 0 ? 0 : assign_pos[k - 1];
+        if (add_node(assign, assign.store->get_operand(0), min_pos, loop,
+                     leaf_of, node_of) < 0)
+            return std::nullopt;
+    }
+    return plan;
+}
+
+int Vectorize::add_node(Assign &assign, Value *val, unsigned min_pos,
+                        const Loop &loop, map<Value *, unsigned> &leaf_of,
+                        map<Value *, unsigned> &node_of) {
+    if (auto it = node_of.find(val); it != node_of.end()) return it->second;
+
+    auto add_leaf = [&](Value *key, Value *leaf) {
+        if (!leaf_of.contains(key)) {
+            leaf_of[key] = assign.leaves.size();
+            assign.leaves.push_back(leaf);
+        }
+        return 2 + leaf_of.at(key);
+    };
+    VExtInst::Node node{VExtInst::NodeKind::Scalar, 0, 0};
+    if (is_invariant(val, loop)) {
+        node.lhs = add_leaf(val, val);
+    } else if (auto load = dyn_cast<LoadInst>(val); load) {
+        if (pos_.at(load) < min_pos) return -1;
+        /** one stream per list */
+        node.kind = VExtInst::NodeKind::Stream;
+        node.lhs = add_leaf(info_.at(load).list, load->get_operand(0));
+    } else {
+        auto inst = (Instruction *)val;
+        node.kind = inst->is_add()   ? VExtInst::NodeKind::Add
+                    : inst->is_sub() ? VExtInst::NodeKind::Sub
+                                     : VExtInst::NodeKind::Mul;
+        auto lhs = add_node(assign, inst->get_operand(0), min_pos, loop,
+                            leaf_of, node_of);
+        auto rhs = add_node(assign, inst->get_operand(1), min_pos, loop,
+                            leaf_of, node_of);
+        if (lhs < 0 || rhs < 0) return -1;
+        node.lhs = lhs;
+        node.rhs = rhs;
+    }
+    if (assign.leaves.size() > VExtInst::max_leaves ||
+        assign.program.size() == VExtInst::max_nodes)
+        return -1;
+    assign.program.push_back(node);
+    return node_of[val] = assign.program.size() - 1;
+}
+
+Value *Vectorize::materialize(Value *val, BasicBlock *bb, const Loop &loop,
+                              map<Value *, Value *> &vmap) {
+    auto inst = dyn_cast<Instruction>(val);
+    if (inst == nullptr || !loop.contains(inst->get_parent())) return val;
+    if (auto it = vmap.find(val); it != vmap.end()) return it->second;
+    vector<Value *> ops;
+    for (auto op : inst->get_operands()) {
+        ops.push_back(materialize(op, bb, loop, vmap));
+    }
+    auto copy = inst->copy_inst(bb);
+    for (unsigned k = 0; k < ops.size(); k++) {
+        copy->set_operand(k, ops[k]);
+    }
+    return vmap[val] = copy;
+}
+
+void Vectorize::vectorize(Function *func, const Loop &loop, const Plan &plan) {
+    auto header = loop.header;
+    auto bb = BasicBlock::create(m_, "", func);
+    move_before(func, bb, header);
+    auto pre_term = loop.preheader->get_terminator();
+    for (unsigned k = 0; k < pre_term->get_num_operand(); k++) {
+        if (pre_term->get_operand(k) == header) pre_term->set_operand(k, bb);
+    }
+
+    /** Run the original loop unless all its checks are known to pass. */
+    auto guard = [&](CmpInst::CmpOp op, Value *lhs, Value *rhs) {
+        auto cond = CmpInst::create_cmp(op, lhs, rhs, bb, m_);
+        auto next = BasicBlock::create(m_, "", func);
+        move_before(func, next, header);
+        BranchInst::create_cond_br(cond, next, header, bb);
+        bb = next;
+    };
+    map<Value *, Value *> vmap;
+    auto i = LoadInst::create_load(m_->get_int32_type(), plan.counter, bb);
+    for (auto &[val, info] : info_) {
+        if (info.kind == Kind::Index) vmap[val] = i;
+    }
+    auto n = materialize(plan.bound, bb, loop, vmap);
+    guard(CmpInst::GE, i, ConstantInt::get(0, m_));
+    guard(CmpInst::LE, i, n);
+    for (auto [list, len] : plan.lists) {
+        auto val = materialize(list, bb, loop, vmap);
+        guard(CmpInst::NE, val, ConstantNull::get(val->get_type()));
+        guard(CmpInst::GE, materialize(len, bb, loop, vmap), n);
+    }
+
+    auto count = BinaryInst::create_sub(n, i, bb, m_);
+    for (auto &assign : plan.assigns) {
+        auto dst = materialize(assign.store->get_operand(1), bb, loop, vmap);
+        vector<Value *> leaves;
+        for (auto leaf : assign.leaves) {
+            leaves.push_back(materialize(leaf, bb, loop, vmap));
+        }
+        VExtInst::create_vext(count, dst, leaves, assign.program, bb);
+    }
+    StoreInst::create_store(n, plan.counter, bb);
+    BranchInst::create_br(plan.exit, bb);
+}
+}  // namespace lightir
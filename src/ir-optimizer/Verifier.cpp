@@ -0,0 +1,180 @@
+#include "Verifier.hpp"
+
+#include <fmt/core.h>
+
+#include "LoopSearch.hpp"
+
+namespace lightir {
+bool Verifier::verify(Module *m) {
+    bool ok = true;
+    for (auto func : m->get_functions()) {
+        if (!verify(func)) ok = false;
+    }
+    return ok;
+}
+
+bool Verifier::verify(Function *func) {
+    ok_ = true;
+    func_ = func;
+    blocks_.clear();
+    preds_.clear();
+    index_.clear();
+    if (func->is_declaration()) return true;
+
+    for (auto bb : func->get_basic_blocks()) {
+        blocks_.insert(bb);
+        int idx = 0;
+        for (auto inst : bb->get_instructions()) index_[inst] = idx++;
+    }
+    for (auto bb : func->get_basic_blocks()) {
+        for (auto succ : LoopSearch::get_succs(bb)) preds_[succ].insert(bb);
+    }
+
+    for (auto bb : func->get_basic_blocks()) check_block(bb);
+    for (auto arg : func->get_args()) {
+        if (arg->get_parent() != func) fail(nullptr, arg, "wrong parent");
+        check_users(arg);
+    }
+    return ok_;
+}
+
+void Verifier::check_block(BasicBlock *bb) {
+    if (bb->get_parent() != func_) fail(bb, bb, "wrong parent");
+
+    auto &insts = bb->get_instructions();
+    bool in_phis = true;
+    for (auto it = insts.begin(); it != insts.end(); ++it) {
+        auto inst = *it;
+        if (inst->get_parent() != bb) {
+            fail(bb, inst, "wrong parent");
+        } else if (inst->get_iterator() != it) {
+            fail(bb, inst, "wrong position");
+        }
+        if (auto phi = dyn_cast<PhiInst>(inst); phi) {
+            if (!in_phis) fail(bb, inst, "phi after other instructions");
+            check_phi(phi);
+        } else {
+            in_phis = false;
+        }
+        if (inst->is_br() && std::next(it) != insts.end()) {
+            fail(bb, inst, "br before the end of the block");
+        }
+        check_operands(inst);
+        check_users(inst);
+    }
+
+    const bool ctor_end =
+        func_->is_ctor && bb == func_->get_basic_blocks().back();
+    if (!insts.empty() && bb->get_terminator() == nullptr && !ctor_end) {
+        fail(bb, nullptr, "no terminator");
+    }
+    check_cfg(bb);
+    check_users(bb);
+}
+
+void Verifier::check_cfg(BasicBlock *bb) {
+    auto succs = LoopSearch::get_succs(bb);
+    for (auto succ : succs) {
+        if (!blocks_.contains(succ)) {
+            fail(bb, bb->get_terminator(), "branch out of the function");
+        }
+    }
+    auto &succ_list = bb->get_succ_basic_blocks();
+    if (set<BasicBlock *>(succ_list.begin(), succ_list.end()) !=
+        set<BasicBlock *>(succs.begin(), succs.end())) {
+        fail(bb, nullptr, "succ list does not match the terminator");
+    }
+    auto &pred_list = bb->get_pre_basic_blocks();
+    if (set<BasicBlock *>(pred_list.begin(), pred_list.end()) != preds_[bb]) {
+        fail(bb, nullptr, "pred list does not match the branches to it");
+    }
+}
+
+void Verifier::check_phi(PhiInst *phi) {
+    auto bb = phi->get_parent();
+    auto num_ops = phi->get_num_operand();
+    if (num_ops % 2 != 0) {
+        fail(bb, phi, "odd number of operands");
+        return;
+    }
+    set<BasicBlock *> incoming;
+    for (unsigned i = 1; i < num_ops; i += 2) {
+        auto op = phi->get_operand(i);
+        if (op == nullptr) continue;
+        auto in = dyn_cast<BasicBlock>(op);
+        if (in == nullptr) {
+            fail(bb, phi, fmt::format("operand {} is not a block", i));
+        } else if (!incoming.insert(in).second) {
+            fail(bb, phi, fmt::format("two values for {}", in->get_name()));
+        }
+    }
+    if (incoming != preds_[bb]) {
+        fail(bb, phi, "incoming blocks do not match the preds");
+    }
+}
+
+void Verifier::check_operands(Instruction *inst) {
+    auto bb = inst->get_parent();
+    for (unsigned i = 0; i < inst->get_num_operand(); i++) {
+        auto op = inst->get_operand(i);
+        if (op == nullptr) {
+            fail(bb, inst, fmt::format("operand {} is not set", i));
+            continue;
+        }
+        if (!inst->is_use_linked(i)) {
+            fail(bb, inst, fmt::format("operand {} lacks the use", i));
+        }
+        if (auto def = dyn_cast<Instruction>(op); def) {
+            auto pos = index_.find(def);
+            if (pos == index_.end()) {
+                fail(bb, inst, fmt::format("operand {} is not in the function",
+                                           i));
+            } else if (def->get_parent() == bb && !inst->is_phi() &&
+                       pos->second >= index_[inst]) {
+                fail(bb, inst, fmt::format("operand {} is defined later", i));
+            }
+        } else if (auto block = dyn_cast<BasicBlock>(op); block) {
+            if (!blocks_.contains(block)) {
+                fail(bb, inst, fmt::format("operand {} is not in the function",
+                                           i));
+            }
+        } else if (auto arg = dyn_cast<Argument>(op); arg) {
+            if (arg->get_parent() != func_) {
+                fail(bb, inst, fmt::format("operand {} is not in the function",
+                                           i));
+            }
+        }
+    }
+}
+
+void Verifier::check_users(Value *val) {
+    auto bb = isa<Instruction>(val) ? cast<Instruction>(val)->get_parent()
+              : isa<BasicBlock>(val) ? cast<BasicBlock>(val)
+                                     : nullptr;
+    for (auto &use : val->get_use_list()) {
+        auto user = dyn_cast<Instruction>(use.val_);
+        if (user == nullptr || !index_.contains(user)) {
+            fail(bb, val, "used outside the function");
+        } else if (use.arg_no_ >= user->get_num_operand() ||
+                   user->get_operand(use.arg_no_) != val) {
+            fail(bb, val, "stale entry in the use list");
+        }
+    }
+}
+
+void Verifier::fail(BasicBlock *bb, Value *val, string_view message) {
+    ok_ = false;
+    errors_ += "@" + func_->get_name();
+    if (bb != nullptr) errors_ += ", " + bb->get_name();
+    if (val == nullptr || isa<BasicBlock>(val)) {
+        // the block is already named
+    } else if (auto inst = dyn_cast<Instruction>(val); inst) {
+        errors_ += ", " + func_->get_parent()->get_instr_op_name(
+                              inst->get_instr_type());
+        if (!inst->get_name().empty()) errors_ += " %" + inst->get_name();
+    } else {
+        errors_ += ", %" + val->get_name();
+    }
+    errors_ += fmt::format(": {}\n", message);
+}
+}  // namespace lightir
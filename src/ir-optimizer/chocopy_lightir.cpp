@@ -1,9 +1,12 @@
 #include "chocopy_lightir.hpp"
 
+#include <sys/resource.h>
+
 #include <cassert>
 #include <fstream>
 #include <ranges>
 #include <regex>
+#include <sstream>
 #include <string>
 #include <utility>
 
@@ -14,9 +17,14 @@
 #include "Function.hpp"
 #include "FunctionDefType.hpp"
 #include "GlobalVariable.hpp"
+#include "IRParser.hpp"
+#include "IRSerializer.hpp"
 #include "Module.hpp"
 #include "Type.hpp"
 #include "Value.hpp"
+#include "chocopy_bytes.hpp"
+#include "chocopy_cache.hpp"
+#include "chocopy_optimization.hpp"
 #include "chocopy_parse.hpp"
 #include "chocopy_semant.hpp"
 
@@ -24,7 +32,6 @@ namespace lightir {
 #define CONST(num) ConstantInt::get(num, &*module)
 
 /** Use the symbol table to generate the type id */
-int LightWalker::get_next_type_id() { return next_type_id++; }
 int LightWalker::get_const_type_id() { return next_const_id++; }
 
 string LightWalker::get_fully_qualified_name(semantic::FunctionDefType *func,
@@ -75,7 +82,7 @@ Type *LightWalker::semantic_type_to_llvm_type(semantic::SymbolType *type) {
             return ptr_obj_type;
         } else {
             const auto class_ =
-                dynamic_cast<Class *>(scope.find_in_global(type->get_name()));
+                dyn_cast<Class>(scope.find_in_global(type->get_name()));
             assert(class_);
             return PtrType::get(class_);
         }
@@ -107,7 +114,8 @@ LightWalker::LightWalker(parser::Program &program)
     ptr_i8_type = PtrType::get(i8_type);
 
     /** Get the class ready. */
-    object_class = new Class(&*module, "object", 0, nullptr, true, true);
+    object_class = new (module.get())
+        Class(module.get(), "object", 0, nullptr, true, true);
     ptr_obj_type = PtrType::get(object_class->get_type());
     null = ConstantNull::get(ptr_obj_type);
 
@@ -117,26 +125,40 @@ LightWalker::LightWalker(parser::Program &program)
     object_class->add_method(object_init);
     ptr_ptr_obj_type = PtrType::get(ptr_obj_type);
 
-    int_class = new Class(&*module, "int", 1, nullptr, true, true);
+    int_class = new (module.get())
+        Class(module.get(), "int", 1, nullptr, true, true);
     ptr_int_type = PtrType::get(int_class->get_type());
     int_class->add_method(object_init);
-    int_class->add_attribute(new AttrInfo(i32_type, "__int__"));
+    int_class->add_attribute(new (module.get()) AttrInfo(i32_type, "__int__"));
 
-    bool_class = new Class(&*module, "bool", 2, nullptr, true, true);
+    bool_class = new (module.get())
+        Class(module.get(), "bool", 2, nullptr, true, true);
     ptr_bool_type = PtrType::get(bool_class->get_type());
     bool_class->add_method(object_init);
-    bool_class->add_attribute(new AttrInfo(i1_type, "__bool__"));
-
-    Class *str_class = new Class(module.get(), "str", 3, object_class, true);
-    str_class->add_attribute(new AttrInfo(i32_type, "__len__", 0));
-    str_class->add_attribute(new AttrInfo(ptr_i8_type, "__str__"));
+    bool_class->add_attribute(new (module.get()) AttrInfo(i1_type, "__bool__"));
+
+    Class *str_class = new (module.get())
+        Class(module.get(), "str", 3, object_class, true);
+    str_class->add_attribute(
+        new (module.get()) AttrInfo(i32_type, "__len__", 0));
+    str_class->add_attribute(
+        new (module.get()) AttrInfo(ptr_i8_type, "__str__"));
     str_class->add_method(object_init);
     ptr_str_type = PtrType::get(str_class->get_type());
 
-    list_class = new Class(&*module, ".list", -1, nullptr, true);
+    for (auto c : {object_class, int_class, bool_class, str_class}) {
+        auto [tag, tag_last] = program.hierachy_tree.interval(c->get_string());
+        assert(c->type_tag_ == static_cast<int>(tag));
+        c->type_tag_last_ = static_cast<int>(tag_last);
+    }
+
+    list_class =
+        new (module.get()) Class(module.get(), ".list", -1, nullptr, true);
     list_class->add_method(object_init);
-    list_class->add_attribute(new AttrInfo(i32_type, "__len__", 0));
-    list_class->add_attribute(new AttrInfo(ptr_ptr_obj_type, "__list__", 0));
+    list_class->add_attribute(
+        new (module.get()) AttrInfo(i32_type, "__len__", 0));
+    list_class->add_attribute(
+        new (module.get()) AttrInfo(ptr_ptr_obj_type, "__list__", 0));
 
     auto TyListClass = list_class->get_type();
     ptr_list_type = PtrType::get(TyListClass);
@@ -154,6 +176,12 @@ LightWalker::LightWalker(parser::Program &program)
     error_div_fun = Function::create(FunctionType::get(void_type, {}),
                                      "error.Div", module.get());
 
+    // the error routines exit, so the blocks calling them are cold and need
+    // no branch back into the main path
+    error_oob_fun->is_noreturn = true;
+    error_none_fun->is_noreturn = true;
+    error_div_fun->is_noreturn = true;
+
     // param: number of elements, element, element, ... (variable args)
     // return: pointer to a list
     construct_list_fun = Function::create(
@@ -242,6 +270,7 @@ void LightWalker::visit(parser::Program &node) {
     builder->set_insert_point(main_bb);
     scope.push_in_global("$main", main_func);
 
+    auto &hierachy_tree = node.hierachy_tree;
     for (const auto &decl : node.declarations) {
         if (auto node = dynamic_cast<parser::ClassDef *>(decl.get()); node) {
             Class *super_class = nullptr;
@@ -253,9 +282,11 @@ void LightWalker::visit(parser::Program &node) {
             }
             assert(super_class);
 
-            auto class_ =
-                new Class(module.get(), node->name->name, get_next_type_id(),
-                          super_class, true, false, true);
+            auto [tag, tag_last] = hierachy_tree.interval(node->name->name);
+            auto class_ = new (module.get())
+                Class(module.get(), node->name->name, static_cast<int>(tag),
+                      super_class, true, false, true);
+            class_->type_tag_last_ = static_cast<int>(tag_last);
             scope.push(node->name->name, class_);
         }
     }
@@ -268,7 +299,7 @@ void LightWalker::visit(parser::Program &node) {
             assert(func_def_type);
             auto unique_func_name = get_fully_qualified_name(func_def_type);
 
-            auto func_type = dynamic_cast<FunctionType *>(
+            auto func_type = dyn_cast<FunctionType>(
                 semantic_type_to_llvm_type(func_def_type));
             assert(func_type);
 
@@ -416,7 +447,7 @@ void LightWalker::visit(parser::BinaryExpr &node) {
             auto t2 = builder->create_cond_br(t1, b1, b2);
             builder->set_insert_point(b1);
             builder->create_call(error_div_fun, {});
-            builder->create_br(b2);
+            builder->create_unreachable();
             builder->set_insert_point(b2);
             auto t3 = builder->create_isdiv(v1, v2);
             res = t3;
@@ -434,7 +465,7 @@ void LightWalker::visit(parser::BinaryExpr &node) {
             auto t2 = builder->create_cond_br(t1, b1, b2);
             builder->set_insert_point(b1);
             builder->create_call(error_div_fun, {});
-            builder->create_br(b2);
+            builder->create_unreachable();
             builder->set_insert_point(b2);
             auto t3 = builder->create_irem(v1, v2);
             res = t3;
@@ -534,7 +565,7 @@ void LightWalker::visit(parser::CallExpr &node) {
         auto is_object_init = sym->get<semantic::ClassDefType>(func_name);
         if (is_object_init) {
             auto class_type =
-                dynamic_cast<Class *>(scope.find_in_global(func_name));
+                dyn_cast<Class>(scope.find_in_global(func_name));
             assert(class_type);
             auto pointer_class_type = PtrType::get(class_type);
 
@@ -543,17 +574,17 @@ void LightWalker::visit(parser::CallExpr &node) {
             auto op = builder->create_bitcast(class_type, alloc_type);
             auto alloc_call = builder->create_call(alloc_fun, {op});
 
-            func = dynamic_cast<Function *>(class_type->get_method()->at(0));
+            func = dyn_cast<Function>(class_type->get_method()->at(0));
             assert(func);
             visitor_return_value =
                 builder->create_bitcast(alloc_call, pointer_class_type);
             args.emplace_back(builder->create_bitcast(
                 alloc_call, func->get_function_type()->get_arg_type(0)));
         } else {
-            func = dynamic_cast<Function *>(scope.find_in_global(func_name));
+            func = dyn_cast<Function>(scope.find_in_global(func_name));
             if (func == nullptr) {
                 // lambda function
-                func = dynamic_cast<Function *>(scope.find(func_name));
+                func = dyn_cast<Function>(scope.find(func_name));
                 auto class_instance = scope.find(func_name + "$anon");
                 assert(func);
                 assert(class_instance);
@@ -578,7 +609,7 @@ void LightWalker::visit(parser::ClassDef &node) {
     auto saved_sym = sym;
     sym = &class_type->current_scope;
 
-    auto class_ = dynamic_cast<Class *>(scope.find_in_global(node.name->name));
+    auto class_ = dyn_cast<Class>(scope.find_in_global(node.name->name));
     assert(class_);
     auto super_class = class_->super_class_info_;
 
@@ -599,12 +630,13 @@ void LightWalker::visit(parser::ClassDef &node) {
 
                 if (attr_type->is_integer_type()) {
                     class_->add_attribute(
-                        new AttrInfo(attr_type, name,
-                                     static_cast<parser::IntegerLiteral *>(
-                                         var_def->value.get())
-                                         ->value));
+                        new (module.get()) AttrInfo(
+                            attr_type, name,
+                            static_cast<parser::IntegerLiteral *>(
+                                var_def->value.get())
+                                ->value));
                 } else if (attr_type->is_bool_type()) {
-                    class_->add_attribute(new AttrInfo(
+                    class_->add_attribute(new (module.get()) AttrInfo(
                         attr_type, name,
                         static_cast<parser::BoolLiteral *>(var_def->value.get())
                             ->bin_value));
@@ -621,9 +653,11 @@ void LightWalker::visit(parser::ClassDef &node) {
                         "const_" + std::to_string(id), module.get(), C);
                     t->set_type(ptr_str_type);
 
-                    class_->add_attribute(new AttrInfo(attr_type, name, t));
+                    class_->add_attribute(
+                        new (module.get()) AttrInfo(attr_type, name, t));
                 } else {
-                    class_->add_attribute(new AttrInfo(attr_type, name));
+                    class_->add_attribute(
+                        new (module.get()) AttrInfo(attr_type, name));
                 }
             }
         }
@@ -637,7 +671,7 @@ void LightWalker::visit(parser::ClassDef &node) {
             assert(func_def_type);
             auto unique_func_name = get_fully_qualified_name(func_def_type);
 
-            auto func_type = dynamic_cast<FunctionType *>(
+            auto func_type = dyn_cast<FunctionType>(
                 semantic_type_to_llvm_type(func_def_type));
             assert(func_type);
 
@@ -662,7 +696,7 @@ void LightWalker::visit(parser::ClassType &node) {
         return;
     }
     const auto class_ =
-        dynamic_cast<Class *>(scope.find_in_global(node.className));
+        dyn_cast<Class>(scope.find_in_global(node.className));
     assert(class_);
     if (node.get_name() == "int") {
         visitor_return_type = IntegerType::get(32, module.get());
@@ -688,7 +722,7 @@ void LightWalker::visit(parser::ForStmt &node) {
     builder->create_cond_br(cond_null, b_null_true, b_null_false);
     builder->set_insert_point(b_null_true);
     builder->create_call(error_none_fun, vector<Value *>());
-    builder->create_br(b_null_false);
+    builder->create_unreachable();
     builder->set_insert_point(b_null_false);
 
     auto it = scope.find(node.identifier->name);
@@ -745,7 +779,7 @@ void LightWalker::visit(parser::ForStmt &node) {
                 if (element_type->is_list_type()) {
                     type = PtrType::get(list_class);
                 } else {
-                    type = dynamic_cast<Type *>(
+                    type = dyn_cast<Class>(
                         scope.find_in_global(element_type->get_name()));
                     assert(type != nullptr);
                     type = PtrType::get(type);
@@ -775,19 +809,19 @@ void LightWalker::visit(parser::FuncDef &node) {
     Function *func;
     Class *anon = nullptr;
     if (!scope.in_global()) {
-        func = dynamic_cast<Function *>(scope.find(func_name));
-        anon = dynamic_cast<Class *>(
+        func = dyn_cast<Function>(scope.find(func_name));
+        anon = dyn_cast<Class>(
             func->get_function_type()->get_arg_type(0)->get_ptr_element_type());
         assert(anon);
         assert(func);
     } else {
         auto is_method =
             unique_func_name.find("$$METHOD$$") != std::string::npos;
-        func = dynamic_cast<Function *>(
+        func = dyn_cast<Function>(
             scope.find_in_global(is_method ? unique_func_name : func_name));
         assert(func);
     }
-    auto &arg_types = func->get_function_type()->args_;
+    auto &arg_types = func->get_function_type()->get_params();
 
     auto saved_b = builder->get_insert_block();
     auto b = BasicBlock::create(module.get(), "", func);
@@ -804,12 +838,14 @@ void LightWalker::visit(parser::FuncDef &node) {
             assert(func_def_type);
             auto unique_func_name = get_fully_qualified_name(func_def_type);
 
-            auto func_type = dynamic_cast<FunctionType *>(
+            auto func_type = dyn_cast<FunctionType>(
                 semantic_type_to_llvm_type(func_def_type));
             assert(func_type);
-            auto anon = new Class(module.get(), unique_func_name, true);
-            func_type->args_.insert(func_type->args_.begin(),
-                                    PtrType::get(anon));
+            auto anon =
+                new (module.get()) Class(module.get(), unique_func_name, true);
+            auto params = func_type->get_params();
+            params.insert(params.begin(), PtrType::get(anon));
+            func_type = FunctionType::get(func_type->get_return_type(), params);
 
             auto func =
                 Function::create(func_type, unique_func_name, module.get());
@@ -822,7 +858,7 @@ void LightWalker::visit(parser::FuncDef &node) {
 
     if (anon) {
         builder->set_insert_point(saved_b);
-        auto arg = new Value(arg_types[0], "arg0");
+        auto arg = new (module.get()) Value(arg_types[0], "arg0");
         auto class_instance = scope.find(func_name + "$anon");
         for (int i = 0; i < node.lambda_params.size(); i++) {
             auto &capture_name = node.lambda_params.at(i);
@@ -830,7 +866,7 @@ void LightWalker::visit(parser::FuncDef &node) {
             assert(capture_value);
 
             auto capture_type = capture_value->get_type();
-            if (dynamic_cast<Function *>(capture_value)) {
+            if (dyn_cast<Function>(capture_value)) {
                 auto capture_func = (Function *)capture_value;
                 auto capture_value = scope.find(capture_name + "$anon");
                 assert(capture_value);
@@ -840,12 +876,12 @@ void LightWalker::visit(parser::FuncDef &node) {
 
             // std::cerr << unique_func_name << " add attr " << capture_name <<
             // " of type " << capture_type->print() << ' ' << std::endl;
-            anon->add_attribute(new AttrInfo(capture_type, capture_name,
-                                             ConstantNull::get(capture_type)));
+            anon->add_attribute(new (module.get()) AttrInfo(
+                capture_type, capture_name, ConstantNull::get(capture_type)));
 
             auto addr = builder->create_gep(class_instance, CONST(i));
             auto v = scope.find(capture_name);
-            if (dynamic_cast<Function *>(v)) {
+            if (dyn_cast<Function>(v)) {
                 v = scope.find(capture_name + "$anon");
             }
             builder->create_store(v, addr);
@@ -869,8 +905,9 @@ void LightWalker::visit(parser::FuncDef &node) {
         auto arg_type = arg_types[arg_num];
         const auto &arg = node.params.at(i);
         auto alloca = builder->create_alloca(arg_type);
-        builder->create_store(
-            new Value(arg_type, "arg" + std::to_string(arg_num)), alloca);
+        builder->create_store(new (module.get()) Value(
+                                  arg_type, "arg" + std::to_string(arg_num)),
+                              alloca);
         scope.push(arg->identifier->name, alloca);
     }
 
@@ -893,7 +930,7 @@ void LightWalker::visit(parser::FuncDef &node) {
         node.returnType->get_name() != "bool" &&
         node.returnType->get_name() != "str") {
         builder->create_ret(
-            new ConstantNull(func->get_function_type()->get_return_type()));
+            ConstantNull::get(func->get_function_type()->get_return_type()));
     }
     builder->set_insert_point(saved_b);
     scope.exit();
@@ -1014,7 +1051,7 @@ void LightWalker::visit(parser::MemberExpr &node) {
     node.object->accept(*this);
     auto obj = visitor_return_value;
     assert(obj);
-    auto class_type = dynamic_cast<Class *>(
+    auto class_type = dyn_cast<Class>(
         scope.find_in_global(node.object->inferredType->get_name()));
     assert(class_type);
 
@@ -1026,14 +1063,15 @@ void LightWalker::visit(parser::MemberExpr &node) {
     builder->create_cond_br(is_none, b_true, b_end);
     builder->set_insert_point(b_true);
     builder->create_call(error_none_fun, {});
-    builder->create_br(b_end);
+    builder->create_unreachable();
     builder->set_insert_point(b_end);
 
-    if (class_type->get_attr_offset(node.member->name) <
+    if (class_type->get_attr_offset(node.member->name.str()) <
         class_type->get_attribute()->size()) {
         // member is a attribute
         auto v = builder->create_gep(
-            obj, CONST(3 + class_type->get_attr_offset(node.member->name)));
+            obj,
+            CONST(3 + class_type->get_attr_offset(node.member->name.str())));
         if (param_get_lvalue) {
             visitor_return_value = v;
         } else {
@@ -1112,7 +1150,7 @@ void LightWalker::visit(parser::NoneLiteral &node) {
 }
 void LightWalker::visit(parser::ReturnStmt &node) {
     if (node.value == nullptr) {
-        builder->create_ret(new ConstantNull(
+        builder->create_ret(ConstantNull::get(
             PtrType::get((Class *)scope.find_in_global("object"))));
         return;
     }
@@ -1196,7 +1234,7 @@ void LightWalker::visit(parser::VarDef &node) {
             const auto &class_name = node.var->type->get_name();
             auto init_value_type_name = node.value->inferredType->get_name();
             const auto class_type =
-                dynamic_cast<Class *>(scope.find_in_global(class_name));
+                dyn_cast<Class>(scope.find_in_global(class_name));
             if (!class_type) {
                 std::cerr << fmt::format("class {} not found", class_name)
                           << std::endl;
@@ -1242,7 +1280,7 @@ void LightWalker::visit(parser::VarDef &node) {
             const auto &class_name = node.var->type->get_name();
             auto init_value_type_name = node.value->inferredType->get_name();
             const auto class_type =
-                dynamic_cast<Class *>(scope.find_in_global(class_name));
+                dyn_cast<Class>(scope.find_in_global(class_name));
             assert(class_type);
             const auto var_type = PtrType::get(class_type);
             t = builder->create_alloca(var_type);
@@ -1303,7 +1341,7 @@ void LightWalker::visit(parser::IndexExpr &node) {
     builder->create_cond_br(cond_null, b_null_true, b_null_false);
     builder->set_insert_point(b_null_true);
     builder->create_call(error_none_fun, vector<Value *>());
-    builder->create_br(b_null_false);
+    builder->create_unreachable();
     builder->set_insert_point(b_null_false);
 
     auto v_len = builder->create_call(len_fun, {list});
@@ -1317,7 +1355,7 @@ void LightWalker::visit(parser::IndexExpr &node) {
     builder->create_cond_br(cond, b_oob, b_1);
     builder->set_insert_point(b_oob);
     builder->create_call(error_oob_fun, vector<Value *>());
-    builder->create_br(b_1);
+    builder->create_unreachable();
     builder->set_insert_point(b_1);
     if (node.list->inferredType->get_name() == "str") {
         assert(!is_get_lvalue);
@@ -1358,7 +1396,7 @@ void LightWalker::visit(parser::IndexExpr &node) {
             if (type_name[0] == '[') {
                 type = list_class->get_type();
             } else {
-                type = dynamic_cast<Class *>(scope.find_in_global(type_name));
+                type = dyn_cast<Class>(scope.find_in_global(type_name));
             }
             auto t6 =
                 builder->create_bitcast(t5, PtrType::get(PtrType::get(type)));
@@ -1376,11 +1414,130 @@ void LightWalker::visit(parser::IndexExpr &node) {
 void print_help(const string_view &exe_name) {
     std::cout << fmt::format(
                      "Usage: {} [ -h | --help ] [ -o <target-file> ] [ -emit ] "
-                     "[ -run ] [ -assem ] <input-file>",
+                     "[ -run ] [ -assem ] [ -pass <pass-name> ]... "
+                     "[ -unroll-factor <n> ] [ -ir-cache ] [ -ast-cache ] "
+                     "[ -emit-ir ] [ -verify ] [ -repeat <n> ] <input-file>",
                      exe_name)
               << std::endl;
 }
 
+string target_of(const string &input_path) {
+    for (string_view ir : {".ll", ".lirb"}) {
+        if (input_path.ends_with(ir)) {
+            // never the input itself: foo.ll is optimized to foo.opt.ll
+            return input_path.substr(0, input_path.size() - ir.size()) +
+                   ".opt";
+        }
+    }
+    return replace_all(input_path, ".py", "");
+}
+
+uint64_t ir_cache_key(string_view tool, const string &input_path,
+                      const CompileOptions &options) {
+    std::ifstream input_stream(input_path, std::ios::binary);
+    string source((std::istreambuf_iterator<char>(input_stream)),
+                  std::istreambuf_iterator<char>());
+    auto key = parser::hash_bytes(source);
+    key = parser::hash_bytes(tool, key);
+    key = parser::hash_bytes(parser::build_id, key);
+    for (const auto &pass : options.passes) {
+        key = parser::hash_bytes(pass + '\0', key);
+    }
+    return parser::hash_bytes(std::to_string(options.unroll_factor), key);
+}
+
+void write_ir(lightir::Module *m, const string &target_path, bool to_file,
+              bool to_stdout) {
+    if (!to_file && !to_stdout) return;
+    std::ofstream file;
+    if (to_file) file.open(target_path + ".ll");
+    // the module prints only once, so going to both means a copy in memory
+    std::ostringstream both;
+    std::ostream &out = to_file && to_stdout ? both
+                        : to_file            ? static_cast<std::ostream &>(file)
+                                             : cout;
+    out << fmt::format(
+        "; ModuleID = \"{}\"\n"
+        "source_filename = \"{}\"\n",
+        m->module_name_, m->source_file_name_);
+    m->print(out);
+    if (to_file && to_stdout) {
+        file << both.view();
+        cout << both.view();
+    }
+}
+
+std::shared_ptr<lightir::Module> load_module(const string &input_path,
+                                             bool ast_cache) {
+    if (input_path.ends_with(".ll")) {
+        string error;
+        std::shared_ptr<lightir::Module> m =
+            lightir::parse_ir_file(input_path, &error);
+        if (m == nullptr) {
+            cout << "Syntax Error" << endl;
+            std::cerr << input_path << ":" << error << endl;
+        }
+        return m;
+    }
+    if (input_path.ends_with(".lirb")) {
+        std::ifstream input_stream(input_path, std::ios::binary);
+        string data((std::istreambuf_iterator<char>(input_stream)),
+                    std::istreambuf_iterator<char>());
+        std::shared_ptr<lightir::Module> m =
+            lightir::read_binary_ir(data, lightir::read_binary_ir_key(data));
+        if (m == nullptr) {
+            cout << "Syntax Error" << endl;
+            std::cerr << input_path << ": not a module of this version"
+                      << endl;
+        }
+        return m;
+    }
+
+    auto tree = semantic::check(input_path, ast_cache);
+    auto &errors = tree->errors->compiler_errors;
+    if (errors.size() != 0) {
+        // the passes only run on a program that parsed
+        cout << (errors.front()->syntax ? "Syntax Error" : "Type Error")
+             << endl;
+        return nullptr;
+    }
+
+    auto LightWalker = lightir::LightWalker(*tree);
+    tree->accept(LightWalker);
+    return LightWalker.get_module();
+}
+
+std::shared_ptr<lightir::Module> compile_module(
+    string_view tool, const string &input_path, const string &target_path,
+    const CompileOptions &options,
+    const std::function<void(lightir::PassManager &)> &add_first) {
+    std::shared_ptr<lightir::Module> m;
+    const auto cache_path = target_path + ".lirb";
+    uint64_t cache_key = 0;
+    if (options.ir_cache) {
+        cache_key = ir_cache_key(tool, input_path, options);
+        m = lightir::read_binary_ir_file(cache_path, cache_key);
+        if (m != nullptr) return m;
+    }
+
+    m = load_module(input_path, options.ast_cache);
+    if (m == nullptr) return nullptr;
+    if (options.unroll_factor > 0) m->unroll_factor = options.unroll_factor;
+    lightir::PassManager pm(m.get());
+    if (options.verify) pm.set_verify(lightir::PassManager::Verify::All);
+    if (add_first) add_first(pm);
+    for (const auto &pass : options.passes) {
+        [[maybe_unused]] bool known = pm.add_Pass(pass);
+        assert(known && "the driver checks the names of the passes");
+    }
+    pm.run();
+
+    if (options.ir_cache) {
+        lightir::write_binary_ir_file(m.get(), cache_path, cache_key);
+    }
+    return m;
+}
+
 #ifdef PA3
 int main(int argc, char *argv[]) {
     string target_path;
@@ -1389,6 +1546,8 @@ int main(int argc, char *argv[]) {
     bool emit = false;
     bool run = false;
     bool assem = false;
+    int repeat = 0;
+    CompileOptions options;
 
     for (int i = 1; i < argc; ++i) {
         if (argv[i] == "-h"s || argv[i] == "--help"s) {
@@ -1408,11 +1567,43 @@ int main(int argc, char *argv[]) {
             assem = true;
         } else if (argv[i] == "-run"s) {
             run = true;
+        } else if (argv[i] == "-pass"s) {
+            if (i + 1 < argc && lightir::PassManager::has_Pass(argv[i + 1])) {
+                options.passes.emplace_back(argv[i + 1]);
+                i += 1;
+            } else {
+                print_help(argv[0]);
+                return 0;
+            }
+        } else if (argv[i] == "-ir-cache"s) {
+            options.ir_cache = true;
+        } else if (argv[i] == "-ast-cache"s) {
+            options.ast_cache = true;
+        } else if (argv[i] == "-verify"s) {
+            options.verify = true;
+        } else if (argv[i] == "-emit-ir"s) {
+            // the .ll is what this tool is for, so it is always written
+        } else if (argv[i] == "-unroll-factor"s) {
+            if (i + 1 < argc) {
+                options.unroll_factor = std::stoi(argv[i + 1]);
+                i += 1;
+            } else {
+                print_help(argv[0]);
+                return 0;
+            }
+        } else if (argv[i] == "-repeat"s) {
+            if (i + 1 < argc) {
+                repeat = std::stoi(argv[i + 1]);
+                i += 1;
+            } else {
+                print_help(argv[0]);
+                return 0;
+            }
         } else {
             if (input_path.empty()) {
                 input_path = argv[i];
                 if (target_path.empty())
-                    target_path = replace_all(input_path, ".py", "");
+                    target_path = target_of(input_path);
             } else {
                 print_help(argv[0]);
                 return 0;
@@ -1420,47 +1611,24 @@ int main(int argc, char *argv[]) {
         }
     }
 
-    std::unique_ptr<parser::Program> tree(parse(input_path.c_str()));
-    if (tree->errors->compiler_errors.size() != 0) {
-        cout << "Syntax Error" << endl;
-        return 0;
-    }
-
-    auto symboltableGenerator = semantic::SymbolTableGenerator(*tree);
-    tree->accept(symboltableGenerator);
-    if (tree->errors->compiler_errors.size() == 0) {
-        auto declarationAnalyzer = semantic::DeclarationAnalyzer(*tree);
-        tree->accept(declarationAnalyzer);
-    }
-    if (tree->errors->compiler_errors.size() == 0) {
-        auto typeChecker = semantic::TypeChecker(*tree);
-        tree->accept(typeChecker);
-    }
-
-    if (tree->errors->compiler_errors.size() != 0) {
-        cout << "Type Error" << endl;
+    if (repeat > 0) {
+        // a compile service's loop: the peak RSS after each module is torn
+        // down, which stays flat once the allocators are warm unless
+        // something outlives its module
+        for (int n = 1; n <= repeat; n++) {
+            compile_module("lightir", input_path, target_path, options);
+            struct rusage usage {};
+            getrusage(RUSAGE_SELF, &usage);
+            cout << fmt::format("{} {}\n", n, usage.ru_maxrss);
+        }
         return 0;
     }
 
-    std::shared_ptr<lightir::Module> m;
-    auto LightWalker = lightir::LightWalker(*tree);
-    tree->accept(LightWalker);
-    m = LightWalker.get_module();
+    auto m = compile_module("lightir", input_path, target_path, options);
+    if (m == nullptr) return 0;
     m->source_file_name_ = input_path;
 
-    string IR = fmt::format(
-        "; ModuleID = \"{}\"\n"
-        "source_filename = \"{}\"\n"
-        "{}",
-        m->module_name_, m->source_file_name_, m->print());
-
-    std::ofstream output_stream(target_path + ".ll");
-    output_stream << IR;
-    output_stream.flush();
-
-    if (emit) {
-        cout << IR;
-    }
+    write_ir(m.get(), target_path, true, emit);
 
     if (assem || run) {
         auto generate_assem = fmt::format(
@@ -0,0 +1,99 @@
+#include "chocopy_optimization.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <unordered_map>
+
+#include "BasicBlock.hpp"
+#include "LoopSearch.hpp"
+#include "LoopUnroll.hpp"
+#include "StackAlloc.hpp"
+#include "TailCallElim.hpp"
+#include "Vectorize.hpp"
+
+namespace lightir {
+int get_arg_no(Value *val, unsigned num_args) {
+    if (val->get_value_kind() != ValueKind::Value && !isa<Argument>(val)) {
+        return -1;
+    }
+    const auto name = val->get_name();
+    for (unsigned i = 0; i < num_args; i++) {
+        if (name == "arg" + std::to_string(i)) return i;
+    }
+    return -1;
+}
+
+void Pass::rebuild_cfg(Function *func) {
+    set_changed(func);
+    for (auto bb : func->get_basic_blocks()) {
+        bb->get_pre_basic_blocks().clear();
+        bb->get_succ_basic_blocks().clear();
+    }
+    for (auto bb : func->get_basic_blocks()) {
+        for (auto succ : LoopSearch::get_succs(bb)) {
+            bb->add_succ_basic_block(succ);
+            succ->add_pre_basic_block(bb);
+        }
+    }
+}
+
+namespace {
+template <typename PassType>
+void add(PassManager &pm, bool emit) {
+    pm.add_Pass<PassType>(emit);
+}
+
+/** The passes `-pass` can name. */
+const std::unordered_map<string_view, void (*)(PassManager &, bool)>
+    named_passes = {
+        {LoopUnroll::name, add<LoopUnroll>},
+        {StackAlloc::name, add<StackAlloc>},
+        {TailCallElim::name, add<TailCallElim>},
+        {Vectorize::name, add<Vectorize>},
+};
+}  // namespace
+
+bool PassManager::has_Pass(const string &name) {
+    return named_passes.contains(name);
+}
+
+bool PassManager::add_Pass(const string &name, bool emit) {
+    auto it = named_passes.find(name);
+    if (it == named_passes.end()) return false;
+    it->second(*this, emit);
+    return true;
+}
+
+void PassManager::check(bool ok, const Verifier &verifier,
+                        string_view when) {
+    if (ok) return;
+    std::cerr << "Broken IR " << when << ":\n" << verifier.get_errors();
+    std::abort();
+}
+
+void PassManager::run() {
+    Verifier verifier;
+    if (verify_ != Verify::None) {
+        check(verifier.verify(m_), verifier, "before the passes");
+    }
+    for (auto &[pass, name, emit] : passes_) {
+        pass->changed_.clear();
+        pass->run();
+        /** new instructions need names before printing or codegen */
+        m_->set_print_name();
+        if (emit) {
+            m_->print(std::cout);
+        }
+
+        bool ok = true;
+        if (verify_ == Verify::All) {
+            ok = verifier.verify(m_);
+        } else if (verify_ == Verify::Changed) {
+            for (auto func : pass->get_changed()) {
+                if (!verifier.verify(func)) ok = false;
+            }
+        }
+        check(ok, verifier, string("after ") + name);
+    }
+}
+}  // namespace lightir
@@ -1,8 +1,49 @@
 %locations
 %define api.location.type {::parser::Location}
+%define api.pure full
+%param {yyscan_t scanner}
+
+%code requires {
+#include <memory>
+#include <stack>
+#include <string>
+#include <vector>
+
+#include "chocopy_parse.hpp"
+
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void *yyscan_t;
+#endif
+
+namespace parser {
+/** The state of one parse, kept by the scanner as its extra data. */
+struct ParseContext {
+    /* The indentation of the enclosing blocks. */
+    std::stack<int> indent_stack;
+    /* The tokens the indentation of a line came to after the first one,
+     * handed out last first, one per call, before scanning on. */
+    std::vector<int> indent_tokens;
+    /* Where they are: the leading blanks of that line. */
+    Location indent_location;
+    int line_num = 1;
+    int col_num = 1;
+    /* The file or buffer name, for the messages. */
+    std::string source_name;
+    /* The nodes and the text of the string literals. */
+    std::shared_ptr<Arena> arena = std::make_shared<Arena>();
+    /* The program, or an empty one holding the syntax errors. */
+    std::unique_ptr<Program> root = std::make_unique<Program>(Location());
+};
+}  // namespace parser
+}
 
 %{
 #define YYLLOC_DEFAULT(Cur, Rhs, N)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <cstdio>
 #include <cstdarg>
 #include <vector>
@@ -11,21 +52,10 @@
 
 #include "chocopy_parse.hpp"
 #include "chocopy_ast.hpp"
+#include "chocopy_bytes.hpp"
 
 using ::parser::Location;
 
-/* external functions from lex */
-extern void yyrestart(FILE*);
-extern int yylex();
-extern int yyparse();
-extern FILE* yyin;
-
-/* the program */
-std::unique_ptr<::parser::Program> ROOT = std::make_unique<::parser::Program>(Location());
-
-/* error reporting */
-void yyerror(const char *s);
-
 /* append item to the end of LIST. Then returns LIST. */
 /* this is a handy helper function. */
 template<typename T, typename X>
@@ -35,10 +65,33 @@ T* combine(T* list, X *item) {
 }
 %}
 
+%code {
+/* external functions from lex */
+extern int yylex(YYSTYPE *yylval_param, YYLTYPE *yylloc_param, yyscan_t scanner);
+extern int yylex_init_extra(::parser::ParseContext *context, yyscan_t *scanner);
+extern void yyset_in(FILE *input, yyscan_t scanner);
+extern void yyset_lineno(int line_number, yyscan_t scanner);
+extern ::parser::ParseContext *yyget_extra(yyscan_t scanner);
+extern int yylex_destroy(yyscan_t scanner);
+#ifndef YY_TYPEDEF_YY_BUFFER_STATE
+#define YY_TYPEDEF_YY_BUFFER_STATE
+typedef struct yy_buffer_state *YY_BUFFER_STATE;
+#endif
+extern YY_BUFFER_STATE yy_scan_buffer(char *base, size_t size, yyscan_t scanner);
+extern void yyrestore_buffer(yyscan_t scanner);
+
+/* the program */
+#define ROOT (yyget_extra(scanner)->root)
+
+/* error reporting */
+void yyerror(YYLTYPE *location, yyscan_t scanner, const char *s);
+}
+
 /* all possible types of semantic value */
 /* check https://www.gnu.org/software/bison/manual/html_node/Union-Decl.html */
 %union {
   char *raw_str;
+  const std::string *raw_name;
   int raw_int;
   ::parser::Stmt *PtrStmt;
   ::parser::Decl *PtrDecl;
@@ -83,7 +136,7 @@ T* combine(T* list, X *item) {
 /* declare tokens and their type */
 /* check https://www.gnu.org/software/bison/manual/html_node/Token-Decl.html */
 %token <raw_int> TOKEN_INTEGER
-%token <raw_str> TOKEN_IDENTIFIER
+%token <raw_name> TOKEN_IDENTIFIER
 %token <raw_str> TOKEN_STRING
 %token TOKEN_TRUE
 %token TOKEN_FALSE
@@ -154,7 +207,7 @@ T* combine(T* list, X *item) {
 /* you don't need to modify the code */
 /* check https://www.gnu.org/software/bison/manual/html_node/Destructor-Decl.html */
 %destructor { } <raw_int>
-%destructor { free($$); } <raw_str>
+%destructor { } <raw_str> <raw_name>
 %destructor { delete $$; } <*>
 
 /* you may define associativity and precedence here */
@@ -227,7 +280,7 @@ typed_var_list: { $$ = new std::vector<std::unique_ptr<::parser::TypedVar>>(); }
         $$->emplace_back($1);
     }
     | typed_var TOKEN_comma typed_var_list { $3->emplace($3->begin(), $1); $$ = $3; }
-func_return_type: { $$ = new parser::ClassType(@$ = yylloc, "<None>"); }
+func_return_type: { $$ = new parser::ClassType(@$ = yylloc, parser::Symbol("<None>")); }
     | TOKEN_rarrow type { $$ = $2; @$ = {@1, @2}; }
 func_decls: { $$ = new std::vector<std::unique_ptr<::parser::Decl>>(); }
     | func_decls global_decl { $$ = combine($1, $2); }
@@ -237,8 +290,8 @@ func_decls: { $$ = new std::vector<std::unique_ptr<::parser::Decl>>(); }
 
 typed_var : identifier TOKEN_colon type { $$ = new parser::TypedVar(@$ = {@1, @3}, $1, $3); }
 type :
-    TOKEN_IDENTIFIER { $$ = new parser::ClassType(@$ = yylloc, string($1)); free($1); }
-    | TOKEN_STRING { $$ = new parser::ClassType(@$ = yylloc, string($1)); delete[] $1; }
+    TOKEN_IDENTIFIER { $$ = new parser::ClassType(@$ = yylloc, parser::Symbol::from($1)); }
+    | TOKEN_STRING { $$ = new parser::ClassType(@$ = yylloc, parser::Symbol($1)); }
     | TOKEN_l_square type TOKEN_r_square { $$ = new parser::ListType(@$ = {@1, @3}, $2); }
 
 global_decl : TOKEN_GLOBAL identifier TOKEN_NEWLINE { $$ = new parser::GlobalDecl(@$ = {@1, @2}, $2); }
@@ -273,7 +326,7 @@ literal :
     | TOKEN_TRUE { $$ = new parser::BoolLiteral(@$ = yylloc, true); }
     | TOKEN_FALSE { $$ = new parser::BoolLiteral(@$ = yylloc, false); }
     | TOKEN_NONE { $$ = new parser::NoneLiteral(@$ = yylloc); }
-    | TOKEN_STRING { $$ = new parser::StringLiteral(@$ = yylloc, string($1)); delete[] $1; }
+    | TOKEN_STRING { $$ = new parser::StringLiteral(@$ = yylloc, string($1)); }
 
 expr :
     expr_no_if { $$ = $1; @$ = @1; }
@@ -341,13 +394,12 @@ assign_stmt :
     }
 
 identifier : TOKEN_IDENTIFIER {
-    $$ = new parser::Ident(@$ = yylloc, string($1));
-    free($1);
+    $$ = new parser::Ident(@$ = yylloc, parser::Symbol::from($1));
 }
 %%
 
 /** The error reporting function. */
-void yyerror(const char *s) {
+void yyerror(YYLTYPE *, yyscan_t scanner, const char *) {
     /* This is just an example.
      * You can customize it as you like. */
     string info("Parsing error");
@@ -355,18 +407,99 @@ void yyerror(const char *s) {
     ROOT->errors->compiler_errors.emplace_back(std::move(error));
 }
 
-std::unique_ptr<::parser::Program> parse(const char* input_path) {
-    if (input_path != NULL) {
-        if (!(yyin = fopen(input_path, "r"))) {
-            std::cerr << fmt::format("[ERR] Open input file {} failed.", input_path) << std::endl;
-            exit(EXIT_FAILURE);
-        }
+/** Parses with the scanner reading from input, or from base if it is set.
+ * flex scans base in place: it has to be writable and end in two NULs,
+ * which size includes, and is left as it was. The nodes go to arena if it
+ * is set, and the first line is numbered first_line. */
+static std::unique_ptr<::parser::Program> parse(FILE *input, char *base, size_t size, std::string_view name,
+                                                std::shared_ptr<::parser::Arena> arena = nullptr, int first_line = 1) {
+    ::parser::ParseContext context;
+    context.source_name = name;
+    context.line_num = first_line;
+    if (arena) context.arena = std::move(arena);
+    yyscan_t scanner;
+    yylex_init_extra(&context, &scanner);
+    if (base != NULL) {
+        yy_scan_buffer(base, size, scanner);
+        /* flex keeps the line number in the buffer, and only numbers those
+         * it creates itself from 1 */
+        yyset_lineno(first_line, scanner);
     } else {
-        yyin = stdin;
+        yyset_in(input, scanner);
     }
     /* uncomment to see the middle process of Bison */
     /* yydebug = 1; */
-    yyrestart(yyin);
-    yyparse();
-    return std::move(ROOT);
+    {
+        ::parser::Arena::Scope scope(context.arena.get());
+        yyparse(scanner);
+    }
+    if (base != NULL) yyrestore_buffer(scanner);
+    yylex_destroy(scanner);
+    context.root->arena = std::move(context.arena);
+    return std::move(context.root);
+}
+
+std::unique_ptr<::parser::Program> parse(FILE *input) {
+    return parse(input, NULL, 0, "<input>");
+}
+
+std::unique_ptr<::parser::Program> parse_buffer(char *base, size_t size, std::string_view name,
+                                                std::shared_ptr<::parser::Arena> arena, int first_line) {
+    return parse(NULL, base, size, name, std::move(arena), first_line);
+}
+
+std::unique_ptr<::parser::Program> parse_buffer(std::string_view source, std::string_view name,
+                                                std::shared_ptr<::parser::Arena> arena, int first_line) {
+    std::string buffer(source.size() + 2, '\0');
+    source.copy(buffer.data(), source.size());
+    return parse_buffer(buffer.data(), buffer.size(), name, std::move(arena), first_line);
+}
+
+size_t scan_buffer(char *base, size_t size, uint64_t *hash) {
+    ::parser::ParseContext context;
+    context.source_name = "<scan>";
+    yyscan_t scanner;
+    yylex_init_extra(&context, &scanner);
+    yy_scan_buffer(base, size, scanner);
+    yyset_lineno(1, scanner);
+    YYSTYPE value;
+    YYLTYPE location;
+    size_t tokens = 0;
+    /* FNV-1a over each token and its location */
+    uint64_t h = 0xcbf29ce484222325;
+    for (int token; (token = yylex(&value, &location, scanner)) != 0; tokens++) {
+        for (int v : {token, location.first.line, location.first.column, location.last.line, location.last.column}) {
+            h = (h ^ static_cast<uint32_t>(v)) * 0x100000001b3;
+        }
+    }
+    yylex_destroy(scanner);
+    *hash = h;
+    return tokens;
+}
+
+std::unique_ptr<::parser::Program> parse(const char* input_path) {
+    if (input_path == NULL) {
+        return parse(stdin, NULL, 0, "<stdin>");
+    }
+    int fd = open(input_path, O_RDONLY);
+    if (fd < 0) {
+        std::cerr << fmt::format("[ERR] Open input file {} failed.", input_path) << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        /* a pipe or a device cannot be mapped */
+        FILE *input = fdopen(fd, "r");
+        auto program = parse(input, NULL, 0, input_path);
+        fclose(input);
+        return program;
+    }
+
+    ::parser::MappedSource source(fd, st.st_size);
+    close(fd);
+    if (!source.mapped()) {
+        std::cerr << fmt::format("[ERR] Map input file {} failed.", input_path) << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    return parse(NULL, source.base(), source.size(), input_path);
 }
@@ -0,0 +1,38 @@
+#include "chocopy_arena.hpp"
+
+namespace parser {
+static thread_local Arena *current_arena = nullptr;
+
+void *BumpAllocator::allocate(size_t size) {
+    constexpr size_t align = alignof(std::max_align_t);
+    size = (size + align - 1) & ~(align - 1);
+    allocated_size_ += size;
+    if (size > block_size / 4) {
+        /** a block of its own, so that the current one is not wasted */
+        blocks_.insert(blocks_.begin(), std::make_unique<std::byte[]>(size));
+        return blocks_.front().get();
+    }
+    if (cur_ == nullptr || static_cast<size_t>(end_ - cur_) < size) {
+        blocks_.push_back(std::make_unique<std::byte[]>(block_size));
+        cur_ = blocks_.back().get();
+        end_ = cur_ + block_size;
+    }
+    auto p = cur_;
+    cur_ += size;
+    return p;
+}
+
+char *Arena::allocate_string(size_t len) {
+    auto str = static_cast<char *>(allocate(len + 1));
+    str[len] = '\0';
+    return str;
+}
+
+Arena *Arena::current() { return current_arena; }
+
+Arena::Scope::Scope(Arena *arena) : outer_(current_arena) {
+    current_arena = arena;
+}
+
+Arena::Scope::~Scope() { current_arena = outer_; }
+}  // namespace parser
@@ -0,0 +1,42 @@
+#include "chocopy_bytes.hpp"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+
+namespace parser {
+bool write_file_atomically(const string &path, string_view data) {
+    // in the same directory, so that the rename does not cross file systems
+    const auto temp_path = path + ".tmp" + std::to_string(getpid());
+    std::ofstream output_stream(temp_path, std::ios::binary);
+    output_stream.write(data.data(), data.size());
+    output_stream.close();
+    if (!output_stream.good() ||
+        std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+MappedSource::MappedSource(int fd, size_t size) {
+    // the file over zeroed memory two bytes longer, so that flex finds its
+    // NULs after the text and may write into it
+    size_ = size + 2;
+    void *base = mmap(nullptr, size_, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) return;
+    if (size > 0 && mmap(base, size, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(base, size_);
+        return;
+    }
+    base_ = static_cast<char *>(base);
+}
+
+MappedSource::~MappedSource() {
+    if (base_ != nullptr) munmap(base_, size_);
+}
+}  // namespace parser
@@ -0,0 +1,384 @@
+#include "chocopy_json.hpp"
+
+#include <algorithm>
+#include <charconv>
+
+#include "FunctionDefType.hpp"
+#include "ValueType.hpp"
+#include "chocopy_parse.hpp"
+
+namespace parser {
+void JsonWriter::begin_object() {
+    element();
+    buf_ += '{';
+    depth_++;
+    empty_ = true;
+}
+
+void JsonWriter::end_object() { close('}'); }
+
+void JsonWriter::begin_array() {
+    element();
+    buf_ += '[';
+    depth_++;
+    empty_ = true;
+}
+
+void JsonWriter::end_array() { close(']'); }
+
+void JsonWriter::key(std::string_view key) {
+    if (!empty_) buf_ += ',';
+    newline();
+    write_string(key);
+    buf_ += ": ";
+    empty_ = false;
+    after_key_ = true;
+}
+
+void JsonWriter::value(std::string_view s) {
+    element();
+    write_string(s);
+}
+
+void JsonWriter::value(int i) {
+    element();
+    char digits[16];
+    auto end = std::to_chars(digits, digits + sizeof(digits), i).ptr;
+    buf_.append(digits, end);
+}
+
+void JsonWriter::value(bool b) {
+    element();
+    buf_ += b ? "true" : "false";
+}
+
+void JsonWriter::end() {
+    buf_ += '\n';
+    flush();
+    out_.flush();
+}
+
+void JsonWriter::flush() {
+    out_.write(buf_.data(), static_cast<std::streamsize>(buf_.size()));
+    buf_.clear();
+}
+
+void JsonWriter::element() {
+    if (after_key_) {
+        after_key_ = false;
+    } else if (depth_ > 0) {
+        if (!empty_) buf_ += ',';
+        newline();
+        empty_ = false;
+    }
+    if (buf_.size() >= buffer_size) flush();
+}
+
+void JsonWriter::close(char c) {
+    depth_--;
+    if (!empty_) newline();
+    buf_ += c;
+    empty_ = false;
+}
+
+void JsonWriter::newline() {
+    buf_ += '\n';
+    buf_.append(static_cast<size_t>(depth_ * indent_), ' ');
+}
+
+void JsonWriter::write_string(std::string_view s) {
+    static constexpr char hex[] = "0123456789abcdef";
+    buf_ += '"';
+    for (char c : s) {
+        switch (c) {
+            case '"': buf_ += "\\\""; break;
+            case '\\': buf_ += "\\\\"; break;
+            case '\b': buf_ += "\\b"; break;
+            case '\f': buf_ += "\\f"; break;
+            case '\n': buf_ += "\\n"; break;
+            case '\r': buf_ += "\\r"; break;
+            case '\t': buf_ += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    buf_ += "\\u00";
+                    buf_ += hex[c >> 4];
+                    buf_ += hex[c & 0xf];
+                } else {
+                    buf_ += c;
+                }
+        }
+    }
+    buf_ += '"';
+}
+}  // namespace parser
+
+namespace ast {
+using namespace parser;
+
+void JsonEmitter::emit(Node &node) {
+    node.accept(*this);
+    out_.end();
+}
+
+void JsonEmitter::object(const Node &node, std::initializer_list<Field> fields,
+                         const semantic::SymbolType *inferred_type) {
+    Field all[16];
+    size_t n = 0;
+    for (auto &field : fields) all[n++] = field;
+    all[n++] = {"kind", [&] { out_.value(node.kind); }};
+    if (inferred_type != nullptr) {
+        all[n++] = {"inferredType", [&] { type(*inferred_type); }};
+    }
+#ifdef __PARSER_PRINT_LOCATION
+    all[n++] = {"location", [&] {
+                    out_.begin_array();
+                    out_.value(node.location.first.line);
+                    out_.value(node.location.first.column);
+                    out_.value(node.location.last.line);
+                    out_.value(node.location.last.column);
+                    out_.end_array();
+                }};
+#endif
+    if (node.has_type_err()) {
+        all[n++] = {"errorMsg", [&] { out_.value(node.typeError); }};
+    }
+    std::sort(all, all + n, [](const Field &a, const Field &b) {
+        return a.first < b.first;
+    });
+
+    out_.begin_object();
+    for (size_t i = 0; i < n; i++) {
+        out_.key(all[i].first);
+        all[i].second();
+    }
+    out_.end_object();
+}
+
+void JsonEmitter::expr(const Expr &node, std::initializer_list<Field> fields) {
+    object(node, fields, node.inferredType.get());
+}
+
+template <typename T>
+void JsonEmitter::list(const T &nodes, bool skip_pass) {
+    out_.begin_array();
+    for (auto &node : nodes) {
+        if (skip_pass && node->kind == "PassStmt") continue;
+        node->accept(*this);
+    }
+    out_.end_array();
+}
+
+void JsonEmitter::type(const semantic::SymbolType &type) {
+    out_.begin_object();
+    if (auto func = dynamic_cast<const semantic::FunctionDefType *>(&type)) {
+        out_.key("kind");
+        out_.value("FuncType");
+        out_.key("parameters");
+        out_.begin_array();
+        for (auto &param : func->params) this->type(*param);
+        out_.end_array();
+        out_.key("returnType");
+        this->type(*func->return_type);
+    } else if (auto list =
+                   dynamic_cast<const semantic::ListValueType *>(&type)) {
+        out_.key("elementType");
+        this->type(*list->element_type);
+        out_.key("kind");
+        out_.value("ListValueType");
+    } else if (dynamic_cast<const semantic::ClassValueType *>(&type)) {
+        out_.key("className");
+        out_.value(type.get_name());
+        out_.key("kind");
+        out_.value("ClassValueType");
+    } else {
+        abort();
+    }
+    out_.end_object();
+}
+
+void JsonEmitter::visit(AssignStmt &node) {
+    object(node, {{"targets", [&] { list(node.targets); }},
+                  {"value", [&] { node.value->accept(*this); }}});
+}
+
+void JsonEmitter::visit(Program &node) {
+    object(node, {{"declarations", [&] { list(node.declarations); }},
+                  {"statements", [&] { list(node.statements); }},
+                  {"errors", [&] { node.errors->accept(*this); }}});
+}
+
+void JsonEmitter::visit(PassStmt &node) {
+    object(static_cast<Stmt &>(node), {});
+}
+
+void JsonEmitter::visit(BinaryExpr &node) {
+    Field left{"left", [&] { node.left->accept(*this); }};
+    Field op{"operator", [&] { out_.value(node.operator_); }};
+    Field right{"right", [&] { node.right->accept(*this); }};
+    if (node.left == nullptr && node.right == nullptr) {
+        expr(node, {op});
+    } else if (node.left == nullptr) {
+        expr(node, {op, right});
+    } else if (node.right == nullptr) {
+        expr(node, {left, op});
+    } else {
+        expr(node, {left, op, right});
+    }
+}
+
+void JsonEmitter::visit(BoolLiteral &node) {
+    expr(node, {{"value", [&] { out_.value(node.bin_value); }}});
+}
+
+void JsonEmitter::visit(CallExpr &node) {
+    expr(node, {{"function", [&] { node.function->accept(*this); }},
+                {"args", [&] { list(node.args); }}});
+}
+
+void JsonEmitter::visit(ClassDef &node) {
+    object(node, {{"name", [&] { node.name->accept(*this); }},
+                  {"superClass", [&] { node.superClass->accept(*this); }},
+                  {"declarations", [&] { list(node.declaration); }}});
+}
+
+void JsonEmitter::visit(ClassType &node) {
+    object(node, {{"className", [&] { out_.value(node.className.str()); }}});
+}
+
+void JsonEmitter::visit(ExprStmt &node) {
+    if (node.expr->kind.empty()) return object(node, {});
+    object(node, {{"expr", [&] { node.expr->accept(*this); }}});
+}
+
+void JsonEmitter::visit(ForStmt &node) {
+    object(node, {{"identifier", [&] { node.identifier->accept(*this); }},
+                  {"iterable", [&] { node.iterable->accept(*this); }},
+                  {"body", [&] { list(node.body); }}});
+}
+
+void JsonEmitter::visit(FuncDef &node) {
+    auto return_type = [&] {
+        if (node.returnType != nullptr) return node.returnType->accept(*this);
+        out_.begin_object();
+        out_.key("className");
+        out_.value("<None>");
+        out_.key("kind");
+        out_.value("ClassType");
+#ifdef __PARSER_PRINT_LOCATION
+        out_.key("location");
+        out_.begin_array();
+        for (int i = 0; i < 4; i++) out_.value(0);
+        out_.end_array();
+#endif
+        out_.end_object();
+    };
+    object(node, {{"name", [&] { node.name->accept(*this); }},
+                  {"params", [&] { list(node.params); }},
+                  {"returnType", return_type},
+                  {"declarations", [&] { list(node.declarations); }},
+                  {"statements", [&] { list(node.statements, true); }}});
+}
+
+void JsonEmitter::visit(GlobalDecl &node) {
+    object(node, {{"variable", [&] { node.variable->accept(*this); }}});
+}
+
+void JsonEmitter::visit(Ident &node) {
+    expr(node, {{"name", [&] { out_.value(node.name.str()); }}});
+}
+
+void JsonEmitter::visit(IfExpr &node) {
+    expr(node, {{"condition", [&] { node.condition->accept(*this); }},
+                {"thenExpr", [&] { node.thenExpr->accept(*this); }},
+                {"elseExpr", [&] { node.elseExpr->accept(*this); }}});
+}
+
+void JsonEmitter::visit(IndexExpr &node) {
+    expr(node, {{"list", [&] { node.list->accept(*this); }},
+                {"index", [&] { node.index->accept(*this); }}});
+}
+
+void JsonEmitter::visit(IntegerLiteral &node) {
+    expr(node, {{"value", [&] { out_.value(node.int_value); }}});
+}
+
+void JsonEmitter::visit(ListExpr &node) {
+    expr(node, {{"elements", [&] { list(node.elements); }}});
+}
+
+void JsonEmitter::visit(ListType &node) {
+    object(node,
+           {{"elementType", [&] { node.elementType->accept(*this); }}});
+}
+
+void JsonEmitter::visit(MemberExpr &node) {
+    expr(node, {{"object", [&] { node.object->accept(*this); }},
+                {"member", [&] { node.member->accept(*this); }}});
+}
+
+void JsonEmitter::visit(IfStmt &node) {
+    auto else_body = [&] {
+        if (node.el == IfStmt::THEN_ELSE) return list(node.elseBody, true);
+        out_.begin_array();
+        if (node.el == IfStmt::THEN_ELIF) node.elifBody->accept(*this);
+        out_.end_array();
+    };
+    object(node, {{"condition", [&] { node.condition->accept(*this); }},
+                  {"thenBody", [&] { list(node.thenBody, true); }},
+                  {"elseBody", else_body}});
+}
+
+void JsonEmitter::visit(MethodCallExpr &node) {
+    expr(node, {{"method", [&] { node.method->accept(*this); }},
+                {"args", [&] { list(node.args); }}});
+}
+
+void JsonEmitter::visit(NoneLiteral &node) { expr(node, {}); }
+
+void JsonEmitter::visit(NonlocalDecl &node) {
+    object(node, {{"variable", [&] { node.variable->accept(*this); }}});
+}
+
+void JsonEmitter::visit(ReturnStmt &node) {
+    if (node.value == nullptr) return object(node, {});
+    object(node, {{"value", [&] { node.value->accept(*this); }}});
+}
+
+void JsonEmitter::visit(StringLiteral &node) {
+    expr(node, {{"value", [&] { out_.value(node.value); }}});
+}
+
+void JsonEmitter::visit(TypeAnnotation &node) { object(node, {}); }
+
+void JsonEmitter::visit(TypedVar &node) {
+    object(node, {{"identifier", [&] { node.identifier->accept(*this); }},
+                  {"type", [&] { node.type->accept(*this); }}});
+}
+
+void JsonEmitter::visit(UnaryExpr &node) {
+    expr(node, {{"operator", [&] { out_.value(node.operator_); }},
+                {"operand", [&] { node.operand->accept(*this); }}});
+}
+
+void JsonEmitter::visit(VarDef &node) {
+    object(node, {{"var", [&] { node.var->accept(*this); }},
+                  {"value", [&] { node.value->accept(*this); }}});
+}
+
+void JsonEmitter::visit(WhileStmt &node) {
+    object(node, {{"condition", [&] { node.condition->accept(*this); }},
+                  {"body", [&] { list(node.body, true); }}});
+}
+
+void JsonEmitter::visit(Errors &node) {
+    object(node, {{"errors", [&] { list(node.compiler_errors); }}});
+}
+
+void JsonEmitter::visit(Node &node) {
+    auto error = dynamic_cast<CompilerErr *>(&node);
+    if (error == nullptr) return object(node, {});
+    Field message{"message", [&] { out_.value(error->message); }};
+    if (!error->syntax) return object(node, {message});
+    object(node, {message, {"syntax", [&] { out_.value(true); }}});
+}
+}  // namespace ast
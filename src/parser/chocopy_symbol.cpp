@@ -0,0 +1,49 @@
+#include "chocopy_symbol.hpp"
+
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace parser {
+namespace {
+/** The text of every symbol. A deque, so that the strings never move. */
+struct Interner {
+    std::shared_mutex mutex;
+    std::deque<string> names{string()};
+    std::unordered_map<string_view, const string *> index{
+        {names.front(), &names.front()}};
+};
+
+Interner &interner() {
+    static Interner *instance = new Interner;
+    return *instance;
+}
+}  // namespace
+
+Symbol::Symbol() : name_(&interner().names.front()) {}
+
+Symbol::Symbol(string_view name) {
+    if (auto symbol = find(name)) {
+        name_ = symbol->name_;
+        return;
+    }
+    auto &in = interner();
+    std::lock_guard<std::shared_mutex> lock(in.mutex);
+    auto it = in.index.find(name);
+    if (it != in.index.end()) {
+        name_ = it->second;
+        return;
+    }
+    name_ = &in.names.emplace_back(name);
+    in.index.emplace(*name_, name_);
+}
+
+std::optional<Symbol> Symbol::find(string_view name) {
+    auto &in = interner();
+    std::shared_lock<std::shared_mutex> lock(in.mutex);
+    auto it = in.index.find(name);
+    if (it == in.index.end()) return std::nullopt;
+    return Symbol(it->second);
+}
+}  // namespace parser
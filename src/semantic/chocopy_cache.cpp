@@ -0,0 +1,1058 @@
+#include "chocopy_cache.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <iterator>
+#include <optional>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "ClassDefType.hpp"
+#include "FunctionDefType.hpp"
+#include "ValueType.hpp"
+#include "chocopy_ast.hpp"
+#include "chocopy_bytes.hpp"
+#include "chocopy_incremental.hpp"
+#include "chocopy_semant.hpp"
+
+using namespace parser;
+using parser::ByteReader;
+using parser::ByteWriter;
+using std::unique_ptr;
+using std::unordered_map;
+using std::vector;
+
+namespace semantic {
+namespace {
+constexpr string_view magic = "ASTB";
+constexpr unsigned version = 3;
+
+enum class TypeTag : uint8_t {
+    ClassValue,
+    ListValue,
+    FunctionDef,
+    ClassDef,
+    Ref,
+    NonlocalRef,
+    GlobalRef
+};
+
+/** Expressions come with their inferred type and statements with is_return,
+ * so each of them is in a range of its own. */
+enum class NodeTag : uint8_t {
+    Null,
+    BinaryExpr,
+    BoolLiteral,
+    CallExpr,
+    Ident,
+    IfExpr,
+    IndexExpr,
+    IntegerLiteral,
+    ListExpr,
+    MemberExpr,
+    MethodCallExpr,
+    NoneLiteral,
+    StringLiteral,
+    UnaryExpr,
+    AssignStmt,
+    ExprStmt,
+    ForStmt,
+    IfStmt,
+    PassStmt,
+    ReturnStmt,
+    WhileStmt,
+    ClassDef,
+    ClassType,
+    FuncDef,
+    GlobalDecl,
+    ListType,
+    NonlocalDecl,
+    TypedVar,
+    VarDef,
+    CompilerErr,
+    SemanticError,
+    Errors
+};
+
+bool is_expr(NodeTag tag) {
+    return tag >= NodeTag::BinaryExpr && tag <= NodeTag::UnaryExpr;
+}
+
+bool is_stmt(NodeTag tag) {
+    return tag >= NodeTag::AssignStmt && tag <= NodeTag::WhileStmt;
+}
+
+class Writer : public ast::Visitor {
+   public:
+    string write(Program *program, uint64_t key, string_view source);
+
+    void visit(AssignStmt &) override;
+    void visit(Program &) override;
+    void visit(PassStmt &) override;
+    void visit(BinaryExpr &) override;
+    void visit(BoolLiteral &) override;
+    void visit(CallExpr &) override;
+    void visit(ClassDef &) override;
+    void visit(ClassType &) override;
+    void visit(ExprStmt &) override;
+    void visit(ForStmt &) override;
+    void visit(FuncDef &) override;
+    void visit(GlobalDecl &) override;
+    void visit(Ident &) override;
+    void visit(IfExpr &) override;
+    void visit(IndexExpr &) override;
+    void visit(IntegerLiteral &) override;
+    void visit(ListExpr &) override;
+    void visit(ListType &) override;
+    void visit(MemberExpr &) override;
+    void visit(IfStmt &) override;
+    void visit(MethodCallExpr &) override;
+    void visit(NoneLiteral &) override;
+    void visit(NonlocalDecl &) override;
+    void visit(ReturnStmt &) override;
+    void visit(StringLiteral &) override;
+    void visit(TypeAnnotation &) override;
+    void visit(TypedVar &) override;
+    void visit(UnaryExpr &) override;
+    void visit(VarDef &) override;
+    void visit(WhileStmt &) override;
+    void visit(Errors &) override;
+    /** Compiler and semantic errors. */
+    void visit(Node &) override;
+
+   private:
+    unsigned string_id(string_view s);
+    /** Numbers type and everything it refers to, the first time. */
+    void collect(SymbolType *type);
+    void collect(const SymbolTable &table);
+    /** 0 for null, else the index of the type plus one. */
+    void put_type(ByteWriter &out, SymbolType *type);
+    /** 0 for null, 1 for the global scope, else the index of the type the
+     * scope belongs to plus two. */
+    void put_table(ByteWriter &out, const SymbolTable *table);
+    void put_scope(ByteWriter &out, const SymbolTable &table);
+    void put_type_shell(SymbolType *type);
+    void put_type_body(SymbolType *type);
+
+    void put_location(const Location &location);
+    void put_node(Node *node);
+    template <typename T>
+    void put_nodes(const vector<unique_ptr<T>> &nodes);
+    void put_header(Node &node, NodeTag tag);
+    void put_expr(Expr &node, NodeTag tag);
+    void put_stmt(Stmt &node, NodeTag tag);
+
+    Program *program_ = nullptr;
+    ByteWriter strings_, types_, type_bodies_, tree_;
+    unordered_map<string, unsigned> string_ids_;
+    unordered_map<const SymbolType *, unsigned> type_ids_;
+    vector<SymbolType *> types_list_;
+    unordered_map<const SymbolTable *, unsigned> scope_owners_;
+};
+
+unsigned Writer::string_id(string_view s) {
+    auto [it, inserted] = string_ids_.emplace(s, string_ids_.size());
+    if (inserted) {
+        strings_.put_uint(s.size());
+        for (auto ch : s) strings_.put_byte(static_cast<uint8_t>(ch));
+    }
+    return it->second;
+}
+
+void Writer::collect(SymbolType *type) {
+    if (type == nullptr || type_ids_.contains(type)) return;
+    auto id = types_list_.size();
+    type_ids_.emplace(type, id);
+    types_list_.push_back(type);
+    if (auto list = dynamic_cast<ListValueType *>(type)) {
+        collect(list->element_type.get());
+    } else if (auto func = dynamic_cast<FunctionDefType *>(type)) {
+        scope_owners_.emplace(&func->current_scope, id);
+        collect(func->return_type.get());
+        for (auto &param : func->params) collect(param.get());
+        collect(func->current_scope);
+    } else if (auto class_def = dynamic_cast<ClassDefType *>(type)) {
+        scope_owners_.emplace(&class_def->current_scope, id);
+        collect(class_def->current_scope);
+    }
+}
+
+void Writer::collect(const SymbolTable &table) {
+    for (auto &[name, type] : table.tab) collect(type.get());
+}
+
+void Writer::put_type(ByteWriter &out, SymbolType *type) {
+    collect(type);
+    out.put_uint(type == nullptr ? 0 : type_ids_.at(type) + 1);
+}
+
+void Writer::put_table(ByteWriter &out, const SymbolTable *table) {
+    if (table == &program_->symbol_table) return out.put_uint(1);
+    auto it = scope_owners_.find(table);
+    out.put_uint(it == scope_owners_.end() ? 0 : it->second + 2);
+}
+
+void Writer::put_scope(ByteWriter &out, const SymbolTable &table) {
+    put_table(out, table.parent);
+    out.put_uint(table.tab.size());
+    for (auto &[name, type] : table.tab) {
+        out.put_uint(string_id(name.str()));
+        put_type(out, type.get());
+    }
+}
+
+void Writer::put_type_shell(SymbolType *type) {
+    if (auto ref = dynamic_cast<RefType *>(type)) {
+        auto tag = TypeTag::Ref;
+        if (dynamic_cast<GlobalRefType *>(type)) tag = TypeTag::GlobalRef;
+        if (dynamic_cast<NonlocalRefType *>(type)) tag = TypeTag::NonlocalRef;
+        types_.put_byte(static_cast<uint8_t>(tag));
+        types_.put_uint(string_id(ref->name));
+    } else if (auto value = dynamic_cast<ClassValueType *>(type)) {
+        types_.put_byte(static_cast<uint8_t>(TypeTag::ClassValue));
+        types_.put_uint(string_id(value->class_name));
+    } else if (dynamic_cast<ListValueType *>(type)) {
+        types_.put_byte(static_cast<uint8_t>(TypeTag::ListValue));
+    } else if (auto func = dynamic_cast<FunctionDefType *>(type)) {
+        types_.put_byte(static_cast<uint8_t>(TypeTag::FunctionDef));
+        types_.put_uint(string_id(func->func_name));
+        types_.put_byte(func->is_method);
+    } else if (auto class_def = dynamic_cast<ClassDefType *>(type)) {
+        types_.put_byte(static_cast<uint8_t>(TypeTag::ClassDef));
+        types_.put_uint(string_id(class_def->super_class));
+        types_.put_uint(string_id(class_def->class_name));
+        types_.put_uint(class_def->inherit_members.size());
+        for (auto &member : class_def->inherit_members) {
+            types_.put_uint(string_id(member));
+        }
+    } else {
+        abort();
+    }
+}
+
+void Writer::put_type_body(SymbolType *type) {
+    if (auto list = dynamic_cast<ListValueType *>(type)) {
+        put_type(type_bodies_, list->element_type.get());
+    } else if (auto func = dynamic_cast<FunctionDefType *>(type)) {
+        put_type(type_bodies_, func->return_type.get());
+        type_bodies_.put_uint(func->params.size());
+        for (auto &param : func->params) put_type(type_bodies_, param.get());
+        put_scope(type_bodies_, func->current_scope);
+    } else if (auto class_def = dynamic_cast<ClassDefType *>(type)) {
+        put_scope(type_bodies_, class_def->current_scope);
+    }
+}
+
+void Writer::put_location(const Location &location) {
+    tree_.put_int(location.first.line);
+    tree_.put_int(location.first.column);
+    tree_.put_int(location.last.line);
+    tree_.put_int(location.last.column);
+}
+
+void Writer::put_node(Node *node) {
+    if (node == nullptr) {
+        return tree_.put_byte(static_cast<uint8_t>(NodeTag::Null));
+    }
+    node->accept(*this);
+}
+
+template <typename T>
+void Writer::put_nodes(const vector<unique_ptr<T>> &nodes) {
+    tree_.put_uint(nodes.size());
+    for (auto &node : nodes) {
+        if (node == nullptr) {
+            tree_.put_byte(static_cast<uint8_t>(NodeTag::Null));
+        } else {
+            node->accept(*this);
+        }
+    }
+}
+
+void Writer::put_header(Node &node, NodeTag tag) {
+    tree_.put_byte(static_cast<uint8_t>(tag));
+    put_location(node.location);
+    tree_.put_uint(string_id(node.typeError));
+}
+
+void Writer::put_expr(Expr &node, NodeTag tag) {
+    put_header(node, tag);
+    put_type(tree_, node.inferredType.get());
+}
+
+void Writer::put_stmt(Stmt &node, NodeTag tag) {
+    put_header(node, tag);
+    tree_.put_byte(node.is_return);
+}
+
+void Writer::visit(BinaryExpr &node) {
+    put_expr(node, NodeTag::BinaryExpr);
+    put_node(node.left.get());
+    tree_.put_uint(string_id(node.operator_));
+    put_node(node.right.get());
+}
+
+void Writer::visit(BoolLiteral &node) {
+    put_expr(node, NodeTag::BoolLiteral);
+    tree_.put_byte(node.bin_value);
+}
+
+void Writer::visit(CallExpr &node) {
+    put_expr(node, NodeTag::CallExpr);
+    put_node(node.function.get());
+    put_nodes(node.args);
+}
+
+void Writer::visit(Ident &node) {
+    put_expr(node, NodeTag::Ident);
+    tree_.put_uint(string_id(node.name.str()));
+}
+
+void Writer::visit(IfExpr &node) {
+    put_expr(node, NodeTag::IfExpr);
+    put_node(node.condition.get());
+    put_node(node.thenExpr.get());
+    put_node(node.elseExpr.get());
+}
+
+void Writer::visit(IndexExpr &node) {
+    put_expr(node, NodeTag::IndexExpr);
+    put_node(node.list.get());
+    put_node(node.index.get());
+}
+
+void Writer::visit(IntegerLiteral &node) {
+    put_expr(node, NodeTag::IntegerLiteral);
+    tree_.put_int(node.value);
+}
+
+void Writer::visit(ListExpr &node) {
+    put_expr(node, NodeTag::ListExpr);
+    put_nodes(node.elements);
+}
+
+void Writer::visit(MemberExpr &node) {
+    put_expr(node, NodeTag::MemberExpr);
+    put_node(node.object.get());
+    put_node(node.member.get());
+    tree_.put_byte(node.is_function_call);
+}
+
+void Writer::visit(MethodCallExpr &node) {
+    put_expr(node, NodeTag::MethodCallExpr);
+    put_node(node.method.get());
+    put_nodes(node.args);
+}
+
+void Writer::visit(NoneLiteral &node) { put_expr(node, NodeTag::NoneLiteral); }
+
+void Writer::visit(StringLiteral &node) {
+    put_expr(node, NodeTag::StringLiteral);
+    tree_.put_uint(string_id(node.value));
+}
+
+void Writer::visit(UnaryExpr &node) {
+    put_expr(node, NodeTag::UnaryExpr);
+    tree_.put_uint(string_id(node.operator_));
+    put_node(node.operand.get());
+}
+
+void Writer::visit(AssignStmt &node) {
+    put_stmt(node, NodeTag::AssignStmt);
+    put_nodes(node.targets);
+    put_node(node.value.get());
+}
+
+void Writer::visit(ExprStmt &node) {
+    put_stmt(node, NodeTag::ExprStmt);
+    put_node(node.expr.get());
+}
+
+void Writer::visit(ForStmt &node) {
+    put_stmt(node, NodeTag::ForStmt);
+    put_node(node.identifier.get());
+    put_node(node.iterable.get());
+    put_nodes(node.body);
+}
+
+void Writer::visit(IfStmt &node) {
+    put_stmt(node, NodeTag::IfStmt);
+    tree_.put_byte(node.el);
+    put_node(node.condition.get());
+    put_nodes(node.thenBody);
+    put_nodes(node.elseBody);
+    put_node(node.elifBody.get());
+}
+
+/** Both of its Node halves, as either may be in the tree. */
+void Writer::visit(PassStmt &node) {
+    put_stmt(node, NodeTag::PassStmt);
+    auto &decl = static_cast<Decl &>(node);
+    put_location(decl.location);
+    tree_.put_uint(string_id(decl.typeError));
+}
+
+void Writer::visit(ReturnStmt &node) {
+    put_stmt(node, NodeTag::ReturnStmt);
+    put_node(node.value.get());
+}
+
+void Writer::visit(WhileStmt &node) {
+    put_stmt(node, NodeTag::WhileStmt);
+    put_node(node.condition.get());
+    put_nodes(node.body);
+}
+
+void Writer::visit(ClassDef &node) {
+    put_header(node, NodeTag::ClassDef);
+    put_node(node.name.get());
+    put_node(node.superClass.get());
+    put_nodes(node.declaration);
+}
+
+void Writer::visit(ClassType &node) {
+    put_header(node, NodeTag::ClassType);
+    tree_.put_uint(string_id(node.className.str()));
+}
+
+void Writer::visit(FuncDef &node) {
+    put_header(node, NodeTag::FuncDef);
+    put_node(node.name.get());
+    put_nodes(node.params);
+    put_node(node.returnType.get());
+    put_nodes(node.declarations);
+    put_nodes(node.statements);
+    tree_.put_uint(node.lambda_params.size());
+    for (auto &name : node.lambda_params) tree_.put_uint(string_id(name));
+}
+
+void Writer::visit(GlobalDecl &node) {
+    put_header(node, NodeTag::GlobalDecl);
+    put_node(node.variable.get());
+}
+
+void Writer::visit(ListType &node) {
+    put_header(node, NodeTag::ListType);
+    put_node(node.elementType.get());
+}
+
+void Writer::visit(NonlocalDecl &node) {
+    put_header(node, NodeTag::NonlocalDecl);
+    put_node(node.variable.get());
+}
+
+void Writer::visit(TypeAnnotation &) { abort(); }
+
+void Writer::visit(TypedVar &node) {
+    put_header(node, NodeTag::TypedVar);
+    put_node(node.identifier.get());
+    put_node(node.type.get());
+}
+
+void Writer::visit(VarDef &node) {
+    put_header(node, NodeTag::VarDef);
+    put_node(node.var.get());
+    put_node(node.value.get());
+}
+
+void Writer::visit(Errors &node) {
+    put_header(node, NodeTag::Errors);
+    put_nodes(node.compiler_errors);
+}
+
+void Writer::visit(Node &node) {
+    auto error = dynamic_cast<CompilerErr *>(&node);
+    if (error == nullptr) abort();
+    put_header(node, dynamic_cast<SemanticError *>(error)
+                         ? NodeTag::SemanticError
+                         : NodeTag::CompilerErr);
+    tree_.put_uint(string_id(error->message));
+    tree_.put_byte(error->syntax);
+}
+
+void Writer::visit(Program &node) {
+    put_location(node.location);
+    tree_.put_uint(string_id(node.typeError));
+    tree_.put_byte(node.type_checked);
+    put_nodes(node.declarations);
+    put_nodes(node.statements);
+    put_node(node.errors.get());
+}
+
+string Writer::write(Program *program, uint64_t key, string_view source) {
+    program_ = program;
+    collect(program->symbol_table);
+    program->accept(*this);
+    for (auto type : types_list_) put_type_shell(type);
+    for (auto type : types_list_) put_type_body(type);
+
+    ByteWriter globals;
+    put_scope(globals, program->symbol_table);
+    auto &classes = program->hierachy_tree.classes();
+    globals.put_uint(classes.size());
+    for (auto &[name, info] : classes) {
+        globals.put_uint(string_id(name.str()));
+        globals.put_uint(string_id(info.super_class.str()));
+    }
+
+    ByteWriter out;
+    for (auto ch : magic) out.put_byte(ch);
+    out.put_uint(version);
+    out.put_fixed64(key);
+    out.put_uint(source.size());
+    out.put_bytes(source);
+    out.put_uint(string_ids_.size());
+    out.append(strings_);
+    out.put_uint(types_list_.size());
+    out.append(types_);
+    out.append(type_bodies_);
+    out.append(globals);
+    out.append(tree_);
+    return out.bytes();
+}
+
+/** The fields every node starts with. */
+struct Header {
+    Location location;
+    string type_error;
+    shared_ptr<SymbolType> inferred_type;
+    bool is_return = false;
+};
+
+class Reader {
+   public:
+    explicit Reader(string_view data) : in_(data) {}
+    unique_ptr<Program> read(uint64_t key);
+
+   private:
+    string_view get_view() {
+        auto idx = in_.get_index(strings_.size());
+        return in_.ok() ? strings_[idx] : string_view();
+    }
+    string get_string() { return string(get_view()); }
+    shared_ptr<SymbolType> get_type();
+    shared_ptr<ValueType> get_value_type();
+    SymbolTable *get_table();
+    void read_types();
+    void read_scope(SymbolTable &table);
+    void read_hierarchy(HierachyTree &hierarchy);
+
+    Location get_location();
+    Node *get_node();
+    /** The next node, which has to be a T or null. */
+    template <typename T>
+    unique_ptr<T> get_node();
+    template <typename T>
+    vector<unique_ptr<T>> get_nodes();
+    template <typename T>
+    Node *finish(Header &header, T *node);
+
+    ByteReader in_;
+    Program *program_ = nullptr;
+    /** views into the data: strings are only copied into the nodes */
+    vector<string_view> strings_;
+    vector<shared_ptr<SymbolType>> types_;
+};
+
+shared_ptr<SymbolType> Reader::get_type() {
+    auto idx = in_.get_index(types_.size() + 1);
+    return in_.ok() && idx > 0 ? types_[idx - 1] : nullptr;
+}
+
+shared_ptr<ValueType> Reader::get_value_type() {
+    auto type = get_type();
+    auto value = std::dynamic_pointer_cast<ValueType>(type);
+    if (type != nullptr && value == nullptr) in_.fail();
+    return value;
+}
+
+SymbolTable *Reader::get_table() {
+    auto idx = in_.get_index(types_.size() + 2);
+    if (!in_.ok() || idx == 0) return nullptr;
+    if (idx == 1) return &program_->symbol_table;
+    auto type = types_[idx - 2].get();
+    if (auto func = dynamic_cast<FunctionDefType *>(type)) {
+        return &func->current_scope;
+    }
+    if (auto class_def = dynamic_cast<ClassDefType *>(type)) {
+        return &class_def->current_scope;
+    }
+    in_.fail();
+    return nullptr;
+}
+
+void Reader::read_types() {
+    auto n = in_.get_count();
+    for (size_t i = 0; i < n && in_.ok(); i++) {
+        shared_ptr<SymbolType> type;
+        switch (static_cast<TypeTag>(in_.get_byte())) {
+            case TypeTag::ClassValue:
+                type = std::make_shared<ClassValueType>(get_string());
+                break;
+            case TypeTag::ListValue:
+                type = std::make_shared<ListValueType>(shared_ptr<ValueType>());
+                break;
+            case TypeTag::FunctionDef: {
+                auto func = std::make_shared<FunctionDefType>();
+                func->func_name = get_string();
+                func->is_method = in_.get_byte();
+                type = func;
+                break;
+            }
+            case TypeTag::ClassDef: {
+                auto super_class = get_string();
+                auto class_def =
+                    std::make_shared<ClassDefType>(super_class, get_string());
+                auto num_members = in_.get_count();
+                for (size_t j = 0; j < num_members && in_.ok(); j++) {
+                    class_def->inherit_members.push_back(get_string());
+                }
+                type = class_def;
+                break;
+            }
+            case TypeTag::Ref:
+                type = std::make_shared<RefType>(get_string());
+                break;
+            case TypeTag::NonlocalRef:
+                type = std::make_shared<NonlocalRefType>(get_string());
+                break;
+            case TypeTag::GlobalRef:
+                type = std::make_shared<GlobalRefType>(get_string());
+                break;
+            default:
+                in_.fail();
+        }
+        types_.push_back(type);
+    }
+
+    for (auto &type : types_) {
+        if (!in_.ok()) return;
+        if (auto list = dynamic_cast<ListValueType *>(type.get())) {
+            list->element_type = get_value_type();
+        } else if (auto func = dynamic_cast<FunctionDefType *>(type.get())) {
+            func->return_type = get_value_type();
+            auto num_params = in_.get_count();
+            for (size_t j = 0; j < num_params && in_.ok(); j++) {
+                func->params.push_back(get_type());
+            }
+            read_scope(func->current_scope);
+        } else if (auto class_def = dynamic_cast<ClassDefType *>(type.get())) {
+            read_scope(class_def->current_scope);
+        }
+    }
+}
+
+void Reader::read_scope(SymbolTable &table) {
+    table.parent = get_table();
+    auto n = in_.get_count();
+    for (size_t i = 0; i < n && in_.ok(); i++) {
+        auto name = Symbol(get_view());
+        table.put(name, get_type());
+    }
+}
+
+/** The classes a new tree starts with are already there. The others come
+ * after their super class, as they were added. */
+void Reader::read_hierarchy(HierachyTree &hierarchy) {
+    auto n = in_.get_count();
+    for (size_t i = 0; i < n && in_.ok(); i++) {
+        auto name = Symbol(get_view());
+        auto super_class = Symbol(get_view());
+        if (!in_.ok() || hierarchy.classes().contains(name)) continue;
+        if (!hierarchy.classes().contains(super_class)) return in_.fail();
+        hierarchy.add_class(name, super_class);
+    }
+}
+
+Location Reader::get_location() {
+    int first_line = in_.get_int();
+    int first_column = in_.get_int();
+    int last_line = in_.get_int();
+    int last_column = in_.get_int();
+    return Location(LocationUnit(first_line, first_column),
+                    LocationUnit(last_line, last_column));
+}
+
+template <typename T>
+unique_ptr<T> Reader::get_node() {
+    auto node = get_node();
+    if (node == nullptr) return nullptr;
+    auto typed = dynamic_cast<T *>(node);
+    if (typed == nullptr) {
+        delete node;
+        in_.fail();
+    }
+    return unique_ptr<T>(typed);
+}
+
+template <typename T>
+vector<unique_ptr<T>> Reader::get_nodes() {
+    vector<unique_ptr<T>> nodes;
+    auto n = in_.get_count();
+    for (size_t i = 0; i < n && in_.ok(); i++) {
+        nodes.push_back(get_node<T>());
+    }
+    return nodes;
+}
+
+template <typename T>
+Node *Reader::finish(Header &header, T *node) {
+    if constexpr (std::is_base_of_v<Expr, T>) {
+        node->inferredType = std::move(header.inferred_type);
+    }
+    if constexpr (std::is_base_of_v<Stmt, T>) {
+        node->is_return = header.is_return;
+        node->Stmt::typeError = std::move(header.type_error);
+        return static_cast<Stmt *>(node);
+    } else {
+        node->typeError = std::move(header.type_error);
+        return node;
+    }
+}
+
+Node *Reader::get_node() {
+    auto tag = static_cast<NodeTag>(in_.get_byte());
+    if (tag == NodeTag::Null || !in_.ok()) return nullptr;
+    Header h;
+    h.location = get_location();
+    h.type_error = get_string();
+    if (is_expr(tag)) h.inferred_type = get_type();
+    if (is_stmt(tag)) h.is_return = in_.get_byte();
+    if (!in_.ok()) return nullptr;
+
+    switch (tag) {
+        case NodeTag::BinaryExpr: {
+            auto left = get_node<Expr>();
+            auto op = get_string();
+            auto right = get_node<Expr>();
+            return finish(h, new BinaryExpr(h.location, left.release(), op,
+                                            right.release()));
+        }
+        case NodeTag::BoolLiteral:
+            return finish(h, new BoolLiteral(h.location, in_.get_byte()));
+        case NodeTag::CallExpr: {
+            auto function = get_node<Ident>();
+            auto args = get_nodes<Expr>();
+            return finish(h, new CallExpr(h.location, function.release(),
+                                          new vector(std::move(args))));
+        }
+        case NodeTag::Ident:
+            return finish(h, new Ident(h.location, Symbol(get_view())));
+        case NodeTag::IfExpr: {
+            auto condition = get_node<Expr>();
+            auto then_expr = get_node<Expr>();
+            auto else_expr = get_node<Expr>();
+            return finish(h, new IfExpr(h.location, condition.release(),
+                                        then_expr.release(),
+                                        else_expr.release()));
+        }
+        case NodeTag::IndexExpr: {
+            auto list = get_node<Expr>();
+            auto index = get_node<Expr>();
+            return finish(h, new IndexExpr(h.location, list.release(),
+                                           index.release()));
+        }
+        case NodeTag::IntegerLiteral:
+            return finish(h, new IntegerLiteral(h.location, in_.get_int()));
+        case NodeTag::ListExpr: {
+            auto elements = get_nodes<Expr>();
+            return finish(h, new ListExpr(h.location,
+                                          new vector(std::move(elements))));
+        }
+        case NodeTag::MemberExpr: {
+            auto object = get_node<Expr>();
+            auto member = get_node<Ident>();
+            auto node =
+                new MemberExpr(h.location, object.release(), member.release());
+            node->is_function_call = in_.get_byte();
+            return finish(h, node);
+        }
+        case NodeTag::MethodCallExpr: {
+            auto method = get_node<MemberExpr>();
+            auto args = get_nodes<Expr>();
+            return finish(h, new MethodCallExpr(h.location, method.release(),
+                                                new vector(std::move(args))));
+        }
+        case NodeTag::NoneLiteral:
+            return finish(h, new NoneLiteral(h.location));
+        case NodeTag::StringLiteral:
+            return finish(h, new StringLiteral(h.location, get_string()));
+        case NodeTag::UnaryExpr: {
+            auto op = get_string();
+            auto operand = get_node<Expr>();
+            return finish(h, new UnaryExpr(h.location, op, operand.release()));
+        }
+        case NodeTag::AssignStmt: {
+            auto targets = get_nodes<Expr>();
+            auto value = get_node<Expr>();
+            auto node = new AssignStmt(h.location, nullptr, value.release());
+            node->targets = std::move(targets);
+            return finish(h, node);
+        }
+        case NodeTag::ExprStmt:
+            return finish(h,
+                          new ExprStmt(h.location, get_node<Expr>().release()));
+        case NodeTag::ForStmt: {
+            auto identifier = get_node<Ident>();
+            auto iterable = get_node<Expr>();
+            auto body = get_nodes<Stmt>();
+            return finish(h, new ForStmt(h.location, identifier.release(),
+                                         iterable.release(),
+                                         new vector(std::move(body))));
+        }
+        case NodeTag::IfStmt: {
+            char el = static_cast<char>(in_.get_byte());
+            auto condition = get_node<Expr>();
+            auto then_body = get_nodes<Stmt>();
+            auto else_body = get_nodes<Stmt>();
+            auto elif_body = get_node<IfStmt>();
+            auto node = new IfStmt(h.location, condition.release(),
+                                   new vector(std::move(then_body)));
+            node->el = el;
+            node->elseBody = std::move(else_body);
+            node->elifBody = std::move(elif_body);
+            return finish(h, node);
+        }
+        case NodeTag::PassStmt: {
+            auto node = new PassStmt(h.location);
+            auto &decl = static_cast<Decl &>(*node);
+            decl.location = get_location();
+            decl.typeError = get_string();
+            return finish(h, node);
+        }
+        case NodeTag::ReturnStmt:
+            return finish(h, new ReturnStmt(h.location,
+                                            get_node<Expr>().release()));
+        case NodeTag::WhileStmt: {
+            auto condition = get_node<Expr>();
+            auto body = get_nodes<Stmt>();
+            return finish(h, new WhileStmt(h.location, condition.release(),
+                                           new vector(std::move(body))));
+        }
+        case NodeTag::ClassDef: {
+            auto name = get_node<Ident>();
+            auto super_class = get_node<Ident>();
+            auto declarations = get_nodes<Decl>();
+            return finish(h, new ClassDef(h.location, name.release(),
+                                          super_class.release(),
+                                          new vector(std::move(declarations))));
+        }
+        case NodeTag::ClassType:
+            return finish(h, new ClassType(h.location, Symbol(get_view())));
+        case NodeTag::FuncDef: {
+            auto name = get_node<Ident>();
+            auto params = get_nodes<TypedVar>();
+            auto return_type = get_node<TypeAnnotation>();
+            auto declarations = get_nodes<Decl>();
+            auto statements = get_nodes<Stmt>();
+            auto node = new FuncDef(h.location, name.release(),
+                                    new vector(std::move(params)),
+                                    return_type.release(),
+                                    new vector(std::move(declarations)),
+                                    new vector(std::move(statements)));
+            auto num_captured = in_.get_count();
+            for (size_t i = 0; i < num_captured && in_.ok(); i++) {
+                node->lambda_params.push_back(get_string());
+            }
+            return finish(h, node);
+        }
+        case NodeTag::GlobalDecl:
+            return finish(h, new GlobalDecl(h.location,
+                                            get_node<Ident>().release()));
+        case NodeTag::ListType: {
+            auto element = get_node<TypeAnnotation>();
+            return finish(h, new ListType(h.location, element.release()));
+        }
+        case NodeTag::NonlocalDecl:
+            return finish(h, new NonlocalDecl(h.location,
+                                              get_node<Ident>().release()));
+        case NodeTag::TypedVar: {
+            auto identifier = get_node<Ident>();
+            auto type = get_node<TypeAnnotation>();
+            return finish(h, new TypedVar(h.location, identifier.release(),
+                                          type.release()));
+        }
+        case NodeTag::VarDef: {
+            auto var = get_node<TypedVar>();
+            auto value = get_node<Literal>();
+            return finish(
+                h, new VarDef(h.location, var.release(), value.release()));
+        }
+        case NodeTag::CompilerErr: {
+            auto message = get_string();
+            bool syntax = in_.get_byte();
+            return finish(h, new CompilerErr(h.location, message, syntax));
+        }
+        case NodeTag::SemanticError: {
+            auto message = get_string();
+            auto node = new SemanticError(h.location, message);
+            node->syntax = in_.get_byte();
+            return finish(h, node);
+        }
+        case NodeTag::Errors: {
+            auto node = new Errors(h.location);
+            node->compiler_errors = get_nodes<CompilerErr>();
+            return finish(h, node);
+        }
+        default:
+            in_.fail();
+            return nullptr;
+    }
+}
+
+unique_ptr<Program> Reader::read(uint64_t key) {
+    if (in_.get_bytes(magic.size()) != magic || in_.get_uint() != version ||
+        in_.get_fixed64() != key || !in_.ok()) {
+        return nullptr;
+    }
+    in_.get_bytes(in_.get_uint());
+    auto num_strings = in_.get_count();
+    for (size_t i = 0; i < num_strings && in_.ok(); i++) {
+        strings_.push_back(in_.get_bytes(in_.get_uint()));
+    }
+    if (!in_.ok()) return nullptr;
+
+    auto arena = std::make_shared<Arena>();
+    Arena::Scope scope(arena.get());
+    auto program = std::make_unique<Program>(Location());
+    program->arena = arena;
+    program_ = program.get();
+
+    read_types();
+    read_scope(program->symbol_table);
+    read_hierarchy(program->hierachy_tree);
+
+    program->location = get_location();
+    program->typeError = get_string();
+    program->type_checked = in_.get_byte();
+    program->declarations = get_nodes<Decl>();
+    program->statements = get_nodes<Stmt>();
+    program->errors = get_node<Errors>();
+    if (!in_.ok() || !in_.at_end() || program->errors == nullptr) {
+        return nullptr;
+    }
+    return program;
+}
+
+/** Calls read on the contents of the file at path, mapped for the time of
+ * the call. A file that is missing or empty reads as null. */
+template <typename F>
+auto read_mapped(const string &path, F read) {
+    decltype(read(string_view())) result{};
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return result;
+    struct stat st {};
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        auto size = static_cast<size_t>(st.st_size);
+        void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            result = read(string_view(static_cast<char *>(data), size));
+            munmap(data, size);
+        }
+    }
+    close(fd);
+    return result;
+}
+
+/** The cache key of source, for this build of the compiler. */
+uint64_t key_of(string_view source) {
+    return parser::hash_bytes(parser::build_id, parser::hash_bytes(source));
+}
+
+void analyze(Program &tree) {
+    if (tree.errors->compiler_errors.size() == 0) {
+        auto symboltableGenerator = SymbolTableGenerator(tree);
+        tree.accept(symboltableGenerator);
+    }
+    if (tree.errors->compiler_errors.size() == 0) {
+        auto declarationAnalyzer = DeclarationAnalyzer(tree);
+        tree.accept(declarationAnalyzer);
+    }
+    if (tree.errors->compiler_errors.size() == 0) {
+        auto typeChecker = TypeChecker(tree);
+        tree.accept(typeChecker);
+    }
+}
+}  // namespace
+
+string write_ast(Program *program, uint64_t key, string_view source) {
+    return Writer().write(program, key, source);
+}
+
+bool write_ast_file(Program *program, const string &path, uint64_t key,
+                    string_view source) {
+    return parser::write_file_atomically(path,
+                                         write_ast(program, key, source));
+}
+
+unique_ptr<Program> read_ast(string_view data, uint64_t key) {
+    return Reader(data).read(key);
+}
+
+unique_ptr<Program> read_ast_file(const string &path, uint64_t key) {
+    return read_mapped(path,
+                       [key](string_view data) { return read_ast(data, key); });
+}
+
+string_view read_ast_source(string_view data) {
+    ByteReader in(data);
+    if (in.get_bytes(magic.size()) != magic || in.get_uint() != version) {
+        return {};
+    }
+    in.get_fixed64();
+    auto source = in.get_bytes(in.get_uint());
+    return in.ok() ? source : string_view();
+}
+
+unique_ptr<Program> check(const string &input_path, bool ast_cache,
+                          bool incremental) {
+    int fd = ast_cache || incremental ? open(input_path.c_str(), O_RDONLY)
+                                      : -1;
+    struct stat st {};
+    std::optional<MappedSource> mapped;
+    if (fd >= 0) {
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+            mapped.emplace(fd, st.st_size);
+        }
+        close(fd);
+    }
+    if (!mapped || !mapped->mapped()) {
+        // parse reports a file it cannot open
+        auto tree = parse(input_path.c_str());
+        analyze(*tree);
+        return tree;
+    }
+
+    // scanned in place below, and as it was again after that
+    auto source = mapped->text();
+    auto key = key_of(source);
+    auto cache_path = input_path + ".astb";
+    if (auto tree = read_ast_file(cache_path, key)) return tree;
+
+    unique_ptr<Program> tree;
+    if (incremental) {
+        // the program last written there, brought up to date
+        tree = read_mapped(cache_path, [&](string_view data) {
+            auto old_source = read_ast_source(data);
+            auto tree = read_ast(data, key_of(old_source));
+            if (tree && !recheck(*tree, old_source, source,
+                                 diff_lines(old_source, source), input_path)) {
+                tree = nullptr;
+            }
+            return tree;
+        });
+    }
+    if (tree == nullptr) {
+        tree = parse_buffer(mapped->base(), mapped->size(), input_path);
+        analyze(*tree);
+    }
+    // the next edit is diffed against this version, so that edits to two
+    // declarations in a row are each rechecked on their own
+    write_ast_file(tree.get(), cache_path, key, source);
+    return tree;
+}
+}  // namespace semantic
@@ -0,0 +1,496 @@
+#include "chocopy_incremental.hpp"
+
+#include <cassert>
+#include <memory>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#include "ClassDefType.hpp"
+#include "FunctionDefType.hpp"
+#include "ValueType.hpp"
+#include "chocopy_ast.hpp"
+#include "chocopy_semant.hpp"
+
+using namespace parser;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+namespace semantic {
+namespace {
+/** The offset of each line of text, then its size. */
+vector<size_t> line_starts(string_view text) {
+    vector<size_t> starts{0};
+    for (size_t i = 0; i + 1 < text.size(); i++) {
+        if (text[i] == '\n') starts.push_back(i + 1);
+    }
+    starts.push_back(text.size());
+    return starts;
+}
+
+/** Lines first to last of text, numbered from 1. */
+string_view lines(string_view text, const vector<size_t> &starts, int first,
+                  int last) {
+    return text.substr(starts[first - 1], starts[last] - starts[first - 1]);
+}
+
+/** Whether name appears in text as a whole name, outside the strings and
+ * the comments. */
+bool mentions(string_view text, string_view name) {
+    auto is_name = [](char ch) {
+        return ch == '_' || (ch >= 'a' && ch <= 'z') ||
+               (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9');
+    };
+    size_t at = 0;
+    while (at < text.size()) {
+        if (text[at] == '#') {
+            at = text.find('\n', at);
+            if (at == string_view::npos) break;
+        } else if (text[at] == '"') {
+            /** up to the closing quote, which a string has on its line */
+            at++;
+            while (at < text.size() && text[at] != '"' && text[at] != '\n')
+                at += text[at] == '\\' ? 2 : 1;
+            at++;
+        } else if (is_name(text[at])) {
+            auto start = at;
+            while (at < text.size() && is_name(text[at])) at++;
+            if (text.substr(start, at - start) == name) return true;
+        } else {
+            at++;
+        }
+    }
+    return false;
+}
+
+/** Unlike FunctionDefType::==, which is for overriding, also compares the
+ * first parameter, and the types themselves rather than their names. */
+bool same_signature(const FunctionDefType &a, const FunctionDefType &b) {
+    if (a.params.size() != b.params.size()) return false;
+    for (size_t i = 0; i < a.params.size(); i++) {
+        if (!a.params[i]->eq(b.params[i].get())) return false;
+    }
+    return a.return_type->eq(b.return_type.get());
+}
+
+/** The same names in the same order, with the same types. */
+bool same_members(const SymbolTable &a, const SymbolTable &b) {
+    if (a.tab.size() != b.tab.size()) return false;
+    auto other = b.tab.begin();
+    for (const auto &[name, type] : a.tab) {
+        const auto &[other_name, other_type] = *other++;
+        if (name != other_name) return false;
+        auto func = dynamic_cast<FunctionDefType *>(type.get());
+        auto other_func = dynamic_cast<FunctionDefType *>(other_type.get());
+        if (func || other_func) {
+            if (!func || !other_func || !same_signature(*func, *other_func)) {
+                return false;
+            }
+        } else if (!type->eq(other_type.get())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** Gives into the signature and scope of from, for a function the other
+ * parts refer to or a method whose object the subclasses share. The
+ * functions nested in it are moved along. */
+void transplant(FunctionDefType &into, FunctionDefType &from) {
+    into.params = std::move(from.params);
+    into.return_type = std::move(from.return_type);
+    into.current_scope.tab = std::move(from.current_scope.tab);
+    for (const auto &[name, type] : into.current_scope.tab) {
+        if (auto nested = dynamic_cast<FunctionDefType *>(type.get())) {
+            nested->current_scope.parent = &into.current_scope;
+        }
+    }
+}
+
+/** Moves every node it visits down by a number of lines. */
+class LineShift : public ast::ASTAnalyzer {
+   public:
+    explicit LineShift(int delta) : delta_(delta) {}
+
+    void shift(Location &location) {
+        location.first.line += delta_;
+        location.last.line += delta_;
+    }
+
+    void visit(BinaryExpr &node) override {
+        shift(node.location);
+        node.left->accept(*this);
+        node.right->accept(*this);
+    }
+    void visit(BoolLiteral &node) override { shift(node.location); }
+    void visit(CallExpr &node) override {
+        shift(node.location);
+        node.function->accept(*this);
+        visit_all(node.args);
+    }
+    void visit(Ident &node) override { shift(node.location); }
+    void visit(IfExpr &node) override {
+        shift(node.location);
+        node.condition->accept(*this);
+        node.thenExpr->accept(*this);
+        node.elseExpr->accept(*this);
+    }
+    void visit(IndexExpr &node) override {
+        shift(node.location);
+        node.list->accept(*this);
+        node.index->accept(*this);
+    }
+    void visit(IntegerLiteral &node) override { shift(node.location); }
+    void visit(ListExpr &node) override {
+        shift(node.location);
+        visit_all(node.elements);
+    }
+    void visit(MemberExpr &node) override {
+        shift(node.location);
+        node.object->accept(*this);
+        node.member->accept(*this);
+    }
+    void visit(MethodCallExpr &node) override {
+        shift(node.location);
+        node.method->accept(*this);
+        visit_all(node.args);
+    }
+    void visit(NoneLiteral &node) override { shift(node.location); }
+    void visit(StringLiteral &node) override { shift(node.location); }
+    void visit(UnaryExpr &node) override {
+        shift(node.location);
+        node.operand->accept(*this);
+    }
+    void visit(AssignStmt &node) override {
+        shift(node.location);
+        visit_all(node.targets);
+        node.value->accept(*this);
+    }
+    void visit(ExprStmt &node) override {
+        shift(node.location);
+        node.expr->accept(*this);
+    }
+    void visit(ForStmt &node) override {
+        shift(node.location);
+        node.identifier->accept(*this);
+        node.iterable->accept(*this);
+        visit_all(node.body);
+    }
+    void visit(IfStmt &node) override {
+        shift(node.location);
+        node.condition->accept(*this);
+        visit_all(node.thenBody);
+        visit_all(node.elseBody);
+        if (node.elifBody) node.elifBody->accept(*this);
+    }
+    /** Both of its Node halves, as either may be in the tree. */
+    void visit(PassStmt &node) override {
+        shift(static_cast<Stmt &>(node).location);
+        shift(static_cast<Decl &>(node).location);
+    }
+    void visit(ReturnStmt &node) override {
+        shift(node.location);
+        if (node.value) node.value->accept(*this);
+    }
+    void visit(WhileStmt &node) override {
+        shift(node.location);
+        node.condition->accept(*this);
+        visit_all(node.body);
+    }
+    void visit(ClassDef &node) override {
+        shift(node.location);
+        node.name->accept(*this);
+        node.superClass->accept(*this);
+        visit_all(node.declaration);
+    }
+    void visit(ClassType &node) override { shift(node.location); }
+    void visit(FuncDef &node) override {
+        shift(node.location);
+        node.name->accept(*this);
+        visit_all(node.params);
+        if (node.returnType) node.returnType->accept(*this);
+        visit_all(node.declarations);
+        visit_all(node.statements);
+    }
+    void visit(GlobalDecl &node) override {
+        shift(node.location);
+        node.variable->accept(*this);
+    }
+    void visit(ListType &node) override {
+        shift(node.location);
+        node.elementType->accept(*this);
+    }
+    void visit(NonlocalDecl &node) override {
+        shift(node.location);
+        node.variable->accept(*this);
+    }
+    void visit(TypedVar &node) override {
+        shift(node.location);
+        node.identifier->accept(*this);
+        node.type->accept(*this);
+    }
+    void visit(VarDef &node) override {
+        shift(node.location);
+        node.var->accept(*this);
+        node.value->accept(*this);
+    }
+
+   private:
+    template <typename T>
+    void visit_all(vector<unique_ptr<T>> &nodes) {
+        for (auto &node : nodes) node->accept(*this);
+    }
+
+    int delta_;
+};
+
+/** A top-level declaration, or the statements for index -1, with the lines
+ * it spans and the errors the type checker found in it. */
+struct Part {
+    int index;
+    int first, last;
+    vector<unique_ptr<CompilerErr>> errors;
+    bool parsed = false;
+};
+
+class Rechecker {
+   public:
+    Rechecker(Program &program, string_view old_source,
+              string_view new_source, const Edit &edit, string_view name)
+        : program_(program),
+          new_source_(new_source),
+          new_starts_(line_starts(new_source)),
+          old_lines_(static_cast<int>(line_starts(old_source).size()) - 1),
+          edit_(edit),
+          name_(name) {}
+
+    bool run();
+
+   private:
+    /** Splits the program and its errors into parts, in old lines. */
+    bool split();
+    Part *find(int line) {
+        for (auto &part : parts_) {
+            if (part.first <= line && line <= part.last) return &part;
+        }
+        return nullptr;
+    }
+    /** Parses, declares and checks part again from the new source. Sets
+     * changed if the type of a declaration changed. */
+    bool refresh(Part &part, bool &changed);
+    bool refresh(Part &part, unique_ptr<Decl> decl, bool &changed);
+    bool refresh_statements(Part &part, Program &snippet);
+    /** Errors before the type checker, which only a full check reports. */
+    bool clean() const { return program_.errors->compiler_errors.empty(); }
+
+    Program &program_;
+    string_view new_source_;
+    vector<size_t> new_starts_;
+    int old_lines_;
+    Edit edit_;
+    string_view name_;
+    vector<Part> parts_;
+};
+
+bool Rechecker::split() {
+    auto &declarations = program_.declarations;
+    auto &statements = program_.statements;
+    for (size_t i = 0; i < declarations.size(); i++) {
+        int first = declarations[i]->location.first.line;
+        if (!parts_.empty()) parts_.back().last = first - 1;
+        parts_.push_back(Part{static_cast<int>(i), first, old_lines_, {}});
+    }
+    if (!statements.empty() && !parts_.empty()) {
+        parts_.back().last = statements.front()->location.first.line - 1;
+    }
+    if (!statements.empty()) {
+        parts_.push_back(Part{-1, statements.front()->location.first.line,
+                              old_lines_, {}});
+    }
+    for (auto &part : parts_) {
+        if (part.first < 1 || part.first > part.last) return false;
+    }
+
+    auto &errors = program_.errors->compiler_errors;
+    for (auto &error : errors) {
+        if (find(error->location.first.line) == nullptr) return false;
+    }
+    for (auto &error : errors) {
+        find(error->location.first.line)->errors.push_back(std::move(error));
+    }
+    errors.clear();
+    return true;
+}
+
+bool Rechecker::refresh(Part &part, bool &changed) {
+    auto text = lines(new_source_, new_starts_, part.first, part.last);
+    auto snippet = parse_buffer(text, name_, program_.arena, part.first);
+    if (!snippet->errors->compiler_errors.empty()) return false;
+    part.parsed = true;
+    part.errors.clear();
+    if (part.index < 0) return refresh_statements(part, *snippet);
+    if (snippet->declarations.size() != 1 || !snippet->statements.empty()) {
+        return false;
+    }
+    return refresh(part, std::move(snippet->declarations.front()), changed);
+}
+
+bool Rechecker::refresh(Part &part, unique_ptr<Decl> decl, bool &changed) {
+    auto &old = program_.declarations[part.index];
+    auto name = decl->get_id()->name;
+    if (typeid(*decl) != typeid(*old) || name != old->get_id()->name) {
+        return false;
+    }
+    auto &global = program_.symbol_table;
+    SymbolTableGenerator generator(program_);
+    auto type = generator.declare(*decl);
+    if (type == nullptr || !clean()) return false;
+
+    if (dynamic_cast<FuncDef *>(decl.get())) {
+        // in place, as the other parts refer to the entry, e.g. by the
+        // inferredType of a call
+        auto old_func = global.declares<FunctionDefType>(name);
+        assert(old_func);
+        auto &func = static_cast<FunctionDefType &>(*type);
+        changed |= !same_signature(*old_func, func);
+        transplant(*old_func, func);
+    } else if (dynamic_cast<VarDef *>(decl.get())) {
+        if (!type->eq(global.declares(name))) {
+            changed = true;
+            global.put(name, type);
+        }
+    } else {
+        auto class_ = std::static_pointer_cast<ClassDefType>(type);
+        auto old_class = global.declares<ClassDefType>(name);
+        assert(old_class);
+        if (class_->super_class != old_class->super_class ||
+            !same_members(old_class->current_scope, class_->current_scope)) {
+            return false;
+        }
+        auto member = class_->current_scope.tab.begin();
+        for (const auto &entry : old_class->current_scope.tab) {
+            const auto &old_type = entry.second;
+            const auto &new_type = (member++)->second;
+            // an inherited method is the same object as before
+            auto method = dynamic_cast<FunctionDefType *>(old_type.get());
+            if (method && new_type != old_type) {
+                transplant(*method,
+                           static_cast<FunctionDefType &>(*new_type));
+            }
+        }
+    }
+
+    DeclarationAnalyzer analyzer(program_);
+    decl->accept(analyzer);
+    if (!clean()) return false;
+    TypeChecker checker(program_);
+    checker.errors = &part.errors;
+    decl->accept(checker);
+    old = std::move(decl);
+    return true;
+}
+
+bool Rechecker::refresh_statements(Part &part, Program &snippet) {
+    if (!snippet.declarations.empty() || snippet.statements.empty()) {
+        return false;
+    }
+    for (const auto &stmt : snippet.statements) {
+        if (dynamic_cast<ReturnStmt *>(stmt.get())) return false;
+    }
+    TypeChecker checker(program_);
+    checker.errors = &part.errors;
+    for (const auto &stmt : snippet.statements) stmt->accept(checker);
+    program_.statements = std::move(snippet.statements);
+    return true;
+}
+
+bool Rechecker::run() {
+    if (!program_.type_checked) return false;
+    if (edit_.removed == 0 && edit_.added == 0) return true;
+    if (!split()) return false;
+
+    // an insertion belongs to the part of the line before it
+    int first = edit_.removed ? edit_.line : edit_.line - 1;
+    int last = edit_.removed ? edit_.line + edit_.removed - 1 : first;
+    auto edited = find(first);
+    if (edited == nullptr || edited != find(last)) return false;
+
+    // from here on, the lines are those of the new source
+    auto delta = edit_.delta();
+    auto end = parts_.data() + parts_.size();
+    edited->last += delta;
+    for (auto part = edited + 1; part != end; part++) {
+        part->first += delta;
+        part->last += delta;
+    }
+    if (edited->first > edited->last) return false;
+
+    bool changed = false;
+    if (!refresh(*edited, changed)) return false;
+    if (changed) {
+        auto name = program_.declarations[edited->index]->get_id()->name;
+        for (auto &part : parts_) {
+            if (part.parsed) continue;
+            auto text = lines(new_source_, new_starts_, part.first, part.last);
+            if (!mentions(text, name.str())) continue;
+            bool also_changed = false;
+            if (!refresh(part, also_changed) || also_changed) return false;
+        }
+    }
+
+    LineShift shift(delta);
+    for (auto part = edited + 1; delta != 0 && part != end; part++) {
+        if (part->parsed) continue;
+        if (part->index < 0) {
+            for (auto &stmt : program_.statements) stmt->accept(shift);
+        } else {
+            program_.declarations[part->index]->accept(shift);
+        }
+        for (auto &error : part->errors) shift.shift(error->location);
+    }
+
+    auto &errors = program_.errors->compiler_errors;
+    for (auto &part : parts_) {
+        std::move(part.errors.begin(), part.errors.end(),
+                  std::back_inserter(errors));
+    }
+    auto &declarations = program_.declarations;
+    auto &statements = program_.statements;
+    program_.location = {
+        declarations.empty() ? statements.front()->location
+                             : declarations.front()->location,
+        statements.empty() ? declarations.back()->location
+                           : statements.back()->location};
+    return true;
+}
+}  // namespace
+
+Edit diff_lines(string_view old_source, string_view new_source) {
+    auto old_starts = line_starts(old_source);
+    auto new_starts = line_starts(new_source);
+    int old_lines = static_cast<int>(old_starts.size()) - 1;
+    int new_lines = static_cast<int>(new_starts.size()) - 1;
+    auto same = [&](int old_line, int new_line) {
+        return lines(old_source, old_starts, old_line, old_line) ==
+               lines(new_source, new_starts, new_line, new_line);
+    };
+    int prefix = 0;
+    while (prefix < old_lines && prefix < new_lines &&
+           same(prefix + 1, prefix + 1)) {
+        prefix++;
+    }
+    int suffix = 0;
+    while (suffix < old_lines - prefix && suffix < new_lines - prefix &&
+           same(old_lines - suffix, new_lines - suffix)) {
+        suffix++;
+    }
+    return {prefix + 1, old_lines - prefix - suffix,
+            new_lines - prefix - suffix};
+}
+
+bool recheck(Program &program, string_view old_source, string_view new_source,
+             const Edit &edit, string_view name) {
+    return Rechecker(program, old_source, new_source, edit, name).run();
+}
+}  // namespace semantic
@@ -4,6 +4,7 @@
 #include <fmt/format.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <iterator>
 #include <list>
@@ -11,16 +12,20 @@
 #include <memory>
 #include <regex>
 #include <set>
+#include <thread>
 #include <utility>
 
 #include "FunctionDefType.hpp"
 #include "SymbolType.hpp"
 #include "ValueType.hpp"
+#include "chocopy_cache.hpp"
+#include "chocopy_json.hpp"
 #include "chocopy_parse.hpp"
 
 using std::set;
 namespace semantic {
 void SymbolTableGenerator::visit(parser::Program &program) {
+    add_predefined();
     for (const auto &decl : program.declarations) {
         auto id = decl->get_id();
         const auto &name = id->name;
@@ -39,6 +44,12 @@ void SymbolTableGenerator::visit(parser::Program &program) {
         sym->put(name, return_value);
     }
 }
+shared_ptr<SymbolType> SymbolTableGenerator::declare(parser::Decl &decl) {
+    assert(sym == global_sym);
+    return_value = nullptr;
+    decl.accept(*this);
+    return return_value;
+}
 void SymbolTableGenerator::visit(parser::ClassDef &class_def) {
     const auto &super_name = class_def.superClass->name;
     const auto super_class_type = global_sym->get<SymbolType>(super_name);
@@ -64,7 +75,10 @@ void SymbolTableGenerator::visit(parser::ClassDef &class_def) {
     const auto &super_scope = super_class_def->current_scope;
     const auto &class_name = class_def.name->name;
     const auto class_ = std::make_shared<ClassDefType>(super_name, class_name);
-    hierachy_tree->add_class(class_name, super_name);
+    // already there when the class is declared again
+    if (hierachy_tree->find(class_name) == nullptr) {
+        hierachy_tree->add_class(class_name, super_name);
+    }
     assert(this->sym == global_sym);
     class_->current_scope.parent = global_sym;
 
@@ -315,12 +329,56 @@ void TypeChecker::typeError(parser::Node *node, const string &message) {
     }
 }
 void TypeChecker::visit(parser::Program &program) {
+    /** A declaration, the scope it is in and the errors found in it. */
+    struct Part {
+        parser::Decl *decl;
+        SymbolTable *scope;
+        vector<std::unique_ptr<parser::CompilerErr>> errors;
+    };
+    vector<Part> parts;
+    size_t bodies = 0;
+    auto add = [&](parser::Decl *decl, SymbolTable *scope) {
+        parts.push_back({decl, scope, {}});
+        bodies += dynamic_cast<parser::FuncDef *>(decl) != nullptr;
+    };
     for (const auto &decl : program.declarations) {
-        decl->accept(*this);
+        if (auto class_ = dynamic_cast<parser::ClassDef *>(decl.get())) {
+            auto scope =
+                &global->get<ClassDefType>(class_->name->name)->current_scope;
+            for (const auto &member : class_->declaration) {
+                add(member.get(), scope);
+            }
+        } else {
+            add(decl.get(), global);
+        }
+    }
+
+    // numbered before the threads share it
+    hierachy_tree->number();
+    std::atomic<size_t> next = 0;
+    auto work = [&]() {
+        TypeChecker checker(*this);
+        for (size_t i; (i = next++) < parts.size();) {
+            checker.sym = parts[i].scope;
+            checker.errors = &parts[i].errors;
+            parts[i].decl->accept(checker);
+        }
+    };
+    vector<std::thread> threads;
+    for (size_t i = 1; i < std::min<size_t>(jobs, bodies); i++) {
+        threads.emplace_back(work);
+    }
+    work();
+    for (auto &thread : threads) thread.join();
+    for (auto &part : parts) {
+        std::move(part.errors.begin(), part.errors.end(),
+                  std::back_inserter(*errors));
     }
+
     for (const auto &stmt : program.statements) {
         stmt->accept(*this);
     }
+    program.type_checked = true;
 }
 void TypeChecker::visit(parser::BinaryExpr &node) {
     node.left->accept(*this);
@@ -925,31 +983,28 @@ bool TypeChecker::is_subtype(SymbolType const *sub, SymbolType const *super) {
     // rule 1
     if (super->get_name() == "object") return true;
     if (sub->is_list_type() || super->is_list_type()) return false;
+    if (sub->get_name() == super->get_name()) return true;
     return hierachy_tree->is_superclass(sub->get_name(), super->get_name());
 }
 }  // namespace semantic
 
 #ifdef PA2
 int main(int argc, char *argv[]) {
-    if (argc != 2) {
-        std::cerr << "Usage: " << argv[0] << " <filename>" << std::endl;
+    std::string_view flag = argc == 3 ? argv[1] : "";
+    bool ast_cache = flag == "-ast-cache";
+    bool incremental = flag == "-incremental";
+    if (argc != 2 && !ast_cache && !incremental) {
+        std::cerr << "Usage: " << argv[0]
+                  << " [ -ast-cache | -incremental ] <filename>" << std::endl;
         return 1;
     }
-    std::unique_ptr<parser::Program> tree(parse(argv[1]));
-    if (tree->errors->compiler_errors.size() == 0) {
-        auto symboltableGenerator = semantic::SymbolTableGenerator(*tree);
-        tree->accept(symboltableGenerator);
-    }
-    if (tree->errors->compiler_errors.size() == 0) {
-        auto declarationAnalyzer = semantic::DeclarationAnalyzer(*tree);
-        tree->accept(declarationAnalyzer);
-    }
-    if (tree->errors->compiler_errors.size() == 0) {
-        auto typeChecker = semantic::TypeChecker(*tree);
-        tree->accept(typeChecker);
-    }
+    auto tree = semantic::check(argv[argc - 1], ast_cache, incremental);
 
-    auto j = tree->toJSON();
-    std::cout << j.dump(2) << std::endl;
+    // an editor that rechecks on each save only reads the errors
+    if (incremental) {
+        ast::JsonEmitter(std::cout).emit(*tree->errors);
+    } else {
+        ast::JsonEmitter(std::cout).emit(*tree);
+    }
 }
 #endif
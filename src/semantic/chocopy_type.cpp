@@ -22,10 +22,14 @@ shared_ptr<ValueType> ValueType::annotate_to_val(
 }
 ListValueType::ListValueType(parser::ListType *typeAnnotation)
     : element_type(
-          ValueType::annotate_to_val(typeAnnotation->elementType.get())) {}
+          ValueType::annotate_to_val(typeAnnotation->elementType.get())) {
+    set_kind(SymbolKind::ListValue);
+}
 
 ClassValueType::ClassValueType(parser::ClassType *classTypeAnnotation)
-    : class_name(classTypeAnnotation->className) {}
+    : class_name(classTypeAnnotation->className) {
+    set_kind(SymbolKind::ClassValue);
+}
 
 const string ValueType::get_name() const {
     return ((ClassValueType *)this)->class_name;
@@ -0,0 +1,85 @@
+#!/usr/bin/python3
+"""Times the AST output of the parser and semantic executables on a large
+generated program, and checks that it is the same as the one of another
+build, e.g. of an older commit:
+
+    python3 tests/bench_ast.py --size 8 --baseline ../old/build
+"""
+import argparse
+import os
+import subprocess
+import tempfile
+import time
+
+TESTDATA_DIR = os.path.abspath(os.path.dirname(__file__))
+PROJECT_DIR = os.path.dirname(TESTDATA_DIR)
+BUILD_DIR = os.path.join(PROJECT_DIR, 'build')
+
+CHUNK = '''
+class C{i}(object):
+    x: int = {i}
+    s: str = "s{i}\\t\\"q\\""
+
+    def m(self: "C{i}", n: int) -> [int]:
+        r: [int] = None
+        r = [n, self.x, n * 2 // 3 % 7]
+        while n > 0:
+            if n % 2 == 0 and not n == 4:
+                r = r + [n]
+            elif n > 10:
+                self.x = self.x - 1
+            else:
+                pass
+            n = n - 1
+        return r
+
+def f{i}(a: int, b: bool) -> int:
+    c: C{i} = None
+    t: int = 0
+    c = C{i}()
+    for t in c.m(a):
+        a = a + t if b else a - t
+    print(c.s)
+    return len(c.m(a)) + a
+'''
+
+# after all the chunks, as the declarations come before the statements
+CALL = 'print(f{i}({i}, True))\n'
+
+
+def generate(size_mb: int, path: str):
+    with open(path, 'w') as f:
+        i = 0
+        while f.tell() < size_mb << 20:
+            f.write(CHUNK.format(i=i))
+            i += 1
+        f.write('\n' + ''.join(CALL.format(i=j) for j in range(i)))
+
+
+def run(executable: str, source: str) -> tuple[float, bytes]:
+    start = time.perf_counter()
+    out = subprocess.run([executable, source], stdout=subprocess.PIPE,
+                         stderr=subprocess.DEVNULL, check=True).stdout
+    return time.perf_counter() - start, out
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='AST output benchmark')
+    parser.add_argument('--size', type=int, default=4,
+                        help='size of the generated source in MiB')
+    parser.add_argument('--build', default=BUILD_DIR)
+    parser.add_argument('--baseline', help='build directory to compare with')
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory() as tmp:
+        source = os.path.join(tmp, 'big.py')
+        generate(args.size, source)
+        for name in ['parser', 'semantic']:
+            seconds, out = run(os.path.join(args.build, name), source)
+            line = f'{name}: {seconds:.2f}s, {len(out) >> 20} MiB of JSON'
+            if args.baseline:
+                base_seconds, base_out = run(
+                    os.path.join(args.baseline, name), source)
+                same = 'same output' if out == base_out else 'OUTPUT DIFFERS'
+                line += f'; baseline {base_seconds:.2f}s, {same}'
+            print(line)
@@ -0,0 +1,157 @@
+#!/usr/bin/python3
+"""Edits a program the way an editor does and checks each version with
+semantic -incremental, which rechecks the program from the .astb of the last
+version it checked and prints its errors, and with a full semantic run. The
+errors have to be the same, and so does the whole program, which semantic
+-ast-cache reads back from the .astb the recheck wrote. Prints the time of
+each, e.g.:
+
+    python3 tests/bench_incremental.py --chunks 200 --random 50
+
+The scripted edits change a body, a signature that other parts use, a
+global, a class attribute, a name that only a string or a comment mentions,
+and the lines around the parts, and break the syntax and fix it again.
+--random adds edits that delete, duplicate or swap lines at random, most of
+which end in errors.
+"""
+import argparse
+import json
+import os
+import random
+import subprocess
+import tempfile
+import time
+
+TESTDATA_DIR = os.path.abspath(os.path.dirname(__file__))
+PROJECT_DIR = os.path.dirname(TESTDATA_DIR)
+BUILD_DIR = os.path.join(PROJECT_DIR, 'build')
+
+HEAD = '''x: int = 1
+s: str = "x"
+
+class A(object):
+    a: int = 0
+
+    def get(self: "A") -> int:
+        return self.a
+
+def f(n: int) -> int:
+    # n plus x
+    return n + x
+
+def g(n: int) -> str:
+    return "f(n)"  # f only in a string
+
+def h() -> int:
+    return f(2)
+'''
+
+CHUNK = '''
+def k{i}(n: int) -> int:
+    a: A = None
+    a = A()
+    while n > {i} % 7:
+        n = n - a.get() - 1
+    return n
+'''
+
+TAIL = '''
+print(f(1))
+print(g(2))
+print(h())
+'''
+
+# (description, text replaced, replacement), applied one after the other
+EDITS = [
+    ('body', 'return n + x', 'return n * x'),
+    ('comment', '# n plus x', '# n times x, not f'),
+    ('signature used elsewhere', 'def f(n: int) -> int:\n'
+     '    # n times x, not f\n    return n * x',
+     'def f(n: int) -> str:\n    # n times x, not f\n    return s'),
+    ('signature back', 'def f(n: int) -> str:\n'
+     '    # n times x, not f\n    return s',
+     'def f(n: int) -> int:\n    # n times x, not f\n    return n * x'),
+    ('string only', '"f(n)"', '"h()"'),
+    ('global', 'x: int = 1', 'x: bool = True'),
+    ('global back', 'x: bool = True', 'x: int = 1'),
+    ('lines added', 'print(g(2))', 'print(x)\nprint(s)\nprint(g(2))'),
+    ('lines removed', 'print(x)\nprint(s)\n', ''),
+    ('method', 'return self.a', 'return self.a + 1'),
+    ('class attribute', 'a: int = 0', 'a: int = 5'),
+    ('class attribute back', 'a: int = 5', 'a: int = 0'),
+    ('syntax error', 'def h() -> int:', 'def h() -> int'),
+    ('syntax fixed', 'def h() -> int', 'def h() -> int:'),
+    ('type error', 'return f(2)', 'return g(2)'),
+    ('type fixed', 'return g(2)', 'return f(2)'),
+]
+
+
+def run(executable: str, source: str, *flags: str) -> tuple[float, bytes]:
+    start = time.perf_counter()
+    out = subprocess.run([executable, *flags, source],
+                         stdout=subprocess.PIPE,
+                         stderr=subprocess.DEVNULL).stdout
+    return time.perf_counter() - start, out
+
+
+def random_edit(rng: random.Random, text: str) -> tuple[str, str]:
+    lines = text.split('\n')
+    i, j = rng.randrange(len(lines)), rng.randrange(len(lines))
+    kind = rng.choice(['delete', 'duplicate', 'swap'])
+    if kind == 'delete':
+        del lines[i]
+    elif kind == 'duplicate':
+        lines.insert(i, lines[j])
+    else:
+        lines[i], lines[j] = lines[j], lines[i]
+    return f'random {kind} {i + 1} {j + 1}', '\n'.join(lines)
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='incremental check')
+    parser.add_argument('--chunks', type=int, default=100,
+                        help='number of functions added to the program')
+    parser.add_argument('--random', type=int, default=0,
+                        help='number of random edits after the scripted ones')
+    parser.add_argument('--seed', type=int, default=0)
+    parser.add_argument('--build', default=BUILD_DIR)
+    args = parser.parse_args()
+
+    semantic = os.path.join(args.build, 'semantic')
+    rng = random.Random(args.seed)
+    text = HEAD + ''.join(CHUNK.format(i=i)
+                          for i in range(args.chunks)) + TAIL
+    edits = len(EDITS) + args.random
+    differ = 0
+    incremental_seconds = full_seconds = 0.0
+    with tempfile.TemporaryDirectory() as tmp:
+        source = os.path.join(tmp, 'edited.py')
+        with open(source, 'w') as f:
+            f.write(text)
+        run(semantic, source, '-incremental')
+        for n in range(edits):
+            if n < len(EDITS):
+                name, old, new = EDITS[n]
+                assert old in text, name
+                text = text.replace(old, new, 1)
+            else:
+                name, text = random_edit(rng, text)
+            with open(source, 'w') as f:
+                f.write(text)
+            seconds, out = run(semantic, source, '-incremental')
+            full, full_out = run(semantic, source)
+            incremental_seconds += seconds
+            full_seconds += full
+            # the program the recheck left in the .astb, types and all
+            _, cached_out = run(semantic, source, '-ast-cache')
+            # a program that crashes the checker crashes both
+            if not out or not full_out:
+                same = out == full_out
+            else:
+                same = json.loads(out) == json.loads(full_out)['errors'] \
+                    and json.loads(cached_out) == json.loads(full_out)
+            differ += not same
+            print(f'{name}: {seconds * 1e3:.1f} ms, full {full * 1e3:.1f} ms'
+                  f'{"" if same else ", OUTPUT DIFFERS"}')
+    print(f'{edits} edits, {differ} differ; incremental '
+          f'{incremental_seconds:.2f}s, full {full_seconds:.2f}s')
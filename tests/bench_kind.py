@@ -0,0 +1,85 @@
+#!/usr/bin/python3
+"""Times cgen on a large generated program, whose optimizer and backend
+passes test the kinds of many values and types, and checks that the .s is
+the same as the one of another build, e.g. of the commit before the kind
+checks:
+
+    python3 tests/bench_kind.py --functions 300 --baseline ../old/build
+
+Each function has many int locals and a long loop over them, so that most
+of the time goes to the IR passes, the lifetime analysis and the register
+allocation rather than to parsing.
+"""
+import argparse
+import os
+import subprocess
+import tempfile
+import time
+
+TESTDATA_DIR = os.path.abspath(os.path.dirname(__file__))
+PROJECT_DIR = os.path.dirname(TESTDATA_DIR)
+BUILD_DIR = os.path.join(PROJECT_DIR, 'build')
+
+LOCALS = 24
+STATEMENTS = 60
+
+
+def function(i: int) -> str:
+    names = [f'v{j}' for j in range(LOCALS)]
+    text = f'\ndef f{i}(n: int) -> int:\n'
+    text += ''.join(f'    {v}: int = {j + i % 5}\n'
+                    for j, v in enumerate(names))
+    text += '    while n > 0:\n'
+    for s in range(STATEMENTS):
+        a, b, c = (names[(s * k + i) % LOCALS] for k in (1, 3, 7))
+        op = ['+', '-', '*', '//', '%'][s % 5]
+        # // and % by a value that is never 0
+        rhs = f'({c} % 7 + 1)' if op in ('//', '%') else c
+        text += f'        {a} = ({b} {op} {rhs}) % 1000003\n'
+    text += '        n = n - 1\n'
+    return text + f'    return {" + ".join(names)}\n'
+
+
+def generate(functions: int, path: str):
+    with open(path, 'w') as f:
+        for i in range(functions):
+            f.write(function(i))
+        f.write('\n' + ''.join(f'print(f{i}({i % 3 + 1}))\n'
+                               for i in range(functions)))
+
+
+def run(build: str, source: str, target: str,
+        repeat: int) -> tuple[float, bytes]:
+    """The best time of a few runs, and the .s it wrote."""
+    best = float('inf')
+    for _ in range(repeat):
+        start = time.perf_counter()
+        subprocess.run([os.path.join(build, 'cgen'), '-o', target, source],
+                       stdout=subprocess.DEVNULL, check=True)
+        best = min(best, time.perf_counter() - start)
+    with open(target + '.s', 'rb') as f:
+        return best, f.read()
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='kind check benchmark')
+    parser.add_argument('--functions', type=int, default=300)
+    parser.add_argument('--repeat', type=int, default=3)
+    parser.add_argument('--build', default=BUILD_DIR)
+    parser.add_argument('--baseline', help='build directory to compare with')
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory() as tmp:
+        source = os.path.join(tmp, 'big.py')
+        generate(args.functions, source)
+        seconds, asm = run(args.build, source, os.path.join(tmp, 'new'),
+                           args.repeat)
+        line = (f'cgen: {seconds:.2f}s, {os.path.getsize(source) >> 10} KiB '
+                f'of source, {len(asm) >> 10} KiB of assembly')
+        if args.baseline:
+            base_seconds, base_asm = run(args.baseline, source,
+                                         os.path.join(tmp, 'base'),
+                                         args.repeat)
+            same = 'same .s' if asm == base_asm else '.s DIFFERS'
+            line += f'; baseline {base_seconds:.2f}s, {same}'
+        print(line)
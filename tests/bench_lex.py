@@ -0,0 +1,98 @@
+#!/usr/bin/python3
+"""Times the scanner alone (parser -lex) in MB/s on a large input, and
+checks that its tokens are the same as those of another build, e.g. with an
+older chocopy.l:
+
+    python3 tests/bench_lex.py --size 16 --baseline ../old/build
+
+The input is a generated program whose blocks nest deeply, so that a line
+often closes several of them, or with --inputs the programs in a directory,
+such as the recursion/ ones run.sh generates with grammarinator, repeated
+up to the size.
+"""
+import argparse
+import os
+import re
+import subprocess
+import tempfile
+
+TESTDATA_DIR = os.path.abspath(os.path.dirname(__file__))
+PROJECT_DIR = os.path.dirname(TESTDATA_DIR)
+BUILD_DIR = os.path.join(PROJECT_DIR, 'build')
+
+HEAD = '''
+# chunk {i}
+def f{i}(n: int) -> int:
+    s: str = "f{i}\\t\\"q\\""
+'''
+
+LEVEL = '''{pad}while n > {d}:  # level {d}
+
+{pad}    # a comment between the blocks
+{pad}    n = n - 1 if n % 2 == 0 else n // 3
+'''
+
+TAIL = '''    return n
+
+print(f{i}({i}))
+'''
+
+
+def chunk(i: int, depth: int) -> str:
+    text = HEAD.format(i=i)
+    for d in range(depth):
+        text += LEVEL.format(pad='    ' * (d + 1), d=d)
+    return text + TAIL.format(i=i)
+
+
+def generate(size_mb: int, path: str, depth: int, inputs: str = None):
+    sources = None
+    if inputs:
+        sources = []
+        for name in sorted(os.listdir(inputs)):
+            with open(os.path.join(inputs, name)) as f:
+                sources.append(f.read().rstrip('\n') + '\n')
+    with open(path, 'w') as f:
+        i = 0
+        while f.tell() < size_mb << 20:
+            f.write(sources[i % len(sources)] if sources else
+                    chunk(i, 1 + i % depth))
+            i += 1
+
+
+def run(executable: str, source: str, repeat: int) -> tuple[float, str]:
+    """The best MB/s of a few runs, and the tokens and their hash."""
+    best, tokens = 0.0, ''
+    for _ in range(repeat):
+        out = subprocess.run([executable, '-lex', source],
+                             stdout=subprocess.PIPE, check=True).stdout
+        match = re.match(r'(.*), ([\d.]+) MB/s', out.decode())
+        tokens = match.group(1)
+        best = max(best, float(match.group(2)))
+    return best, tokens
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='lexer benchmark')
+    parser.add_argument('--size', type=int, default=16,
+                        help='size of the input in MiB')
+    parser.add_argument('--depth', type=int, default=12,
+                        help='deepest nesting of the generated blocks')
+    parser.add_argument('--inputs', help='directory of programs to use')
+    parser.add_argument('--repeat', type=int, default=3)
+    parser.add_argument('--build', default=BUILD_DIR)
+    parser.add_argument('--baseline', help='build directory to compare with')
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory() as tmp:
+        source = os.path.join(tmp, 'big.py')
+        generate(args.size, source, args.depth, args.inputs)
+        mb_s, tokens = run(os.path.join(args.build, 'parser'), source,
+                           args.repeat)
+        line = f'lexer: {mb_s:.1f} MB/s, {tokens}'
+        if args.baseline:
+            base_mb_s, base_tokens = run(
+                os.path.join(args.baseline, 'parser'), source, args.repeat)
+            same = 'same tokens' if tokens == base_tokens else 'TOKENS DIFFER'
+            line += f'; baseline {base_mb_s:.1f} MB/s, {same}'
+        print(line)
@@ -0,0 +1,92 @@
+#!/usr/bin/python3
+"""Times ir-optimizer on a module of thousands of functions, to see that
+Module::print and the lookups of functions by name stay linear in their
+number, and checks that the .ll is the same as the one of another build:
+
+    python3 tests/bench_module.py --functions 5000 --baseline ../old/build
+
+The module is written twice: once from a generated program, which times
+building and printing it, and once from that .ll, in which each call is
+resolved by Module::get_function. Both are also timed on half the
+functions; a time that grows by much more than 2x on twice the functions
+is quadratic somewhere.
+"""
+import argparse
+import os
+import subprocess
+import tempfile
+import time
+
+TESTDATA_DIR = os.path.abspath(os.path.dirname(__file__))
+PROJECT_DIR = os.path.dirname(TESTDATA_DIR)
+BUILD_DIR = os.path.join(PROJECT_DIR, 'build')
+
+CALLS = 4
+
+
+def function(i: int, functions: int) -> str:
+    """A function that calls the next few, so that most names are used
+    before they are defined."""
+    calls = ' + '.join(f'f{(i + k) % functions}(n - 1)'
+                       for k in range(1, CALLS + 1))
+    return (f'\ndef f{i}(n: int) -> int:\n'
+            f'    if n <= 0:\n'
+            f'        return {i}\n'
+            f'    return ({calls}) % 1000003\n')
+
+
+def generate(functions: int, path: str):
+    with open(path, 'w') as f:
+        for i in range(functions):
+            f.write(function(i, functions))
+        f.write('\nprint(f0(2))\n')
+
+
+def run(build: str, input_path: str, target: str,
+        repeat: int) -> tuple[float, bytes]:
+    """The best time of a few runs, and the .ll it wrote."""
+    best = float('inf')
+    for _ in range(repeat):
+        start = time.perf_counter()
+        subprocess.run([os.path.join(build, 'ir-optimizer'), '-o', target,
+                        input_path], stdout=subprocess.DEVNULL, check=True)
+        best = min(best, time.perf_counter() - start)
+    with open(target + '.ll', 'rb') as f:
+        return best, f.read()
+
+
+def measure(build: str, functions: int, tmp: str,
+            repeat: int) -> tuple[float, float, bytes]:
+    """The times from the program and from its .ll, and the .ll."""
+    source = os.path.join(tmp, f'big{functions}.py')
+    generate(functions, source)
+    first = os.path.join(tmp, f'first{functions}')
+    second = os.path.join(tmp, f'second{functions}')
+    from_source, ir = run(build, source, first, repeat)
+    from_ir, _ = run(build, first + '.ll', second, repeat)
+    return from_source, from_ir, ir
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='large module benchmark')
+    parser.add_argument('--functions', type=int, default=5000)
+    parser.add_argument('--repeat', type=int, default=3)
+    parser.add_argument('--build', default=BUILD_DIR)
+    parser.add_argument('--baseline', help='build directory to compare with')
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory() as tmp:
+        half = args.functions // 2
+        half_source, half_ir, _ = measure(args.build, half, tmp, args.repeat)
+        from_source, from_ir, ir = measure(args.build, args.functions, tmp,
+                                           args.repeat)
+        print(f'from .py: {from_source:.2f}s '
+              f'({from_source / half_source:.1f}x the time of {half}), '
+              f'from .ll: {from_ir:.2f}s '
+              f'({from_ir / half_ir:.1f}x), {len(ir) >> 10} KiB of IR')
+        if args.baseline:
+            base_source, base_ir, base = measure(
+                args.baseline, args.functions, tmp, args.repeat)
+            same = 'same .ll' if ir == base else '.ll DIFFERS'
+            print(f'baseline from .py: {base_source:.2f}s, '
+                  f'from .ll: {base_ir:.2f}s, {same}')
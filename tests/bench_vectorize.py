@@ -0,0 +1,88 @@
+#!/usr/bin/python3
+"""Compiles a program with cgen with and without -pass Vectorize, runs both
+under qemu with the V extension, and checks that they print the same, and
+the same as the expected output if there is one. Prints the time of each:
+
+    python3 tests/bench_vectorize.py --repeat 5
+
+The program is tests/pa4/benchmarks/vectorize.py unless others are given.
+Both are linked for rv32imacv, so that the only difference between them is
+the code the pass generates.
+"""
+import argparse
+import os
+import subprocess
+import tempfile
+import time
+
+TESTDATA_DIR = os.path.abspath(os.path.dirname(__file__))
+PROJECT_DIR = os.path.dirname(TESTDATA_DIR)
+BUILD_DIR = os.path.join(PROJECT_DIR, 'build')
+
+
+def build(build_dir: str, program: str, target: str, passes: list[str]):
+    args = [os.path.join(build_dir, 'cgen'), '-o', target]
+    for name in passes:
+        args += ['-pass', name]
+    subprocess.run(args + [program], stdout=subprocess.DEVNULL, check=True,
+                   timeout=60)
+    subprocess.run(['riscv64-elf-gcc', '-mabi=ilp32', '-march=rv32imacv',
+                    '-o', target, target + '.s', '-L' + build_dir,
+                    '-lchocopy_stdlib'], check=True, timeout=60)
+
+
+def run(target: str, repeat: int) -> tuple[float, str]:
+    """The best time of a few runs in seconds, and what the program
+    printed."""
+    best, output = float('inf'), ''
+    for _ in range(repeat):
+        start = time.perf_counter()
+        result = subprocess.run(['qemu-riscv32', '-cpu', 'rv32,v=true',
+                                 target], stdout=subprocess.PIPE,
+                                timeout=600)
+        best = min(best, time.perf_counter() - start)
+        output = result.stdout.decode(errors='replace')
+    return best, output
+
+
+def expected_of(program: str):
+    """The output program has to print, None if there is no .result."""
+    path = program + '.ast.typed.s.result'
+    if not os.path.exists(path):
+        return None
+    with open(path) as f:
+        return f.read()
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='Vectorize benchmark')
+    parser.add_argument('--build', default=BUILD_DIR)
+    parser.add_argument('--repeat', type=int, default=3)
+    parser.add_argument('programs', nargs='*', default=[
+        os.path.join(TESTDATA_DIR, 'pa4', 'benchmarks', 'vectorize.py')])
+    args = parser.parse_args()
+
+    failed = 0
+    with tempfile.TemporaryDirectory() as tmp:
+        for program in args.programs:
+            scalar = os.path.join(tmp, 'scalar')
+            vector = os.path.join(tmp, 'vector')
+            build(args.build, program, scalar, [])
+            build(args.build, program, vector, ['Vectorize'])
+            scalar_time, scalar_output = run(scalar, args.repeat)
+            vector_time, vector_output = run(vector, args.repeat)
+
+            expected = expected_of(program)
+            if scalar_output != vector_output:
+                verdict = 'OUTPUTS DIFFER'
+            elif expected is not None and \
+                    scalar_output.strip() != expected.strip():
+                verdict = 'BOTH DIFFER FROM THE .result'
+            else:
+                verdict = 'same output'
+            if verdict != 'same output':
+                failed += 1
+            print(f'{os.path.relpath(program)}: scalar {scalar_time:.3f} s, '
+                  f'vector {vector_time:.3f} s '
+                  f'({scalar_time / vector_time:.2f}x), {verdict}')
+    exit(1 if failed else 0)
@@ -110,7 +110,8 @@ def compare_ast(student_ast: dict, reference_ast: dict, verbose: bool = False) -
     return compare_ast_node(student_ast, reference_ast, verbose=verbose)
 
 
-def check_testcase(directory: str, testcase: str, pa: int) -> int:
+def check_testcase(directory: str, testcase: str, pa: int,
+                   passes: list[str] = [], timeout: float = 3) -> int:
     assert 1 <= pa <= 4
     if pa == 1:
         assert os.path.exists(PARSER_EXECUTABLE)
@@ -153,9 +154,12 @@ def check_testcase(directory: str, testcase: str, pa: int) -> int:
             '-o', os.path.join(RESULT_DIR, testcase),
             '-run', os.path.join(directory, f'{testcase}.py')]
     }[pa]
+    # cgen -run runs qemu with the V extension when Vectorize is among them
+    for name in passes if pa >= 3 else []:
+        command[1:1] = ['-pass', name]
 
     try:
-        p = subprocess.run(command, timeout=3, capture_output=True)
+        p = subprocess.run(command, timeout=timeout, capture_output=True)
         student_output = p.stdout.decode()
     except subprocess.TimeoutExpired:
         with print_lock:
@@ -206,7 +210,9 @@ def check_testcase(directory: str, testcase: str, pa: int) -> int:
     return 0
 
 
-def check_testcases_in_directory(directory: str, pa: int) -> tuple[int, int]:
+def check_testcases_in_directory(directory: str, pa: int,
+                                 passes: list[str] = [],
+                                 timeout: float = 3) -> tuple[int, int]:
     if not (os.path.exists(directory) and os.path.isdir(directory)):
         print(f'[{directory} does not exist]')
         return 0, 0
@@ -215,7 +221,7 @@ def check_testcases_in_directory(directory: str, pa: int) -> tuple[int, int]:
                                       for x in os.listdir(directory) if x.endswith('.py')])
     with Pool(THREADS) as p:
         results = p.starmap(check_testcase, [
-            (directory, testcase, pa)
+            (directory, testcase, pa, passes, timeout)
             for testcase in testcases
         ])
     ret = sum(results), len(results)
@@ -223,14 +229,19 @@ def check_testcases_in_directory(directory: str, pa: int) -> tuple[int, int]:
     return ret
 
 
-def check_pa(pa: int):
+def check_pa(pa: int, passes: list[str] = [], timeout: float = 3,
+             benchmarks: bool = False) -> bool:
     pa_directory = os.path.join(TESTDATA_DIR, f'pa{pa}')
     subdirectories = ['sample']
     subdirectories.append('sp23')
+    if benchmarks:
+        subdirectories.append('benchmarks')
     results = [
-        check_testcases_in_directory(os.path.join(pa_directory, sub), pa)
+        check_testcases_in_directory(os.path.join(pa_directory, sub), pa,
+                                     passes, timeout)
         for sub in subdirectories
     ]
+    return all(passed == total for passed, total in results)
 
 
 if __name__ == '__main__':
@@ -244,6 +255,12 @@ if __name__ == '__main__':
 
     parser = argparse.ArgumentParser(description="Checker for ChocoPy")
     parser.add_argument("--pa", metavar="N", type=int, nargs="+")
+    parser.add_argument("--pass", dest="passes", action="append", default=[],
+                        help="pass for ir-optimizer or cgen to run")
+    parser.add_argument("--timeout", type=float, default=3,
+                        help="seconds each testcase may take")
+    parser.add_argument("--benchmarks", action="store_true",
+                        help="also run the benchmarks directory")
 
     args = parser.parse_args()
     if args.pa is None:
@@ -256,4 +273,5 @@ if __name__ == '__main__':
         os.sys.exit(1)
 
     print(f'[checking PA{pa}]')
-    check_pa(pa)
+    if not check_pa(pa, args.passes, args.timeout, args.benchmarks):
+        os.sys.exit(1)
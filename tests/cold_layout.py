@@ -0,0 +1,137 @@
+#!/usr/bin/python3
+"""Checks how cgen lays out the blocks that call a runtime error routine
+(error.OOB, error.None, error.Div): in each function they come after all the
+others, and a block that only calls the routine may share its body with
+the others that call the same one, but never with one that calls another.
+
+    python3 tests/cold_layout.py tests/pa4/sample/error_cold_*.py
+
+The routine each block calls is read from the .ll cgen -emit-ir writes next
+to the .s, and the block of each label from the .s, whose labels are
+.<function>_<block>. The programs are those of tests/pa4/sample unless
+others are given.
+"""
+import argparse
+import glob
+import os
+import re
+import subprocess
+import tempfile
+from typing import Optional
+
+TESTDATA_DIR = os.path.abspath(os.path.dirname(__file__))
+PROJECT_DIR = os.path.dirname(TESTDATA_DIR)
+BUILD_DIR = os.path.join(PROJECT_DIR, 'build')
+
+IR_DEFINE = re.compile(r'^define [^@]*@([^(\s]+)\(')
+IR_LABEL = re.compile(r'^([^\s:;%@]+):')
+IR_ERROR_CALL = re.compile(r'call void @(error\.\w+)\(')
+ASM_GLOBL = re.compile(r'^\.globl (\S+)$')
+ASM_LABEL = re.compile(r'^(\S+):$')
+ASM_ERROR_CALL = re.compile(r'^\s*(?:call|tail)\s+(error\.\w+)\b')
+
+
+def error_blocks(ll: str) -> dict[tuple[str, str], str]:
+    """The routine called by each block that calls one, by function and
+    block name."""
+    blocks = {}
+    function = block = None
+    for line in ll.splitlines():
+        if match := IR_DEFINE.match(line):
+            function, block = match.group(1), None
+        elif line.startswith('}'):
+            function = None
+        elif function and (match := IR_LABEL.match(line)):
+            block = match.group(1)
+        elif function and block and (match := IR_ERROR_CALL.search(line)):
+            blocks[(function, block)] = match.group(1)
+    return blocks
+
+
+def asm_functions(asm: str) -> dict[str, list[tuple[list[str], list[str]]]]:
+    """For each function, its blocks in order: the labels that start each
+    body, several when blocks share it, and the lines of the body."""
+    functions = {}
+    function = None
+    for line in asm.splitlines():
+        if match := ASM_GLOBL.match(line):
+            function = match.group(1)
+            functions[function] = []
+            continue
+        if function is None:
+            continue
+        match = ASM_LABEL.match(line)
+        if match and match.group(1) == f'{function}$return':
+            function = None
+        elif match and match.group(1).startswith(f'.{function}_'):
+            groups = functions[function]
+            if groups and not groups[-1][1]:
+                groups[-1][0].append(match.group(1))
+            else:
+                groups.append(([match.group(1)], []))
+        elif functions[function]:
+            functions[function][-1][1].append(line)
+    return functions
+
+
+def check(executable: str, program: str, tmp: str) -> Optional[list[str]]:
+    """What is laid out wrong, None if the program does not compile."""
+    target = os.path.join(tmp, 'cold')
+    for path in [target + '.ll', target + '.s']:
+        if os.path.exists(path):
+            os.remove(path)
+    subprocess.run([executable, '-emit-ir', '-o', target, program],
+                   stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL,
+                   timeout=60)
+    if not os.path.exists(target + '.s'):
+        return None
+    with open(target + '.ll') as f:
+        expected = error_blocks(f.read())
+    with open(target + '.s') as f:
+        functions = asm_functions(f.read())
+
+    problems = []
+    for function, groups in functions.items():
+        seen_cold = None
+        for labels, body in groups:
+            callees = {m.group(1) for m in map(ASM_ERROR_CALL.match, body)
+                       if m}
+            if callees:
+                seen_cold = seen_cold or labels[0]
+            elif seen_cold and any(line.strip() for line in body):
+                problems.append(f'{labels[0]} comes after the cold block '
+                                f'{seen_cold}')
+            for label in labels:
+                block = label[len(f'.{function}_'):]
+                callee = expected.get((function, block))
+                if callee and callees != {callee}:
+                    problems.append(f'{label} should call {callee}, but its '
+                                    f'body calls {sorted(callees) or "none"}')
+                elif callee is None and len(labels) > 1:
+                    problems.append(f'{label} shares the body of an error '
+                                    f'block but calls no routine in the IR')
+    return problems
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='cold block layout')
+    parser.add_argument('--build', default=BUILD_DIR)
+    parser.add_argument('programs', nargs='*', default=sorted(
+        glob.glob(os.path.join(TESTDATA_DIR, 'pa4', 'sample', '*.py'))))
+    args = parser.parse_args()
+
+    executable = os.path.join(args.build, 'cgen')
+    failed = skipped = 0
+    with tempfile.TemporaryDirectory() as tmp:
+        for program in args.programs:
+            problems = check(executable, program, tmp)
+            if problems is None:
+                skipped += 1
+                continue
+            failed += bool(problems)
+            for problem in problems:
+                print(f'{os.path.relpath(program)}: {problem}')
+    checked = len(args.programs) - skipped
+    print(f'{checked - failed}/{checked} laid out as expected, '
+          f'{skipped} without code')
+    exit(1 if failed else 0)
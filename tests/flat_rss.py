@@ -0,0 +1,62 @@
+#!/usr/bin/python3
+"""Checks that compiling the same program over and over in one process, as a
+compile service does, keeps the peak RSS flat: ir-optimizer -repeat builds
+and tears down a Module for the program n times and prints the peak RSS
+after each, which may grow while the allocators warm up but not after.
+
+    python3 tests/flat_rss.py --repeat 500 --pass LoopUnroll
+
+An object allocated outside the arena of its module, or a list the module
+does not free, grows it by as much on every round, so even a few bytes a
+value show up over a few hundred rounds.
+"""
+import argparse
+import glob
+import os
+import subprocess
+
+TESTDATA_DIR = os.path.abspath(os.path.dirname(__file__))
+PROJECT_DIR = os.path.dirname(TESTDATA_DIR)
+BUILD_DIR = os.path.join(PROJECT_DIR, 'build')
+
+
+def peak_rss(executable: str, program: str, repeat: int,
+             passes: list[str]) -> list[int]:
+    """The peak RSS in KiB after each round."""
+    args = [executable, '-repeat', str(repeat)]
+    for name in passes:
+        args += ['-pass', name]
+    out = subprocess.run(args + [program], stdout=subprocess.PIPE,
+                         stderr=subprocess.DEVNULL, check=True,
+                         timeout=3600).stdout.decode()
+    # past the errors a program that does not compile prints each round
+    return [int(fields[1]) for fields in map(str.split, out.splitlines())
+            if len(fields) == 2 and fields[0].isdigit()]
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='RSS over repeated compiles')
+    parser.add_argument('--build', default=BUILD_DIR)
+    parser.add_argument('--repeat', type=int, default=300)
+    parser.add_argument('--warmup', type=float, default=0.2,
+                        help='share of the rounds that may still grow')
+    parser.add_argument('--slack', type=int, default=256,
+                        help='KiB the peak may grow by after the warm-up')
+    parser.add_argument('--pass', dest='passes', action='append',
+                        default=[], help='pass to run on the program')
+    parser.add_argument('programs', nargs='*', default=sorted(
+        glob.glob(os.path.join(TESTDATA_DIR, 'pa4', 'benchmarks', '*.py'))))
+    args = parser.parse_args()
+
+    executable = os.path.join(args.build, 'ir-optimizer')
+    warm = max(1, int(args.repeat * args.warmup))
+    failed = 0
+    for program in args.programs:
+        rss = peak_rss(executable, program, args.repeat, args.passes)
+        growth = rss[-1] - rss[warm - 1]
+        flat = growth <= args.slack
+        failed += not flat
+        print(f'{os.path.relpath(program)}: {rss[warm - 1]} KiB after '
+              f'{warm} rounds, {rss[-1]} KiB after {len(rss)}'
+              f'{"" if flat else ", GROWS"}')
+    exit(1 if failed else 0)
@@ -0,0 +1,239 @@
+#!/usr/bin/python3
+"""Checks the JSON AST of the parser and semantic executables on random
+programs: it has to be what json::dump(2) prints for it, that is the same
+text as Python prints once it reads it back with sorted keys, and with
+--baseline the same as that of another build, e.g. of an older commit:
+
+    python3 tests/fuzz_json.py --count 500 --baseline ../old/build
+
+The programs use every kind of node, strings with escapes, and names from
+a small pool, so that many have type errors; some lose or gain a line at
+random and have syntax errors instead. Run it on a build with
+__PARSER_PRINT_LOCATION defined to check the locations as well.
+"""
+import argparse
+import json
+import os
+import random
+import subprocess
+import tempfile
+from typing import Optional
+
+TESTDATA_DIR = os.path.abspath(os.path.dirname(__file__))
+PROJECT_DIR = os.path.dirname(TESTDATA_DIR)
+BUILD_DIR = os.path.join(PROJECT_DIR, 'build')
+
+NAMES = ['x', 'y', 'n', 's', 'a', 'b', 'f', 'g', 'self', 'len', 'print']
+TYPES = ['int', 'bool', 'str', 'object', '[int]', '[str]', '"A"', 'A',
+         '[[bool]]', 'B']
+STRINGS = ['', 'a', 'x y', '\\n', '\\t\\\\', '\\"q\\"', 'tab\\tend']
+BINARY = ['+', '-', '*', '//', '%', '==', '!=', '<', '<=', '>', '>=',
+          'and', 'or', 'is']
+
+
+class Generator:
+    def __init__(self, rng: random.Random):
+        self.rng = rng
+
+    def name(self) -> str:
+        return self.rng.choice(NAMES)
+
+    def literal(self) -> str:
+        kind = self.rng.randrange(5)
+        if kind == 0:
+            return str(self.rng.choice([0, 1, 7, 42, 2147483647]))
+        if kind == 1:
+            return self.rng.choice(['True', 'False'])
+        if kind == 2:
+            return 'None'
+        return '"' + self.rng.choice(STRINGS) + '"'
+
+    def expr(self, depth: int = 0) -> str:
+        if depth > 3 or self.rng.random() < 0.3:
+            return self.literal() if self.rng.random() < 0.5 else \
+                self.name()
+        kind = self.rng.randrange(9)
+        sub = lambda: self.expr(depth + 1)
+        if kind == 0:
+            return f'{sub()} {self.rng.choice(BINARY)} {sub()}'
+        if kind == 1:
+            return f'{self.rng.choice(["-", "not "])}{sub()}'
+        if kind == 2:
+            return f'({sub()} if {sub()} else {sub()})'
+        if kind == 3:
+            items = ', '.join(sub() for _ in range(self.rng.randrange(4)))
+            return f'[{items}]'
+        if kind == 4:
+            return f'{sub()}[{sub()}]'
+        if kind == 5:
+            return f'{self.name()}.{self.name()}'
+        if kind == 6:
+            args = ', '.join(sub() for _ in range(self.rng.randrange(3)))
+            return f'{self.name()}({args})'
+        if kind == 7:
+            args = ', '.join(sub() for _ in range(self.rng.randrange(3)))
+            return f'{self.name()}.{self.name()}({args})'
+        return f'({sub()})'
+
+    def target(self) -> str:
+        kind = self.rng.randrange(3)
+        if kind == 0:
+            return self.name()
+        if kind == 1:
+            return f'{self.name()}.{self.name()}'
+        return f'{self.name()}[{self.expr(2)}]'
+
+    def stmt(self, pad: str, depth: int, in_func: bool) -> list[str]:
+        kind = self.rng.randrange(9 if depth < 3 else 4)
+        if kind == 0:
+            targets = ' = '.join(self.target()
+                                 for _ in range(self.rng.randint(1, 2)))
+            return [f'{pad}{targets} = {self.expr()}']
+        if kind == 1:
+            return [f'{pad}{self.expr()}']
+        if kind == 2:
+            return [f'{pad}pass']
+        if kind == 3:
+            if in_func:
+                value = self.expr() if self.rng.random() < 0.7 else ''
+                return [f'{pad}return {value}'.rstrip()]
+            return [f'{pad}print({self.expr()})']
+        body = lambda: self.block(pad + '    ', depth + 1, in_func)
+        if kind == 4:
+            lines = [f'{pad}if {self.expr()}:'] + body()
+            if self.rng.random() < 0.5:
+                lines += [f'{pad}elif {self.expr()}:'] + body()
+            if self.rng.random() < 0.5:
+                lines += [f'{pad}else:'] + body()
+            return lines
+        if kind == 5:
+            return [f'{pad}while {self.expr()}:'] + body()
+        if kind == 6:
+            return [f'{pad}for {self.name()} in {self.expr()}:'] + body()
+        if kind == 7:
+            return [f'{pad}# a comment', f'{pad}{self.expr()}  # after']
+        return [f'{pad}{self.target()} = {self.expr()}']
+
+    def block(self, pad: str, depth: int, in_func: bool) -> list[str]:
+        lines = []
+        for _ in range(self.rng.randint(1, 3)):
+            lines += self.stmt(pad, depth, in_func)
+        return lines
+
+    def var_def(self, pad: str) -> str:
+        return f'{pad}{self.name()}: {self.rng.choice(TYPES)} = ' \
+            f'{self.literal()}'
+
+    def func_def(self, pad: str, depth: int, method: bool) -> list[str]:
+        params = [f'{self.name()}: {self.rng.choice(TYPES)}'
+                  for _ in range(self.rng.randrange(3))]
+        if method:
+            params.insert(0, 'self: "A"')
+        result = f' -> {self.rng.choice(TYPES)}' \
+            if self.rng.random() < 0.7 else ''
+        lines = [f'{pad}def {self.name()}({", ".join(params)}){result}:']
+        inner = pad + '    '
+        for _ in range(self.rng.randrange(3)):
+            kind = self.rng.randrange(4)
+            if kind == 0:
+                lines.append(f'{inner}global {self.name()}')
+            elif kind == 1:
+                lines.append(f'{inner}nonlocal {self.name()}')
+            elif kind == 2 and depth < 2:
+                lines += self.func_def(inner, depth + 1, False)
+            else:
+                lines.append(self.var_def(inner))
+        return lines + self.block(inner, depth + 1, True)
+
+    def class_def(self) -> list[str]:
+        super_class = self.rng.choice(['object', 'A', 'int', 'B'])
+        lines = [f'class {self.rng.choice(["A", "B"])}({super_class}):']
+        for _ in range(self.rng.randint(1, 3)):
+            if self.rng.random() < 0.5:
+                lines.append(self.var_def('    '))
+            else:
+                lines += self.func_def('    ', 1, True)
+        return lines
+
+    def program(self) -> str:
+        lines = []
+        for _ in range(self.rng.randint(1, 6)):
+            kind = self.rng.randrange(3)
+            if kind == 0:
+                lines.append(self.var_def(''))
+            elif kind == 1:
+                lines += self.func_def('', 0, False)
+            else:
+                lines += self.class_def()
+        lines += self.block('', 0, False)
+        if self.rng.random() < 0.2 and len(lines) > 1:
+            # a syntax error, or an indentation one
+            i = self.rng.randrange(len(lines))
+            if self.rng.random() < 0.5:
+                del lines[i]
+            else:
+                lines.insert(i, '  ' + lines[i])
+        return '\n'.join(lines) + '\n'
+
+
+def run(executable: str, source: str) -> Optional[bytes]:
+    """The output, None if the executable crashed."""
+    result = subprocess.run([executable, source], stdout=subprocess.PIPE,
+                            stderr=subprocess.DEVNULL, timeout=60)
+    return None if result.returncode < 0 else result.stdout
+
+
+def dump(out: bytes) -> bytes:
+    """out as json::dump(2) prints it, with the newline after it."""
+    tree = json.loads(out)
+    return (json.dumps(tree, indent=2, sort_keys=True, ensure_ascii=False)
+            + '\n').encode()
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='JSON AST fuzzer')
+    parser.add_argument('--count', type=int, default=200)
+    parser.add_argument('--seed', type=int, default=0)
+    parser.add_argument('--build', default=BUILD_DIR)
+    parser.add_argument('--baseline', help='build directory to compare with')
+    args = parser.parse_args()
+
+    # a build with __PARSER_PRINT_LOCATION may only have the parser
+    names = [name for name in ['parser', 'semantic']
+             if os.path.exists(os.path.join(args.build, name))]
+    generator = Generator(random.Random(args.seed))
+    failed = crashed = 0
+    with tempfile.TemporaryDirectory() as tmp:
+        for i in range(args.count):
+            source = os.path.join(tmp, f'{i}.py')
+            with open(source, 'w') as f:
+                f.write(generator.program())
+            for name in names:
+                out = run(os.path.join(args.build, name), source)
+                base = run(os.path.join(args.baseline, name), source) \
+                    if args.baseline else None
+                error = ''
+                if out is None:
+                    # the crashes the baseline has too are not the JSON's
+                    if args.baseline and base is not None:
+                        error = 'crashed, unlike the baseline'
+                    else:
+                        crashed += 1
+                elif args.baseline and out != base:
+                    error = 'differs from the baseline'
+                else:
+                    try:
+                        if out != dump(out):
+                            error = 'not as json::dump(2) prints it'
+                    except ValueError:
+                        error = 'not JSON'
+                if error:
+                    failed += 1
+                    kept = os.path.join(os.getcwd(), f'fuzz_json_{i}.py')
+                    with open(source) as f, open(kept, 'w') as k:
+                        k.write(f.read())
+                    print(f'{name} on {kept}: {error}')
+    total = len(names) * args.count
+    print(f'{total - failed - crashed}/{total} outputs as expected, '
+          f'{crashed} crashed')
+    exit(1 if failed else 0)
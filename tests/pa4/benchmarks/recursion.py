@@ -0,0 +1,39 @@
+# Deep recursion, far beyond what fits on the stack unless tail calls are
+# turned into jumps
+
+# Self tail recursion
+def sum_mod(n:int, acc:int) -> int:
+    if n == 0:
+        return acc
+    return sum_mod(n - 1, acc + n % 7)
+
+# Mutual tail recursion
+def is_even(n:int) -> bool:
+    if n == 0:
+        return True
+    return is_odd(n - 1)
+
+def is_odd(n:int) -> bool:
+    if n == 0:
+        return False
+    return is_even(n - 1)
+
+# Self tail recursion of a nested function
+def triangle(n:int) -> int:
+    total:int = 0
+    def go(i:int) -> int:
+        nonlocal total
+        if i > n:
+            return total
+        total = total + i
+        return go(i + 1)
+    return go(1)
+
+# Input parameter
+n:int = 1000000
+
+# Crunch
+print(sum_mod(n, 0))
+print(is_even(n))
+print(is_odd(n + 1))
+print(triangle(50000))
@@ -0,0 +1,58 @@
+# Counted for loops over lists, strings and short list literals
+def make_list(n: int) -> [int]:
+    a: [int] = None
+    a = [0]
+    while len(a) < n:
+        a = a + a
+    return a
+
+def weigh(a: [int]) -> int:
+    s: int = 0
+    x: int = 0
+    for x in a:
+        s = (s * 3 + x) % 1000003
+    return s
+
+def poly(x: int) -> int:
+    s: int = 0
+    k: int = 0
+    for k in [3, 1, 4, 1, 5, 9, 2, 6]:
+        s = (s * x + k) % 1000003
+    return s
+
+def vowels(t: str) -> int:
+    n: int = 0
+    c: str = ""
+    for c in t:
+        if c == "a" or c == "e" or c == "i" or c == "o" or c == "u":
+            n = n + 1
+    return n
+
+# Input parameters
+n: int = 2048
+rounds: int = 200
+
+a: [int] = None
+text: str = "the quick brown fox jumps over the lazy dog"
+i: int = 0
+r: int = 0
+weights: int = 0
+values: int = 0
+count: int = 0
+
+a = make_list(n)
+while i < n:
+    a[i] = (i * 13) % 97
+    i = i + 1
+
+# Crunch
+while r < rounds:
+    weights = (weights + weigh(a)) % 1000003
+    values = (values + poly(r)) % 1000003
+    count = count + vowels(text)
+    a[r % n] = r
+    r = r + 1
+
+print(weights)
+print(values)
+print(count)
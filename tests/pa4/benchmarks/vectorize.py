@@ -0,0 +1,49 @@
+# Element-wise arithmetic on [int] lists
+def make_list(n: int) -> [int]:
+	a: [int] = None
+	a = [0]
+	while len(a) < n:
+		a = a + a
+	return a
+
+def checksum(a: [int], n: int) -> int:
+	s: int = 0
+	i: int = 0
+	while i < n:
+		s = (s * 31 + a[i]) % 1000003
+		i = i + 1
+	return s
+
+# Input parameters
+n: int = 4096
+rounds: int = 100
+
+x: [int] = None
+y: [int] = None
+z: [int] = None
+w: [int] = None
+i: int = 0
+r: int = 0
+
+x = make_list(n)
+y = make_list(n)
+z = make_list(n)
+w = make_list(n)
+while i < n:
+	x[i] = i % 100
+	y[i] = (i * 7) % 50
+	i = i + 1
+
+# Crunch
+while r < rounds:
+	i = 0
+	while i < n:
+		z[i] = x[i] + y[i]
+		w[i] = 3 * z[i] - y[i]
+		x[i] = w[i] - 2 * z[i]
+		i = i + 1
+	r = r + 1
+
+print(checksum(x, n))
+print(checksum(z, n))
+print(checksum(w, n))
@@ -0,0 +1,33 @@
+# Several None checks on the hot path, whose error blocks share one body
+class Node(object):
+    value: int = 0
+    next: "Node" = None
+
+    def sum(self: "Node") -> int:
+        s: int = 0
+        n: Node = None
+        n = self
+        while not (n is None):
+            s = s + n.value
+            n = n.next
+        return s
+
+def make(k: int) -> Node:
+    head: Node = None
+    n: Node = None
+    while k > 0:
+        n = Node()
+        n.value = k
+        n.next = head
+        head = n
+        k = k - 1
+    return head
+
+def second(n: Node) -> int:
+    return n.next.value + n.next.next.value
+
+l: Node = None
+l = make(4)
+print(l.sum())
+print(second(l))
+print(second(l.next.next))
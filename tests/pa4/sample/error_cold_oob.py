@@ -0,0 +1,16 @@
+# Several index checks per loop, whose error blocks share one body
+def total(xs: [int], ys: [int], n: int) -> int:
+    s: int = 0
+    i: int = 0
+    while i < n:
+        s = s + xs[i] * ys[i] - xs[n - 1 - i]
+        i = i + 1
+    return s
+
+a: [int] = None
+b: [int] = None
+a = [1, 2, 3, 4, 5]
+b = [5, 4, 3, 2, 1]
+print(total(a, b, 5))
+print(total(b, a, 3))
+print(total(a, b, 6))
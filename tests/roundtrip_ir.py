@@ -0,0 +1,122 @@
+#!/usr/bin/python3
+"""Checks that the LightIR ir-optimizer writes reads back the same: for each
+program, the .ll of the program is given to ir-optimizer again, and the .ll
+it writes has to be the same text, apart from source_filename. Then the
+.lirb that -ir-cache wrote for the program is given to it, and the .lirb it
+writes has to be the same bytes, apart from the key in the header.
+
+    python3 tests/roundtrip_ir.py --pass LoopUnroll --pass StackAlloc
+
+The programs are those of tests/pa3/sample and tests/pa4/sample, or of the
+directories given. The passes run on the program only, so the second .ll
+and .lirb hold the module of the first ones written again.
+"""
+import argparse
+import glob
+import os
+import subprocess
+import tempfile
+from typing import Optional
+
+TESTDATA_DIR = os.path.abspath(os.path.dirname(__file__))
+PROJECT_DIR = os.path.dirname(TESTDATA_DIR)
+BUILD_DIR = os.path.join(PROJECT_DIR, 'build')
+
+
+def without_source_filename(text: str) -> list[str]:
+    return [line for line in text.splitlines()
+            if not line.startswith('source_filename')]
+
+
+def without_header(data: bytes) -> bytes:
+    """data past "LIRB", the LEB128 version and the 8-byte key."""
+    i = 4
+    while i < len(data) and data[i] & 0x80:
+        i += 1
+    return data[i + 1 + 8:]
+
+
+def run(args: list[str]) -> str:
+    """What went wrong, empty if the run printed nothing and exited 0."""
+    result = subprocess.run(args, stdout=subprocess.PIPE,
+                            stderr=subprocess.STDOUT, timeout=60)
+    if result.returncode != 0 or result.stdout:
+        return result.stdout.decode(errors='replace').strip() or \
+            f'exit code {result.returncode}'
+    return ''
+
+
+def roundtrip(executable: str, program: str, passes: list[str],
+              tmp: str) -> Optional[str]:
+    """The reason the IR of program does not read back, empty if it does,
+    None if the program has errors and no IR."""
+    first = os.path.join(tmp, 'first')
+    third = os.path.join(tmp, 'third')
+    for path in [first + '.ll', first + '.lirb', third + '.lirb']:
+        if os.path.exists(path):
+            os.remove(path)
+    args = [executable, '-ir-cache', '-o', first]
+    for name in passes:
+        args += ['-pass', name]
+    subprocess.run(args + [program], stdout=subprocess.DEVNULL,
+                   stderr=subprocess.DEVNULL, timeout=60)
+    if not os.path.exists(first + '.ll'):
+        return None
+
+    second = os.path.join(tmp, 'second')
+    if os.path.exists(second + '.ll'):
+        os.remove(second + '.ll')
+    error = run([executable, '-o', second, first + '.ll'])
+    if error:
+        return error
+    with open(first + '.ll') as f:
+        expected = without_source_filename(f.read())
+    with open(second + '.ll') as f:
+        actual = without_source_filename(f.read())
+    if actual != expected:
+        line = next((i for i, (a, b) in enumerate(zip(actual, expected))
+                     if a != b), min(len(actual), len(expected)))
+        return f'.ll differs at line {line + 1}'
+
+    # the key covers the input, so the .lirb is written, not read
+    error = run([executable, '-ir-cache', '-o', third, first + '.lirb'])
+    if error:
+        return error
+    with open(first + '.lirb', 'rb') as f:
+        expected = without_header(f.read())
+    with open(third + '.lirb', 'rb') as f:
+        actual = without_header(f.read())
+    if actual != expected:
+        offset = next((i for i, (a, b) in enumerate(zip(actual, expected))
+                       if a != b), min(len(actual), len(expected)))
+        return f'.lirb differs at byte {offset} past the header'
+    return ''
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='LightIR round trip')
+    parser.add_argument('--build', default=BUILD_DIR)
+    parser.add_argument('--pass', dest='passes', action='append',
+                        default=[], help='pass to run on the program first')
+    parser.add_argument('directories', nargs='*', default=[
+        os.path.join(TESTDATA_DIR, 'pa3', 'sample'),
+        os.path.join(TESTDATA_DIR, 'pa4', 'sample')])
+    args = parser.parse_args()
+
+    executable = os.path.join(args.build, 'ir-optimizer')
+    programs = sorted(program for directory in args.directories
+                      for program in glob.glob(os.path.join(directory,
+                                                            '*.py')))
+    failed = skipped = 0
+    with tempfile.TemporaryDirectory() as tmp:
+        for program in programs:
+            error = roundtrip(executable, program, args.passes, tmp)
+            if error is None:
+                skipped += 1
+            elif error:
+                failed += 1
+                print(f'{os.path.relpath(program)}: {error}')
+    checked = len(programs) - skipped
+    print(f'{checked - failed}/{checked} read back the same, '
+          f'{skipped} without IR')
+    exit(1 if failed else 0)